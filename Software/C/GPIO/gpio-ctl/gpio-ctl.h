@@ -1,38 +1,39 @@
-// File: gpio-ctl.h
-// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
-// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
-// Date: 16 Feb 2018
-// Rev.: 16 Feb 2018
-//
-// Header file for the GPIO control program for the FTDI FH232H chip.
-//
-
-
-
-#ifndef __GPIO_CTL_H
-#define __GPIO_CTL_H
-
-
-
-// Use GPIO MPSSE library functions.
-#include "gpio_mpsse.h"
-
-
-
-// Message prefixes.
-#define PREFIX_DEBUG            "DEBUG: "
-#define PREFIX_ERROR            "ERROR: "
-
-
-
-// Level of debug info.
-//#define DEBUG_LEVEL 0
-//#define DEBUG_LEVEL 1
-//#define DEBUG_LEVEL 2
-//#define DEBUG_LEVEL 3
-#define DEBUG_LEVEL 4
-
-
-
-#endif
-
+// File: gpio-ctl.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 16 Feb 2018
+// Rev.: 19 Oct 2026
+//
+// Header file for the GPIO control program for the FTDI FH232H chip.
+//
+
+
+
+#ifndef __GPIO_CTL_H
+#define __GPIO_CTL_H
+
+
+
+// Use GPIO MPSSE library functions.
+#include "gpio_mpsse.h"
+#include "gpio_event.h"
+
+
+
+// Message prefixes.
+#define PREFIX_DEBUG            "DEBUG: "
+#define PREFIX_ERROR            "ERROR: "
+
+
+
+// Level of debug info.
+//#define DEBUG_LEVEL 0
+//#define DEBUG_LEVEL 1
+//#define DEBUG_LEVEL 2
+//#define DEBUG_LEVEL 3
+#define DEBUG_LEVEL 4
+
+
+
+#endif
+
@@ -0,0 +1,359 @@
+// File: gpio_event.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Edge-triggered GPIO input monitoring on top of the hardware GPIO IO
+// functions.
+//
+// Polling gpio_get_pins() costs one USB round trip per sample and misses all
+// pulses between the polls. Here, a monitor thread keeps a continuous stream
+// of pin samples in flight: each USB transfer holds GPIO_EVENT_SAMPLES
+// GET_BITS_LOW (and GET_BITS_HIGH, if GPIOH pins are monitored) commands, and
+// the next transfer is written before the data of the previous one is read.
+// The MPSSE thus never runs out of commands and samples the pins without
+// gaps. Edges are detected in the sample stream on the host and delivered
+// with an estimated time stamp, either to a callback or through an event
+// queue signalled by an eventfd.
+//
+// While no other thread uses the adapter, the stream runs continuously. As
+// soon as another job is queued on the adapter or another thread waits for
+// the adapter lock (e.g. to defer commands or to change the I2C frequency),
+// the stream is drained and the adapter is handed over before sampling
+// resumes. The stream is also
+// drained before calling the callback, so that it may use the adapter.
+//
+// The MPSSE wait on IO commands (WAIT_ON_HIGH, WAIT_ON_LOW) are not used:
+// they only watch GPIOL1 and block the whole MPSSE until the level occurs,
+// without any way to abort the wait. This would stall the I2C functions
+// sharing the adapter.
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <mpsse.h>
+#include "mpsse_adapter.h"
+#include "gpio_mpsse.h"
+#include "gpio_event.h"
+
+
+
+// Job setting the monitored pins to inputs.
+struct gpio_event_dir_job {
+    unsigned char low;          // Low byte pins to set to inputs.
+    unsigned char high;         // High byte pins to set to inputs.
+};
+
+
+
+// Function prototypes.
+static int gpio_event_build_inputs(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static void *gpio_event_thread(void *arg);
+static int gpio_event_stream(struct gpio_event_monitor *mon, unsigned char *cmd, int cmd_len, unsigned char *buf, int sample_len);
+static int gpio_event_recv(struct gpio_event_monitor *mon, unsigned char *buf, int len);
+static void gpio_event_process(struct gpio_event_monitor *mon, unsigned char *buf, int sample_len, struct timespec *t_start, struct timespec *t_end);
+static void gpio_event_deliver(struct gpio_event_monitor *mon, struct gpio_event *event);
+static void gpio_event_callback_pending(struct gpio_event_monitor *mon);
+
+
+
+// Start monitoring GPIO pins for edges. The monitored pins are set to inputs.
+// If callback is NULL, the events are queued and can be read with
+// gpio_event_read(), the file descriptor returned by gpio_event_fd() then
+// becomes readable.
+int gpio_event_start(struct gpio_event_monitor *mon, struct mpsse_adapter *adapter, int rising, int falling, gpio_event_callback callback, void *arg)
+{
+    int mask = (rising | falling) & 0xfff;
+    struct gpio_event_dir_job job;
+
+    if(mon == NULL || adapter == NULL || mask == 0) {
+        fprintf(stderr, "%s: %s: %sInvalid GPIO event monitor parameters.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    memset(mon, 0, sizeof(struct gpio_event_monitor));
+    mon->adapter = adapter;
+    mon->rising = rising & 0xfff;
+    mon->falling = falling & 0xfff;
+    mon->callback = callback;
+    mon->arg = arg;
+    mon->last = -1;
+    mon->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(mon->fd < 0) {
+        fprintf(stderr, "%s: %s: %sCannot create the event file descriptor.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    // Set the monitored pins to inputs. GPIOL0..GPIOL3 are located at
+    // ADBUS4..ADBUS7, GPIOH0..GPIOH7 at ACBUS0..ACBUS7.
+    job.low = (mask & 0x00f) << 4;
+    job.high = (mask & 0xff0) >> 4;
+    if(mpsse_adapter_run(adapter, gpio_event_build_inputs, &job)) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to set the GPIO pins 0x%03x to inputs.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, mask);
+        close(mon->fd);
+        return -1;
+    }
+
+    pthread_mutex_init(&mon->lock, NULL);
+    mon->running = 1;
+    if(pthread_create(&mon->thread, NULL, gpio_event_thread, mon)) {
+        fprintf(stderr, "%s: %s: %sCannot create the GPIO event monitor thread.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        pthread_mutex_destroy(&mon->lock);
+        close(mon->fd);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Stop monitoring GPIO pins.
+int gpio_event_stop(struct gpio_event_monitor *mon)
+{
+    if(mon == NULL || mon->adapter == NULL) return -1;
+
+    __atomic_store_n(&mon->running, 0, __ATOMIC_RELEASE);
+    pthread_join(mon->thread, NULL);
+    pthread_mutex_destroy(&mon->lock);
+    close(mon->fd);
+    mon->adapter = NULL;
+
+    return mon->status;
+}
+
+
+
+// Get the event file descriptor. It becomes readable when events are queued
+// or the monitor stopped due to an error.
+int gpio_event_fd(struct gpio_event_monitor *mon)
+{
+    return mon->fd;
+}
+
+
+
+// Read queued events without blocking. Returns the number of events read or
+// -1 if the monitor stopped due to an error and no events are left.
+int gpio_event_read(struct gpio_event_monitor *mon, struct gpio_event *events, int max)
+{
+    int n = 0;
+    uint64_t value;
+
+    pthread_mutex_lock(&mon->lock);
+    // Clear the event file descriptor before taking the events, so that
+    // events queued meanwhile signal it again.
+    if(read(mon->fd, &value, sizeof(value)) < 0) value = 0;
+    while(n < max && mon->count > 0) {
+        events[n++] = mon->queue[mon->head];
+        mon->head = (mon->head + 1) % GPIO_EVENT_QUEUE;
+        mon->count--;
+    }
+    pthread_mutex_unlock(&mon->lock);
+
+    if(n == 0 && __atomic_load_n(&mon->status, __ATOMIC_ACQUIRE)) return -1;
+
+    return n;
+}
+
+
+
+// Build setting the monitored pins to inputs, keeping their output levels.
+static int gpio_event_build_inputs(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    int status = 0;
+    struct gpio_event_dir_job *job = (struct gpio_event_dir_job *) arg;
+
+    if(job->low)
+        status |= mpsse_adapter_set_low(adapter, cmd, adapter->pins.low, 0x00, job->low);
+    if(job->high)
+        status |= mpsse_adapter_set_high(adapter, cmd, adapter->pins.high, 0x00, job->high);
+
+    return status ? -1 : 0;
+}
+
+
+
+// Monitor thread.
+static void *gpio_event_thread(void *arg)
+{
+    struct gpio_event_monitor *mon = (struct gpio_event_monitor *) arg;
+    unsigned char cmd[2 * GPIO_EVENT_SAMPLES + 1];
+    unsigned char buf[2 * GPIO_EVENT_SAMPLES];
+    int i, cmd_len = 0;
+    int sample_len = (((mon->rising | mon->falling) & 0xff0) != 0) ? 2 : 1;
+    uint64_t value = 1;
+
+    // Sampling commands of one USB transfer.
+    for(i = 0; i < GPIO_EVENT_SAMPLES; i++) {
+        cmd[cmd_len++] = GET_BITS_LOW;
+        if(sample_len == 2)
+            cmd[cmd_len++] = GET_BITS_HIGH;
+    }
+    cmd[cmd_len++] = SEND_IMMEDIATE;
+
+    while(__atomic_load_n(&mon->running, __ATOMIC_ACQUIRE)) {
+        mpsse_adapter_lock(mon->adapter);
+        mon->status = gpio_event_stream(mon, cmd, cmd_len, buf, sample_len);
+        mpsse_adapter_unlock(mon->adapter);
+        gpio_event_callback_pending(mon);
+        if(mon->status) {
+            if(mon->adapter->verbose)
+                fprintf(stderr, "%s: %s: %sUSB error while sampling the GPIO pins. Monitor stopped.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+            // Wake up the reader.
+            if(write(mon->fd, &value, sizeof(value)) < 0) {}
+            break;
+        }
+        // Execute the jobs of other threads waiting for the adapter.
+        if(__atomic_load_n(&mon->adapter->queue, __ATOMIC_ACQUIRE) != NULL)
+            mpsse_adapter_flush(mon->adapter);
+        // Let threads waiting in mpsse_adapter_lock() (e.g. deferring
+        // commands) take the adapter before streaming again.
+        while(__atomic_load_n(&mon->adapter->waiters, __ATOMIC_ACQUIRE) > 0 &&
+              __atomic_load_n(&mon->running, __ATOMIC_ACQUIRE))
+            sched_yield();
+    }
+
+    return NULL;
+}
+
+
+
+// Stream pin samples while holding the adapter lock. Two USB transfers are
+// kept in flight, until the monitor is stopped, another job is queued on the
+// adapter, another thread waits for the adapter lock or events for the
+// callback are pending.
+static int gpio_event_stream(struct gpio_event_monitor *mon, unsigned char *cmd, int cmd_len, unsigned char *buf, int sample_len)
+{
+    struct ftdi_context *ftdi = &mon->adapter->mpsse->ftdi;
+    struct timespec t_start, t_end;
+    int in_flight = 0;
+    int status = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    if(ftdi_write_data(ftdi, cmd, cmd_len) != cmd_len) return -1;
+    in_flight++;
+
+    while(in_flight > 0) {
+        // Queue the next transfer, unless the stream should end.
+        if(status == 0 && mon->pending_count == 0 && __atomic_load_n(&mon->running, __ATOMIC_ACQUIRE) &&
+           __atomic_load_n(&mon->adapter->queue, __ATOMIC_ACQUIRE) == NULL &&
+           __atomic_load_n(&mon->adapter->waiters, __ATOMIC_ACQUIRE) == 0) {
+            if(ftdi_write_data(ftdi, cmd, cmd_len) != cmd_len)
+                status = -1;
+            else
+                in_flight++;
+        }
+        // Get the samples of the oldest transfer.
+        if(gpio_event_recv(mon, buf, GPIO_EVENT_SAMPLES * sample_len)) return -1;
+        in_flight--;
+        clock_gettime(CLOCK_MONOTONIC, &t_end);
+        gpio_event_process(mon, buf, sample_len, &t_start, &t_end);
+        t_start = t_end;
+    }
+
+    return status;
+}
+
+
+
+// Receive read-back data from the MPSSE.
+static int gpio_event_recv(struct gpio_event_monitor *mon, unsigned char *buf, int len)
+{
+    int r, rx_len = 0, retries = 0;
+
+    while(rx_len < len) {
+        r = ftdi_read_data(&mon->adapter->mpsse->ftdi, buf + rx_len, len - rx_len);
+        if(r < 0) return -1;
+        if(r == 0 && ++retries > MPSSE_ADAPTER_READ_RETRIES) return -1;
+        rx_len += r;
+    }
+
+    return 0;
+}
+
+
+
+// Detect edges in the samples of one USB transfer. The samples were taken
+// between t_start and t_end, their time stamps are interpolated.
+static void gpio_event_process(struct gpio_event_monitor *mon, unsigned char *buf, int sample_len, struct timespec *t_start, struct timespec *t_end)
+{
+    int i, pin, pins, changed;
+    long long t0, dt, t;
+    struct gpio_event event;
+
+    t0 = (long long) t_start->tv_sec * 1000000000LL + t_start->tv_nsec;
+    dt = (long long) t_end->tv_sec * 1000000000LL + t_end->tv_nsec - t0;
+
+    for(i = 0; i < GPIO_EVENT_SAMPLES; i++) {
+        // GPIOL0..GPIOL3 are located at ADBUS4..ADBUS7, GPIOH0..GPIOH7 at
+        // ACBUS0..ACBUS7.
+        pins = (buf[i * sample_len] >> 4) & 0x00f;
+        if(sample_len == 2)
+            pins |= (buf[i * sample_len + 1] << 4) & 0xff0;
+        if(mon->last >= 0 && pins != mon->last) {
+            changed = pins ^ mon->last;
+            t = t0 + dt * (i + 1) / GPIO_EVENT_SAMPLES;
+            event.pins = pins;
+            event.ts.tv_sec = t / 1000000000LL;
+            event.ts.tv_nsec = t % 1000000000LL;
+            for(pin = 0; pin < 12; pin++) {
+                if(!((changed >> pin) & 0x1)) continue;
+                event.pin = pin;
+                event.edge = ((pins >> pin) & 0x1) ? GPIO_EVENT_RISING : GPIO_EVENT_FALLING;
+                if(((event.edge == GPIO_EVENT_RISING) ? mon->rising : mon->falling) & (1 << pin))
+                    gpio_event_deliver(mon, &event);
+            }
+        }
+        mon->last = pins;
+    }
+    mon->samples += GPIO_EVENT_SAMPLES;
+}
+
+
+
+// Deliver an event to the callback or the event queue. Events for the
+// callback are kept until the adapter is released.
+static void gpio_event_deliver(struct gpio_event_monitor *mon, struct gpio_event *event)
+{
+    uint64_t value = 1;
+
+    if(mon->callback != NULL) {
+        if(mon->pending_count < GPIO_EVENT_QUEUE)
+            mon->pending[mon->pending_count++] = *event;
+        else
+            mon->overruns++;
+        return;
+    }
+
+    pthread_mutex_lock(&mon->lock);
+    if(mon->count < GPIO_EVENT_QUEUE) {
+        mon->queue[(mon->head + mon->count) % GPIO_EVENT_QUEUE] = *event;
+        mon->count++;
+    } else {
+        mon->overruns++;
+    }
+    pthread_mutex_unlock(&mon->lock);
+    if(write(mon->fd, &value, sizeof(value)) < 0) {}
+}
+
+
+
+// Pass the pending events to the callback.
+static void gpio_event_callback_pending(struct gpio_event_monitor *mon)
+{
+    int i;
+
+    for(i = 0; i < mon->pending_count; i++)
+        mon->callback(&mon->pending[i], mon->arg);
+    mon->pending_count = 0;
+}
+
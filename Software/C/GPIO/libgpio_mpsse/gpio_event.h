@@ -0,0 +1,86 @@
+// File: gpio_event.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for the edge-triggered GPIO input monitoring on top of the
+// hardware GPIO IO functions.
+//
+
+
+
+#ifndef __GPIO_EVENT_H
+#define __GPIO_EVENT_H
+
+
+
+#include <pthread.h>
+#include <time.h>
+#include "gpio_mpsse.h"
+
+
+
+// Edge types.
+#define GPIO_EVENT_RISING           0x1
+#define GPIO_EVENT_FALLING          0x2
+
+// Number of pin samples per USB transfer. Two transfers are kept in flight,
+// so that their read-back data fits into the 1 kB transmit buffer of the
+// FT232H, also when sampling both the low and the high byte pins.
+#define GPIO_EVENT_SAMPLES          256
+
+// Number of events buffered for gpio_event_read().
+#define GPIO_EVENT_QUEUE            256
+
+
+
+// GPIO event.
+struct gpio_event {
+    int pin;                    // GPIO pin number (0..11).
+    int edge;                   // GPIO_EVENT_RISING or GPIO_EVENT_FALLING.
+    int pins;                   // Levels of all GPIO pins after the edge.
+    struct timespec ts;         // Estimated time of the edge (CLOCK_MONOTONIC).
+};
+
+// GPIO event callback, called from the monitor thread while it does not
+// hold the adapter, so the callback may e.g. execute I2C transactions.
+typedef void (*gpio_event_callback)(const struct gpio_event *event, void *arg);
+
+// GPIO event monitor.
+struct gpio_event_monitor {
+    struct mpsse_adapter *adapter;
+    int rising;                 // GPIO pins monitored for rising edges.
+    int falling;                // GPIO pins monitored for falling edges.
+    gpio_event_callback callback;
+    void *arg;
+    int fd;                     // Event file descriptor, readable when events are queued.
+    pthread_t thread;
+    int running;
+    int status;                 // 0 = OK, -1 = USB error, the monitor stopped.
+    int last;                   // Last pin sample, -1 = none yet.
+    // Event queue, used if no callback is set.
+    pthread_mutex_t lock;
+    struct gpio_event queue[GPIO_EVENT_QUEUE];
+    int head;
+    int count;
+    // Events waiting to be passed to the callback.
+    struct gpio_event pending[GPIO_EVENT_QUEUE];
+    int pending_count;
+    // Statistics.
+    long samples;               // Number of pin samples taken.
+    long overruns;              // Number of events lost due to a full queue.
+};
+
+
+
+// Function prototypes.
+int gpio_event_start(struct gpio_event_monitor *mon, struct mpsse_adapter *adapter, int rising, int falling, gpio_event_callback callback, void *arg);
+int gpio_event_stop(struct gpio_event_monitor *mon);
+int gpio_event_fd(struct gpio_event_monitor *mon);
+int gpio_event_read(struct gpio_event_monitor *mon, struct gpio_event *events, int max);
+
+
+
+#endif
+
@@ -0,0 +1,531 @@
+// File: gpio_i2c.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Lockstep multi-bus bit-banged I2C on top of the hardware GPIO IO functions.
+//
+// Up to 6 I2C buses are connected to pairs of the 12 GPIO pins, each bus with
+// its own pull-up resistors. All buses are clocked in lockstep: the SCL pins
+// of all buses toggle together, while each SDA pin carries the data of its
+// own bus. This way, identical chips on separate buses, e.g. several Si5338
+// clock generators, are programmed in the time of one.
+//
+// The pins are bit-banged with MPSSE SET_BITS_LOW/SET_BITS_HIGH commands,
+// emulating open drain outputs: a line is pulled low by switching its pin to
+// an output driving zero and released by switching it to an input. At each
+// SCL high phase where the slaves drive SDA (ACK and read bits), the pins are
+// sampled with GET_BITS_LOW/GET_BITS_HIGH. The data and ACK bits of all buses
+// are taken from the same sample stream afterwards. The SCL half periods are
+// timed by the MPSSE, see mpsse_adapter_delay().
+//
+// All transactions of a batch are compiled into one large command buffer and
+// executed in one USB transfer. A bit takes about 20 command bytes, so the
+// transfer speed is limited by the SCL timing, not by USB round trips.
+//
+// Adaptive clocking, used by the hardware I2C engine for clock stretching,
+// would make the MPSSE wait for RTCK on each clock pulse of the delays. It is
+// therefore disabled during a batch and enabled again afterwards. GPIOL3 is
+// the RTCK input while adaptive clocking is enabled, so it cannot be used for
+// a bus then.
+//
+// Limitations:
+// - Clock stretching is not supported.
+// - A bus receiving a NACK keeps being clocked in lockstep with the others
+//   until the end of the transaction. The NACK is reported per bus.
+// - SK (ADBUS0) toggles during the SCL half periods, see
+//   mpsse_adapter_delay(). On an idle I2C bus on ADBUS0..ADBUS2, SDA stays
+//   high, so no target sees a start or stop condition.
+//
+// Example:
+//   const int scl[4] = {0, 2, 4, 6}, sda[4] = {1, 3, 5, 7};
+//   gpio_init();
+//   gpio_i2c_init(&bus, gpio_get_adapter(), 4, scl, sda);
+//   gpio_i2c_write(&bus, 0x70, data, size, &nack);    // Write to all 4 buses.
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpsse.h>
+#include "mpsse_adapter.h"
+#include "gpio_mpsse.h"
+#include "gpio_i2c.h"
+
+
+
+// Job setting the I2C lines of all buses to idle.
+struct gpio_i2c_idle_job {
+    struct gpio_i2c *bus;
+};
+
+// I2C batch job.
+struct gpio_i2c_batch_job {
+    struct gpio_i2c *bus;
+    struct gpio_i2c_xfer *xfers;
+    int num;
+    unsigned char *samples;     // Low and high byte pin samples, 2 bytes per SCL high phase.
+    int count;                  // Number of samples.
+};
+
+
+
+// Function prototypes.
+static int gpio_i2c_pin(int gpio, unsigned char *low, unsigned char *high);
+static int gpio_i2c_check_pins(struct mpsse_adapter *adapter, struct gpio_i2c *bus);
+static void gpio_i2c_decode(struct gpio_i2c *bus, struct gpio_i2c_batch_job *job);
+static int gpio_i2c_build_set(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, unsigned char low, unsigned char low_drive, unsigned char high, unsigned char high_drive);
+static int gpio_i2c_build_scl(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, struct gpio_i2c *bus, int level);
+static int gpio_i2c_build_sda(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, struct gpio_i2c *bus, int levels);
+static int gpio_i2c_build_sample(struct mpsse_cmd *cmd, struct gpio_i2c *bus, struct gpio_i2c_batch_job *job);
+static int gpio_i2c_build_bit(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, struct gpio_i2c_batch_job *job, int levels, int sample);
+static int gpio_i2c_build_byte(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, struct gpio_i2c_batch_job *job, struct gpio_i2c_msg *msg, int index);
+static int gpio_i2c_build_batch(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int gpio_i2c_build_idle(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+
+
+
+// Set up a set of I2C buses clocked in lockstep. The SCL and SDA lines of bus
+// i are connected to the GPIO pins scl[i] and sda[i] (0..11). The buses may
+// share the SCL pin of bus 0. The lines are released, so that they are pulled
+// high.
+int gpio_i2c_init(struct gpio_i2c *bus, struct mpsse_adapter *adapter, int num, const int *scl, const int *sda)
+{
+    int i;
+    int used = 0;
+    unsigned char low, high;
+    struct gpio_i2c_idle_job job;
+
+    if(bus == NULL || adapter == NULL || num < 1 || num > GPIO_I2C_BUS_MAX) {
+        fprintf(stderr, "%s: %s: %sInvalid multi-bus I2C parameters.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    memset(bus, 0, sizeof(struct gpio_i2c));
+    bus->adapter = adapter;
+    bus->num = num;
+    for(i = 0; i < num; i++) {
+        if(scl[i] < 0 || scl[i] >= GPIO_MPSSE_PIN_COUNT || sda[i] < 0 || sda[i] >= GPIO_MPSSE_PIN_COUNT ||
+           scl[i] == sda[i] || (used & (1 << sda[i])) || ((used & (1 << scl[i])) && scl[i] != scl[0])) {
+            if(adapter->verbose)
+                fprintf(stderr, "%s: %s: %sInvalid or duplicate GPIO pins %d and %d for SCL and SDA of I2C bus %d.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, scl[i], sda[i], i);
+            return -1;
+        }
+        used |= (1 << scl[i]) | (1 << sda[i]);
+        bus->scl[i] = scl[i];
+        bus->sda[i] = sda[i];
+        gpio_i2c_pin(scl[i], &low, &high);
+        bus->scl_low |= low;
+        bus->scl_high |= high;
+        gpio_i2c_pin(sda[i], &bus->sda_low[i], &bus->sda_high[i]);
+        bus->sda_low_all |= bus->sda_low[i];
+        bus->sda_high_all |= bus->sda_high[i];
+    }
+    gpio_i2c_set_freq(bus, GPIO_I2C_FREQ_DEFAULT);
+
+    // Release all lines.
+    job.bus = bus;
+    if(mpsse_adapter_run(adapter, gpio_i2c_build_idle, &job)) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to set up the GPIO pins of the I2C buses.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Set the I2C frequency of a set of I2C buses.
+int gpio_i2c_set_freq(struct gpio_i2c *bus, int freq)
+{
+    if(bus == NULL) return -1;
+    if(freq <= 0 || freq > GPIO_I2C_FREQ_MAX) {
+        if(bus->adapter != NULL && bus->adapter->verbose)
+            fprintf(stderr, "%s: %s: %sInvalid I2C frequency of %d Hz. Use up to %d Hz.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, freq, GPIO_I2C_FREQ_MAX);
+        return -1;
+    }
+
+    bus->freq = freq;
+    bus->half = (500000 + freq - 1) / freq;
+
+    return 0;
+}
+
+
+
+// Write the same data to the I2C slave with the given address on all buses.
+// The buses that received a NACK are returned in nack, if not NULL.
+int gpio_i2c_write(struct gpio_i2c *bus, int i2c_dev_adr, char *data, int size, int *nack)
+{
+    int status;
+    struct gpio_i2c_msg msg;
+    struct gpio_i2c_xfer xfer;
+
+    memset(&msg, 0, sizeof(struct gpio_i2c_msg));
+    msg.adr = i2c_dev_adr;
+    msg.flags = 0;
+    msg.len = size;
+    msg.buf[0] = data;
+    xfer.msgs = &msg;
+    xfer.num = 1;
+    xfer.delay = 0;
+    xfer.nack = 0;
+    status = gpio_i2c_transfer_batch(bus, &xfer, 1);
+    if(nack != NULL)
+        *nack = xfer.nack;
+
+    return status;
+}
+
+
+
+// Read data from the I2C slave with the given address on all buses. The data
+// of bus i is stored in data[i].
+int gpio_i2c_read(struct gpio_i2c *bus, int i2c_dev_adr, char **data, int size, int *nack)
+{
+    int i;
+    int status;
+    struct gpio_i2c_msg msg;
+    struct gpio_i2c_xfer xfer;
+
+    if(bus == NULL) return -1;
+
+    memset(&msg, 0, sizeof(struct gpio_i2c_msg));
+    msg.adr = i2c_dev_adr;
+    msg.flags = GPIO_I2C_M_RD;
+    msg.len = size;
+    for(i = 0; i < bus->num; i++)
+        msg.buf[i] = data[i];
+    xfer.msgs = &msg;
+    xfer.num = 1;
+    xfer.delay = 0;
+    xfer.nack = 0;
+    status = gpio_i2c_transfer_batch(bus, &xfer, 1);
+    if(nack != NULL)
+        *nack = xfer.nack;
+
+    return status;
+}
+
+
+
+// Execute several independent I2C transactions on all buses in one USB
+// transfer. Each transaction consists of messages separated by repeated start
+// conditions. The result of each transaction is stored in its nack and status
+// fields. Returns 0 if all transactions succeeded on all buses.
+int gpio_i2c_transfer_batch(struct gpio_i2c *bus, struct gpio_i2c_xfer *xfers, int num)
+{
+    int i, j;
+    int status;
+    int count = 0;
+    struct gpio_i2c_batch_job job;
+
+    if(bus == NULL || bus->adapter == NULL) {
+        fprintf(stderr, "%s: %s: %sThe multi-bus I2C was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    if(xfers == NULL || num <= 0) return -1;
+
+    // Check the transactions and count the samples.
+    for(i = 0; i < num; i++) {
+        xfers[i].nack = 0;
+        xfers[i].status = 0;
+        if(xfers[i].msgs == NULL || xfers[i].num <= 0) return -1;
+        for(j = 0; j < xfers[i].num; j++) {
+            if(xfers[i].msgs[j].adr < 0 || xfers[i].msgs[j].adr > 0x7f || xfers[i].msgs[j].len < 0 ||
+               (!(xfers[i].msgs[j].flags & GPIO_I2C_M_RD) && xfers[i].msgs[j].len > 0 && xfers[i].msgs[j].buf[0] == NULL)) {
+                if(bus->adapter->verbose)
+                    fprintf(stderr, "%s: %s: %sInvalid I2C message %d of transaction %d.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, j, i);
+                return -1;
+            }
+            count += 1 + ((xfers[i].msgs[j].flags & GPIO_I2C_M_RD) ? 8 : 1) * xfers[i].msgs[j].len;
+        }
+    }
+
+    job.bus = bus;
+    job.xfers = xfers;
+    job.num = num;
+    job.count = 0;
+    job.samples = calloc(2 * count, 1);
+    if(job.samples == NULL) {
+        fprintf(stderr, "%s: %s: %sCannot allocate memory for %d I2C bit samples.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, count);
+        return -1;
+    }
+    status = mpsse_adapter_run(bus->adapter, gpio_i2c_build_batch, &job);
+    if(status) {
+        if(bus->adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to execute a batch of %d I2C transaction(s).\n", __FILE__, __FUNCTION__, PREFIX_ERROR, num);
+        free(job.samples);
+        return -1;
+    }
+
+    // Extract the data and ACK bits of all buses from the samples.
+    gpio_i2c_decode(bus, &job);
+    free(job.samples);
+    for(i = 0; i < num; i++) {
+        if(!xfers[i].nack) continue;
+        xfers[i].status = -1;
+        status = -1;
+        if(bus->adapter->verbose)
+            fprintf(stderr, "%s: %s: %sNACK of I2C transaction %d to address 0x%02x on the bus(es) 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i, xfers[i].msgs[0].adr, xfers[i].nack);
+    }
+
+    return status;
+}
+
+
+
+// Get the low and high byte MPSSE pins of a GPIO pin.
+static int gpio_i2c_pin(int gpio, unsigned char *low, unsigned char *high)
+{
+    *low = 0;
+    *high = 0;
+    if(gpio_mpsse_pin[gpio] < NUM_GPIOL_PINS)
+        *low = GPIO0 << gpio_mpsse_pin[gpio];
+    else
+        *high = 1 << (gpio_mpsse_pin[gpio] - NUM_GPIOL_PINS);
+
+    return 0;
+}
+
+
+
+// Check that the pins of the buses are not used by another engine. GPIOL3 is
+// the RTCK input of the adaptive clocking.
+// CAUTION: Must only be called from a build function!
+static int gpio_i2c_check_pins(struct mpsse_adapter *adapter, struct gpio_i2c *bus)
+{
+    if(adapter->adaptive && ((bus->scl_low | bus->sda_low_all) & GPIO3)) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sGPIOL3 is used as RTCK for I2C clock stretching and cannot be used for a multi-bus I2C bus.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Extract the data and ACK bits of all buses from the samples, in the order
+// they were taken.
+static void gpio_i2c_decode(struct gpio_i2c *bus, struct gpio_i2c_batch_job *job)
+{
+    int i, j, k, b, n = 0;
+    int byte;
+    struct gpio_i2c_msg *msg;
+    unsigned char *s;
+
+    for(i = 0; i < job->num; i++) {
+        for(j = 0; j < job->xfers[i].num; j++) {
+            msg = &job->xfers[i].msgs[j];
+            for(k = -1; k < msg->len; k++) {
+                for(b = 0; b < bus->num; b++) {
+                    if(k >= 0 && (msg->flags & GPIO_I2C_M_RD)) {
+                        // Data byte read, MSB first.
+                        s = &job->samples[2 * n];
+                        for(byte = 0; s < &job->samples[2 * (n + 8)]; s += 2)
+                            byte = (byte << 1) | (((s[0] & bus->sda_low[b]) || (s[1] & bus->sda_high[b])) ? 1 : 0);
+                        if(msg->buf[b] != NULL)
+                            msg->buf[b][k] = byte;
+                    } else {
+                        // ACK of the address or of a data byte written.
+                        s = &job->samples[2 * n];
+                        if((s[0] & bus->sda_low[b]) || (s[1] & bus->sda_high[b]))
+                            job->xfers[i].nack |= 1 << b;
+                    }
+                }
+                n += (k >= 0 && (msg->flags & GPIO_I2C_M_RD)) ? 8 : 1;
+            }
+        }
+    }
+}
+
+
+
+// Pull the selected low and high byte pins low (drive = 1) or release them
+// (drive = 0).
+static int gpio_i2c_build_set(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, unsigned char low, unsigned char low_drive, unsigned char high, unsigned char high_drive)
+{
+    int status = 0;
+
+    if(low)
+        status |= mpsse_adapter_set_low(adapter, cmd, 0x00, low_drive, low);
+    if(high)
+        status |= mpsse_adapter_set_high(adapter, cmd, 0x00, high_drive, high);
+
+    return status;
+}
+
+
+
+// Build setting SCL of all buses.
+static int gpio_i2c_build_scl(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, struct gpio_i2c *bus, int level)
+{
+    return gpio_i2c_build_set(adapter, cmd, bus->scl_low, level ? 0x00 : 0xff, bus->scl_high, level ? 0x00 : 0xff);
+}
+
+
+
+// Build setting SDA of each bus. Bit i of levels is the level of bus i.
+static int gpio_i2c_build_sda(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, struct gpio_i2c *bus, int levels)
+{
+    int b;
+    unsigned char low = 0, high = 0;
+
+    for(b = 0; b < bus->num; b++) {
+        if((levels >> b) & 0x1) continue;
+        low |= bus->sda_low[b];
+        high |= bus->sda_high[b];
+    }
+
+    return gpio_i2c_build_set(adapter, cmd, bus->sda_low_all, low, bus->sda_high_all, high);
+}
+
+
+
+// Build sampling the SDA pins.
+static int gpio_i2c_build_sample(struct mpsse_cmd *cmd, struct gpio_i2c *bus, struct gpio_i2c_batch_job *job)
+{
+    int status = 0;
+
+    if(bus->sda_low_all) {
+        status |= mpsse_cmd_read(cmd, &job->samples[2 * job->count], 1, NULL);
+        status |= mpsse_cmd_byte(cmd, GET_BITS_LOW);
+    }
+    if(bus->sda_high_all) {
+        status |= mpsse_cmd_read(cmd, &job->samples[2 * job->count + 1], 1, NULL);
+        status |= mpsse_cmd_byte(cmd, GET_BITS_HIGH);
+    }
+    job->count++;
+
+    return status;
+}
+
+
+
+// Build one bit on all buses: SDA is set while SCL is low, then SCL is high
+// for one half period, optionally sampling SDA at its end.
+static int gpio_i2c_build_bit(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, struct gpio_i2c_batch_job *job, int levels, int sample)
+{
+    int status = 0;
+    struct gpio_i2c *bus = job->bus;
+
+    status |= gpio_i2c_build_sda(adapter, cmd, bus, levels);
+    status |= mpsse_adapter_delay(adapter, cmd, bus->half);
+    status |= gpio_i2c_build_scl(adapter, cmd, bus, 1);
+    status |= mpsse_adapter_delay(adapter, cmd, bus->half);
+    if(sample)
+        status |= gpio_i2c_build_sample(cmd, bus, job);
+    status |= gpio_i2c_build_scl(adapter, cmd, bus, 0);
+
+    return status;
+}
+
+
+
+// Build one byte on all buses with the ACK bit. Byte index -1 is the address
+// byte.
+static int gpio_i2c_build_byte(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, struct gpio_i2c_batch_job *job, struct gpio_i2c_msg *msg, int index)
+{
+    int i, b;
+    int status = 0;
+    int levels;
+    int all = (1 << job->bus->num) - 1;
+    int data[GPIO_I2C_BUS_MAX];
+    char *buf;
+
+    // Read a byte, then ACK it, except for the last one.
+    if(index >= 0 && (msg->flags & GPIO_I2C_M_RD)) {
+        for(i = 0; i < 8; i++)
+            status |= gpio_i2c_build_bit(adapter, cmd, job, all, 1);
+        status |= gpio_i2c_build_bit(adapter, cmd, job, (index == msg->len - 1) ? all : 0, 0);
+        return status;
+    }
+
+    // Write the address or a data byte of each bus, then sample the ACK.
+    for(b = 0; b < job->bus->num; b++) {
+        buf = (msg->buf[b] != NULL) ? msg->buf[b] : msg->buf[0];
+        data[b] = (index < 0) ? ((msg->adr << 1) | ((msg->flags & GPIO_I2C_M_RD) ? 1 : 0)) : (unsigned char) buf[index];
+    }
+    for(i = 7; i >= 0; i--) {
+        for(b = 0, levels = 0; b < job->bus->num; b++)
+            levels |= ((data[b] >> i) & 0x1) << b;
+        status |= gpio_i2c_build_bit(adapter, cmd, job, levels, 0);
+    }
+    status |= gpio_i2c_build_bit(adapter, cmd, job, all, 1);
+
+    return status;
+}
+
+
+
+// Build the I2C transactions of a batch job.
+static int gpio_i2c_build_batch(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    int i, j, k;
+    int status = 0;
+    struct gpio_i2c_batch_job *job = (struct gpio_i2c_batch_job *) arg;
+    struct gpio_i2c *bus = job->bus;
+    struct gpio_i2c_xfer *xfer;
+    int all = (1 << bus->num) - 1;
+    int adaptive = adapter->adaptive;
+
+    if(gpio_i2c_check_pins(adapter, bus)) return -1;
+
+    // The delays clock SK, so disable adaptive clocking, which would wait for
+    // RTCK on each clock pulse.
+    if(adaptive)
+        status |= mpsse_adapter_set_adaptive(adapter, cmd, 0);
+
+    job->count = 0;
+    for(i = 0; i < job->num; i++) {
+        xfer = &job->xfers[i];
+        for(j = 0; j < xfer->num; j++) {
+            // Start or repeated start condition.
+            if(j > 0) {
+                status |= gpio_i2c_build_sda(adapter, cmd, bus, all);
+                status |= mpsse_adapter_delay(adapter, cmd, bus->half);
+                status |= gpio_i2c_build_scl(adapter, cmd, bus, 1);
+                status |= mpsse_adapter_delay(adapter, cmd, bus->half);
+            }
+            status |= gpio_i2c_build_sda(adapter, cmd, bus, 0);
+            status |= mpsse_adapter_delay(adapter, cmd, bus->half);
+            status |= gpio_i2c_build_scl(adapter, cmd, bus, 0);
+            // Address and data bytes.
+            for(k = -1; k < xfer->msgs[j].len; k++)
+                status |= gpio_i2c_build_byte(adapter, cmd, job, &xfer->msgs[j], k);
+        }
+        // Stop condition.
+        status |= gpio_i2c_build_sda(adapter, cmd, bus, 0);
+        status |= mpsse_adapter_delay(adapter, cmd, bus->half);
+        status |= gpio_i2c_build_scl(adapter, cmd, bus, 1);
+        status |= mpsse_adapter_delay(adapter, cmd, bus->half);
+        status |= gpio_i2c_build_sda(adapter, cmd, bus, all);
+        status |= mpsse_adapter_delay(adapter, cmd, bus->half);
+        status |= mpsse_adapter_delay(adapter, cmd, xfer->delay);
+        if(status) break;
+    }
+
+    // Enable adaptive clocking again for the I2C engine.
+    if(adaptive)
+        status |= mpsse_adapter_set_adaptive(adapter, cmd, 1);
+
+    return status ? -1 : 0;
+}
+
+
+
+// Build releasing all I2C lines.
+static int gpio_i2c_build_idle(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    struct gpio_i2c *bus = ((struct gpio_i2c_idle_job *) arg)->bus;
+
+    if(gpio_i2c_check_pins(adapter, bus)) return -1;
+
+    return gpio_i2c_build_set(adapter, cmd, bus->scl_low | bus->sda_low_all, 0x00, bus->scl_high | bus->sda_high_all, 0x00) ? -1 : 0;
+}
+
@@ -0,0 +1,80 @@
+// File: gpio_i2c.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for the lockstep multi-bus bit-banged I2C functions on top of
+// the hardware GPIO IO functions.
+//
+
+
+
+#ifndef __GPIO_I2C_H
+#define __GPIO_I2C_H
+
+
+
+#include "gpio_mpsse.h"
+
+
+
+// Maximum number of I2C buses, each using two of the 12 GPIO pins.
+#define GPIO_I2C_BUS_MAX            (GPIO_MPSSE_PIN_COUNT / 2)
+
+// I2C frequencies. The SCL half period is rounded up to whole microseconds.
+#define GPIO_I2C_FREQ_DEFAULT       100000
+#define GPIO_I2C_FREQ_MAX           400000
+
+// I2C message flags.
+#define GPIO_I2C_M_RD               0x0001  // Read data from the I2C slaves.
+
+
+
+// I2C message, transferred on all buses in lockstep. Each bus has its own
+// data buffer. For a write, a NULL buffer sends the data of bus 0. For a read,
+// a NULL buffer discards the data.
+struct gpio_i2c_msg {
+    int adr;                    // 7-bit I2C device address, the same on all buses.
+    int flags;                  // GPIO_I2C_M_* flags.
+    int len;                    // Number of data bytes.
+    char *buf[GPIO_I2C_BUS_MAX];    // Data buffer of each bus.
+};
+
+// I2C transaction, used for executing several independent transactions in
+// one USB transfer.
+struct gpio_i2c_xfer {
+    struct gpio_i2c_msg *msgs;  // Messages of the transaction.
+    int num;                    // Number of messages.
+    int delay;                  // Delay in us after the transaction, timed by the MPSSE.
+    int nack;                   // Result: buses that received a NACK (bit mask).
+    int status;                 // Result: 0 = OK, -1 = NACK received on any bus.
+};
+
+// Set of I2C buses clocked in lockstep.
+struct gpio_i2c {
+    struct mpsse_adapter *adapter;
+    int num;                    // Number of buses.
+    int scl[GPIO_I2C_BUS_MAX];  // GPIO pin of SCL of each bus.
+    int sda[GPIO_I2C_BUS_MAX];  // GPIO pin of SDA of each bus.
+    int freq;                   // I2C frequency.
+    int half;                   // SCL half period in us.
+    // MPSSE pins of the buses in the low and high byte.
+    unsigned char scl_low, scl_high;
+    unsigned char sda_low[GPIO_I2C_BUS_MAX], sda_high[GPIO_I2C_BUS_MAX];
+    unsigned char sda_low_all, sda_high_all;
+};
+
+
+
+// Function prototypes.
+int gpio_i2c_init(struct gpio_i2c *bus, struct mpsse_adapter *adapter, int num, const int *scl, const int *sda);
+int gpio_i2c_set_freq(struct gpio_i2c *bus, int freq);
+int gpio_i2c_write(struct gpio_i2c *bus, int i2c_dev_adr, char *data, int size, int *nack);
+int gpio_i2c_read(struct gpio_i2c *bus, int i2c_dev_adr, char **data, int size, int *nack);
+int gpio_i2c_transfer_batch(struct gpio_i2c *bus, struct gpio_i2c_xfer *xfers, int num);
+
+
+
+#endif
+
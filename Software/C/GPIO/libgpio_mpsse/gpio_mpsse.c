@@ -1,182 +1,446 @@
-// File: gpio_mpsse.c
-// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
-// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
-// Date: 16 Feb 2018
-// Rev.: 16 Feb 2018
-//
-// Basic hardware GPIO functions based on FTDI's Multi-Protocol Synchronous
-// Serial Engine (MPSSE).
-//
-
-
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <mpsse.h>
-#include "gpio_mpsse.h"
-
-
-
-// Global variables.
-struct mpsse_context *gpio_mpsse = NULL;
-int gpio_mpsse_verbose = 1;
-
-// GPIO pin list.
-#define GPIO_MPSSE_PIN_COUNT (4 + 8)
-const int gpio_mpsse_pin[] =
-{
-    GPIOL0,
-    GPIOL1,
-    GPIOL2,
-    GPIOL3,
-    GPIOH0,
-    GPIOH1,
-    GPIOH2,
-    GPIOH3,
-    GPIOH4,
-    GPIOH5,
-    GPIOH6,
-    GPIOH7
-};
-
-
-
-// Initialize the GPIO hardware.
-// CAUTION: Calling gpio_init() resets all GPIO output levels to low!
-int gpio_init(void)
-{
-    // Check if the GPIO device was already initialized.
-    if(gpio_mpsse != NULL) return 0;
-
-    // Open the GPIO device with default frequency of 100 kHz.
-    if(!((gpio_mpsse = MPSSE(GPIO, 0, 0)) != NULL && gpio_mpsse->open))
-    {
-        fprintf(stderr, "%s: %s: %sFailed to initialize MPSSE: %s\n", __FILE__, __FUNCTION__, PREFIX_ERROR, ErrorString(gpio_mpsse));
-        return -1;
-    }
-
-    return 0;
-}
-
-
-
-// Reset the GPIO hardware.
-int gpio_reset(void)
-{
-    // This is a dummy function, no operation.
-    return 0;
-}
-
-
-
-// Close the GPIO hardware.
-// CAUTION: After calling gpio_close(), all GPIO pins will be set to high!
-int gpio_close(void)
-{
-    Close(gpio_mpsse);
-    gpio_mpsse = NULL;
-
-    return 0;
-}
-
-
-
-// Get information about the GPIO device.
-int gpio_info(void)
-{
-    // Check if the GPIO device was initialized.
-    if(gpio_mpsse == NULL) {
-        if(gpio_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sThe GPIO device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
-        return -1;
-    }
-
-    printf("GPIO master device: %s\n", GetDescription(gpio_mpsse));
-    printf("GPIO master device VID: 0x%04x\n", GetVid(gpio_mpsse));
-    printf("GPIO master device PID: 0x%04x\n", GetPid(gpio_mpsse));
-
-    return 0;
-}
-
-
-
-// Set verbosity of the GPIO functions.
-int gpio_set_verbose(int verbose)
-{
-    gpio_mpsse_verbose = verbose;
-    return 0;
-}
-
-
-
-// Set the output levels of the GPIO pins.
-int gpio_set_pins(int gpio_data, int gpio_mask)
-{
-    int i;
-    int status;
-
-    // Check if the GPIO device was initialized.
-    if(gpio_mpsse == NULL) {
-        if(gpio_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sThe GPIO device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
-        return 1;
-    }
-
-    // Loop over all GPIO pins.
-    for(i = 0; i < GPIO_MPSSE_PIN_COUNT; i++) {
-        // GPIO pin selected.
-        if(((gpio_mask >> i) & 0x1) == 1) {
-            // Set GPIO pin low or high, according to data value.
-            if(((gpio_data >> i) & 0x1) == 0)
-                status = PinLow(gpio_mpsse, gpio_mpsse_pin[i]);
-            else
-                status = PinHigh(gpio_mpsse, gpio_mpsse_pin[i]);
-            if(status) {
-                if(gpio_mpsse_verbose)
-                    fprintf(stderr, "%s: %s: %sUnable to set the output level of GPIO pin %d.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i);
-                return 1;
-            }
-        }
-    }
-
-    return 0;
-}
-
-
-
-// Get the input levels of the GPIO pins.
-// CAUTION: Only the state of the first 4 GPIO pins (GPIOL0..GPIOL3) can be
-//          read! All other states will always read 0!
-int gpio_get_pins(int *gpio_data)
-{
-    int i;
-    int status;
-    int gpio_data_tmp;
-
-    // Check if the GPIO device was initialized.
-    if(gpio_mpsse == NULL) {
-        if(gpio_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sThe GPIO device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
-        return 1;
-    }
-
-    // Loop over all GPIO pins.
-    gpio_data_tmp = 0;
-    for(i = 0; i < GPIO_MPSSE_PIN_COUNT; i++) {
-        // Get the state of the current pin.
-        status = PinState(gpio_mpsse, gpio_mpsse_pin[i], -1);
-        if(status < 0) {
-            if(gpio_mpsse_verbose)
-                fprintf(stderr, "%s: %s: %sUnable to get the input level of GPIO pin %d.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i);
-            return status;
-        }
-        // Store the current input level
-        gpio_data_tmp |= (status & 0x1) << i;
-    }
-
-    *gpio_data = gpio_data_tmp;
-
-    return 0;
-}
-
+// File: gpio_mpsse.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 16 Feb 2018
+// Rev.: 19 Oct 2026
+//
+// Basic hardware GPIO functions based on FTDI's Multi-Protocol Synchronous
+// Serial Engine (MPSSE).
+//
+// The GPIO accesses are executed through the MPSSE adapter layer, so an
+// adapter may be shared by any number of threads. If the I2C functions are
+// used in the same process, they share the adapter with the GPIO functions.
+// GPIO pin changes can then be deferred with gpio_queue_pins(), so that they
+// are sent in the same USB transfer as the next I2C transaction.
+// Delays queued with gpio_queue_delay() between them are timed by the MPSSE,
+// e.g. for a reset pulse followed by the configuration of the device:
+//   gpio_queue_pins(0x000, 0x001);     // Assert the reset.
+//   gpio_queue_delay(100);             // 100 us reset pulse.
+//   gpio_queue_pins(0x001, 0x001);     // Release the reset.
+//   gpio_queue_delay(10000);           // 10 ms until the device is ready.
+//   i2c_write(...);                    // One USB transfer for all.
+//
+// In attach mode (gpio_attach(), gpio_mpsse_attach()), the GPIO pins keep
+// their states across program invocations. Closing leaves the device in MPSSE
+// mode and records the pin states. The next program attaching to the device
+// reads back the pin levels instead of resetting the device, so no pin
+// glitches and the MPSSE set up is skipped.
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <mpsse.h>
+#include "mpsse_adapter.h"
+#include "gpio_mpsse.h"
+
+
+
+// GPIO pin access job.
+struct gpio_mpsse_job {
+    int data;
+    int mask;
+    unsigned char pins[2];      // Levels of the low and high byte pins read back.
+};
+
+
+
+// Global variables.
+// Default GPIO adapter used by the non-reentrant functions.
+static struct mpsse_adapter *gpio_mpsse = NULL;
+static pthread_mutex_t gpio_mpsse_init_lock = PTHREAD_MUTEX_INITIALIZER;
+static int gpio_mpsse_verbose = 1;
+
+// GPIO pin list.
+const int gpio_mpsse_pin[] =
+{
+    GPIOL0,
+    GPIOL1,
+    GPIOL2,
+    GPIOL3,
+    GPIOH0,
+    GPIOH1,
+    GPIOH2,
+    GPIOH3,
+    GPIOH4,
+    GPIOH5,
+    GPIOH6,
+    GPIOH7
+};
+
+
+
+// Function prototypes.
+static int gpio_mpsse_build_set_pins(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int gpio_mpsse_build_get_pins(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+
+
+
+// Initialize the GPIO hardware.
+// CAUTION: Calling gpio_init() resets all GPIO output levels to low!
+int gpio_init(void)
+{
+    pthread_mutex_lock(&gpio_mpsse_init_lock);
+
+    // Open the default GPIO device, if it was not yet initialized.
+    if(gpio_mpsse == NULL) {
+        gpio_mpsse = gpio_mpsse_open();
+        if(gpio_mpsse != NULL)
+            gpio_mpsse_set_verbose(gpio_mpsse, gpio_mpsse_verbose);
+    }
+
+    pthread_mutex_unlock(&gpio_mpsse_init_lock);
+
+    return (gpio_mpsse == NULL) ? -1 : 0;
+}
+
+
+
+// Attach to the GPIO hardware. The GPIO pins keep the states they were left
+// in by the last program using attach mode, also when closing.
+int gpio_attach(void)
+{
+    pthread_mutex_lock(&gpio_mpsse_init_lock);
+
+    // Attach to the default GPIO device, if it was not yet initialized.
+    if(gpio_mpsse == NULL) {
+        gpio_mpsse = gpio_mpsse_attach();
+        if(gpio_mpsse != NULL)
+            gpio_mpsse_set_verbose(gpio_mpsse, gpio_mpsse_verbose);
+    }
+
+    pthread_mutex_unlock(&gpio_mpsse_init_lock);
+
+    return (gpio_mpsse == NULL) ? -1 : 0;
+}
+
+
+
+// Reset the GPIO hardware.
+int gpio_reset(void)
+{
+    // This is a dummy function, no operation.
+    return 0;
+}
+
+
+
+// Close the GPIO hardware.
+// CAUTION: Unless attached with gpio_attach(), all GPIO pins will be set to
+// high after calling gpio_close()!
+int gpio_close(void)
+{
+    pthread_mutex_lock(&gpio_mpsse_init_lock);
+    gpio_mpsse_close(gpio_mpsse);
+    gpio_mpsse = NULL;
+    pthread_mutex_unlock(&gpio_mpsse_init_lock);
+
+    return 0;
+}
+
+
+
+// Get information about the GPIO device.
+int gpio_info(void)
+{
+    return gpio_mpsse_info(gpio_mpsse);
+}
+
+
+
+// Set verbosity of the GPIO functions.
+int gpio_set_verbose(int verbose)
+{
+    gpio_mpsse_verbose = verbose;
+    if(gpio_mpsse != NULL)
+        gpio_mpsse_set_verbose(gpio_mpsse, verbose);
+    return 0;
+}
+
+
+
+// Set the output levels of the GPIO pins.
+int gpio_set_pins(int gpio_data, int gpio_mask)
+{
+    return gpio_mpsse_set_pins(gpio_mpsse, gpio_data, gpio_mask);
+}
+
+
+
+// Get the input levels of the GPIO pins.
+int gpio_get_pins(int *gpio_data)
+{
+    return gpio_mpsse_get_pins(gpio_mpsse, gpio_data);
+}
+
+
+
+// Queue setting the output levels of the GPIO pins. The pins are set at the
+// beginning of the next USB transfer on the adapter.
+int gpio_queue_pins(int gpio_data, int gpio_mask)
+{
+    return gpio_mpsse_queue_pins(gpio_mpsse, gpio_data, gpio_mask);
+}
+
+
+
+// Queue a delay, timed by the MPSSE. It is executed at the beginning of the
+// next USB transfer on the adapter, after the pin changes queued before.
+int gpio_queue_delay(int usec)
+{
+    return gpio_mpsse_queue_delay(gpio_mpsse, usec);
+}
+
+
+
+// Get the default GPIO adapter.
+struct mpsse_adapter *gpio_get_adapter(void)
+{
+    return gpio_mpsse;
+}
+
+
+
+// Open a GPIO adapter.
+// If the adapter is already used by the I2C functions, the GPIO functions
+// share it and the GPIO output levels are kept.
+// CAUTION: Opening a new GPIO adapter resets all GPIO output levels to low!
+struct mpsse_adapter *gpio_mpsse_open(void)
+{
+    return mpsse_adapter_open(GPIO, 0, 0);
+}
+
+
+
+// Open a GPIO adapter on an interface (IFACE_A .. IFACE_D) of the FTDI device
+// with the given serial number, NULL for the first device found. The GPIO pins
+// of the interfaces of an FT2232H or FT4232H can be used from different
+// threads in parallel.
+struct mpsse_adapter *gpio_mpsse_open_if(const char *serial, int interface)
+{
+    return mpsse_adapter_open_if(GPIO, 0, 0, serial, interface);
+}
+
+
+
+// Attach to a GPIO adapter. If the device was left in MPSSE mode by a previous
+// attached GPIO adapter, the pin states are read back and kept. Otherwise, the
+// device is set up like with gpio_mpsse_open(). Closing the adapter leaves all
+// pins unchanged.
+struct mpsse_adapter *gpio_mpsse_attach(void)
+{
+    return mpsse_adapter_attach(GPIO, 0, 0);
+}
+
+
+
+// Close a GPIO adapter.
+// CAUTION: Unless attached, all GPIO pins will be set to high after closing a
+// GPIO adapter!
+int gpio_mpsse_close(struct mpsse_adapter *adapter)
+{
+    mpsse_adapter_close(adapter);
+
+    return 0;
+}
+
+
+
+// Get information about a GPIO adapter.
+int gpio_mpsse_info(struct mpsse_adapter *adapter)
+{
+    // Check if the GPIO device was initialized.
+    if(adapter == NULL) {
+        if(gpio_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe GPIO device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    printf("GPIO master device: %s\n", GetDescription(adapter->mpsse));
+    printf("GPIO master device VID: 0x%04x\n", GetVid(adapter->mpsse));
+    printf("GPIO master device PID: 0x%04x\n", GetPid(adapter->mpsse));
+
+    return 0;
+}
+
+
+
+// Set verbosity of the GPIO functions operating on a GPIO adapter.
+int gpio_mpsse_set_verbose(struct mpsse_adapter *adapter, int verbose)
+{
+    if(adapter == NULL) return -1;
+
+    adapter->verbose = verbose;
+
+    return 0;
+}
+
+
+
+// Set the output levels of the GPIO pins.
+int gpio_mpsse_set_pins(struct mpsse_adapter *adapter, int gpio_data, int gpio_mask)
+{
+    int status;
+    struct gpio_mpsse_job job;
+
+    // Check if the GPIO device was initialized.
+    if(adapter == NULL) {
+        if(gpio_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe GPIO device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return 1;
+    }
+
+    // Set all selected GPIO pins at once.
+    job.data = gpio_data;
+    job.mask = gpio_mask;
+    status = mpsse_adapter_run(adapter, gpio_mpsse_build_set_pins, &job);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to set the output levels of the GPIO pins to 0x%03x with mask 0x%03x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, gpio_data, gpio_mask);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+// Queue setting the output levels of the GPIO pins. The pins are set at the
+// beginning of the next USB transfer on the adapter, e.g. right before the next
+// I2C transaction.
+int gpio_mpsse_queue_pins(struct mpsse_adapter *adapter, int gpio_data, int gpio_mask)
+{
+    int status;
+    struct gpio_mpsse_job job;
+
+    // Check if the GPIO device was initialized.
+    if(adapter == NULL) {
+        if(gpio_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe GPIO device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return 1;
+    }
+
+    job.data = gpio_data;
+    job.mask = gpio_mask;
+    status = mpsse_adapter_defer(adapter, gpio_mpsse_build_set_pins, &job);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to queue the output levels 0x%03x with mask 0x%03x of the GPIO pins.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, gpio_data, gpio_mask);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+// Queue a delay, timed by the MPSSE. It is executed at the beginning of the
+// next USB transfer on the adapter, after the pin changes queued before.
+// CAUTION: ADBUS0 toggles during the delay, see mpsse_adapter_delay()!
+int gpio_mpsse_queue_delay(struct mpsse_adapter *adapter, int usec)
+{
+    int status;
+
+    // Check if the GPIO device was initialized.
+    if(adapter == NULL) {
+        if(gpio_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe GPIO device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return 1;
+    }
+
+    status = mpsse_adapter_queue_delay(adapter, usec);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to queue a delay of %d us.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, usec);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+// Get the input levels of the GPIO pins.
+// The levels of all 12 GPIO pins are read back, for output pins this is the
+// level driven by the FT232H.
+int gpio_mpsse_get_pins(struct mpsse_adapter *adapter, int *gpio_data)
+{
+    int status;
+    struct gpio_mpsse_job job;
+
+    // Check if the GPIO device was initialized.
+    if(adapter == NULL) {
+        if(gpio_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe GPIO device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return 1;
+    }
+
+    // Read the low and the high byte pins.
+    status = mpsse_adapter_run(adapter, gpio_mpsse_build_get_pins, &job);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to get the input levels of the GPIO pins.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return 1;
+    }
+
+    // GPIOL0..GPIOL3 are located at ADBUS4..ADBUS7, GPIOH0..GPIOH7 at
+    // ACBUS0..ACBUS7.
+    *gpio_data = ((job.pins[0] >> 4) & 0x00f) | ((job.pins[1] << 4) & 0xff0);
+
+    return 0;
+}
+
+
+
+// Build the setting of the GPIO pin output levels.
+static int gpio_mpsse_build_set_pins(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    int i;
+    int status = 0;
+    unsigned char low = 0, low_mask = 0;
+    unsigned char high = 0, high_mask = 0;
+    struct gpio_mpsse_job *job = (struct gpio_mpsse_job *) arg;
+
+    // Map the GPIO pins to the low and high byte pins.
+    for(i = 0; i < GPIO_MPSSE_PIN_COUNT; i++) {
+        // GPIO pin selected.
+        if(((job->mask >> i) & 0x1) == 0) continue;
+        if(gpio_mpsse_pin[i] < NUM_GPIOL_PINS) {
+            low_mask |= GPIO0 << gpio_mpsse_pin[i];
+            if(((job->data >> i) & 0x1) == 1)
+                low |= GPIO0 << gpio_mpsse_pin[i];
+        } else {
+            high_mask |= 1 << (gpio_mpsse_pin[i] - NUM_GPIOL_PINS);
+            if(((job->data >> i) & 0x1) == 1)
+                high |= 1 << (gpio_mpsse_pin[i] - NUM_GPIOL_PINS);
+        }
+    }
+
+    // Set the GPIO pins, keeping the pin directions.
+    if(low_mask)
+        status |= mpsse_adapter_set_low(adapter, cmd, low, adapter->pins.low_dir, low_mask);
+    if(high_mask)
+        status |= mpsse_adapter_set_high(adapter, cmd, high, adapter->pins.high_dir, high_mask);
+
+    return status ? -1 : 0;
+}
+
+
+
+// Build the reading of the GPIO pin levels.
+static int gpio_mpsse_build_get_pins(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    int status = 0;
+    struct gpio_mpsse_job *job = (struct gpio_mpsse_job *) arg;
+
+    status |= mpsse_cmd_read(cmd, &job->pins[0], 1, NULL);
+    status |= mpsse_cmd_byte(cmd, GET_BITS_LOW);
+    status |= mpsse_cmd_read(cmd, &job->pins[1], 1, NULL);
+    status |= mpsse_cmd_byte(cmd, GET_BITS_HIGH);
+
+    return status ? -1 : 0;
+}
+
@@ -1,36 +1,62 @@
-// File: gpio_mpsse.h
-// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
-// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
-// Date: 16 Feb 2018
-// Rev.: 16 Feb 2018
-//
-// Header file for the basic hardware GPIO IO functions based on FTDI's
-// Multi-Protocol Synchronous Serial Engine (MPSSE).
-//
-
-
-
-#ifndef __GPIO_MPSSE_H
-#define __GPIO_MPSSE_H
-
-
-
-// Message prefixes.
-#define PREFIX_DEBUG            "DEBUG: "
-#define PREFIX_ERROR            "ERROR: "
-
-
-
-// Function prototypes.
-int gpio_init(void);
-int gpio_reset(void);
-int gpio_close(void);
-int gpio_info(void);
-int gpio_set_verbose(int verbose);
-int gpio_set_pins(int gpio_data, int gpio_mask);
-int gpio_get_pins(int *gpio_data);
-
-
-
-#endif
-
+// File: gpio_mpsse.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 16 Feb 2018
+// Rev.: 19 Oct 2026
+//
+// Header file for the basic hardware GPIO IO functions based on FTDI's
+// Multi-Protocol Synchronous Serial Engine (MPSSE).
+//
+
+
+
+#ifndef __GPIO_MPSSE_H
+#define __GPIO_MPSSE_H
+
+
+
+// Message prefixes.
+#define PREFIX_DEBUG            "DEBUG: "
+#define PREFIX_ERROR            "ERROR: "
+
+
+
+// GPIO pin list. GPIO pin i is located at the MPSSE pin gpio_mpsse_pin[i]:
+// GPIOL0..GPIOL3 at ADBUS4..ADBUS7, GPIOH0..GPIOH7 at ACBUS0..ACBUS7.
+#define GPIO_MPSSE_PIN_COUNT (4 + 8)
+extern const int gpio_mpsse_pin[];
+
+struct mpsse_adapter;
+
+
+
+// Function prototypes.
+// Functions operating on the default GPIO adapter.
+int gpio_init(void);
+int gpio_attach(void);
+int gpio_reset(void);
+int gpio_close(void);
+int gpio_info(void);
+int gpio_set_verbose(int verbose);
+int gpio_set_pins(int gpio_data, int gpio_mask);
+int gpio_get_pins(int *gpio_data);
+int gpio_queue_pins(int gpio_data, int gpio_mask);
+int gpio_queue_delay(int usec);
+struct mpsse_adapter *gpio_get_adapter(void);
+// Reentrant functions operating on an explicitly opened GPIO adapter. An
+// adapter may be shared by any number of threads.
+struct mpsse_adapter *gpio_mpsse_open(void);
+struct mpsse_adapter *gpio_mpsse_open_if(const char *serial, int interface);
+struct mpsse_adapter *gpio_mpsse_attach(void);
+int gpio_mpsse_close(struct mpsse_adapter *adapter);
+int gpio_mpsse_info(struct mpsse_adapter *adapter);
+int gpio_mpsse_set_verbose(struct mpsse_adapter *adapter, int verbose);
+int gpio_mpsse_set_pins(struct mpsse_adapter *adapter, int gpio_data, int gpio_mask);
+int gpio_mpsse_get_pins(struct mpsse_adapter *adapter, int *gpio_data);
+int gpio_mpsse_queue_pins(struct mpsse_adapter *adapter, int gpio_data, int gpio_mask);
+int gpio_mpsse_queue_delay(struct mpsse_adapter *adapter, int usec);
+
+
+
+#endif
+
@@ -0,0 +1,256 @@
+// File: i2c-eeprom.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// I2C EEPROM (24Cxx and compatible) programmer for the FTDI FH232H chip using
+// FTDI's Multi-Protocol Synchronous Serial Engine (MPSSE).
+//
+// Images are written page by page. The end of each write cycle is detected by
+// ACK polling, and pages that already contain the data are skipped. After
+// writing, the EEPROM contents are verified.
+//
+// FTDI FT232H pinning:
+// - ADBUS0(13): SCL
+// - ADBUS1(14): SDA output
+// - ADBUS2(15): SDA input (optional)
+//
+// On the FT232H, SDA is driven open drain and read on ADBUS1, so ADBUS1(14)
+// and ADBUS2(15) need not be tied together. On other FTDI chips, they *must*
+// be tied together! Otherwise, either no data will be driven onto SDA or only
+// a constant high signal level (i.e. NACK, 0xFF) will be received!
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <mpsse.h>
+#include "i2c-eeprom.h"
+
+
+
+// Function protoypes.
+int show_help(char* prog_name);
+int list_parts(void);
+double time_s(void);
+
+
+
+int main(int argc, char **argv)
+{
+    int i;
+    int status;
+    // I2C options.
+    int i2c_freq = ONE_HUNDRED_KHZ;
+    int i2c_strap = 0;
+    // EEPROM options.
+    char *eeprom_part_name;
+    int eeprom_adr;
+    char *eeprom_cmd;
+    char *eeprom_file_name;
+    int eeprom_offset = 0;
+    int eeprom_len = -1;
+    int eeprom_flags = 0;
+    struct i2c_eeprom eeprom;
+    const struct i2c_eeprom_part *eeprom_part;
+    // Data.
+    FILE *fp_eeprom_file;
+    char *data;
+    int data_len;
+    double time_start;
+
+    // Check command line arguments.
+    if(argc >= 2 && !strcmp(argv[1], "-l"))
+        return list_parts();
+    for(i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if(!strcmp(argv[i], "-t")) {
+            i2c_strap = 1;
+        } else if(!strcmp(argv[i], "-F")) {
+            eeprom_flags |= I2C_EEPROM_WRITE_FORCE;
+        } else if(!strcmp(argv[i], "-o") && i + 1 < argc) {
+            eeprom_offset = (int) strtoul(argv[++i], NULL, 0);
+        } else if(!strcmp(argv[i], "-n") && i + 1 < argc) {
+            eeprom_len = (int) strtoul(argv[++i], NULL, 0);
+        } else if(!strcmp(argv[i], "-s") && i + 1 < argc) {
+            i2c_freq = (int) strtoul(argv[++i], NULL, 0);
+        } else {
+            show_help(argv[0]);
+            return 1;
+        }
+    }
+    if(argc - i != 4) {
+        show_help(argv[0]);
+        return 1;
+    }
+    eeprom_part_name = argv[i];
+    eeprom_adr = (int)(strtoul(argv[i+1], NULL, 0) & 0x7f);
+    eeprom_cmd = argv[i+2];
+    eeprom_file_name = argv[i+3];
+    if(strcmp(eeprom_cmd, "read") && strcmp(eeprom_cmd, "write") && strcmp(eeprom_cmd, "verify")) {
+        printf("%sUnknown command \"%s\". Use read, write or verify.\n", PREFIX_ERROR, eeprom_cmd);
+        return 1;
+    }
+    eeprom_part = i2c_eeprom_find_part(eeprom_part_name);
+    if(eeprom_part == NULL) {
+        printf("%sUnknown EEPROM part \"%s\". Use -l to list the supported parts.\n", PREFIX_ERROR, eeprom_part_name);
+        return 1;
+    }
+    if(eeprom_offset < 0 || eeprom_offset >= eeprom_part->size) {
+        printf("%sThe offset 0x%05x exceeds the size of the %s of %d bytes.\n", PREFIX_ERROR, eeprom_offset, eeprom_part->name, eeprom_part->size);
+        return 1;
+    }
+    if(eeprom_len < 0 || eeprom_len > eeprom_part->size - eeprom_offset)
+        eeprom_len = eeprom_part->size - eeprom_offset;
+
+    // Get the data to write or to compare with.
+    data = malloc(eeprom_len);
+    if(data == NULL) {
+        printf("%sCannot allocate memory for %d byte(s).\n", PREFIX_ERROR, eeprom_len);
+        return 1;
+    }
+    data_len = eeprom_len;
+    if(strcmp(eeprom_cmd, "read")) {
+        fp_eeprom_file = fopen(eeprom_file_name, "rb");
+        if(fp_eeprom_file == NULL) {
+            printf("%sCannot open the image file \"%s\".\n", PREFIX_ERROR, eeprom_file_name);
+            free(data);
+            return 1;
+        }
+        data_len = fread(data, 1, eeprom_len, fp_eeprom_file);
+        fclose(fp_eeprom_file);
+        if(data_len <= 0) {
+            printf("%sThe image file \"%s\" is empty.\n", PREFIX_ERROR, eeprom_file_name);
+            free(data);
+            return 1;
+        }
+    }
+
+    // Initialize the I2C master device.
+    status = i2c_init();
+    if(status) {
+        printf("%sUnable to open the I2C device.\n", PREFIX_ERROR);
+        free(data);
+        return 1;
+    }
+    // Set the I2C bus frequency.
+    status = i2c_set_freq(i2c_freq);
+    if(status) {
+        printf("%sUnable to set the I2C frequency to %d Hz.\n", PREFIX_ERROR, i2c_freq);
+        i2c_close();
+        free(data);
+        return 1;
+    }
+    // Use the ADBUS1/ADBUS2 strap for reading.
+    if(i2c_strap && i2c_set_strap(1)) {
+        printf("%sUnable to set the I2C SDA strap.\n", PREFIX_ERROR);
+        i2c_close();
+        free(data);
+        return 1;
+    }
+    // Set verbosity of the I2C library functions.
+    i2c_set_verbose(1);
+
+    // Show device information.
+    #if DEBUG_LEVEL >= 1
+    i2c_info();
+    #endif
+
+    i2c_eeprom_init(&eeprom, i2c_get_adapter(), eeprom_adr, eeprom_part->name);
+    time_start = time_s();
+
+    // Read the EEPROM into the image file.
+    if(!strcmp(eeprom_cmd, "read")) {
+        status = i2c_eeprom_read(&eeprom, eeprom_offset, data, data_len);
+        if(status) {
+            printf("%sUnable to read %d byte(s) from the EEPROM.\n", PREFIX_ERROR, data_len);
+        } else {
+            fp_eeprom_file = fopen(eeprom_file_name, "wb");
+            if(fp_eeprom_file == NULL || (int) fwrite(data, 1, data_len, fp_eeprom_file) != data_len) {
+                printf("%sCannot write the image file \"%s\".\n", PREFIX_ERROR, eeprom_file_name);
+                status = -1;
+            }
+            if(fp_eeprom_file != NULL)
+                fclose(fp_eeprom_file);
+            if(!status)
+                printf("Read %d byte(s) in %.3f s.\n", data_len, time_s() - time_start);
+        }
+    }
+
+    // Write the image file to the EEPROM.
+    if(!strcmp(eeprom_cmd, "write")) {
+        status = i2c_eeprom_write(&eeprom, eeprom_offset, data, data_len, eeprom_flags);
+        if(status)
+            printf("%sUnable to write %d byte(s) to the EEPROM.\n", PREFIX_ERROR, data_len);
+        else
+            printf("Wrote %d byte(s) in %.3f s: %d page(s) written, %d page(s) skipped, %d ACK poll(s).\n",
+                   data_len, time_s() - time_start, eeprom.pages_written, eeprom.pages_skipped, eeprom.polls);
+    }
+
+    // Verify the EEPROM contents.
+    if(!status && strcmp(eeprom_cmd, "read")) {
+        status = i2c_eeprom_verify(&eeprom, eeprom_offset, data, data_len);
+        if(status < 0)
+            printf("%sUnable to read %d byte(s) from the EEPROM for verification.\n", PREFIX_ERROR, data_len);
+        else if(status > 0)
+            printf("%sVerification failed: %d byte(s) differ.\n", PREFIX_ERROR, status);
+        else
+            printf("Verified %d byte(s).\n", data_len);
+    }
+
+    // Close the I2C device.
+    i2c_close();
+    free(data);
+
+    return status ? 1 : 0;
+}
+
+
+
+// List the supported EEPROM parts.
+int list_parts(void)
+{
+    int i;
+    const struct i2c_eeprom_part *part;
+
+    printf("Part      Size (bytes)  Page size (bytes)  Address width (bytes)\n");
+    for(i = 0; (part = i2c_eeprom_get_part(i)) != NULL; i++)
+        printf("%-8s  %12d  %17d  %21d\n", part->name, part->size, part->page_size, part->adr_width);
+
+    return 0;
+}
+
+
+
+// Get a monotonic time stamp in s.
+double time_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+
+// Show help message.
+int show_help(char* prog_name)
+{
+    printf("I2C EEPROM programmer (read/write/verify)\n");
+    printf("\n");
+    printf("Usage: %s [-o OFFSET] [-n LEN] [-s FREQ] [-t] [-F] PART CHIP-ADR read|write|verify FILE\n", prog_name);
+    printf("       %s -l\n", prog_name);
+    printf("\n");
+    printf("  -o OFFSET   Start offset in the EEPROM (default: 0).\n");
+    printf("  -n LEN      Number of bytes (default: up to the end of the EEPROM).\n");
+    printf("  -s FREQ     I2C frequency in Hz, up to 1000000 (default: 100000).\n");
+    printf("  -t          ADBUS1 and ADBUS2 are tied together, use them for faster reads.\n");
+    printf("  -F          Write all pages, even if they already contain the data.\n");
+    printf("  -l          List the supported EEPROM parts.\n");
+    return 0;
+}
+
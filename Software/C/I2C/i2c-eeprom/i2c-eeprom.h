@@ -0,0 +1,39 @@
+// File: i2c-eeprom.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for the I2C EEPROM programmer for the FTDI FH232H chip.
+//
+
+
+
+#ifndef __I2C_EEPROM_PROG_H
+#define __I2C_EEPROM_PROG_H
+
+
+
+// Use I2C MPSSE library functions.
+#include "i2c_mpsse.h"
+#include "i2c_eeprom.h"
+
+
+
+// Message prefixes.
+#define PREFIX_DEBUG            "DEBUG: "
+#define PREFIX_ERROR            "ERROR: "
+
+
+
+// Level of debug info.
+#define DEBUG_LEVEL 0
+//#define DEBUG_LEVEL 1
+//#define DEBUG_LEVEL 2
+//#define DEBUG_LEVEL 3
+//#define DEBUG_LEVEL 4
+
+
+
+#endif
+
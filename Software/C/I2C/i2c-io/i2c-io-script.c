@@ -0,0 +1,416 @@
+// File: i2c-io-script.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Script mode of the raw I2C IO control program.
+//
+// The script is parsed completely before any I2C access. Consecutive I2C
+// operations are then executed as batches in single USB transfers. The results
+// are printed after each batch, so they are streamed out while the script is
+// still running. A sleep ends the batch and waits on the host, while a delay
+// is clocked by the MPSSE between the I2C operations of the batch, e.g. for
+// waiting for a calibration with microsecond precision.
+//
+// Script format, one operation per line, '#' starts a comment:
+//   w CHIP-ADR [DATA ...]          Write data bytes.
+//   r CHIP-ADR LEN                 Read LEN data bytes.
+//   wr CHIP-ADR LEN [DATA ...]     Write data bytes, then read LEN data bytes
+//                                  after a repeated start condition.
+//   sleep MSEC                     Wait for MSEC milliseconds.
+//   delay USEC                     Wait for USEC microseconds, timed by the
+//                                  MPSSE within the batch (up to 0.5 s).
+//   expect DATA[/MASK] ...         Compare the data of the previous read with
+//                                  the expected data bytes, optionally masked.
+//
+// Example:
+//   w 0x70 0x01                    # Select channel 0 of an I2C switch.
+//   wr 0x50 2 0x00                 # Read 2 bytes from data address 0x00.
+//   expect 0x12 0x30/0xf0
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "i2c-io.h"
+#include "i2c-io-script.h"
+#include "mpsse_adapter.h"
+
+
+
+// Function prototypes.
+static int i2c_script_number(const char *str, long min, long max, long *value);
+static struct i2c_script_op *i2c_script_add(struct i2c_script *script);
+static int i2c_script_parse_line(struct i2c_script *script, char *line, int line_number);
+static int i2c_script_report(struct i2c_script *script, int first, int last, int *last_read);
+static int i2c_script_flush(void);
+
+
+
+// Parse a script. Returns 0 on success or -1 if the script contains errors.
+int i2c_script_parse(FILE *fp, struct i2c_script *script)
+{
+    int status = 0;
+    char *line = NULL;          // This must be set to NULL so that getline reserves memory.
+    size_t line_len = 0;        // This must be set to 0 so that getline reserves memory.
+    int line_number = 0;
+
+    memset(script, 0, sizeof(struct i2c_script));
+
+    while(getline(&line, &line_len, fp) != -1) {
+        line_number++;
+        if(i2c_script_parse_line(script, line, line_number))
+            status = -1;
+    }
+    free(line);
+
+    return status;
+}
+
+
+
+// Execute a parsed script. Returns 0 if all operations succeeded.
+int i2c_script_run(struct i2c_script *script)
+{
+    int i, n;
+    int first;
+    int status = 0;
+    int last_read = -1;
+    struct i2c_script_op *op;
+    struct i2c_mpsse_xfer xfers[I2C_SCRIPT_BATCH_MAX];
+    struct i2c_mpsse_msg msgs[I2C_SCRIPT_BATCH_MAX * 2];
+
+    i = 0;
+    while(i < script->count) {
+        // Collect the I2C operations up to the next sleep.
+        first = i;
+        for(n = 0; i < script->count && n < I2C_SCRIPT_BATCH_MAX; i++) {
+            op = &script->ops[i];
+            if(op->type == I2C_SCRIPT_OP_SLEEP) break;
+            if(op->type == I2C_SCRIPT_OP_EXPECT) continue;
+            if(op->type == I2C_SCRIPT_OP_DELAY) {
+                // Delay after the previous operation of the batch, or before
+                // the first one.
+                if(n == 0) {
+                    if(mpsse_adapter_queue_delay(i2c_get_adapter(), op->usec)) {
+                        printf("%sLine %d: Unable to queue a delay of %d us.\n", PREFIX_ERROR, op->line, op->usec);
+                        status = -1;
+                    }
+                } else if(xfers[n-1].delay + op->usec > MPSSE_ADAPTER_DELAY_MAX) {
+                    break;
+                } else {
+                    xfers[n-1].delay += op->usec;
+                }
+                continue;
+            }
+            xfers[n].msgs = &msgs[n * 2];
+            xfers[n].num = 0;
+            xfers[n].delay = 0;
+            if(op->type != I2C_SCRIPT_OP_READ) {
+                msgs[n * 2 + xfers[n].num].adr = op->adr;
+                msgs[n * 2 + xfers[n].num].flags = 0;
+                msgs[n * 2 + xfers[n].num].len = op->wr_len;
+                msgs[n * 2 + xfers[n].num].buf = op->data;
+                xfers[n].num++;
+            }
+            if(op->type != I2C_SCRIPT_OP_WRITE) {
+                msgs[n * 2 + xfers[n].num].adr = op->adr;
+                msgs[n * 2 + xfers[n].num].flags = I2C_MPSSE_M_RD;
+                msgs[n * 2 + xfers[n].num].len = op->rd_len;
+                msgs[n * 2 + xfers[n].num].buf = op->data + op->wr_len;
+                xfers[n].num++;
+            }
+            n++;
+        }
+
+        // Execute the batch and report the results.
+        if(n > 0) {
+            i2c_transfer_batch(xfers, n);
+            for(n = 0, op = &script->ops[first]; op < &script->ops[i]; op++)
+                if(op->type != I2C_SCRIPT_OP_EXPECT && op->type != I2C_SCRIPT_OP_DELAY)
+                    op->status = xfers[n++].status;
+        }
+        if(i2c_script_report(script, first, i, &last_read))
+            status = -1;
+
+        // Sleep. Delays queued without a following I2C operation are
+        // executed before.
+        if(i < script->count && script->ops[i].type == I2C_SCRIPT_OP_SLEEP) {
+            if(i2c_script_flush())
+                status = -1;
+            fflush(stdout);
+            usleep(script->ops[i].msec * 1000);
+            i++;
+        }
+    }
+
+    // Execute the delays queued at the end of the script.
+    if(i2c_script_flush())
+        status = -1;
+
+    return status;
+}
+
+
+
+// Free a parsed script.
+void i2c_script_free(struct i2c_script *script)
+{
+    int i;
+
+    for(i = 0; i < script->count; i++) {
+        free(script->ops[i].data);
+        free(script->ops[i].mask);
+    }
+    free(script->ops);
+    memset(script, 0, sizeof(struct i2c_script));
+}
+
+
+
+// Convert a number and check its range.
+static int i2c_script_number(const char *str, long min, long max, long *value)
+{
+    char *end;
+
+    *value = strtol(str, &end, 0);
+    if(end == str || *end != '\0' || *value < min || *value > max)
+        return -1;
+
+    return 0;
+}
+
+
+
+// Add an operation to a script.
+static struct i2c_script_op *i2c_script_add(struct i2c_script *script)
+{
+    int size;
+    struct i2c_script_op *ops;
+
+    if(script->count >= script->size) {
+        size = script->size ? script->size * 2 : 256;
+        ops = realloc(script->ops, size * sizeof(struct i2c_script_op));
+        if(ops == NULL) return NULL;
+        script->ops = ops;
+        script->size = size;
+    }
+    memset(&script->ops[script->count], 0, sizeof(struct i2c_script_op));
+
+    return &script->ops[script->count++];
+}
+
+
+
+// Parse one line of a script.
+static int i2c_script_parse_line(struct i2c_script *script, char *line, int line_number)
+{
+    int i;
+    int argc = 0;
+    long value;
+    char *argv[I2C_DATA_LEN_MAX + 3];
+    char *token, *mask;
+    struct i2c_script_op *op;
+
+    // Remove comments and split the line into words.
+    token = strchr(line, '#');
+    if(token != NULL) *token = '\0';
+    for(token = strtok(line, " \t\r\n"); token != NULL; token = strtok(NULL, " \t\r\n")) {
+        if(argc >= I2C_DATA_LEN_MAX + 3) {
+            printf("%sLine %d: Too many data bytes.\n", PREFIX_ERROR, line_number);
+            return -1;
+        }
+        argv[argc++] = token;
+    }
+    if(argc == 0) return 0;
+
+    op = i2c_script_add(script);
+    if(op == NULL) {
+        printf("%sLine %d: Cannot allocate memory.\n", PREFIX_ERROR, line_number);
+        return -1;
+    }
+    op->line = line_number;
+
+    // Operation type.
+    if(!strcmp(argv[0], "w") && argc >= 2) {
+        op->type = I2C_SCRIPT_OP_WRITE;
+        op->wr_len = argc - 2;
+    } else if(!strcmp(argv[0], "r") && argc == 3) {
+        op->type = I2C_SCRIPT_OP_READ;
+    } else if(!strcmp(argv[0], "wr") && argc >= 3) {
+        op->type = I2C_SCRIPT_OP_WRITE_READ;
+        op->wr_len = argc - 3;
+    } else if(!strcmp(argv[0], "sleep") && argc == 2) {
+        op->type = I2C_SCRIPT_OP_SLEEP;
+    } else if(!strcmp(argv[0], "delay") && argc == 2) {
+        op->type = I2C_SCRIPT_OP_DELAY;
+    } else if(!strcmp(argv[0], "expect") && argc >= 2) {
+        op->type = I2C_SCRIPT_OP_EXPECT;
+        op->rd_len = argc - 1;
+    } else {
+        printf("%sLine %d: Invalid operation '%s' or wrong number of parameters.\n", PREFIX_ERROR, line_number, argv[0]);
+        goto fail;
+    }
+
+    // Sleep time.
+    if(op->type == I2C_SCRIPT_OP_SLEEP) {
+        if(i2c_script_number(argv[1], 0, 3600000, &value)) {
+            printf("%sLine %d: Invalid sleep time '%s'.\n", PREFIX_ERROR, line_number, argv[1]);
+            goto fail;
+        }
+        op->msec = (int) value;
+        return 0;
+    }
+
+    // Delay.
+    if(op->type == I2C_SCRIPT_OP_DELAY) {
+        if(i2c_script_number(argv[1], 0, MPSSE_ADAPTER_DELAY_MAX, &value)) {
+            printf("%sLine %d: Invalid delay '%s'. Use 0..%d us.\n", PREFIX_ERROR, line_number, argv[1], MPSSE_ADAPTER_DELAY_MAX);
+            goto fail;
+        }
+        op->usec = (int) value;
+        return 0;
+    }
+
+    // Expected data bytes with optional masks.
+    if(op->type == I2C_SCRIPT_OP_EXPECT) {
+        op->data = malloc(op->rd_len);
+        op->mask = malloc(op->rd_len);
+        if(op->data == NULL || op->mask == NULL) {
+            printf("%sLine %d: Cannot allocate memory.\n", PREFIX_ERROR, line_number);
+            goto fail;
+        }
+        for(i = 0; i < op->rd_len; i++) {
+            mask = strchr(argv[i+1], '/');
+            if(mask != NULL) *mask++ = '\0';
+            if(i2c_script_number(argv[i+1], 0, 0xff, &value)) {
+                printf("%sLine %d: Invalid expected data byte '%s'.\n", PREFIX_ERROR, line_number, argv[i+1]);
+                goto fail;
+            }
+            op->data[i] = (char) value;
+            op->mask[i] = (char) 0xff;
+            if(mask != NULL) {
+                if(i2c_script_number(mask, 0, 0xff, &value)) {
+                    printf("%sLine %d: Invalid mask '%s'.\n", PREFIX_ERROR, line_number, mask);
+                    goto fail;
+                }
+                op->mask[i] = (char) value;
+            }
+        }
+        return 0;
+    }
+
+    // I2C device address.
+    if(i2c_script_number(argv[1], 0, 0x7f, &value)) {
+        printf("%sLine %d: Invalid I2C chip address '%s'.\n", PREFIX_ERROR, line_number, argv[1]);
+        goto fail;
+    }
+    op->adr = (int) value;
+
+    // Read length.
+    if(op->type != I2C_SCRIPT_OP_WRITE) {
+        if(i2c_script_number(argv[2], 1, I2C_DATA_LEN_MAX, &value)) {
+            printf("%sLine %d: Invalid read length '%s'.\n", PREFIX_ERROR, line_number, argv[2]);
+            goto fail;
+        }
+        op->rd_len = (int) value;
+    }
+
+    // Write data bytes, followed by space for the read data.
+    op->data = malloc(op->wr_len + op->rd_len + 1);
+    if(op->data == NULL) {
+        printf("%sLine %d: Cannot allocate memory.\n", PREFIX_ERROR, line_number);
+        goto fail;
+    }
+    for(i = 0; i < op->wr_len; i++) {
+        if(i2c_script_number(argv[argc - op->wr_len + i], 0, 0xff, &value)) {
+            printf("%sLine %d: Invalid data byte '%s'.\n", PREFIX_ERROR, line_number, argv[argc - op->wr_len + i]);
+            goto fail;
+        }
+        op->data[i] = (char) value;
+    }
+
+    return 0;
+
+fail:
+    // Drop the invalid operation.
+    free(op->data);
+    free(op->mask);
+    script->count--;
+    return -1;
+}
+
+
+
+// Print the results of the operations first..last-1 after their execution.
+// Returns -1 if any of them failed.
+static int i2c_script_report(struct i2c_script *script, int first, int last, int *last_read)
+{
+    int i, j;
+    int status = 0;
+    struct i2c_script_op *op, *rd;
+
+    for(i = first; i < last; i++) {
+        op = &script->ops[i];
+        switch(op->type) {
+        case I2C_SCRIPT_OP_WRITE:
+            if(op->status) {
+                printf("%sLine %d: Unable to write %d byte(s) to the I2C chip address 0x%02x.\n", PREFIX_ERROR, op->line, op->wr_len, op->adr);
+                status = -1;
+            }
+            break;
+        case I2C_SCRIPT_OP_READ:
+        case I2C_SCRIPT_OP_WRITE_READ:
+            *last_read = i;
+            if(op->status) {
+                printf("%sLine %d: Unable to read %d byte(s) from the I2C chip address 0x%02x.\n", PREFIX_ERROR, op->line, op->rd_len, op->adr);
+                status = -1;
+                break;
+            }
+            // Print the data read from I2C.
+            for(j = 0; j < op->rd_len; j++)
+                printf("0x%02x%s", op->data[op->wr_len + j] & 0xff, (j < op->rd_len - 1) ? " " : "\n");
+            break;
+        case I2C_SCRIPT_OP_EXPECT:
+            if(*last_read < 0 || script->ops[*last_read].status) {
+                printf("%sLine %d: No data read to compare.\n", PREFIX_ERROR, op->line);
+                status = -1;
+                break;
+            }
+            rd = &script->ops[*last_read];
+            if(op->rd_len > rd->rd_len) {
+                printf("%sLine %d: Expected %d byte(s), but only %d byte(s) were read in line %d.\n", PREFIX_ERROR, op->line, op->rd_len, rd->rd_len, rd->line);
+                status = -1;
+                break;
+            }
+            for(j = 0; j < op->rd_len; j++) {
+                if((rd->data[rd->wr_len + j] & op->mask[j]) != (op->data[j] & op->mask[j])) {
+                    printf("%sLine %d: Data byte %d is 0x%02x, expected 0x%02x with mask 0x%02x.\n", PREFIX_ERROR, op->line, j, rd->data[rd->wr_len + j] & 0xff, op->data[j] & 0xff, op->mask[j] & 0xff);
+                    status = -1;
+                }
+            }
+            break;
+        }
+    }
+    fflush(stdout);
+
+    return status;
+}
+
+
+
+// Send delays queued on the adapter to the MPSSE.
+static int i2c_script_flush(void)
+{
+    if(mpsse_adapter_flush(i2c_get_adapter())) {
+        printf("%sUnable to execute the queued delays.\n", PREFIX_ERROR);
+        return -1;
+    }
+
+    return 0;
+}
+
@@ -0,0 +1,65 @@
+// File: i2c-io-script.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for the script mode of the raw I2C IO control program.
+//
+
+
+
+#ifndef __I2C_IO_SCRIPT_H
+#define __I2C_IO_SCRIPT_H
+
+
+
+#include <stdio.h>
+
+
+
+// Script operation types.
+#define I2C_SCRIPT_OP_WRITE         0       // w CHIP-ADR [DATA ...]
+#define I2C_SCRIPT_OP_READ          1       // r CHIP-ADR LEN
+#define I2C_SCRIPT_OP_WRITE_READ    2       // wr CHIP-ADR LEN [DATA ...]
+#define I2C_SCRIPT_OP_SLEEP         3       // sleep MSEC
+#define I2C_SCRIPT_OP_EXPECT        4       // expect DATA[/MASK] ...
+#define I2C_SCRIPT_OP_DELAY         5       // delay USEC
+
+// Maximum number of I2C operations executed in one USB transfer.
+#define I2C_SCRIPT_BATCH_MAX        64
+
+
+
+// Script operation.
+struct i2c_script_op {
+    int type;                   // I2C_SCRIPT_OP_* type.
+    int line;                   // Line number in the script.
+    int adr;                    // I2C device address.
+    int wr_len;                 // Number of bytes to write.
+    int rd_len;                 // Number of bytes to read or expected bytes.
+    char *data;                 // Write data followed by read data, or expected data.
+    char *mask;                 // Masks of the expected data.
+    int msec;                   // Sleep time in ms.
+    int usec;                   // Delay in us.
+    int status;                 // Result: 0 = OK, -1 = failed.
+};
+
+// Parsed script.
+struct i2c_script {
+    struct i2c_script_op *ops;
+    int count;
+    int size;
+};
+
+
+
+// Function prototypes.
+int i2c_script_parse(FILE *fp, struct i2c_script *script);
+int i2c_script_run(struct i2c_script *script);
+void i2c_script_free(struct i2c_script *script);
+
+
+
+#endif
+
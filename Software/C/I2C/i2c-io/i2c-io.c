@@ -1,339 +1,568 @@
-// File: i2c-io.c
-// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
-// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
-// Date: 05 Feb 2018
-// Rev.: 16 Feb 2018
-//
-// Raw I2C IO control program for the FTDI FH232H chip using FTDI's Multi -
-// Protocol Synchronous Serial Engine (MPSSE).
-//
-// FTDI FT232H pinning:
-// - ADBUS0(13): SCL
-// - ADBUS1(14): SDA output
-// - ADBUS2(15): SDA input
-//
-// CAUTION:
-// The pins ADBUS1(14) and ADBUS2(15) *must* be tied together! Otherwise,
-// either no data will be driven onto SDA or only a constant high signal level
-// (i.e. NACK, 0xFF) will be received!
-//
-
-
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <mpsse.h>
-#include "i2c-io.h"
-
-
-
-// Function protoypes.
-int show_help(char* prog_name);
-
-
-
-int main(int argc, char **argv)
-{
-    int i;
-    int status;
-    // FTDI I2C hardware.
-    #ifndef USE_LIBI2C_MPSSE
-    struct mpsse_context *mpsse_i2c = NULL;
-    #endif
-    int i2c_freq = ONE_HUNDRED_KHZ;
-//    int i2c_freq = FOUR_HUNDRED_KHZ;
-    // I2C address and data.
-    int i2c_dev_adr;
-    int i2c_data_adr = 0;
-    char i2c_data[I2C_DATA_LEN_MAX+1];
-    #ifndef USE_LIBI2C_MPSSE
-    char *i2c_data_ptr = NULL;
-    #endif
-    int i2c_data_len;
-
-    // Check command line arguments.
-    if(argc < 2) {
-        show_help(argv[0]);
-        return 1;
-    }
-    i2c_dev_adr = (int)(strtoul(argv[1], NULL, 0) & 0x7f);
-    if(argc > 2) {
-        i2c_data_adr = (int)(strtoul(argv[2], NULL, 0) & 0xff);
-    }
-    i2c_data_len = argc - 3;
-    if(i2c_data_len > I2C_DATA_LEN_MAX)
-        i2c_data_len = I2C_DATA_LEN_MAX;
-
-    #ifdef USE_LIBI2C_MPSSE
-    // Initialize the I2C master device.
-    status = i2c_init();
-    if(status) {
-        printf("%sUnable to open the I2C device.\n", PREFIX_ERROR);
-        return 1;
-    }
-    // Set the I2C bus frequency.
-    status = i2c_set_freq(i2c_freq);
-    if(status) {
-        printf("%sUnable to set the I2C frequency to %d Hz.\n", PREFIX_ERROR, i2c_freq);
-        return 1;
-    }
-    // Set verbosity of the I2C library functions.
-    i2c_set_verbose(1);
-    #else
-    // Open the I2C master.
-    if(!((mpsse_i2c = MPSSE(I2C, i2c_freq, MSB)) != NULL && mpsse_i2c->open))
-    {
-        printf("%sFailed to initialize MPSSE: %s\n", PREFIX_ERROR, ErrorString(mpsse_i2c));
-        return -1;
-    }
-    #endif
-
-    // Show device information.
-    #if DEBUG_LEVEL >= 1
-    #ifdef USE_LIBI2C_MPSSE
-    i2c_info();
-    #else
-    printf("I2C master device: %s\n", GetDescription(mpsse_i2c));
-    printf("I2C master device VID: 0x%04x\n", GetVid(mpsse_i2c));
-    printf("I2C master device PID: 0x%04x\n", GetPid(mpsse_i2c));
-    printf("I2C bus speed: %d Hz\n", GetClock(mpsse_i2c));
-    #endif
-    #endif
-
-    // I2C read with chip address only.
-    if(argc == 2) {
-        #if DEBUG_LEVEL >= 3
-        printf("%sI2C read from chip address 0x%02x.\n", PREFIX_DEBUG, i2c_dev_adr);
-        #endif
-        #ifdef USE_LIBI2C_MPSSE
-        // Read 1 byte from the I2C device.
-        i2c_data_len = 1;
-        status = i2c_read(i2c_dev_adr, i2c_data, i2c_data_len);
-        if(status) {
-            printf("%sUnable to read %d byte(s) from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_data_len, i2c_dev_adr);
-            return 1;
-        }
-        // Print the data read from I2C.
-        printf("0x%02x\n", i2c_data[0] & 0xff);
-        #else
-        // Generate start condition.
-        status = Start(mpsse_i2c);
-        if(status) {
-            printf("%sUnable to generate start condition.\n", PREFIX_ERROR);
-            return 1;
-        }
-        // Send device address with read command.
-        i2c_data[0] = ((i2c_dev_adr & 0x7f) << 1) | 0x01;
-        status = Write(mpsse_i2c, i2c_data, 1);
-        if(status) {
-            printf("%sUnable to set the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
-            return 1;
-        }
-        // Check for acknowledge.
-        if(GetAck(mpsse_i2c) != ACK) {
-            printf("%sDid not get acknowledge from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
-            return 1;
-        }
-        // Read from the I2C bus.
-        i2c_data_len = 1;
-        i2c_data_ptr = Read(mpsse_i2c, i2c_data_len);
-        if(i2c_data_ptr == NULL) {
-            printf("%sUnable to read %d byte(s) from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_data_len, i2c_dev_adr);
-            return 1;
-        }
-        // Check for acknowledge.
-        if(GetAck(mpsse_i2c) != ACK) {
-            printf("%sDid not get acknowledge from the I2C chip address 0x%02x after reading data.\n", PREFIX_ERROR, i2c_dev_adr);
-            return 1;
-        }
-        // Generate stop condition.
-        status = Stop(mpsse_i2c);
-        if(status) {
-            printf("%sUnable to generate stop condition.\n", PREFIX_ERROR);
-            return 1;
-        }
-        // Print the data read from I2C.
-        printf("0x%02x\n",(*i2c_data_ptr) & 0x000000ff);
-        free(i2c_data_ptr);
-        #endif
-    // I2C read with chip address and data address.
-    } else if(argc == 3) {
-        #if DEBUG_LEVEL >= 3
-        printf("%sI2C read from chip address 0x%02x, data address 0x%02x.\n", PREFIX_DEBUG, i2c_dev_adr, i2c_data_adr);
-        #endif
-        #ifdef USE_LIBI2C_MPSSE
-        // Set the I2C data address.
-        i2c_data[0] = i2c_data_adr & 0xff;
-        status = i2c_write(i2c_dev_adr, i2c_data, 1);
-        if(status) {
-            printf("%sUnable to set the I2C data address 0x%02x for device address 0x%02x.\n", PREFIX_ERROR, i2c_data_adr, i2c_dev_adr);
-            return 1;
-        }
-        // Read 1 byte from the I2C device.
-        i2c_data_len = 1;
-        status = i2c_read(i2c_dev_adr, i2c_data, i2c_data_len);
-        if(status) {
-            printf("%sUnable to read %d byte(s) from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_data_len, i2c_dev_adr);
-            return 1;
-        }
-        // Print the data read from I2C.
-        printf("0x%02x\n", i2c_data[0] & 0xff);
-        #else
-        // Generate start condition.
-        status = Start(mpsse_i2c);
-        if(status) {
-            printf("%sUnable to generate start condition.\n", PREFIX_ERROR);
-            return 1;
-        }
-        // Send device address with write command.
-        i2c_data[0] = ((i2c_dev_adr & 0x7f) << 1) | 0x00;
-        status = Write(mpsse_i2c, i2c_data, 1);
-        if(status) {
-            printf("%sUnable to set the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
-            return 1;
-        }
-        // Check for acknowledge.
-        if(GetAck(mpsse_i2c) != ACK) {
-            printf("%sDid not get acknowledge from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
-            return 1;
-        }
-        // Write the data address
-        i2c_data[0] = i2c_data_adr & 0xff;
-        status = Write(mpsse_i2c, i2c_data, 1);
-        if(status) {
-            printf("%sUnable to set the I2C data address 0x%02x for device address 0x%02x.\n", PREFIX_ERROR, i2c_data_adr, i2c_dev_adr);
-            return 1;
-        }
-        // Check for acknowledge.
-        if(GetAck(mpsse_i2c) != ACK) {
-            printf("%sDid not get acknowledge from the I2C chip address 0x%02x, data address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr, i2c_data_adr);
-            return 1;
-        }
-        //(Re-)Generate start condition.
-        status = Start(mpsse_i2c);
-        if(status) {
-            printf("%sUnable to(re-)generate start condition.\n", PREFIX_ERROR);
-            return 1;
-        }
-        // Send device address with read command.
-        i2c_data[0] = ((i2c_dev_adr & 0x7f) << 1) | 0x01;
-        status = Write(mpsse_i2c, i2c_data, 1);
-        if(status) {
-            printf("%sUnable to set the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
-            return 1;
-        }
-        // Check for acknowledge.
-        if(GetAck(mpsse_i2c) != ACK) {
-            printf("%sDid not get acknowledge from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
-            return 1;
-        }
-        // Read from the I2C bus.
-        i2c_data_len = 1;
-        i2c_data_ptr = Read(mpsse_i2c, i2c_data_len);
-        if(i2c_data_ptr == NULL) {
-            printf("%sUnable to read %d byte(s) from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_data_len, i2c_dev_adr);
-            return 1;
-        }
-        // Check for acknowledge.
-        if(GetAck(mpsse_i2c) != ACK) {
-            printf("%sDid not get acknowledge from the I2C chip address 0x%02x, data address 0x%02x after reading data.\n", PREFIX_ERROR, i2c_dev_adr, i2c_data_adr);
-            return 1;
-        }
-        // Generate stop condition.
-        status = Stop(mpsse_i2c);
-        if(status) {
-            printf("%sUnable to generate stop condition.\n", PREFIX_ERROR);
-            return 1;
-        }
-        // Print the data read from I2C.
-        printf("0x%02x\n",(*i2c_data_ptr) & 0x000000ff);
-        free(i2c_data_ptr);
-        #endif
-    // I2C write.
-    } else if(argc >= 4) {
-        #if DEBUG_LEVEL >= 3
-        printf("%sI2C write to chip address 0x%02x, data address 0x%02x.\n", PREFIX_DEBUG, i2c_dev_adr, i2c_data_adr);
-        printf("%sData: ", PREFIX_DEBUG);
-        for(i = 0; i < i2c_data_len; i++) {
-            printf("0x%02x ",(char)(strtoul(argv[i+3], NULL, 0) & 0xff));
-        }
-        printf("\n");
-        #endif
-        #ifdef USE_LIBI2C_MPSSE
-        // Prepare the I2C data.
-        i2c_data[0] = (char)(i2c_data_adr & 0xff);
-        for(i = 0; i < i2c_data_len; i++)
-            i2c_data[i+1] = (char)(strtoul(argv[i+3], NULL, 0) & 0xff);
-        // Send the I2C data.
-        status = i2c_write(i2c_dev_adr, i2c_data, i2c_data_len + 1);
-        if(status) {
-            printf("%sUnable to write %d byte(s) to the I2C chip address 0x%02x, data address 0x%02x.\n", PREFIX_ERROR, i2c_data_len, i2c_dev_adr, i2c_data_adr);
-            return 1;
-        }
-        #else
-        // Generate start condition.
-        status = Start(mpsse_i2c);
-        if(status) {
-            printf("%sUnable to generate start condition.\n", PREFIX_ERROR);
-            return 1;
-        }
-        // Send device address with write command.
-        i2c_data[0] = ((i2c_dev_adr & 0x7f) << 1) | 0x00;
-        status = Write(mpsse_i2c, i2c_data, 1);
-        if(status) {
-            printf("%sUnable to set the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
-            return 1;
-        }
-        // Check for acknowledge.
-        if(GetAck(mpsse_i2c) != ACK) {
-            printf("%sDid not get acknowledge from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
-            return 1;
-        }
-        // Prepare the I2C data.
-        i2c_data[0] = (char)(i2c_data_adr & 0xff);
-        for(i = 0; i < i2c_data_len; i++)
-            i2c_data[i+1] = (char)(strtoul(argv[i+3], NULL, 0) & 0xff);
-        // Send the I2C data.
-        status = Write(mpsse_i2c, i2c_data, i2c_data_len + 1);
-        if(status) {
-            printf("%sUnable to write %d byte(s) to the I2C chip address 0x%02x, data address 0x%02x.\n", PREFIX_ERROR, i2c_data_len, i2c_dev_adr, i2c_data_adr);
-            return 1;
-        }
-        // Check for acknowledge.
-        if(GetAck(mpsse_i2c) != ACK) {
-            printf("%sDid not get acknowledge from the I2C chip address 0x%02x after writing data.\n", PREFIX_ERROR, i2c_dev_adr);
-            return 1;
-        }
-        // Generate stop condition.
-        status = Stop(mpsse_i2c);
-        if(status) {
-            printf("%sUnable to generate stop condition.\n", PREFIX_ERROR);
-            return 1;
-        }
-        #endif
-    } else {
-        printf("%sSpecify either 2..3(for read) or 4(for write) parameters!", PREFIX_ERROR);
-        return 1;
-    }
-
-    // Close the I2C device.
-    #ifdef USE_LIBI2C_MPSSE
-    i2c_close();
-    #else
-    Close(mpsse_i2c);
-    #endif
-
-    return 0;
-}
-
-
-
-// Show help message.
-int show_help(char* prog_name)
-{
-    printf("Raw I2C IO control program (read/write)\n");
-    printf("\n");
-    printf("Usage: %s CHIP-ADR [DATA-ADR] [DATA]\n", prog_name);
-    return 0;
-}
-
+// File: i2c-io.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 05 Feb 2018
+// Rev.: 19 Oct 2026
+//
+// Raw I2C IO control program for the FTDI FH232H chip using FTDI's Multi -
+// Protocol Synchronous Serial Engine (MPSSE).
+//
+// FTDI FT232H pinning:
+// - ADBUS0(13): SCL
+// - ADBUS1(14): SDA output
+// - ADBUS2(15): SDA input
+//
+// CAUTION:
+// Without the libi2c_mpsse library, the pins ADBUS1(14) and ADBUS2(15) *must*
+// be tied together! Otherwise, either no data will be driven onto SDA or only
+// a constant high signal level (i.e. NACK, 0xFF) will be received!
+// The libi2c_mpsse library drives SDA open drain on the FT232H and samples it
+// on ADBUS1, so the strap is optional. If it is present, the option -t makes
+// reads use it, which is faster.
+//
+// The option -s sets the I2C frequency, up to 1 MHz (Fast-mode Plus).
+//
+// The option -i selects the MPSSE interface (A or B) of an FT2232H or FT4232H.
+// Each interface drives an I2C bus of its own on its ADBUS/BDBUS pins.
+//
+// The option -T measures the USB latency timer and chunk size settings for a
+// workload class (poll or stream) and saves the best ones as the profile of
+// the device. The option -w selects the workload class of the profile applied
+// when the device is opened, the default is poll.
+//
+// The options -a and -n select the width of the data address (0, 1, 2 or 4
+// bytes) and the number of bytes to read. Reads of many bytes are executed as
+// one I2C transaction, e.g. for dumping a whole EEPROM.
+//
+// With the option -f, a script of I2C operations is read from a file or from
+// stdin and executed in batches, see i2c-io-script.c for the script format.
+// The options -s, -t, -i and -w also apply to the script.
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpsse.h>
+#include "i2c-io.h"
+#ifdef USE_LIBI2C_MPSSE
+#include "mpsse_adapter.h"
+#include "i2c-io-script.h"
+#endif
+
+
+
+// Function protoypes.
+int show_help(char* prog_name);
+#ifdef USE_LIBI2C_MPSSE
+void print_data(char *data, int len);
+int run_script(char *script_file_name, int i2c_freq, int i2c_strap);
+#endif
+
+
+
+int main(int argc, char **argv)
+{
+    int i;
+    int status;
+    // FTDI I2C hardware.
+    #ifndef USE_LIBI2C_MPSSE
+    struct mpsse_context *mpsse_i2c = NULL;
+    #endif
+    int i2c_freq = ONE_HUNDRED_KHZ;
+//    int i2c_freq = FOUR_HUNDRED_KHZ;
+    // I2C address and data.
+    int i2c_dev_adr;
+    unsigned int i2c_data_adr = 0;
+    char i2c_data[I2C_DATA_LEN_MAX+4];
+    #ifdef USE_LIBI2C_MPSSE
+    int i2c_adr_width = 1;
+    int i2c_read_len = 1;
+    char *i2c_read_data = NULL;
+    int i2c_strap = 0;
+    int tune_workload = -1;
+    char *script_file_name = NULL;
+    #else
+    char *i2c_data_ptr = NULL;
+    #endif
+    int i2c_data_len;
+
+    // Check command line arguments.
+    if(argc < 2) {
+        show_help(argv[0]);
+        return 1;
+    }
+    #ifdef USE_LIBI2C_MPSSE
+    // Parse the options and remove them from the command line arguments.
+    for(i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if(!strcmp(argv[i], "-t")) {
+            i2c_strap = 1;
+        } else if(!strcmp(argv[i], "-f")) {
+            // The script file name is optional, stdin is used without it.
+            if(i + 1 < argc && (argv[i+1][0] != '-' || !strcmp(argv[i+1], "-")))
+                script_file_name = argv[++i];
+            else
+                script_file_name = "-";
+        } else if(!strcmp(argv[i], "-s") && i + 1 < argc) {
+            i2c_freq = (int) strtoul(argv[++i], NULL, 0);
+            if(i2c_freq <= 0 || i2c_freq > ONE_MHZ) {
+                printf("%sInvalid I2C frequency of %d Hz. Use up to %d Hz.\n", PREFIX_ERROR, i2c_freq, ONE_MHZ);
+                return 1;
+            }
+        } else if(!strcmp(argv[i], "-i") && i + 1 < argc) {
+            i++;
+            if(mpsse_adapter_select_interface(mpsse_adapter_parse_interface(argv[i]))) {
+                printf("%sInvalid FTDI interface \"%s\". Use A, B, C or D.\n", PREFIX_ERROR, argv[i]);
+                return 1;
+            }
+        } else if((!strcmp(argv[i], "-w") || !strcmp(argv[i], "-T")) && i + 1 < argc) {
+            status = mpsse_tune_parse_workload(argv[i+1]);
+            if(status < 0) {
+                printf("%sInvalid workload class \"%s\". Use poll or stream.\n", PREFIX_ERROR, argv[i+1]);
+                return 1;
+            }
+            if(!strcmp(argv[i], "-T"))
+                tune_workload = status;
+            else
+                mpsse_adapter_select_workload(status);
+            i++;
+        } else if(!strcmp(argv[i], "-a") && i + 1 < argc) {
+            i2c_adr_width = (int) strtoul(argv[++i], NULL, 0);
+            if(i2c_adr_width != 0 && i2c_adr_width != 1 && i2c_adr_width != 2 && i2c_adr_width != 4) {
+                printf("%sInvalid data address width of %d byte(s). Use 0, 1, 2 or 4 bytes.\n", PREFIX_ERROR, i2c_adr_width);
+                return 1;
+            }
+        } else if(!strcmp(argv[i], "-n") && i + 1 < argc) {
+            i2c_read_len = (int) strtoul(argv[++i], NULL, 0);
+            if(i2c_read_len < 1 || i2c_read_len > I2C_READ_LEN_MAX) {
+                printf("%sInvalid read length of %d byte(s). Use 1..%d bytes.\n", PREFIX_ERROR, i2c_read_len, I2C_READ_LEN_MAX);
+                return 1;
+            }
+        } else {
+            show_help(argv[0]);
+            return 1;
+        }
+    }
+    argv[i-1] = argv[0];
+    argv += i - 1;
+    argc -= i - 1;
+    // Tune the USB settings.
+    if(tune_workload >= 0) {
+        if(i2c_init()) {
+            printf("%sUnable to open the I2C device.\n", PREFIX_ERROR);
+            return 1;
+        }
+        status = mpsse_tune_run(i2c_get_adapter(), tune_workload, NULL, 1);
+        i2c_close();
+        return status ? 1 : 0;
+    }
+    // Execute a script of I2C operations.
+    if(script_file_name != NULL) {
+        if(argc != 1) {
+            show_help(argv[0]);
+            return 1;
+        }
+        return run_script(script_file_name, i2c_freq, i2c_strap);
+    }
+    if(argc < 2) {
+        show_help(argv[0]);
+        return 1;
+    }
+    #endif
+    i2c_dev_adr = (int)(strtoul(argv[1], NULL, 0) & 0x7f);
+    if(argc > 2) {
+        #ifdef USE_LIBI2C_MPSSE
+        i2c_data_adr = (unsigned int) strtoul(argv[2], NULL, 0);
+        if(i2c_adr_width < 4)
+            i2c_data_adr &= (1u << (8 * i2c_adr_width)) - 1;
+        #else
+        i2c_data_adr = (unsigned int)(strtoul(argv[2], NULL, 0) & 0xff);
+        #endif
+    }
+    i2c_data_len = argc - 3;
+    if(i2c_data_len > I2C_DATA_LEN_MAX)
+        i2c_data_len = I2C_DATA_LEN_MAX;
+
+    #ifdef USE_LIBI2C_MPSSE
+    // Initialize the I2C master device.
+    status = i2c_init();
+    if(status) {
+        printf("%sUnable to open the I2C device.\n", PREFIX_ERROR);
+        return 1;
+    }
+    // Set the I2C bus frequency.
+    status = i2c_set_freq(i2c_freq);
+    if(status) {
+        printf("%sUnable to set the I2C frequency to %d Hz.\n", PREFIX_ERROR, i2c_freq);
+        return 1;
+    }
+    // Use the ADBUS1/ADBUS2 strap for reading.
+    if(i2c_strap && i2c_set_strap(1)) {
+        printf("%sUnable to set the I2C SDA strap.\n", PREFIX_ERROR);
+        return 1;
+    }
+    // Set verbosity of the I2C library functions.
+    i2c_set_verbose(1);
+    #else
+    // Open the I2C master.
+    if(!((mpsse_i2c = MPSSE(I2C, i2c_freq, MSB)) != NULL && mpsse_i2c->open))
+    {
+        printf("%sFailed to initialize MPSSE: %s\n", PREFIX_ERROR, ErrorString(mpsse_i2c));
+        return -1;
+    }
+    #endif
+
+    // Show device information.
+    #if DEBUG_LEVEL >= 1
+    #ifdef USE_LIBI2C_MPSSE
+    i2c_info();
+    #else
+    printf("I2C master device: %s\n", GetDescription(mpsse_i2c));
+    printf("I2C master device VID: 0x%04x\n", GetVid(mpsse_i2c));
+    printf("I2C master device PID: 0x%04x\n", GetPid(mpsse_i2c));
+    printf("I2C bus speed: %d Hz\n", GetClock(mpsse_i2c));
+    #endif
+    #endif
+
+    // I2C read with chip address only.
+    if(argc == 2) {
+        #if DEBUG_LEVEL >= 3
+        printf("%sI2C read from chip address 0x%02x.\n", PREFIX_DEBUG, i2c_dev_adr);
+        #endif
+        #ifdef USE_LIBI2C_MPSSE
+        // Read the data bytes from the I2C device.
+        i2c_read_data = malloc(i2c_read_len);
+        if(i2c_read_data == NULL) {
+            printf("%sCannot allocate memory for %d byte(s).\n", PREFIX_ERROR, i2c_read_len);
+            return 1;
+        }
+        status = i2c_read(i2c_dev_adr, i2c_read_data, i2c_read_len);
+        if(status) {
+            printf("%sUnable to read %d byte(s) from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_read_len, i2c_dev_adr);
+            return 1;
+        }
+        // Print the data read from I2C.
+        print_data(i2c_read_data, i2c_read_len);
+        free(i2c_read_data);
+        #else
+        // Generate start condition.
+        status = Start(mpsse_i2c);
+        if(status) {
+            printf("%sUnable to generate start condition.\n", PREFIX_ERROR);
+            return 1;
+        }
+        // Send device address with read command.
+        i2c_data[0] = ((i2c_dev_adr & 0x7f) << 1) | 0x01;
+        status = Write(mpsse_i2c, i2c_data, 1);
+        if(status) {
+            printf("%sUnable to set the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
+            return 1;
+        }
+        // Check for acknowledge.
+        if(GetAck(mpsse_i2c) != ACK) {
+            printf("%sDid not get acknowledge from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
+            return 1;
+        }
+        // Read from the I2C bus.
+        i2c_data_len = 1;
+        i2c_data_ptr = Read(mpsse_i2c, i2c_data_len);
+        if(i2c_data_ptr == NULL) {
+            printf("%sUnable to read %d byte(s) from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_data_len, i2c_dev_adr);
+            return 1;
+        }
+        // Check for acknowledge.
+        if(GetAck(mpsse_i2c) != ACK) {
+            printf("%sDid not get acknowledge from the I2C chip address 0x%02x after reading data.\n", PREFIX_ERROR, i2c_dev_adr);
+            return 1;
+        }
+        // Generate stop condition.
+        status = Stop(mpsse_i2c);
+        if(status) {
+            printf("%sUnable to generate stop condition.\n", PREFIX_ERROR);
+            return 1;
+        }
+        // Print the data read from I2C.
+        printf("0x%02x\n",(*i2c_data_ptr) & 0x000000ff);
+        free(i2c_data_ptr);
+        #endif
+    // I2C read with chip address and data address.
+    } else if(argc == 3) {
+        #if DEBUG_LEVEL >= 3
+        printf("%sI2C read from chip address 0x%02x, data address 0x%02x.\n", PREFIX_DEBUG, i2c_dev_adr, i2c_data_adr);
+        #endif
+        #ifdef USE_LIBI2C_MPSSE
+        // Write the I2C data address and read the data bytes after a repeated
+        // start condition in one I2C transaction.
+        i2c_read_data = malloc(i2c_read_len);
+        if(i2c_read_data == NULL) {
+            printf("%sCannot allocate memory for %d byte(s).\n", PREFIX_ERROR, i2c_read_len);
+            return 1;
+        }
+        status = i2c_reg_read(i2c_dev_adr, i2c_data_adr, i2c_adr_width, i2c_read_data, i2c_read_len);
+        if(status) {
+            printf("%sUnable to read %d byte(s) from the I2C chip address 0x%02x, data address 0x%02x.\n", PREFIX_ERROR, i2c_read_len, i2c_dev_adr, i2c_data_adr);
+            return 1;
+        }
+        // Print the data read from I2C.
+        print_data(i2c_read_data, i2c_read_len);
+        free(i2c_read_data);
+        #else
+        // Generate start condition.
+        status = Start(mpsse_i2c);
+        if(status) {
+            printf("%sUnable to generate start condition.\n", PREFIX_ERROR);
+            return 1;
+        }
+        // Send device address with write command.
+        i2c_data[0] = ((i2c_dev_adr & 0x7f) << 1) | 0x00;
+        status = Write(mpsse_i2c, i2c_data, 1);
+        if(status) {
+            printf("%sUnable to set the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
+            return 1;
+        }
+        // Check for acknowledge.
+        if(GetAck(mpsse_i2c) != ACK) {
+            printf("%sDid not get acknowledge from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
+            return 1;
+        }
+        // Write the data address
+        i2c_data[0] = i2c_data_adr & 0xff;
+        status = Write(mpsse_i2c, i2c_data, 1);
+        if(status) {
+            printf("%sUnable to set the I2C data address 0x%02x for device address 0x%02x.\n", PREFIX_ERROR, i2c_data_adr, i2c_dev_adr);
+            return 1;
+        }
+        // Check for acknowledge.
+        if(GetAck(mpsse_i2c) != ACK) {
+            printf("%sDid not get acknowledge from the I2C chip address 0x%02x, data address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr, i2c_data_adr);
+            return 1;
+        }
+        //(Re-)Generate start condition.
+        status = Start(mpsse_i2c);
+        if(status) {
+            printf("%sUnable to(re-)generate start condition.\n", PREFIX_ERROR);
+            return 1;
+        }
+        // Send device address with read command.
+        i2c_data[0] = ((i2c_dev_adr & 0x7f) << 1) | 0x01;
+        status = Write(mpsse_i2c, i2c_data, 1);
+        if(status) {
+            printf("%sUnable to set the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
+            return 1;
+        }
+        // Check for acknowledge.
+        if(GetAck(mpsse_i2c) != ACK) {
+            printf("%sDid not get acknowledge from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
+            return 1;
+        }
+        // Read from the I2C bus.
+        i2c_data_len = 1;
+        i2c_data_ptr = Read(mpsse_i2c, i2c_data_len);
+        if(i2c_data_ptr == NULL) {
+            printf("%sUnable to read %d byte(s) from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_data_len, i2c_dev_adr);
+            return 1;
+        }
+        // Check for acknowledge.
+        if(GetAck(mpsse_i2c) != ACK) {
+            printf("%sDid not get acknowledge from the I2C chip address 0x%02x, data address 0x%02x after reading data.\n", PREFIX_ERROR, i2c_dev_adr, i2c_data_adr);
+            return 1;
+        }
+        // Generate stop condition.
+        status = Stop(mpsse_i2c);
+        if(status) {
+            printf("%sUnable to generate stop condition.\n", PREFIX_ERROR);
+            return 1;
+        }
+        // Print the data read from I2C.
+        printf("0x%02x\n",(*i2c_data_ptr) & 0x000000ff);
+        free(i2c_data_ptr);
+        #endif
+    // I2C write.
+    } else if(argc >= 4) {
+        #if DEBUG_LEVEL >= 3
+        printf("%sI2C write to chip address 0x%02x, data address 0x%02x.\n", PREFIX_DEBUG, i2c_dev_adr, i2c_data_adr);
+        printf("%sData: ", PREFIX_DEBUG);
+        for(i = 0; i < i2c_data_len; i++) {
+            printf("0x%02x ",(char)(strtoul(argv[i+3], NULL, 0) & 0xff));
+        }
+        printf("\n");
+        #endif
+        #ifdef USE_LIBI2C_MPSSE
+        // Prepare the I2C data.
+        for(i = 0; i < i2c_data_len; i++)
+            i2c_data[i] = (char)(strtoul(argv[i+3], NULL, 0) & 0xff);
+        // Send the I2C data address and data.
+        status = i2c_reg_write(i2c_dev_adr, i2c_data_adr, i2c_adr_width, i2c_data, i2c_data_len);
+        if(status) {
+            printf("%sUnable to write %d byte(s) to the I2C chip address 0x%02x, data address 0x%02x.\n", PREFIX_ERROR, i2c_data_len, i2c_dev_adr, i2c_data_adr);
+            return 1;
+        }
+        #else
+        // Generate start condition.
+        status = Start(mpsse_i2c);
+        if(status) {
+            printf("%sUnable to generate start condition.\n", PREFIX_ERROR);
+            return 1;
+        }
+        // Send device address with write command.
+        i2c_data[0] = ((i2c_dev_adr & 0x7f) << 1) | 0x00;
+        status = Write(mpsse_i2c, i2c_data, 1);
+        if(status) {
+            printf("%sUnable to set the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
+            return 1;
+        }
+        // Check for acknowledge.
+        if(GetAck(mpsse_i2c) != ACK) {
+            printf("%sDid not get acknowledge from the I2C chip address 0x%02x.\n", PREFIX_ERROR, i2c_dev_adr);
+            return 1;
+        }
+        // Prepare the I2C data.
+        i2c_data[0] = (char)(i2c_data_adr & 0xff);
+        for(i = 0; i < i2c_data_len; i++)
+            i2c_data[i+1] = (char)(strtoul(argv[i+3], NULL, 0) & 0xff);
+        // Send the I2C data.
+        status = Write(mpsse_i2c, i2c_data, i2c_data_len + 1);
+        if(status) {
+            printf("%sUnable to write %d byte(s) to the I2C chip address 0x%02x, data address 0x%02x.\n", PREFIX_ERROR, i2c_data_len, i2c_dev_adr, i2c_data_adr);
+            return 1;
+        }
+        // Check for acknowledge.
+        if(GetAck(mpsse_i2c) != ACK) {
+            printf("%sDid not get acknowledge from the I2C chip address 0x%02x after writing data.\n", PREFIX_ERROR, i2c_dev_adr);
+            return 1;
+        }
+        // Generate stop condition.
+        status = Stop(mpsse_i2c);
+        if(status) {
+            printf("%sUnable to generate stop condition.\n", PREFIX_ERROR);
+            return 1;
+        }
+        #endif
+    } else {
+        printf("%sSpecify either 2..3(for read) or 4(for write) parameters!", PREFIX_ERROR);
+        return 1;
+    }
+
+    // Close the I2C device.
+    #ifdef USE_LIBI2C_MPSSE
+    i2c_close();
+    #else
+    Close(mpsse_i2c);
+    #endif
+
+    return 0;
+}
+
+
+
+#ifdef USE_LIBI2C_MPSSE
+// Print data read from I2C, 16 bytes per line.
+void print_data(char *data, int len)
+{
+    int i;
+
+    for(i = 0; i < len; i++)
+        printf("0x%02x%s", data[i] & 0xff, ((i % 16) == 15 || i == len - 1) ? "\n" : " ");
+}
+
+
+
+// Execute a script of I2C operations. The script is read from stdin if the
+// file name is "-".
+int run_script(char *script_file_name, int i2c_freq, int i2c_strap)
+{
+    int status;
+    FILE *fp_script_file;
+    struct i2c_script script;
+
+    // Parse the whole script before accessing the I2C bus.
+    if(!strcmp(script_file_name, "-")) {
+        fp_script_file = stdin;
+    } else {
+        fp_script_file = fopen(script_file_name, "r");
+        if(fp_script_file == NULL) {
+            printf("%sCannot open the script file \"%s\".\n", PREFIX_ERROR, script_file_name);
+            return 1;
+        }
+    }
+    status = i2c_script_parse(fp_script_file, &script);
+    if(fp_script_file != stdin)
+        fclose(fp_script_file);
+    if(status) {
+        printf("%sErrors in the script \"%s\".\n", PREFIX_ERROR, script_file_name);
+        i2c_script_free(&script);
+        return 1;
+    }
+
+    // Initialize the I2C master device.
+    status = i2c_init();
+    if(status) {
+        printf("%sUnable to open the I2C device.\n", PREFIX_ERROR);
+        i2c_script_free(&script);
+        return 1;
+    }
+    // Set the I2C bus frequency.
+    status = i2c_set_freq(i2c_freq);
+    if(status) {
+        printf("%sUnable to set the I2C frequency to %d Hz.\n", PREFIX_ERROR, i2c_freq);
+        i2c_close();
+        i2c_script_free(&script);
+        return 1;
+    }
+    // Use the ADBUS1/ADBUS2 strap for reading.
+    if(i2c_strap && i2c_set_strap(1)) {
+        printf("%sUnable to set the I2C SDA strap.\n", PREFIX_ERROR);
+        i2c_close();
+        i2c_script_free(&script);
+        return 1;
+    }
+    // Set verbosity of the I2C library functions.
+    i2c_set_verbose(1);
+
+    // Execute the script.
+    status = i2c_script_run(&script);
+
+    // Close the I2C device.
+    i2c_close();
+    i2c_script_free(&script);
+
+    return status ? 1 : 0;
+}
+#endif
+
+
+
+// Show help message.
+int show_help(char* prog_name)
+{
+    printf("Raw I2C IO control program (read/write)\n");
+    printf("\n");
+    #ifdef USE_LIBI2C_MPSSE
+    printf("Usage: %s [-s FREQ] [-t] [-i IFACE] [-w WORKLOAD] [-a ADR-WIDTH] [-n LEN] CHIP-ADR [DATA-ADR] [DATA]\n", prog_name);
+    printf("       %s [-s FREQ] [-t] [-i IFACE] [-w WORKLOAD] -f [SCRIPT-FILE]\n", prog_name);
+    printf("       %s [-i IFACE] -T WORKLOAD\n", prog_name);
+    printf("\n");
+    printf("  -s FREQ        I2C frequency in Hz, up to 1000000 (default: 100000).\n");
+    printf("  -t             ADBUS1 and ADBUS2 are tied together, use them for faster reads.\n");
+    printf("  -i IFACE       MPSSE interface of an FT2232H or FT4232H: A (default) .. D.\n");
+    printf("  -w WORKLOAD    Apply the USB settings profile of the workload class: poll (default) or stream.\n");
+    printf("  -T WORKLOAD    Measure the USB settings for the workload class and save the best ones.\n");
+    printf("  -a ADR-WIDTH   Width of the data address: 0, 1 (default), 2 or 4 bytes.\n");
+    printf("  -n LEN         Number of bytes to read (default: 1).\n");
+    printf("  -f SCRIPT-FILE Execute a script of I2C operations, see below.\n");
+    printf("\n");
+    printf("Script mode: Execute the I2C operations of SCRIPT-FILE or of stdin, if\n");
+    printf("SCRIPT-FILE is omitted or \"-\". One operation per line, '#' starts a comment:\n");
+    printf("  w CHIP-ADR [DATA ...]        Write data bytes.\n");
+    printf("  r CHIP-ADR LEN               Read LEN data bytes.\n");
+    printf("  wr CHIP-ADR LEN [DATA ...]   Write data bytes, then read LEN data bytes.\n");
+    printf("  sleep MSEC                   Wait for MSEC milliseconds.\n");
+    printf("  delay USEC                   Wait for USEC microseconds, timed by the FTDI chip.\n");
+    printf("  expect DATA[/MASK] ...       Compare the data of the previous read.\n");
+    #else
+    printf("Usage: %s CHIP-ADR [DATA-ADR] [DATA]\n", prog_name);
+    #endif
+    return 0;
+}
+
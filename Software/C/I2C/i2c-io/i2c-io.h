@@ -1,46 +1,49 @@
-// File: i2c-io.h
-// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
-// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
-// Date: 05 Feb 2018
-// Rev.: 16 Feb 2018
-//
-// Header file for the raw I2C IO control program for the FTDI FH232H chip.
-//
-
-
-
-#ifndef __I2C_IO_H
-#define __I2C_IO_H
-
-
-
-// Use I2C MPSSE library functions.
-#define USE_LIBI2C_MPSSE
-#ifdef USE_LIBI2C_MPSSE
-#include "i2c_mpsse.h"
-#endif
-
-
-
-// Maximum I2C data length.
-#define I2C_DATA_LEN_MAX        1024
-
-
-
-// Message prefixes.
-#define PREFIX_DEBUG            "DEBUG: "
-#define PREFIX_ERROR            "ERROR: "
-
-
-
-// Level of debug info.
-#define DEBUG_LEVEL 0
-//#define DEBUG_LEVEL 1
-//#define DEBUG_LEVEL 2
-//#define DEBUG_LEVEL 3
-//#define DEBUG_LEVEL 4
-
-
-
-#endif
-
+// File: i2c-io.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 05 Feb 2018
+// Rev.: 19 Oct 2026
+//
+// Header file for the raw I2C IO control program for the FTDI FH232H chip.
+//
+
+
+
+#ifndef __I2C_IO_H
+#define __I2C_IO_H
+
+
+
+// Use I2C MPSSE library functions.
+#define USE_LIBI2C_MPSSE
+#ifdef USE_LIBI2C_MPSSE
+#include "i2c_mpsse.h"
+#endif
+
+
+
+// Maximum I2C data length.
+#define I2C_DATA_LEN_MAX        1024
+
+// Maximum number of bytes read in one I2C transaction.
+#define I2C_READ_LEN_MAX        (16 * 1024 * 1024)
+
+
+
+// Message prefixes.
+#define PREFIX_DEBUG            "DEBUG: "
+#define PREFIX_ERROR            "ERROR: "
+
+
+
+// Level of debug info.
+#define DEBUG_LEVEL 0
+//#define DEBUG_LEVEL 1
+//#define DEBUG_LEVEL 2
+//#define DEBUG_LEVEL 3
+//#define DEBUG_LEVEL 4
+
+
+
+#endif
+
@@ -1,38 +1,38 @@
-// File: i2c-si5xxx-init.h
-// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
-// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
-// Date: 12 Feb 2018
-// Rev.: 16 Feb 2018
-//
-// Header file for the initialization of a Silicon Labs clock generator /
-// jitter attenuator chip (e.g. Si5338, Si5324) via I2C.
-//
-
-
-
-#ifndef __I2C_SI5XXX_INIT_H
-#define __I2C_SI5XXX_INIT_H
-
-
-
-#include "i2c_mpsse.h"
-
-
-
-// Message prefixes.
-#define PREFIX_DEBUG            "DEBUG: "
-#define PREFIX_ERROR            "ERROR: "
-
-
-
-// Level of debug info.
-#define DEBUG_LEVEL 0
-//#define DEBUG_LEVEL 1
-//#define DEBUG_LEVEL 2
-//#define DEBUG_LEVEL 3
-//#define DEBUG_LEVEL 4
-
-
-
-#endif
-
+// File: i2c-si5xxx-init.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 12 Feb 2018
+// Rev.: 16 Feb 2018
+//
+// Header file for the initialization of a Silicon Labs clock generator /
+// jitter attenuator chip (e.g. Si5338, Si5324) via I2C.
+//
+
+
+
+#ifndef __I2C_SI5XXX_INIT_H
+#define __I2C_SI5XXX_INIT_H
+
+
+
+#include "i2c_mpsse.h"
+
+
+
+// Message prefixes.
+#define PREFIX_DEBUG            "DEBUG: "
+#define PREFIX_ERROR            "ERROR: "
+
+
+
+// Level of debug info.
+#define DEBUG_LEVEL 0
+//#define DEBUG_LEVEL 1
+//#define DEBUG_LEVEL 2
+//#define DEBUG_LEVEL 3
+//#define DEBUG_LEVEL 4
+
+
+
+#endif
+
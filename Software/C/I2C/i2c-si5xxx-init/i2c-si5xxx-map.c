@@ -0,0 +1,555 @@
+// File: i2c-si5xxx-map.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Load the register map of a Silicon Labs clock generator / jitter attenuator
+// chip with paged register address space via I2C.
+//
+// The register addresses of the map may exceed 8 bits:
+// - Si534x (Si5341, Si5345, Si5395, ...): 16 bit addresses of the ClockBuilder
+//   Pro maps. The upper byte is selected with the page register 0x01.
+// - Si5338: Addresses 256..350 are accessed with bit 0 of the page register
+//   255 set. The maps either use these addresses directly, or they contain
+//   writes to the page register followed by the 8 bit addresses of the page.
+// Writes to the page register in the map only change the page of the
+// following 8 bit addresses. The loader keeps track of the page selected on
+// the chip and only writes the page register when the page changes.
+//
+// The register writes are split into groups at delays and at the start and
+// end of the preamble and the postamble. Consecutive registers of a group are
+// written in one I2C burst, using the address auto-increment of the chip. The
+// configuration registers between the preamble and the postamble are sorted by
+// address first. All other writes keep the order of the map, as e.g. the
+// calibration of the Si5324 must be started by the last write. Registers with a write-allowed mask are
+// read first, also in bursts, to merge the new bits. All reads and all writes
+// of a group are executed as one batch in a single USB transfer.
+//
+// Delays of up to MPSSE_ADAPTER_DELAY_MAX after a group are timed by the MPSSE
+// after the last write of the group. The host does not wait for them, the
+// MPSSE executes the next group only after the delay.
+//
+// Identical chips behind several channels of a PCA9548 multiplexer are loaded
+// at once. The registers with a write-allowed mask are read from each chip
+// separately. A group is written to all chips at once with all their channels
+// enabled, if its data is the same for all chips, which is always the case for
+// groups without masked registers. Otherwise, the group is written to each chip
+// separately.
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <mpsse.h>
+#include "mpsse_adapter.h"
+#include "i2c-si5xxx-init.h"
+#include "i2c-si5xxx-map.h"
+
+
+
+// Batch of I2C transactions.
+struct si5xxx_batch {
+    struct i2c_mpsse_xfer *xfers;
+    struct i2c_mpsse_msg *msgs;
+    int *adrs;                  // Register address of each transaction, -1 = page select.
+    char *data;
+    int num;
+    int num_msgs;
+    int len;
+};
+
+
+
+// Function prototypes.
+static struct si5xxx_group *si5xxx_map_split(struct si5xxx_map *map);
+static int si5xxx_reg_compare(const void *a, const void *b);
+static int si5xxx_group_prepare(struct si5xxx_map *map, struct si5xxx_group *group, int page_reg, int *file_page, struct si5xxx_reg *w);
+static int si5xxx_batch_page(struct si5xxx_batch *batch, int i2c_dev_adr, int page_reg, int page, int *cur_page, struct si5xxx_stats *stats);
+static int si5xxx_batch_run(struct si5xxx_batch *batch, int i2c_dev_adr, const char *what, struct si5xxx_target *target, int channel);
+
+
+
+// Initialize a register map.
+void si5xxx_map_init(struct si5xxx_map *map)
+{
+    memset(map, 0, sizeof(struct si5xxx_map));
+}
+
+
+
+// Free the memory of a register map.
+void si5xxx_map_free(struct si5xxx_map *map)
+{
+    free(map->regs);
+    free(map->groups);
+    si5xxx_map_init(map);
+}
+
+
+
+// Add a register write to the current group of a register map.
+int si5xxx_map_add(struct si5xxx_map *map, int adr, int data, int mask)
+{
+    struct si5xxx_reg *regs;
+
+    if(map->num_groups == 0 && si5xxx_map_split(map) == NULL) return -1;
+
+    if(map->num_regs >= map->size_regs) {
+        regs = realloc(map->regs, (map->size_regs ? 2 * map->size_regs : 256) * sizeof(struct si5xxx_reg));
+        if(regs == NULL) {
+            fprintf(stderr, "%s: %s: %sCannot allocate memory for the register map.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+            return -1;
+        }
+        map->regs = regs;
+        map->size_regs = map->size_regs ? 2 * map->size_regs : 256;
+    }
+    map->regs[map->num_regs].adr = adr;
+    map->regs[map->num_regs].data = data;
+    map->regs[map->num_regs].mask = mask;
+    map->regs[map->num_regs].index = map->num_regs;
+    map->num_regs++;
+    map->groups[map->num_groups - 1].num++;
+
+    return 0;
+}
+
+
+
+// Check a line of the register map file for the comments marking delays and
+// the preamble and postamble, e.g. of ClockBuilder Pro:
+//   /* Start configuration preamble */
+//   /* Delay 300 msec */
+//   # End configuration postamble
+// Returns 1 if a marker was found, otherwise 0, or -1 on error.
+int si5xxx_map_comment(struct si5xxx_map *map, const char *line)
+{
+    int i;
+    long delay;
+    char *end;
+    char comment[256];
+    const char *ptr;
+    struct si5xxx_group *group;
+
+    // Only look at the comment part of the line.
+    ptr = strchr(line, '#');
+    if(ptr == NULL) ptr = strstr(line, "//");
+    if(ptr == NULL) ptr = strstr(line, "/*");
+    if(ptr == NULL) return 0;
+    for(i = 0; ptr[i] && i < (int) sizeof(comment) - 1; i++)
+        comment[i] = tolower((unsigned char) ptr[i]);
+    comment[i] = 0;
+
+    // Start or end of the preamble or postamble.
+    if(strstr(comment, "preamble") != NULL || strstr(comment, "postamble") != NULL) {
+        map->sections = 1;
+        if(strstr(comment, "start") != NULL)
+            map->ordered = 1;
+        else if(strstr(comment, "end") != NULL)
+            map->ordered = 0;
+        else
+            return 0;
+        return (si5xxx_map_split(map) == NULL) ? -1 : 1;
+    }
+
+    // Delay.
+    ptr = strstr(comment, "delay");
+    if(ptr == NULL) return 0;
+    delay = strtol(ptr + 5, &end, 10);
+    while(isspace((unsigned char) *end)) end++;
+    if(end == ptr + 5 || delay <= 0 || strncmp(end, "ms", 2)) return 0;
+    if(map->num_groups == 0 && si5xxx_map_split(map) == NULL) return -1;
+    map->groups[map->num_groups - 1].delay += (int) delay;
+    group = si5xxx_map_split(map);
+
+    return (group == NULL) ? -1 : 1;
+}
+
+
+
+// Detect the page select register from the register addresses of a map.
+int si5xxx_map_page_reg(struct si5xxx_map *map)
+{
+    int i;
+    int adr_max = 0;
+    int page_write = 0;
+
+    for(i = 0; i < map->num_regs; i++) {
+        if(map->regs[i].adr > adr_max)
+            adr_max = map->regs[i].adr;
+        if(map->regs[i].adr == SI5XXX_PAGE_REG_SI5338)
+            page_write = 1;
+    }
+
+    if(adr_max > 0x1ff) return SI5XXX_PAGE_REG_SI534X;
+    if(adr_max > 0xff || page_write) return SI5XXX_PAGE_REG_SI5338;
+
+    return SI5XXX_PAGE_REG_NONE;
+}
+
+
+
+// Load a register map into the chip. If target is not NULL, the map is loaded
+// into identical chips behind several channels of a multiplexer: the
+// registers with a write-allowed mask are read per channel. Groups resulting
+// in the same data for all chips are written to all of them at once, other
+// groups per channel.
+int si5xxx_map_load(struct si5xxx_map *map, int i2c_dev_adr, int page_reg, struct si5xxx_target *target, struct si5xxx_stats *stats)
+{
+    int c, g, i, j, k, n;
+    int num_ch = 1;
+    int channel[8] = {-1};
+    int delay;
+    int status = 0;
+    int file_page = 0;
+    int cur_page = -1;          // Page selected on the chip, -1 = unknown.
+    int start_page;
+    int broadcast;
+    char page_data[2];
+    char *cur = NULL;           // Register values read, per channel.
+    char *val = NULL;           // Register values to write, per channel.
+    struct si5xxx_reg *w = NULL;
+    struct si5xxx_batch batch;
+    struct i2c_mpsse_xfer *xfer;
+
+    memset(stats, 0, sizeof(struct si5xxx_stats));
+    memset(&batch, 0, sizeof(struct si5xxx_batch));
+    if(page_reg == SI5XXX_PAGE_REG_AUTO)
+        page_reg = si5xxx_map_page_reg(map);
+    if(target != NULL) {
+        for(c = 0, num_ch = 0; c < 8; c++)
+            if((target->channels >> c) & 0x1)
+                channel[num_ch++] = c;
+        if(num_ch == 0) return -1;
+    }
+
+    // Allocate the working memory for the largest possible group.
+    n = map->num_regs + 1;
+    w = malloc(n * sizeof(struct si5xxx_reg));
+    cur = malloc(n * num_ch);
+    val = malloc(n * num_ch);
+    batch.xfers = malloc((2 * n + 1) * sizeof(struct i2c_mpsse_xfer));
+    batch.msgs = malloc(2 * (2 * n + 1) * sizeof(struct i2c_mpsse_msg));
+    batch.adrs = malloc((2 * n + 1) * sizeof(int));
+    batch.data = malloc(4 * n + 2);
+    if(w == NULL || cur == NULL || val == NULL || batch.xfers == NULL || batch.msgs == NULL || batch.adrs == NULL || batch.data == NULL) {
+        fprintf(stderr, "%s: %s: %sCannot allocate memory for loading the register map.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        status = -1;
+    }
+
+    for(g = 0; g < map->num_groups && !status; g++) {
+        n = si5xxx_group_prepare(map, &map->groups[g], page_reg, &file_page, w);
+
+        // Read the registers with a write-allowed mask, unless the register
+        // was already written before within this group. Consecutive registers
+        // are read in one burst.
+        batch.num = batch.num_msgs = batch.len = 0;
+        for(i = 0; i < n; i = j) {
+            for(k = i - 1; k >= 0 && w[k].adr != w[i].adr; k--);
+            if(w[i].mask == 0xff || k >= 0) {
+                j = i + 1;
+                continue;
+            }
+            for(j = i + 1; j < n && w[j].mask != 0xff && w[j].adr == w[j-1].adr + 1 && (w[j].adr >> 8) == (w[i].adr >> 8); j++);
+            if(page_reg >= 0)
+                si5xxx_batch_page(&batch, i2c_dev_adr, page_reg, w[i].adr >> 8, &cur_page, stats);
+            xfer = &batch.xfers[batch.num];
+            xfer->msgs = &batch.msgs[batch.num_msgs];
+            xfer->num = 2;
+            xfer->delay = 0;
+            xfer->msgs[0].adr = i2c_dev_adr;
+            xfer->msgs[0].flags = 0;
+            xfer->msgs[0].len = 1;
+            xfer->msgs[0].buf = &batch.data[batch.len];
+            xfer->msgs[0].buf[0] = w[i].adr & 0xff;
+            xfer->msgs[1].adr = i2c_dev_adr;
+            xfer->msgs[1].flags = I2C_MPSSE_M_RD;
+            xfer->msgs[1].len = j - i;
+            xfer->msgs[1].buf = &cur[i];
+            batch.adrs[batch.num] = w[i].adr;
+            batch.num++;
+            batch.num_msgs += 2;
+            batch.len++;
+            stats->reads++;
+        }
+        // The chips behind a multiplexer are read one channel after the
+        // other, each into its own part of the buffer.
+        for(c = 0; c < num_ch && batch.num > 0 && !status; c++) {
+            for(i = 0; i < batch.num; i++)
+                if(batch.xfers[i].num == 2)
+                    batch.xfers[i].msgs[1].buf += c ? n : 0;
+            stats->batches++;
+            if(si5xxx_batch_run(&batch, i2c_dev_adr, "read", target, channel[c]))
+                status = -1;
+        }
+        if(status) break;
+
+        // Merge the bits to be written into the current register values. For
+        // more details on the write-allowed mask, see the Silicon Labs Si5338
+        // reference manual (Si5338-RM.pdf), page 29.
+        for(c = 0; c < num_ch; c++) {
+            for(i = 0; i < n; i++) {
+                val[c * n + i] = w[i].data;
+                if(w[i].mask == 0xff) continue;
+                for(k = i - 1; k >= 0 && w[k].adr != w[i].adr; k--);
+                val[c * n + i] = (((k >= 0) ? val[c * n + k] : cur[c * n + i]) & ~w[i].mask) | (w[i].data & w[i].mask);
+            }
+        }
+
+        // Write the group to all chips at once, if the data is the same for
+        // all of them. Otherwise, write it to each chip separately.
+        broadcast = 1;
+        for(c = 1; c < num_ch; c++)
+            if(memcmp(val, &val[c * n], n))
+                broadcast = 0;
+        if(target != NULL && broadcast)
+            stats->broadcasts++;
+        start_page = cur_page;
+        delay = map->groups[g].delay * 1000;
+        for(c = 0; c < (broadcast ? 1 : num_ch) && !status; c++) {
+            // Write consecutive registers of the same page in one burst.
+            cur_page = start_page;
+            batch.num = batch.num_msgs = batch.len = 0;
+            for(i = 0; i < n; i = j) {
+                for(j = i + 1; j < n && w[j].adr == w[j-1].adr + 1 && (w[j].adr >> 8) == (w[i].adr >> 8); j++);
+                if(page_reg >= 0)
+                    si5xxx_batch_page(&batch, i2c_dev_adr, page_reg, w[i].adr >> 8, &cur_page, stats);
+                xfer = &batch.xfers[batch.num];
+                xfer->msgs = &batch.msgs[batch.num_msgs];
+                xfer->num = 1;
+                xfer->delay = 0;
+                xfer->msgs[0].adr = i2c_dev_adr;
+                xfer->msgs[0].flags = 0;
+                xfer->msgs[0].len = 1 + j - i;
+                xfer->msgs[0].buf = &batch.data[batch.len];
+                xfer->msgs[0].buf[0] = w[i].adr & 0xff;
+                for(k = i; k < j; k++)
+                    xfer->msgs[0].buf[1 + k - i] = val[c * n + k];
+                batch.adrs[batch.num] = w[i].adr;
+                batch.num++;
+                batch.num_msgs++;
+                batch.len += 1 + j - i;
+                stats->writes++;
+                stats->regs += j - i;
+            }
+            // Wait, e.g. for the calibration of the chip after the preamble.
+            // Short delays are timed by the MPSSE after the last write. Chips
+            // written separately are calibrated in parallel, so only wait
+            // after the last one.
+            if(batch.num > 0 && c == (broadcast ? 0 : num_ch - 1) && delay <= MPSSE_ADAPTER_DELAY_MAX) {
+                batch.xfers[batch.num - 1].delay = delay;
+                delay = 0;
+            }
+            if(batch.num > 0) {
+                stats->batches++;
+                if(si5xxx_batch_run(&batch, i2c_dev_adr, "write", target, broadcast ? -1 : channel[c]))
+                    status = -1;
+            }
+        }
+        if(status) break;
+        if(delay > 0)
+            usleep(delay);
+    }
+
+    // Leave the chip with page 0 selected.
+    if(!status && page_reg >= 0 && cur_page != 0) {
+        page_data[0] = page_reg;
+        page_data[1] = 0;
+        if(target != NULL)
+            status = i2c_mux_broadcast_write(target->topo, target->mux, target->channels, i2c_dev_adr, page_data, 2);
+        else
+            status = i2c_write(i2c_dev_adr, page_data, 2);
+        if(status) {
+            fprintf(stderr, "%s: %s: %sUnable to select page 0 of the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i2c_dev_adr);
+            status = -1;
+        } else {
+            stats->page_selects++;
+        }
+    }
+
+    free(w);
+    free(cur);
+    free(val);
+    free(batch.xfers);
+    free(batch.msgs);
+    free(batch.adrs);
+    free(batch.data);
+
+    return status;
+}
+
+
+
+// Start a new group of register writes. An empty group is reused.
+static struct si5xxx_group *si5xxx_map_split(struct si5xxx_map *map)
+{
+    struct si5xxx_group *groups;
+    struct si5xxx_group *group;
+
+    if(map->num_groups > 0) {
+        group = &map->groups[map->num_groups - 1];
+        if(group->num == 0 && group->delay == 0) {
+            group->ordered = map->ordered;
+            return group;
+        }
+    }
+
+    if(map->num_groups >= map->size_groups) {
+        groups = realloc(map->groups, (map->size_groups ? 2 * map->size_groups : 16) * sizeof(struct si5xxx_group));
+        if(groups == NULL) {
+            fprintf(stderr, "%s: %s: %sCannot allocate memory for the register map.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+            return NULL;
+        }
+        map->groups = groups;
+        map->size_groups = map->size_groups ? 2 * map->size_groups : 16;
+    }
+    group = &map->groups[map->num_groups++];
+    group->first = map->num_regs;
+    group->num = 0;
+    group->ordered = map->ordered;
+    group->delay = 0;
+
+    return group;
+}
+
+
+
+// Compare two register writes by address, then by position in the file.
+static int si5xxx_reg_compare(const void *a, const void *b)
+{
+    const struct si5xxx_reg *ra = (const struct si5xxx_reg *) a;
+    const struct si5xxx_reg *rb = (const struct si5xxx_reg *) b;
+
+    if(ra->adr != rb->adr) return ra->adr - rb->adr;
+
+    return ra->index - rb->index;
+}
+
+
+
+// Prepare the register writes of a group. The writes to the page register are
+// removed and all addresses are converted to the full address including the
+// page. Registers with an empty write-allowed mask are dropped. The
+// configuration registers of a map with preamble and postamble are sorted by
+// address and multiple writes to the same register are merged. Returns the
+// number of register writes.
+static int si5xxx_group_prepare(struct si5xxx_map *map, struct si5xxx_group *group, int page_reg, int *file_page, struct si5xxx_reg *w)
+{
+    int i, n = 0;
+    struct si5xxx_reg *reg;
+
+    for(i = 0; i < group->num; i++) {
+        reg = &map->regs[group->first + i];
+        if(page_reg >= 0 && (reg->adr & 0xff) == page_reg) {
+            *file_page = reg->data & ((page_reg == SI5XXX_PAGE_REG_SI5338) ? 0x01 : 0xff);
+            continue;
+        }
+        if(reg->mask == 0) continue;
+        w[n] = *reg;
+        if(page_reg >= 0 && reg->adr <= 0xff)
+            w[n].adr = (*file_page << 8) | reg->adr;
+        n++;
+    }
+    if(!map->sections || group->ordered || n == 0) return n;
+
+    qsort(w, n, sizeof(struct si5xxx_reg), si5xxx_reg_compare);
+    for(i = 1, reg = w; i < n; i++) {
+        if(w[i].adr == reg->adr) {
+            reg->data = (reg->data & ~w[i].mask) | (w[i].data & w[i].mask);
+            reg->mask |= w[i].mask;
+        } else {
+            *(++reg) = w[i];
+        }
+    }
+
+    return reg - w + 1;
+}
+
+
+
+// Add a page select to a batch, if the page changes.
+static int si5xxx_batch_page(struct si5xxx_batch *batch, int i2c_dev_adr, int page_reg, int page, int *cur_page, struct si5xxx_stats *stats)
+{
+    struct i2c_mpsse_xfer *xfer;
+
+    if(page == *cur_page) return 0;
+
+    xfer = &batch->xfers[batch->num];
+    xfer->msgs = &batch->msgs[batch->num_msgs];
+    xfer->num = 1;
+    xfer->delay = 0;
+    xfer->msgs[0].adr = i2c_dev_adr;
+    xfer->msgs[0].flags = 0;
+    xfer->msgs[0].len = 2;
+    xfer->msgs[0].buf = &batch->data[batch->len];
+    xfer->msgs[0].buf[0] = page_reg;
+    xfer->msgs[0].buf[1] = page;
+    batch->adrs[batch->num] = -1;
+    batch->num++;
+    batch->num_msgs++;
+    batch->len += 2;
+    stats->page_selects++;
+    *cur_page = page;
+
+    return 1;
+}
+
+
+
+// Execute a batch of I2C transactions in one USB transfer. Behind a
+// multiplexer, the batch is executed either on one channel or, for channel -1,
+// on all channels of the target at once.
+static int si5xxx_batch_run(struct si5xxx_batch *batch, int i2c_dev_adr, const char *what, struct si5xxx_target *target, int channel)
+{
+    int i;
+    int status;
+    int delay;
+    struct i2c_mux_op *ops;
+
+    if(target == NULL) {
+        status = i2c_transfer_batch(batch->xfers, batch->num);
+    } else if(channel < 0) {
+        status = i2c_mux_broadcast(target->topo, target->mux, target->channels, batch->xfers, batch->num);
+    } else {
+        // The multiplexer layer does not time delays, so wait on the host.
+        ops = malloc(batch->num * sizeof(struct i2c_mux_op));
+        if(ops == NULL) {
+            fprintf(stderr, "%s: %s: %sCannot allocate memory for the I2C multiplexer batch.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+            return -1;
+        }
+        for(i = 0; i < batch->num; i++) {
+            ops[i].mux = target->mux;
+            ops[i].channel = channel;
+            ops[i].msgs = batch->xfers[i].msgs;
+            ops[i].num = batch->xfers[i].num;
+        }
+        status = i2c_mux_batch(target->topo, ops, batch->num);
+        for(i = 0, delay = 0; i < batch->num; i++) {
+            batch->xfers[i].status = ops[i].status;
+            delay += batch->xfers[i].delay;
+        }
+        free(ops);
+        if(!status && delay > 0)
+            usleep(delay);
+    }
+    if(!status) return 0;
+
+    for(i = 0; i < batch->num; i++) {
+        if(!batch->xfers[i].status) continue;
+        if(batch->adrs[i] < 0)
+            fprintf(stderr, "%sUnable to select page 0x%02x of the I2C chip address 0x%02x", PREFIX_ERROR, batch->xfers[i].msgs[0].buf[1] & 0xff, i2c_dev_adr);
+        else
+            fprintf(stderr, "%sUnable to %s the register 0x%04x of the I2C chip address 0x%02x", PREFIX_ERROR, what, batch->adrs[i], i2c_dev_adr);
+        if(target != NULL && channel >= 0)
+            fprintf(stderr, " on multiplexer channel %d", channel);
+        fprintf(stderr, ".\n");
+        break;
+    }
+
+    return -1;
+}
+
@@ -0,0 +1,92 @@
+// File: i2c-si5xxx-map.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for loading the register map of a Silicon Labs clock generator /
+// jitter attenuator chip with paged register address space via I2C.
+//
+
+
+
+#ifndef __I2C_SI5XXX_MAP_H
+#define __I2C_SI5XXX_MAP_H
+
+
+
+#include "i2c_mux.h"
+
+
+
+// Page select registers.
+#define SI5XXX_PAGE_REG_NONE        -1      // No paging, e.g. Si5324, Si5319.
+#define SI5XXX_PAGE_REG_AUTO        -2      // Detect from the register addresses.
+#define SI5XXX_PAGE_REG_SI534X      0x01    // Si5341, Si5345, Si5395, ...
+#define SI5XXX_PAGE_REG_SI5338      255     // Si5338, bit 0 selects registers 256..511.
+
+
+
+// Register write of a register map.
+struct si5xxx_reg {
+    int adr;                    // Register address as given in the file.
+    int data;                   // Data byte.
+    int mask;                   // Write-allowed bits, 0xff = whole register.
+    int index;                  // Position in the file, for stable sorting.
+};
+
+// Group of register writes. Groups are separated by delays and by the start
+// and end of the preamble and the postamble of ClockBuilder Pro register maps.
+// The configuration registers between the preamble and the postamble may be
+// reordered.
+struct si5xxx_group {
+    int first;                  // Index of the first register write.
+    int num;                    // Number of register writes.
+    int ordered;                // Keep the order of the file (preamble, postamble).
+    int delay;                  // Delay in ms after the group.
+};
+
+// Register map.
+struct si5xxx_map {
+    struct si5xxx_reg *regs;
+    int num_regs;
+    int size_regs;
+    struct si5xxx_group *groups;
+    int num_groups;
+    int size_groups;
+    int ordered;                // Inside a preamble or postamble.
+    int sections;               // Preamble or postamble found, the other registers may be sorted.
+};
+
+// Identical chips behind several channels of an I2C multiplexer, loaded with
+// the same register map at once.
+struct si5xxx_target {
+    struct i2c_mux_topo *topo;  // Multiplexer topology.
+    int mux;                    // Index of the multiplexer (I2C_MUX_TYPE_PCA9548).
+    int channels;               // Channel mask.
+};
+
+// Statistics of loading a register map.
+struct si5xxx_stats {
+    int regs;                   // Registers written.
+    int writes;                 // I2C write transactions (bursts).
+    int reads;                  // I2C read transactions for masked registers.
+    int page_selects;           // Page select writes.
+    int batches;                // USB transfers.
+    int broadcasts;             // Groups written to all chips at once.
+};
+
+
+
+// Function prototypes.
+void si5xxx_map_init(struct si5xxx_map *map);
+void si5xxx_map_free(struct si5xxx_map *map);
+int si5xxx_map_add(struct si5xxx_map *map, int adr, int data, int mask);
+int si5xxx_map_comment(struct si5xxx_map *map, const char *line);
+int si5xxx_map_page_reg(struct si5xxx_map *map);
+int si5xxx_map_load(struct si5xxx_map *map, int i2c_dev_adr, int page_reg, struct si5xxx_target *target, struct si5xxx_stats *stats);
+
+
+
+#endif
+
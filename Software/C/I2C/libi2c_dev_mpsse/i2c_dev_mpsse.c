@@ -0,0 +1,660 @@
+// File: i2c_dev_mpsse.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Linux i2c-dev emulation on top of the hardware I2C IO functions based on
+// FTDI's Multi-Protocol Synchronous Serial Engine (MPSSE).
+//
+// The library is loaded with LD_PRELOAD into unmodified programs using the
+// Linux i2c-dev interface, e.g. i2cdetect, i2cget, i2cset, i2cdump and
+// i2ctransfer of the i2c-tools:
+//   LD_PRELOAD=./libi2c_dev_mpsse.so I2C_DEV_MPSSE_BUS=9 i2cdetect -y 9
+//
+// Opening /dev/i2c-N (or /dev/i2c/N), where N is set by the environment
+// variable I2C_DEV_MPSSE_BUS (default: 0), opens the MPSSE I2C adapter
+// instead. The program gets a file descriptor of /dev/null as handle, all
+// i2c-dev ioctls and reads/writes on it are executed by the MPSSE I2C engine:
+// - I2C_RDWR: All messages are executed as one combined I2C transaction in one
+//   USB transfer, separated by repeated start conditions. Messages with the
+//   flag I2C_M_STOP end a transaction, the next one is started after the
+//   previous one succeeded.
+// - I2C_SMBUS: The SMBus transfers are mapped onto combined I2C transactions.
+//   SMBus block reads and PEC are not supported, see I2C_DEV_MPSSE_FUNCS.
+// - read(), write(): One I2C transaction with the address set by I2C_SLAVE.
+//
+// Further environment variables:
+// - I2C_DEV_MPSSE_SERIAL: Serial number of the FTDI device to use.
+// - I2C_DEV_MPSSE_IFACE: MPSSE interface of an FT2232H or FT4232H (A .. D).
+// - I2C_DEV_MPSSE_FREQ: I2C frequency in Hz (default: 100000).
+// - I2C_DEV_MPSSE_VERBOSE: Print the error messages of the I2C library. As
+//   bus scans expect NACKs, they are suppressed by default.
+//
+// The adapter is opened with the first file descriptor and closed with the
+// last one. Address NACKs are reported as ENXIO, like most kernel drivers do.
+// As ten bit addresses are not supported by the MPSSE I2C engine, I2C_TENBIT
+// fails.
+//
+
+
+
+// Use the plain definitions of the C library functions that are replaced.
+#define _GNU_SOURCE
+#undef _FORTIFY_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "mpsse_adapter.h"
+#include "i2c_mpsse.h"
+#include "i2c_dev_mpsse.h"
+
+
+
+// Open file descriptor of the emulated I2C bus.
+struct i2c_dev_mpsse_fd {
+    int fd;
+    int adr;                    // I2C address set by I2C_SLAVE.
+};
+
+
+
+// Global variables.
+// Open file descriptors. The lock is only held briefly, never while calling
+// into libftdi or libusb, which use the replaced functions themselves.
+static struct i2c_dev_mpsse_fd i2c_dev_mpsse_fds[I2C_DEV_MPSSE_FD_MAX];
+static int i2c_dev_mpsse_fd_count = 0;
+static pthread_mutex_t i2c_dev_mpsse_fd_lock = PTHREAD_MUTEX_INITIALIZER;
+// I2C adapter, opened with the first file descriptor.
+static struct mpsse_adapter *i2c_dev_mpsse_adapter = NULL;
+static pthread_mutex_t i2c_dev_mpsse_open_lock = PTHREAD_MUTEX_INITIALIZER;
+// Settings.
+static pthread_once_t i2c_dev_mpsse_once = PTHREAD_ONCE_INIT;
+static int i2c_dev_mpsse_bus = I2C_DEV_MPSSE_BUS_DEFAULT;
+// Functions of the C library.
+static int (*i2c_dev_mpsse_libc_open)(const char *path, int flags, ...);
+static int (*i2c_dev_mpsse_libc_open64)(const char *path, int flags, ...);
+static int (*i2c_dev_mpsse_libc_openat)(int dirfd, const char *path, int flags, ...);
+static int (*i2c_dev_mpsse_libc_openat64)(int dirfd, const char *path, int flags, ...);
+static int (*i2c_dev_mpsse_libc_close)(int fd);
+static int (*i2c_dev_mpsse_libc_ioctl)(int fd, unsigned long request, ...);
+static ssize_t (*i2c_dev_mpsse_libc_read)(int fd, void *buf, size_t count);
+static ssize_t (*i2c_dev_mpsse_libc_write)(int fd, const void *buf, size_t count);
+
+
+
+// Function prototypes.
+static void i2c_dev_mpsse_setup(void);
+static int i2c_dev_mpsse_match(const char *path);
+static int i2c_dev_mpsse_open(int flags);
+static int i2c_dev_mpsse_find(int fd, struct mpsse_adapter **adapter, int *adr);
+static int i2c_dev_mpsse_set_adr(int fd, int adr);
+static int i2c_dev_mpsse_transfer(struct mpsse_adapter *adapter, struct i2c_mpsse_msg *msgs, int num);
+static int i2c_dev_mpsse_rdwr(struct mpsse_adapter *adapter, struct i2c_rdwr_ioctl_data *rdwr);
+static int i2c_dev_mpsse_smbus(struct mpsse_adapter *adapter, int adr, struct i2c_smbus_ioctl_data *smbus);
+static int i2c_dev_mpsse_ioctl(int fd, struct mpsse_adapter *adapter, int adr, unsigned long request, unsigned long arg);
+
+
+
+// Replacement of open().
+int open(const char *path, int flags, ...)
+{
+    va_list ap;
+    mode_t mode = 0;
+
+    pthread_once(&i2c_dev_mpsse_once, i2c_dev_mpsse_setup);
+    if(i2c_dev_mpsse_match(path))
+        return i2c_dev_mpsse_open(flags);
+    if(flags & (O_CREAT | O_TMPFILE)) {
+        va_start(ap, flags);
+        mode = va_arg(ap, mode_t);
+        va_end(ap);
+    }
+
+    return i2c_dev_mpsse_libc_open(path, flags, mode);
+}
+
+
+
+// Replacement of open64().
+int open64(const char *path, int flags, ...)
+{
+    va_list ap;
+    mode_t mode = 0;
+
+    pthread_once(&i2c_dev_mpsse_once, i2c_dev_mpsse_setup);
+    if(i2c_dev_mpsse_match(path))
+        return i2c_dev_mpsse_open(flags);
+    if(flags & (O_CREAT | O_TMPFILE)) {
+        va_start(ap, flags);
+        mode = va_arg(ap, mode_t);
+        va_end(ap);
+    }
+
+    return i2c_dev_mpsse_libc_open64(path, flags, mode);
+}
+
+
+
+// Replacement of openat(). Only absolute paths are checked.
+int openat(int dirfd, const char *path, int flags, ...)
+{
+    va_list ap;
+    mode_t mode = 0;
+
+    pthread_once(&i2c_dev_mpsse_once, i2c_dev_mpsse_setup);
+    if(i2c_dev_mpsse_match(path))
+        return i2c_dev_mpsse_open(flags);
+    if(flags & (O_CREAT | O_TMPFILE)) {
+        va_start(ap, flags);
+        mode = va_arg(ap, mode_t);
+        va_end(ap);
+    }
+
+    return i2c_dev_mpsse_libc_openat(dirfd, path, flags, mode);
+}
+
+
+
+// Replacement of openat64(). Only absolute paths are checked.
+int openat64(int dirfd, const char *path, int flags, ...)
+{
+    va_list ap;
+    mode_t mode = 0;
+
+    pthread_once(&i2c_dev_mpsse_once, i2c_dev_mpsse_setup);
+    if(i2c_dev_mpsse_match(path))
+        return i2c_dev_mpsse_open(flags);
+    if(flags & (O_CREAT | O_TMPFILE)) {
+        va_start(ap, flags);
+        mode = va_arg(ap, mode_t);
+        va_end(ap);
+    }
+
+    return i2c_dev_mpsse_libc_openat64(dirfd, path, flags, mode);
+}
+
+
+
+// Replacements of the open() variants used by programs compiled with
+// _FORTIFY_SOURCE.
+int __open_2(const char *path, int flags)
+{
+    return open(path, flags);
+}
+
+int __open64_2(const char *path, int flags)
+{
+    return open64(path, flags);
+}
+
+
+
+// Replacement of close(). The adapter is closed with the last file
+// descriptor of the emulated I2C bus.
+int close(int fd)
+{
+    int i, status;
+    int found = 0, count;
+    struct mpsse_adapter *adapter = NULL;
+
+    pthread_once(&i2c_dev_mpsse_once, i2c_dev_mpsse_setup);
+    pthread_mutex_lock(&i2c_dev_mpsse_fd_lock);
+    for(i = 0; i < i2c_dev_mpsse_fd_count; i++) {
+        if(i2c_dev_mpsse_fds[i].fd == fd) {
+            i2c_dev_mpsse_fds[i] = i2c_dev_mpsse_fds[--i2c_dev_mpsse_fd_count];
+            found = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&i2c_dev_mpsse_fd_lock);
+
+    status = i2c_dev_mpsse_libc_close(fd);
+    if(!found) return status;
+
+    // Close the adapter, unless another file descriptor was opened meanwhile.
+    pthread_mutex_lock(&i2c_dev_mpsse_open_lock);
+    pthread_mutex_lock(&i2c_dev_mpsse_fd_lock);
+    count = i2c_dev_mpsse_fd_count;
+    pthread_mutex_unlock(&i2c_dev_mpsse_fd_lock);
+    if(count == 0) {
+        adapter = i2c_dev_mpsse_adapter;
+        i2c_dev_mpsse_adapter = NULL;
+    }
+    i2c_mpsse_close(adapter);
+    pthread_mutex_unlock(&i2c_dev_mpsse_open_lock);
+
+    return status;
+}
+
+
+
+// Replacement of ioctl().
+int ioctl(int fd, unsigned long request, ...)
+{
+    va_list ap;
+    unsigned long arg;
+    struct mpsse_adapter *adapter;
+    int adr;
+
+    va_start(ap, request);
+    arg = va_arg(ap, unsigned long);
+    va_end(ap);
+
+    pthread_once(&i2c_dev_mpsse_once, i2c_dev_mpsse_setup);
+    if(!i2c_dev_mpsse_find(fd, &adapter, &adr))
+        return i2c_dev_mpsse_libc_ioctl(fd, request, arg);
+
+    return i2c_dev_mpsse_ioctl(fd, adapter, adr, request, arg);
+}
+
+
+
+// Replacement of read(). Reads data from the I2C address set by I2C_SLAVE.
+ssize_t read(int fd, void *buf, size_t count)
+{
+    struct mpsse_adapter *adapter;
+    struct i2c_mpsse_msg msg;
+    int adr;
+
+    pthread_once(&i2c_dev_mpsse_once, i2c_dev_mpsse_setup);
+    if(!i2c_dev_mpsse_find(fd, &adapter, &adr))
+        return i2c_dev_mpsse_libc_read(fd, buf, count);
+    if(count > 8192) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    msg.adr = adr;
+    msg.flags = I2C_MPSSE_M_RD;
+    msg.len = (int) count;
+    msg.buf = buf;
+    if(i2c_dev_mpsse_transfer(adapter, &msg, 1)) return -1;
+
+    return count;
+}
+
+
+
+// Replacement of write(). Writes data to the I2C address set by I2C_SLAVE.
+ssize_t write(int fd, const void *buf, size_t count)
+{
+    struct mpsse_adapter *adapter;
+    struct i2c_mpsse_msg msg;
+    int adr;
+
+    pthread_once(&i2c_dev_mpsse_once, i2c_dev_mpsse_setup);
+    if(!i2c_dev_mpsse_find(fd, &adapter, &adr))
+        return i2c_dev_mpsse_libc_write(fd, buf, count);
+    if(count > 8192) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    msg.adr = adr;
+    msg.flags = 0;
+    msg.len = (int) count;
+    msg.buf = (char *) buf;
+    if(i2c_dev_mpsse_transfer(adapter, &msg, 1)) return -1;
+
+    return count;
+}
+
+
+
+// Look up the functions of the C library and read the settings.
+static void i2c_dev_mpsse_setup(void)
+{
+    const char *env;
+
+    i2c_dev_mpsse_libc_open = dlsym(RTLD_NEXT, "open");
+    i2c_dev_mpsse_libc_open64 = dlsym(RTLD_NEXT, "open64");
+    i2c_dev_mpsse_libc_openat = dlsym(RTLD_NEXT, "openat");
+    i2c_dev_mpsse_libc_openat64 = dlsym(RTLD_NEXT, "openat64");
+    i2c_dev_mpsse_libc_close = dlsym(RTLD_NEXT, "close");
+    i2c_dev_mpsse_libc_ioctl = dlsym(RTLD_NEXT, "ioctl");
+    i2c_dev_mpsse_libc_read = dlsym(RTLD_NEXT, "read");
+    i2c_dev_mpsse_libc_write = dlsym(RTLD_NEXT, "write");
+
+    env = getenv(I2C_DEV_MPSSE_ENV_BUS);
+    if(env != NULL && *env)
+        i2c_dev_mpsse_bus = (int) strtol(env, NULL, 0);
+}
+
+
+
+// Check if a path is the one of the emulated I2C bus.
+static int i2c_dev_mpsse_match(const char *path)
+{
+    int bus, len = 0;
+
+    if(path == NULL || strncmp(path, "/dev/i2c", 8)) return 0;
+    if(sscanf(path, "/dev/i2c-%d%n", &bus, &len) != 1 && sscanf(path, "/dev/i2c/%d%n", &bus, &len) != 1)
+        return 0;
+
+    return path[len] == 0 && bus == i2c_dev_mpsse_bus;
+}
+
+
+
+// Open a file descriptor of the emulated I2C bus. The adapter is opened with
+// the first one.
+static int i2c_dev_mpsse_open(int flags)
+{
+    const char *env;
+    int fd, interface, count;
+    int verbose = 0;
+
+    pthread_mutex_lock(&i2c_dev_mpsse_open_lock);
+    if(i2c_dev_mpsse_adapter == NULL) {
+        env = getenv(I2C_DEV_MPSSE_ENV_VERBOSE);
+        if(env != NULL && *env)
+            verbose = (int) strtol(env, NULL, 0);
+        env = getenv(I2C_DEV_MPSSE_ENV_IFACE);
+        interface = (env != NULL && *env) ? mpsse_adapter_parse_interface(env) : IFACE_A;
+        if(interface < 0) {
+            fprintf(stderr, "%s: %s: %sInvalid FTDI interface \"%s\" in %s.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, env, I2C_DEV_MPSSE_ENV_IFACE);
+            pthread_mutex_unlock(&i2c_dev_mpsse_open_lock);
+            errno = ENODEV;
+            return -1;
+        }
+        i2c_dev_mpsse_adapter = i2c_mpsse_open_if(getenv(I2C_DEV_MPSSE_ENV_SERIAL), interface);
+        if(i2c_dev_mpsse_adapter == NULL) {
+            pthread_mutex_unlock(&i2c_dev_mpsse_open_lock);
+            errno = ENODEV;
+            return -1;
+        }
+        i2c_mpsse_set_verbose(i2c_dev_mpsse_adapter, verbose);
+        env = getenv(I2C_DEV_MPSSE_ENV_FREQ);
+        if(env != NULL && *env && i2c_mpsse_set_freq(i2c_dev_mpsse_adapter, (int) strtol(env, NULL, 0)))
+            fprintf(stderr, "%s: %s: %sUnable to set the I2C frequency to %s Hz.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, env);
+    }
+
+    // Use a file descriptor of /dev/null as handle.
+    fd = i2c_dev_mpsse_libc_open("/dev/null", O_RDWR | (flags & O_CLOEXEC));
+    if(fd >= 0) {
+        pthread_mutex_lock(&i2c_dev_mpsse_fd_lock);
+        if(i2c_dev_mpsse_fd_count < I2C_DEV_MPSSE_FD_MAX) {
+            i2c_dev_mpsse_fds[i2c_dev_mpsse_fd_count].fd = fd;
+            i2c_dev_mpsse_fds[i2c_dev_mpsse_fd_count].adr = 0;
+            i2c_dev_mpsse_fd_count++;
+        } else {
+            i2c_dev_mpsse_libc_close(fd);
+            fd = -1;
+            errno = EMFILE;
+        }
+        pthread_mutex_unlock(&i2c_dev_mpsse_fd_lock);
+    }
+    if(fd < 0) {
+        pthread_mutex_lock(&i2c_dev_mpsse_fd_lock);
+        count = i2c_dev_mpsse_fd_count;
+        pthread_mutex_unlock(&i2c_dev_mpsse_fd_lock);
+        if(count == 0) {
+            i2c_mpsse_close(i2c_dev_mpsse_adapter);
+            i2c_dev_mpsse_adapter = NULL;
+        }
+    }
+    pthread_mutex_unlock(&i2c_dev_mpsse_open_lock);
+
+    return fd;
+}
+
+
+
+// Find a file descriptor of the emulated I2C bus. Returns 1 if found.
+static int i2c_dev_mpsse_find(int fd, struct mpsse_adapter **adapter, int *adr)
+{
+    int i;
+    int found = 0;
+
+    pthread_mutex_lock(&i2c_dev_mpsse_fd_lock);
+    for(i = 0; i < i2c_dev_mpsse_fd_count; i++) {
+        if(i2c_dev_mpsse_fds[i].fd == fd) {
+            *adapter = i2c_dev_mpsse_adapter;
+            *adr = i2c_dev_mpsse_fds[i].adr;
+            found = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&i2c_dev_mpsse_fd_lock);
+
+    return found;
+}
+
+
+
+// Set the I2C address of a file descriptor.
+static int i2c_dev_mpsse_set_adr(int fd, int adr)
+{
+    int i;
+
+    pthread_mutex_lock(&i2c_dev_mpsse_fd_lock);
+    for(i = 0; i < i2c_dev_mpsse_fd_count; i++)
+        if(i2c_dev_mpsse_fds[i].fd == fd)
+            i2c_dev_mpsse_fds[i].adr = adr;
+    pthread_mutex_unlock(&i2c_dev_mpsse_fd_lock);
+
+    return 0;
+}
+
+
+
+// Execute I2C messages as one combined transaction.
+static int i2c_dev_mpsse_transfer(struct mpsse_adapter *adapter, struct i2c_mpsse_msg *msgs, int num)
+{
+    if(i2c_mpsse_transfer(adapter, msgs, num)) {
+        errno = ENXIO;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Execute the messages of an I2C_RDWR ioctl. Returns the number of messages.
+static int i2c_dev_mpsse_rdwr(struct mpsse_adapter *adapter, struct i2c_rdwr_ioctl_data *rdwr)
+{
+    struct i2c_mpsse_msg msgs[I2C_DEV_MPSSE_MSGS_MAX];
+    struct i2c_msg *msg;
+    int i, first = 0;
+
+    if(rdwr == NULL || rdwr->msgs == NULL || rdwr->nmsgs == 0 || rdwr->nmsgs > I2C_DEV_MPSSE_MSGS_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for(i = 0; i < (int) rdwr->nmsgs; i++) {
+        msg = &rdwr->msgs[i];
+        if((msg->flags & I2C_M_TEN) || msg->addr > 0x7f || msg->len > 8192) {
+            errno = EINVAL;
+            return -1;
+        }
+        // Protocol mangling and SMBus block reads are not supported.
+        if(msg->flags & ~(I2C_M_RD | I2C_M_STOP)) {
+            errno = EOPNOTSUPP;
+            return -1;
+        }
+        msgs[i].adr = msg->addr;
+        msgs[i].flags = (msg->flags & I2C_M_RD) ? I2C_MPSSE_M_RD : 0;
+        msgs[i].len = msg->len;
+        msgs[i].buf = (char *) msg->buf;
+    }
+
+    // Execute the messages up to each stop condition as one transaction.
+    for(i = 0; i < (int) rdwr->nmsgs; i++) {
+        if(i == (int) rdwr->nmsgs - 1 || (rdwr->msgs[i].flags & I2C_M_STOP)) {
+            if(i2c_dev_mpsse_transfer(adapter, msgs + first, i + 1 - first)) return -1;
+            first = i + 1;
+        }
+    }
+
+    return rdwr->nmsgs;
+}
+
+
+
+// Execute an SMBus transfer of an I2C_SMBUS ioctl as combined I2C
+// transaction.
+static int i2c_dev_mpsse_smbus(struct mpsse_adapter *adapter, int adr, struct i2c_smbus_ioctl_data *smbus)
+{
+    struct i2c_mpsse_msg msgs[2];
+    unsigned char wbuf[I2C_SMBUS_BLOCK_MAX + 2];
+    unsigned char rbuf[I2C_SMBUS_BLOCK_MAX];
+    union i2c_smbus_data *data = smbus->data;
+    int rd = (smbus->read_write == I2C_SMBUS_READ);
+    int wlen = 1;               // Length of the write message, -1 = none.
+    int rlen = 0;               // Length of the read message, 0 = none.
+    int num = 0, len = 0;
+
+    if(data == NULL && smbus->size != I2C_SMBUS_QUICK && !(smbus->size == I2C_SMBUS_BYTE && !rd)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    wbuf[0] = smbus->command;
+    switch(smbus->size) {
+        case I2C_SMBUS_QUICK:
+            // Only the address with the read/write bit.
+            msgs[0].adr = adr;
+            msgs[0].flags = rd ? I2C_MPSSE_M_RD : 0;
+            msgs[0].len = 0;
+            msgs[0].buf = (char *) wbuf;
+            return i2c_dev_mpsse_transfer(adapter, msgs, 1);
+        case I2C_SMBUS_BYTE:
+            if(rd) {
+                wlen = -1;
+                rlen = 1;
+            }
+            break;
+        case I2C_SMBUS_BYTE_DATA:
+            if(rd) {
+                rlen = 1;
+            } else {
+                wbuf[1] = data->byte;
+                wlen = 2;
+            }
+            break;
+        case I2C_SMBUS_WORD_DATA:
+        case I2C_SMBUS_PROC_CALL:
+            if(rd && smbus->size == I2C_SMBUS_WORD_DATA) {
+                rlen = 2;
+            } else {
+                wbuf[1] = data->word & 0xff;
+                wbuf[2] = data->word >> 8;
+                wlen = 3;
+                if(smbus->size == I2C_SMBUS_PROC_CALL)
+                    rlen = 2;
+            }
+            break;
+        case I2C_SMBUS_BLOCK_DATA:
+            // The length of a block read is only known after reading the
+            // first byte.
+            if(rd) {
+                errno = EOPNOTSUPP;
+                return -1;
+            }
+            len = data->block[0];
+            if(len < 1 || len > I2C_SMBUS_BLOCK_MAX) {
+                errno = EINVAL;
+                return -1;
+            }
+            memcpy(wbuf + 1, data->block, len + 1);
+            wlen = len + 2;
+            break;
+        case I2C_SMBUS_I2C_BLOCK_BROKEN:
+        case I2C_SMBUS_I2C_BLOCK_DATA:
+            len = data->block[0];
+            if(len < 1 || len > I2C_SMBUS_BLOCK_MAX) {
+                errno = EINVAL;
+                return -1;
+            }
+            if(rd) {
+                rlen = len;
+            } else {
+                memcpy(wbuf + 1, data->block + 1, len);
+                wlen = len + 1;
+            }
+            break;
+        default:
+            errno = EOPNOTSUPP;
+            return -1;
+    }
+
+    // Write the command and data, then read back with a repeated start.
+    if(wlen >= 0) {
+        msgs[num].adr = adr;
+        msgs[num].flags = 0;
+        msgs[num].len = wlen;
+        msgs[num].buf = (char *) wbuf;
+        num++;
+    }
+    if(rlen > 0) {
+        msgs[num].adr = adr;
+        msgs[num].flags = I2C_MPSSE_M_RD;
+        msgs[num].len = rlen;
+        msgs[num].buf = (char *) rbuf;
+        num++;
+    }
+    if(i2c_dev_mpsse_transfer(adapter, msgs, num)) return -1;
+
+    // Return the data read.
+    if(rlen == 0)
+        return 0;
+    if(smbus->size == I2C_SMBUS_BYTE || smbus->size == I2C_SMBUS_BYTE_DATA)
+        data->byte = rbuf[0];
+    else if(smbus->size == I2C_SMBUS_WORD_DATA || smbus->size == I2C_SMBUS_PROC_CALL)
+        data->word = rbuf[0] | (rbuf[1] << 8);
+    else
+        memcpy(data->block + 1, rbuf, rlen);
+
+    return 0;
+}
+
+
+
+// Execute an i2c-dev ioctl.
+static int i2c_dev_mpsse_ioctl(int fd, struct mpsse_adapter *adapter, int adr, unsigned long request, unsigned long arg)
+{
+    switch(request) {
+        case I2C_SLAVE:
+        case I2C_SLAVE_FORCE:
+            if(arg > 0x7f) {
+                errno = EINVAL;
+                return -1;
+            }
+            return i2c_dev_mpsse_set_adr(fd, (int) arg);
+        case I2C_TENBIT:
+        case I2C_PEC:
+            if(arg) {
+                errno = EINVAL;
+                return -1;
+            }
+            return 0;
+        case I2C_FUNCS:
+            *((unsigned long *) arg) = I2C_DEV_MPSSE_FUNCS;
+            return 0;
+        case I2C_RDWR:
+            return i2c_dev_mpsse_rdwr(adapter, (struct i2c_rdwr_ioctl_data *) arg);
+        case I2C_SMBUS:
+            return i2c_dev_mpsse_smbus(adapter, adr, (struct i2c_smbus_ioctl_data *) arg);
+        case I2C_RETRIES:
+        case I2C_TIMEOUT:
+            // The MPSSE I2C engine neither retries nor times out.
+            return 0;
+        default:
+            errno = ENOTTY;
+            return -1;
+    }
+}
+
@@ -0,0 +1,50 @@
+// File: i2c_dev_mpsse.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for the Linux i2c-dev emulation on top of the hardware I2C IO
+// functions based on FTDI's Multi-Protocol Synchronous Serial Engine (MPSSE).
+//
+
+
+
+#ifndef __I2C_DEV_MPSSE_H
+#define __I2C_DEV_MPSSE_H
+
+
+
+#include <linux/i2c.h>
+
+
+
+// Environment variables.
+#define I2C_DEV_MPSSE_ENV_BUS       "I2C_DEV_MPSSE_BUS"     // Number N of the emulated /dev/i2c-N.
+#define I2C_DEV_MPSSE_ENV_SERIAL    "I2C_DEV_MPSSE_SERIAL"  // Serial number of the FTDI device.
+#define I2C_DEV_MPSSE_ENV_IFACE     "I2C_DEV_MPSSE_IFACE"   // MPSSE interface, A (default) .. D.
+#define I2C_DEV_MPSSE_ENV_FREQ      "I2C_DEV_MPSSE_FREQ"    // I2C frequency in Hz.
+#define I2C_DEV_MPSSE_ENV_VERBOSE   "I2C_DEV_MPSSE_VERBOSE" // Print the errors of the I2C library.
+
+// Default number of the emulated I2C bus.
+#define I2C_DEV_MPSSE_BUS_DEFAULT   0
+
+// Maximum number of open file descriptors of the emulated I2C bus.
+#define I2C_DEV_MPSSE_FD_MAX        16
+
+// Maximum number of messages of an I2C_RDWR ioctl, as in the kernel.
+#define I2C_DEV_MPSSE_MSGS_MAX      42
+
+// Functionality reported by the I2C_FUNCS ioctl. All SMBus transfers with a
+// known length are emulated. SMBus block reads (I2C_M_RECV_LEN) would need the
+// length byte before building the rest of the transaction and PEC is not
+// implemented.
+#define I2C_DEV_MPSSE_FUNCS         (I2C_FUNC_I2C | I2C_FUNC_SMBUS_QUICK | I2C_FUNC_SMBUS_BYTE | \
+                                     I2C_FUNC_SMBUS_BYTE_DATA | I2C_FUNC_SMBUS_WORD_DATA | \
+                                     I2C_FUNC_SMBUS_PROC_CALL | I2C_FUNC_SMBUS_WRITE_BLOCK_DATA | \
+                                     I2C_FUNC_SMBUS_I2C_BLOCK)
+
+
+
+#endif
+
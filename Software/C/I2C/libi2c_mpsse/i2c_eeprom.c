@@ -0,0 +1,326 @@
+// File: i2c_eeprom.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// I2C EEPROM (24Cxx and compatible) functions on top of the hardware I2C IO
+// functions.
+//
+// Writes are split at the page boundaries of the part. Each page is written
+// in one I2C transaction. The end of the internal write cycle is detected by
+// ACK polling: the EEPROM does not acknowledge its address while it is busy.
+// Several polls are sent in the same USB transfer as the page write, so the
+// programming time is set by the real write cycle of the EEPROM instead of a
+// worst case delay. Pages that already contain the data are skipped.
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "mpsse_adapter.h"
+#include "i2c_mpsse.h"
+#include "i2c_eeprom.h"
+
+
+
+// Global variables.
+// Supported EEPROM parts.
+static const struct i2c_eeprom_part i2c_eeprom_parts[] =
+{
+    { "24C01",      128,    8,   1 },
+    { "24C02",      256,    8,   1 },
+    { "24C04",      512,   16,   1 },
+    { "24C08",     1024,   16,   1 },
+    { "24C16",     2048,   16,   1 },
+    { "24C32",     4096,   32,   2 },
+    { "24C64",     8192,   32,   2 },
+    { "24C128",   16384,   64,   2 },
+    { "24C256",   32768,   64,   2 },
+    { "24C512",   65536,  128,   2 },
+    { "24M01",   131072,  256,   2 },
+    { "24M02",   262144,  256,   2 },
+    { NULL,           0,    0,   0 }
+};
+
+
+
+// Function prototypes.
+static int i2c_eeprom_check(struct i2c_eeprom *eeprom, int offset, int size);
+static int i2c_eeprom_dev_adr(struct i2c_eeprom *eeprom, int offset);
+static int i2c_eeprom_block_len(struct i2c_eeprom *eeprom, int offset, int size);
+static int i2c_eeprom_write_page(struct i2c_eeprom *eeprom, int offset, char *data, int size, char *buf);
+static long i2c_eeprom_time_ms(void);
+
+
+
+// Find an EEPROM part by its name. The name is not case sensitive and may
+// have a prefix, e.g. "AT24C256" or "24c256".
+const struct i2c_eeprom_part *i2c_eeprom_find_part(const char *name)
+{
+    int i;
+    int len, len_part;
+
+    if(name == NULL) return NULL;
+
+    len = strlen(name);
+    for(i = 0; i2c_eeprom_parts[i].name != NULL; i++) {
+        len_part = strlen(i2c_eeprom_parts[i].name);
+        if(len >= len_part && !strcasecmp(name + len - len_part, i2c_eeprom_parts[i].name))
+            return &i2c_eeprom_parts[i];
+    }
+
+    return NULL;
+}
+
+
+
+// Get an EEPROM part by its index in the list of supported parts. Returns NULL
+// after the last part.
+const struct i2c_eeprom_part *i2c_eeprom_get_part(int index)
+{
+    if(index < 0 || index >= (int) (sizeof(i2c_eeprom_parts) / sizeof(i2c_eeprom_parts[0])) - 1)
+        return NULL;
+
+    return &i2c_eeprom_parts[index];
+}
+
+
+
+// Initialize an EEPROM device.
+int i2c_eeprom_init(struct i2c_eeprom *eeprom, struct mpsse_adapter *adapter, int adr, const char *part_name)
+{
+    if(eeprom == NULL) return -1;
+
+    memset(eeprom, 0, sizeof(struct i2c_eeprom));
+    eeprom->part = i2c_eeprom_find_part(part_name);
+    if(eeprom->part == NULL) {
+        fprintf(stderr, "%s: %s: %sUnknown EEPROM part \"%s\".\n", __FILE__, __FUNCTION__, PREFIX_ERROR, part_name);
+        return -1;
+    }
+    eeprom->adapter = adapter;
+    eeprom->adr = adr & 0x7f;
+
+    return 0;
+}
+
+
+
+// Read data from an EEPROM. Each block addressed by the same I2C device
+// address is read in one I2C transaction.
+int i2c_eeprom_read(struct i2c_eeprom *eeprom, int offset, char *data, int size)
+{
+    int len;
+
+    if(i2c_eeprom_check(eeprom, offset, size)) return -1;
+
+    while(size > 0) {
+        len = i2c_eeprom_block_len(eeprom, offset, size);
+        if(i2c_mpsse_reg_read(eeprom->adapter, i2c_eeprom_dev_adr(eeprom, offset), offset, eeprom->part->adr_width, data, len)) {
+            if(eeprom->adapter->verbose)
+                fprintf(stderr, "%s: %s: %sUnable to read %d byte(s) from EEPROM offset 0x%05x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, len, offset);
+            return -1;
+        }
+        offset += len;
+        data += len;
+        size -= len;
+    }
+
+    return 0;
+}
+
+
+
+// Write data to an EEPROM. Unless I2C_EEPROM_WRITE_FORCE is set, the EEPROM
+// is read first and only the pages that differ are written.
+int i2c_eeprom_write(struct i2c_eeprom *eeprom, int offset, char *data, int size, int flags)
+{
+    int pos, len;
+    int status = 0;
+    char *old = NULL;
+    char *buf = NULL;
+
+    if(i2c_eeprom_check(eeprom, offset, size)) return -1;
+    eeprom->pages_written = 0;
+    eeprom->pages_skipped = 0;
+    eeprom->polls = 0;
+
+    // Read the current contents in one go.
+    if(!(flags & I2C_EEPROM_WRITE_FORCE)) {
+        old = malloc(size);
+        if(old == NULL || i2c_eeprom_read(eeprom, offset, old, size)) {
+            free(old);
+            old = NULL;
+        }
+    }
+
+    // Buffer for the data address followed by the page data.
+    buf = malloc(eeprom->part->adr_width + eeprom->part->page_size);
+    if(buf == NULL) {
+        fprintf(stderr, "%s: %s: %sCannot allocate memory for the EEPROM page buffer.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        free(old);
+        return -1;
+    }
+
+    // Write page by page.
+    for(pos = 0; pos < size; pos += len) {
+        len = eeprom->part->page_size - ((offset + pos) % eeprom->part->page_size);
+        if(len > size - pos) len = size - pos;
+        if(old != NULL && !memcmp(old + pos, data + pos, len)) {
+            eeprom->pages_skipped++;
+            continue;
+        }
+        if(i2c_eeprom_write_page(eeprom, offset + pos, data + pos, len, buf)) {
+            status = -1;
+            break;
+        }
+        eeprom->pages_written++;
+    }
+
+    free(buf);
+    free(old);
+
+    return status;
+}
+
+
+
+// Verify the contents of an EEPROM. Returns 0 if the data matches, the number
+// of differing bytes otherwise or -1 on error.
+int i2c_eeprom_verify(struct i2c_eeprom *eeprom, int offset, char *data, int size)
+{
+    int i;
+    int errors = 0;
+    char *buf;
+
+    if(i2c_eeprom_check(eeprom, offset, size)) return -1;
+
+    buf = malloc(size);
+    if(buf == NULL) {
+        fprintf(stderr, "%s: %s: %sCannot allocate memory for %d byte(s).\n", __FILE__, __FUNCTION__, PREFIX_ERROR, size);
+        return -1;
+    }
+    if(i2c_eeprom_read(eeprom, offset, buf, size)) {
+        free(buf);
+        return -1;
+    }
+    for(i = 0; i < size; i++)
+        if(buf[i] != data[i])
+            errors++;
+    free(buf);
+
+    return errors;
+}
+
+
+
+// Check the parameters of an EEPROM access.
+static int i2c_eeprom_check(struct i2c_eeprom *eeprom, int offset, int size)
+{
+    if(eeprom == NULL || eeprom->part == NULL || eeprom->adapter == NULL) {
+        if(eeprom == NULL || eeprom->adapter == NULL || eeprom->adapter->verbose)
+            fprintf(stderr, "%s: %s: %sThe EEPROM device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    if(offset < 0 || size < 0 || offset + size > eeprom->part->size) {
+        if(eeprom->adapter->verbose)
+            fprintf(stderr, "%s: %s: %sAccess to %d byte(s) at offset 0x%05x exceeds the EEPROM size of %d bytes.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, size, offset, eeprom->part->size);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Get the I2C device address for an EEPROM offset. The address bits above the
+// data address are sent in the low bits of the device address.
+static int i2c_eeprom_dev_adr(struct i2c_eeprom *eeprom, int offset)
+{
+    return (eeprom->adr | (offset >> (8 * eeprom->part->adr_width))) & 0x7f;
+}
+
+
+
+// Get the number of bytes up to the end of the block addressed by the same
+// I2C device address.
+static int i2c_eeprom_block_len(struct i2c_eeprom *eeprom, int offset, int size)
+{
+    int block_size = 1 << (8 * eeprom->part->adr_width);
+    int len = block_size - (offset % block_size);
+
+    return (len > size) ? size : len;
+}
+
+
+
+// Write one page to the EEPROM and wait for the end of the write cycle. The
+// page write and the first ACK polls are sent in the same USB transfer.
+static int i2c_eeprom_write_page(struct i2c_eeprom *eeprom, int offset, char *data, int size, char *buf)
+{
+    int i;
+    int first;
+    int dev_adr = i2c_eeprom_dev_adr(eeprom, offset);
+    long start;
+    struct i2c_mpsse_msg msgs[1 + I2C_EEPROM_POLLS];
+    struct i2c_mpsse_xfer xfers[1 + I2C_EEPROM_POLLS];
+
+    // Page write: data address followed by the data.
+    for(i = 0; i < eeprom->part->adr_width; i++)
+        buf[i] = (char) ((offset >> (8 * (eeprom->part->adr_width - 1 - i))) & 0xff);
+    memcpy(buf + eeprom->part->adr_width, data, size);
+    msgs[0].adr = dev_adr;
+    msgs[0].flags = 0;
+    msgs[0].len = eeprom->part->adr_width + size;
+    msgs[0].buf = buf;
+    // ACK polls: address only writes.
+    for(i = 1; i < 1 + I2C_EEPROM_POLLS; i++) {
+        msgs[i].adr = dev_adr;
+        msgs[i].flags = 0;
+        msgs[i].len = 0;
+        msgs[i].buf = NULL;
+    }
+    for(i = 0; i < 1 + I2C_EEPROM_POLLS; i++) {
+        xfers[i].msgs = &msgs[i];
+        xfers[i].num = 1;
+        xfers[i].delay = 0;
+    }
+
+    // Poll until the EEPROM acknowledges its address again.
+    start = i2c_eeprom_time_ms();
+    for(first = 0; ; first = 1) {
+        i2c_mpsse_transfer_batch(eeprom->adapter, &xfers[first], 1 + I2C_EEPROM_POLLS - first);
+        if(first == 0 && xfers[0].status) {
+            if(eeprom->adapter->verbose)
+                fprintf(stderr, "%s: %s: %sUnable to write %d byte(s) to EEPROM offset 0x%05x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, size, offset);
+            return -1;
+        }
+        for(i = 1; i < 1 + I2C_EEPROM_POLLS; i++) {
+            eeprom->polls++;
+            if(xfers[i].status == 0)
+                return 0;
+        }
+        if(i2c_eeprom_time_ms() - start > I2C_EEPROM_WRITE_TIMEOUT) {
+            if(eeprom->adapter->verbose)
+                fprintf(stderr, "%s: %s: %sTimeout waiting for the write cycle at EEPROM offset 0x%05x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, offset);
+            return -1;
+        }
+    }
+}
+
+
+
+// Get a monotonic time stamp in ms.
+static long i2c_eeprom_time_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
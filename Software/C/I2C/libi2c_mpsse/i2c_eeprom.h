@@ -0,0 +1,67 @@
+// File: i2c_eeprom.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for the I2C EEPROM (24Cxx and compatible) functions on top of
+// the hardware I2C IO functions.
+//
+
+
+
+#ifndef __I2C_EEPROM_H
+#define __I2C_EEPROM_H
+
+
+
+#include "i2c_mpsse.h"
+
+
+
+// Number of ACK polls sent per USB transfer while waiting for the end of an
+// EEPROM write cycle.
+#define I2C_EEPROM_POLLS            8
+
+// Maximum time to wait for the end of an EEPROM write cycle in ms.
+#define I2C_EEPROM_WRITE_TIMEOUT    50
+
+// EEPROM write flags.
+#define I2C_EEPROM_WRITE_FORCE      0x0001  // Write all pages, even if they already match.
+
+
+
+// EEPROM part.
+struct i2c_eeprom_part {
+    const char *name;           // Part name, e.g. "24C256".
+    int size;                   // Size in bytes.
+    int page_size;              // Size of a write page in bytes.
+    int adr_width;              // Width of the data address in bytes. Higher
+                                // address bits are sent in the device address.
+};
+
+// EEPROM device.
+struct i2c_eeprom {
+    struct mpsse_adapter *adapter;
+    const struct i2c_eeprom_part *part;
+    int adr;                    // 7-bit I2C base address of the EEPROM.
+    // Statistics of the last write.
+    int pages_written;
+    int pages_skipped;
+    int polls;                  // Number of ACK polls sent.
+};
+
+
+
+// Function prototypes.
+const struct i2c_eeprom_part *i2c_eeprom_find_part(const char *name);
+const struct i2c_eeprom_part *i2c_eeprom_get_part(int index);
+int i2c_eeprom_init(struct i2c_eeprom *eeprom, struct mpsse_adapter *adapter, int adr, const char *part_name);
+int i2c_eeprom_read(struct i2c_eeprom *eeprom, int offset, char *data, int size);
+int i2c_eeprom_write(struct i2c_eeprom *eeprom, int offset, char *data, int size, int flags);
+int i2c_eeprom_verify(struct i2c_eeprom *eeprom, int offset, char *data, int size);
+
+
+
+#endif
+
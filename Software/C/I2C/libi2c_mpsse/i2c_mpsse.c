@@ -1,268 +1,1478 @@
-// File: i2c_mpsse.c
-// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
-// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
-// Date: 09 Feb 2018
-// Rev.: 16 Feb 2018
-//
-// Basic hardware I2C IO functions based on FTDI's Multi-Protocol Synchronous
-// Serial Engine (MPSSE).
-//
-
-
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <mpsse.h>
-#include "i2c_mpsse.h"
-
-
-
-// Global variables.
-struct mpsse_context *i2c_mpsse = NULL;
-int i2c_mpsse_verbose = 1;
-
-
-
-// Initialize the I2C hardware.
-int i2c_init(void)
-{
-    // Check if the I2C device was already initialized.
-    if(i2c_mpsse != NULL) return 0;
-
-    // Open the I2C device with default frequency of 100 kHz.
-    if(!((i2c_mpsse = MPSSE(I2C, ONE_HUNDRED_KHZ, MSB)) != NULL && i2c_mpsse->open))
-    {
-        fprintf(stderr, "%s: %s: %sFailed to initialize MPSSE: %s\n", __FILE__, __FUNCTION__, PREFIX_ERROR, ErrorString(i2c_mpsse));
-        return -1;
-    }
-
-    return 0;
-}
-
-
-
-// Reset the I2C hardware.
-int i2c_reset(void)
-{
-    // This is a dummy function, no operation.
-    return 0;
-}
-
-
-
-// Close the I2C hardware.
-int i2c_close(void)
-{
-    Close(i2c_mpsse);
-    i2c_mpsse = NULL;
-
-    return 0;
-}
-
-
-
-// Get the I2C frequency.
-int i2c_get_freq(int *i2c_freq)
-{
-    // Check if the I2C device was initialized.
-    if(i2c_mpsse == NULL) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
-        return -1;
-    }
-
-    *i2c_freq = GetClock(i2c_mpsse);
-
-    return 0;
-}
-
-
-
-// Set the I2C frequency.
-int i2c_set_freq(int i2c_freq)
-{
-    int status;
-
-    // Check if the I2C device was initialized.
-    if(i2c_mpsse == NULL) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
-        return -1;
-    }
-
-    status = SetClock(i2c_mpsse, i2c_freq);
-    if(status) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sUnable to set the I2C frequency to %d Hz.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i2c_freq);
-        return -1;
-    }
-
-    return 0;
-}
-
-
-
-// Get information about the I2C device.
-int i2c_info(void)
-{
-    // Check if the I2C device was initialized.
-    if(i2c_mpsse == NULL) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
-        return -1;
-    }
-
-    printf("I2C master device: %s\n", GetDescription(i2c_mpsse));
-    printf("I2C master device VID: 0x%04x\n", GetVid(i2c_mpsse));
-    printf("I2C master device PID: 0x%04x\n", GetPid(i2c_mpsse));
-    printf("I2C bus speed: %d Hz\n", GetClock(i2c_mpsse));
-
-    return 0;
-}
-
-
-
-// Set verbosity of the I2C functions.
-int i2c_set_verbose(int verbose)
-{
-    i2c_mpsse_verbose = verbose;
-    return 0;
-}
-
-
-
-// Write data to the I2C bus.
-int i2c_write(int i2c_dev_adr, char *data, int size)
-{
-    int status;
-    char i2c_data[2];
-
-    // Check if the I2C device was initialized.
-    if(i2c_mpsse == NULL) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
-        return -1;
-    }
-
-    // Generate start condition.
-    status = Start(i2c_mpsse);
-    if(status) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sUnable to generate start condition.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
-        return -1;
-    }
-
-    // Send device address with write command.
-    i2c_data[0] = ((i2c_dev_adr & 0x7f) << 1) | 0x00;
-    status = Write(i2c_mpsse, i2c_data, 1);
-    if(status) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sUnable to set the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i2c_dev_adr);
-        return -1;
-    }
-
-    // Check for acknowledge.
-    if(GetAck(i2c_mpsse) != ACK) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sDid not get acknowledge from the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i2c_dev_adr);
-        return -1;
-    }
-
-    // Send the I2C data.
-    status = Write(i2c_mpsse, data, size);
-    if(status) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sUnable to write %d byte(s) to the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, size, i2c_dev_adr);
-        return -1;
-    }
-
-    // Check for acknowledge.
-    if(GetAck(i2c_mpsse) != ACK) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sDid not get acknowledge from the I2C chip address 0x%02x after writing data.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i2c_dev_adr);
-        return -1;
-    }
-
-    // Generate stop condition.
-    status = Stop(i2c_mpsse);
-    if(status) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sUnable to generate stop condition.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
-        return -1;
-    }
-
-    return 0;
-}
-
-
-
-// Read data from the I2C bus.
-int i2c_read(int i2c_dev_adr, char *data, int size)
-{
-    int status;
-    char i2c_data[2];
-    char *i2c_data_ptr = NULL;    
-
-    // Check if the I2C device was initialized.
-    if(i2c_mpsse == NULL) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
-        return -1;
-    }
-
-    // Generate start condition.
-    status = Start(i2c_mpsse);
-    if(status) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sUnable to generate start condition.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
-        return -1;
-    }
-
-    // Send device address with read command.
-    i2c_data[0] = ((i2c_dev_adr & 0x7f) << 1) | 0x01;
-    status = Write(i2c_mpsse, i2c_data, 1);
-    if(status) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sUnable to set the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i2c_dev_adr);
-        return -1;
-    }
-
-    // Check for acknowledge.
-    if(GetAck(i2c_mpsse) != ACK) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sDid not get acknowledge from the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i2c_dev_adr);
-        return -1;
-    }
-
-    // Read from the I2C bus.
-    i2c_data_ptr = Read(i2c_mpsse, size);
-    if(i2c_data_ptr == NULL) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sUnable to read %d byte(s) from the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, size, i2c_dev_adr);
-        return -1;
-    }
-
-    // Check for acknowledge.
-    if(GetAck(i2c_mpsse) != ACK) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sDid not get acknowledge from the I2C chip address 0x%02x after reading data.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i2c_dev_adr);
-        return -1;
-    }
-
-    // Generate stop condition.
-    status = Stop(i2c_mpsse);
-    if(status) {
-        if(i2c_mpsse_verbose)
-            fprintf(stderr, "%s: %s: %sUnable to generate stop condition.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
-        return -1;
-    }
-
-    // Copy the data read to the buffer passed to this function as argument and
-    // free the memory that has been reserved by the Read function.
-    strncpy(data, i2c_data_ptr, size);
-    free(i2c_data_ptr);
-
-    return 0;
-}
-
+// File: i2c_mpsse.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 09 Feb 2018
+// Rev.: 19 Oct 2026
+//
+// Basic hardware I2C IO functions based on FTDI's Multi-Protocol Synchronous
+// Serial Engine (MPSSE).
+//
+// FTDI FT232H pinning:
+// - ADBUS0(13): SCL
+// - ADBUS1(14): SDA output
+// - ADBUS2(15): SDA input (optional on the FT232H, see below)
+// - ADBUS7(21): RTCK, connected to SCL (only for clock stretching)
+// All other pins are left to the GPIO functions, which may share the adapter.
+//
+// On the FT232H, SCL and SDA are open drain outputs, which only drive zero
+// (MPSSE command 0x9E). SDA then stays an output for the whole transaction and
+// is released by shifting out ones, so that no pin direction changes are
+// needed between the bytes. Together with the three phase clocking, which
+// keeps the data valid on both clock edges, this provides the data hold times
+// for Fast-mode Plus with 1 MHz. ADBUS1 and ADBUS2 need not be tied together:
+// Without this strap, SDA is sampled on ADBUS1 while SCL is high. With the
+// strap (see i2c_mpsse_set_strap()), data bytes are shifted in on ADBUS2,
+// which takes much fewer commands and USB bytes for reads.
+// Other FTDI chips drive SDA push-pull and switch its direction for reading,
+// so they require ADBUS1 and ADBUS2 to be tied together.
+//
+// The I2C transactions are compiled into MPSSE command sequences and executed
+// through the MPSSE adapter layer. All bytes of a transaction, including the
+// ACK bits, are transferred in a single USB round trip. The ACK bits are
+// checked after the transaction has completed. Transactions submitted by
+// different threads on the same adapter are serialized and merged into
+// combined USB transfers.
+//
+// Clock stretching is supported with the adaptive clocking of the FT232H. SCL
+// is then only driven low and read back on GPIOL3 (RTCK), so the MPSSE waits
+// while a slow target holds SCL low. In open drain mode, this requires the
+// ADBUS1/ADBUS2 strap, as SDA is then never sampled with pin commands. After each transaction the bus lines are
+// read back. If SDA is stuck low, the bus is recovered automatically by
+// clocking out 9 SCL pulses followed by a stop condition.
+//
+// Each I2C device address may have its own I2C frequency, so that fast and
+// slow devices can share the same bus. The MPSSE clock divisor is changed
+// within the command sequence right before a transaction, but only if the
+// frequency actually changes.
+//
+// Transactions executed repeatedly can be prepared (see i2c_mpsse_prepare()).
+// Their MPSSE command sequence is compiled once into a template, in which only
+// the data bytes written are patched for each execution. The template is
+// compiled again automatically, if the pin states, the clock or the I2C
+// settings of the adapter have changed in the meantime.
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <mpsse.h>
+#include "mpsse_adapter.h"
+#include "i2c_mpsse.h"
+
+
+
+// I2C pins.
+#define I2C_MPSSE_SCL           SK          // ADBUS0
+#define I2C_MPSSE_SDA_OUT       DO          // ADBUS1
+#define I2C_MPSSE_SDA_IN        DI          // ADBUS2
+#define I2C_MPSSE_PINS          (I2C_MPSSE_SCL | I2C_MPSSE_SDA_OUT | I2C_MPSSE_SDA_IN)
+#define I2C_MPSSE_RTCK          GPIO3       // ADBUS7
+
+// Pin SDA is read on. In open drain mode, ADBUS1 always shows the SDA level.
+#define I2C_MPSSE_SDA(adapter)  ((adapter)->i2c_open_drain ? I2C_MPSSE_SDA_OUT : I2C_MPSSE_SDA_IN)
+
+// The three phase clocking stretches each SCL period to 3/2 of the MPSSE
+// clock period. Get the MPSSE clock frequency for an I2C frequency.
+#define I2C_MPSSE_CLOCK(freq)   (((freq) * 3) / 2)
+
+// Number of SCL pulses for freeing SDA held low by a target.
+#define I2C_MPSSE_RECOVER_PULSES    9
+
+// MPSSE data shifting commands. I2C propagates data on the falling clock edge
+// and reads data on the rising clock edge.
+#define I2C_MPSSE_TX            (MPSSE_DO_WRITE | MSB | MPSSE_WRITE_NEG)
+#define I2C_MPSSE_RX            (MPSSE_DO_READ | MSB)
+
+
+
+// I2C transfer job.
+struct i2c_mpsse_job {
+    struct i2c_mpsse_msg *msgs;
+    int num;
+    int nack_adr;               // Number of NACKs received for device addresses.
+    int nack_data;              // Number of NACKs received for data bytes.
+    unsigned char bus;          // Levels of the I2C lines after the transaction.
+};
+
+// I2C batch job.
+struct i2c_mpsse_batch_job {
+    struct i2c_mpsse_xfer *xfers;
+    int num;
+    unsigned char *bus;         // Levels of the I2C lines after each transaction.
+};
+
+
+
+// Prepared I2C transaction.
+struct i2c_mpsse_prep {
+    struct mpsse_adapter *adapter;
+    struct i2c_mpsse_msg *msgs; // Messages bound to the transaction.
+    int num;
+    struct mpsse_cmd tmpl;      // Compiled command template.
+    int *slots;                 // Template offsets of the data bytes written.
+    int num_slots;
+    int valid;                  // Template compiled.
+    // Adapter state the template was compiled for.
+    struct mpsse_pins pins;
+    int clock;
+    int freq;
+    int adaptive;
+    int open_drain;
+    int strap;
+    // Adapter state after the template.
+    struct mpsse_pins pins_end;
+    int clock_end;
+    // Results.
+    int nack_adr;               // Number of NACKs received for device addresses.
+    int nack_data;              // Number of NACKs received for data bytes.
+    unsigned char bus;          // Levels of the I2C lines after the transaction.
+};
+
+
+
+// Global variables.
+// Default I2C adapter used by the non-reentrant functions.
+static struct mpsse_adapter *i2c_mpsse = NULL;
+static pthread_mutex_t i2c_mpsse_init_lock = PTHREAD_MUTEX_INITIALIZER;
+static int i2c_mpsse_verbose = 1;
+
+
+
+// Function prototypes.
+static struct mpsse_adapter *i2c_mpsse_setup(struct mpsse_adapter *adapter);
+static int i2c_mpsse_reg_adr_check(struct mpsse_adapter *adapter, int adr_width);
+static void i2c_mpsse_reg_adr(char *buf, unsigned int reg_adr, int adr_width);
+static int i2c_mpsse_build_lines(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, int scl, int sda, int sda_drive);
+static int i2c_mpsse_build_sample(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, char *data, int *nack);
+static int i2c_mpsse_build_start(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, int repeated);
+static int i2c_mpsse_build_stop(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter);
+static int i2c_mpsse_build_write_byte(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, unsigned char data, int *nack, int *offset);
+static int i2c_mpsse_build_read_byte(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, char *data, int last);
+static int i2c_mpsse_build_msgs(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, struct i2c_mpsse_msg *msgs, int num, int *nack_adr, int *nack_data, unsigned char *bus, int *slots);
+static int i2c_mpsse_dev_freq(struct mpsse_adapter *adapter, struct i2c_mpsse_msg *msgs, int num);
+static int i2c_mpsse_build_dev_freq(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, struct i2c_mpsse_msg *msgs, int num);
+static int i2c_mpsse_build_get_bus(struct mpsse_cmd *cmd, unsigned char *bus);
+static int i2c_mpsse_check_bus(struct mpsse_adapter *adapter, unsigned char bus);
+static int i2c_mpsse_build_transfer(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int i2c_mpsse_build_batch(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int i2c_mpsse_prep_valid(struct mpsse_adapter *adapter, struct i2c_mpsse_prep *prep);
+static int i2c_mpsse_build_prep(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int i2c_mpsse_build_set_freq(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int i2c_mpsse_build_init(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int i2c_mpsse_build_set_stretch(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int i2c_mpsse_build_set_strap(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int i2c_mpsse_build_recover(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+
+
+
+// Initialize the I2C hardware.
+int i2c_init(void)
+{
+    pthread_mutex_lock(&i2c_mpsse_init_lock);
+
+    // Open the default I2C device, if it was not yet initialized.
+    if(i2c_mpsse == NULL) {
+        i2c_mpsse = i2c_mpsse_open();
+        if(i2c_mpsse != NULL)
+            i2c_mpsse_set_verbose(i2c_mpsse, i2c_mpsse_verbose);
+    }
+
+    pthread_mutex_unlock(&i2c_mpsse_init_lock);
+
+    return (i2c_mpsse == NULL) ? -1 : 0;
+}
+
+
+
+// Reset the I2C hardware.
+int i2c_reset(void)
+{
+    // This is a dummy function, no operation.
+    return 0;
+}
+
+
+
+// Close the I2C hardware.
+int i2c_close(void)
+{
+    pthread_mutex_lock(&i2c_mpsse_init_lock);
+    i2c_mpsse_close(i2c_mpsse);
+    i2c_mpsse = NULL;
+    pthread_mutex_unlock(&i2c_mpsse_init_lock);
+
+    return 0;
+}
+
+
+
+// Get the I2C frequency.
+int i2c_get_freq(int *i2c_freq)
+{
+    return i2c_mpsse_get_freq(i2c_mpsse, i2c_freq);
+}
+
+
+
+// Set the I2C frequency.
+int i2c_set_freq(int i2c_freq)
+{
+    return i2c_mpsse_set_freq(i2c_mpsse, i2c_freq);
+}
+
+
+
+// Get information about the I2C device.
+int i2c_info(void)
+{
+    return i2c_mpsse_info(i2c_mpsse);
+}
+
+
+
+// Set the I2C frequency of an I2C device address.
+int i2c_set_dev_freq(int i2c_dev_adr, int i2c_freq)
+{
+    return i2c_mpsse_set_dev_freq(i2c_mpsse, i2c_dev_adr, i2c_freq);
+}
+
+
+
+// Get the I2C frequency of an I2C device address.
+int i2c_get_dev_freq(int i2c_dev_adr, int *i2c_freq)
+{
+    return i2c_mpsse_get_dev_freq(i2c_mpsse, i2c_dev_adr, i2c_freq);
+}
+
+
+
+// Enable or disable I2C clock stretching.
+int i2c_set_stretch(int enable)
+{
+    return i2c_mpsse_set_stretch(i2c_mpsse, enable);
+}
+
+
+
+// Tell the I2C engine whether ADBUS1 and ADBUS2 are tied together.
+int i2c_set_strap(int strap)
+{
+    return i2c_mpsse_set_strap(i2c_mpsse, strap);
+}
+
+
+
+// Recover the I2C bus from a target holding SDA low.
+int i2c_recover(void)
+{
+    return i2c_mpsse_recover(i2c_mpsse);
+}
+
+
+
+// Set verbosity of the I2C functions.
+int i2c_set_verbose(int verbose)
+{
+    i2c_mpsse_verbose = verbose;
+    if(i2c_mpsse != NULL)
+        i2c_mpsse_set_verbose(i2c_mpsse, verbose);
+    return 0;
+}
+
+
+
+// Write data to the I2C bus.
+int i2c_write(int i2c_dev_adr, char *data, int size)
+{
+    return i2c_mpsse_write(i2c_mpsse, i2c_dev_adr, data, size);
+}
+
+
+
+// Read data from the I2C bus.
+int i2c_read(int i2c_dev_adr, char *data, int size)
+{
+    return i2c_mpsse_read(i2c_mpsse, i2c_dev_adr, data, size);
+}
+
+
+
+// Write data to a register of an I2C device.
+int i2c_reg_write(int i2c_dev_adr, unsigned int reg_adr, int adr_width, char *data, int size)
+{
+    return i2c_mpsse_reg_write(i2c_mpsse, i2c_dev_adr, reg_adr, adr_width, data, size);
+}
+
+
+
+// Read data from a register of an I2C device.
+int i2c_reg_read(int i2c_dev_adr, unsigned int reg_adr, int adr_width, char *data, int size)
+{
+    return i2c_mpsse_reg_read(i2c_mpsse, i2c_dev_adr, reg_adr, adr_width, data, size);
+}
+
+
+
+// Execute several I2C messages as one combined transaction.
+int i2c_transfer(struct i2c_mpsse_msg *msgs, int num)
+{
+    return i2c_mpsse_transfer(i2c_mpsse, msgs, num);
+}
+
+
+
+// Execute several independent I2C transactions in one USB transfer.
+int i2c_transfer_batch(struct i2c_mpsse_xfer *xfers, int num)
+{
+    return i2c_mpsse_transfer_batch(i2c_mpsse, xfers, num);
+}
+
+
+
+// Prepare an I2C transaction for repeated execution.
+struct i2c_mpsse_prep *i2c_prepare(struct i2c_mpsse_msg *msgs, int num)
+{
+    return i2c_mpsse_prepare(i2c_mpsse, msgs, num);
+}
+
+
+
+// Get the default I2C adapter.
+struct mpsse_adapter *i2c_get_adapter(void)
+{
+    return i2c_mpsse;
+}
+
+
+
+// Open an I2C adapter.
+// If the adapter is already used by the GPIO functions, the I2C functions
+// share it.
+struct mpsse_adapter *i2c_mpsse_open(void)
+{
+    // Open the I2C device with default frequency of 100 kHz.
+    return i2c_mpsse_setup(mpsse_adapter_open(I2C, I2C_MPSSE_CLOCK(ONE_HUNDRED_KHZ), MSB));
+}
+
+
+
+// Open an I2C adapter on an interface (IFACE_A .. IFACE_D) of the FTDI device
+// with the given serial number, NULL for the first device found. Each MPSSE
+// interface of an FT2232H or FT4232H drives an I2C bus of its own. The buses
+// can be used from different threads in parallel.
+struct mpsse_adapter *i2c_mpsse_open_if(const char *serial, int interface)
+{
+    return i2c_mpsse_setup(mpsse_adapter_open_if(I2C, I2C_MPSSE_CLOCK(ONE_HUNDRED_KHZ), MSB, serial, interface));
+}
+
+
+
+// Set up the I2C pins of a newly opened adapter.
+static struct mpsse_adapter *i2c_mpsse_setup(struct mpsse_adapter *adapter)
+{
+    int status;
+    unsigned char bus = 0;
+
+    if(adapter == NULL) return NULL;
+
+    // Set up the I2C pins and clocking.
+    status = mpsse_adapter_run(adapter, i2c_mpsse_build_init, &bus);
+    if(status) {
+        fprintf(stderr, "%s: %s: %sUnable to set up the I2C pins.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        mpsse_adapter_close(adapter);
+        return NULL;
+    }
+
+    // Free the I2C bus, if a target still holds SDA low, e.g. after the
+    // previous program was aborted in the middle of a transaction.
+    if(i2c_mpsse_check_bus(adapter, bus)) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C bus is stuck (SCL = %d, SDA = %d). Trying to recover it.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, (bus & I2C_MPSSE_SCL) ? 1 : 0, (bus & I2C_MPSSE_SDA(adapter)) ? 1 : 0);
+        i2c_mpsse_recover(adapter);
+    }
+
+    return adapter;
+}
+
+
+
+// Close an I2C adapter.
+int i2c_mpsse_close(struct mpsse_adapter *adapter)
+{
+    mpsse_adapter_close(adapter);
+
+    return 0;
+}
+
+
+
+// Get information about an I2C adapter.
+int i2c_mpsse_info(struct mpsse_adapter *adapter)
+{
+    // Check if the I2C device was initialized.
+    if(adapter == NULL) {
+        if(i2c_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    printf("I2C master device: %s\n", GetDescription(adapter->mpsse));
+    printf("I2C master device VID: 0x%04x\n", GetVid(adapter->mpsse));
+    printf("I2C master device PID: 0x%04x\n", GetPid(adapter->mpsse));
+    printf("I2C bus speed: %d Hz\n", adapter->i2c_freq);
+    printf("I2C clock stretching: %s\n", adapter->adaptive ? "enabled" : "disabled");
+    printf("I2C SDA output: %s\n", adapter->i2c_open_drain ? "open drain" : "push-pull");
+    printf("I2C SDA input: %s\n", (!adapter->i2c_open_drain || adapter->i2c_strap) ? "ADBUS2 (tied to ADBUS1)" : "ADBUS1");
+
+    return 0;
+}
+
+
+
+// Get the I2C frequency of an I2C adapter.
+int i2c_mpsse_get_freq(struct mpsse_adapter *adapter, int *i2c_freq)
+{
+    // Check if the I2C device was initialized.
+    if(adapter == NULL) {
+        if(i2c_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    *i2c_freq = adapter->i2c_freq;
+
+    return 0;
+}
+
+
+
+// Set the default I2C frequency of an I2C adapter. It is used for all I2C
+// device addresses without their own I2C frequency.
+int i2c_mpsse_set_freq(struct mpsse_adapter *adapter, int i2c_freq)
+{
+    int status;
+
+    // Check if the I2C device was initialized.
+    if(adapter == NULL) {
+        if(i2c_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    if(i2c_freq <= 0) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sInvalid I2C frequency of %d Hz.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i2c_freq);
+        return -1;
+    }
+
+    status = mpsse_adapter_run(adapter, i2c_mpsse_build_set_freq, &i2c_freq);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to set the I2C frequency to %d Hz.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i2c_freq);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Set the I2C frequency of an I2C device address. All transactions with this
+// device are then executed at this frequency. A frequency of 0 makes the
+// device use the default I2C frequency again.
+int i2c_mpsse_set_dev_freq(struct mpsse_adapter *adapter, int i2c_dev_adr, int i2c_freq)
+{
+    // Check if the I2C device was initialized.
+    if(adapter == NULL) {
+        if(i2c_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    if(i2c_freq < 0) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sInvalid I2C frequency of %d Hz for the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i2c_freq, i2c_dev_adr);
+        return -1;
+    }
+
+    mpsse_adapter_lock(adapter);
+    adapter->i2c_dev_freq[i2c_dev_adr & 0x7f] = i2c_freq;
+    mpsse_adapter_unlock(adapter);
+
+    return 0;
+}
+
+
+
+// Get the I2C frequency used for an I2C device address.
+int i2c_mpsse_get_dev_freq(struct mpsse_adapter *adapter, int i2c_dev_adr, int *i2c_freq)
+{
+    // Check if the I2C device was initialized.
+    if(adapter == NULL) {
+        if(i2c_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    mpsse_adapter_lock(adapter);
+    *i2c_freq = adapter->i2c_dev_freq[i2c_dev_adr & 0x7f];
+    if(*i2c_freq == 0)
+        *i2c_freq = adapter->i2c_freq;
+    mpsse_adapter_unlock(adapter);
+
+    return 0;
+}
+
+
+
+// Set verbosity of the I2C functions operating on an I2C adapter.
+int i2c_mpsse_set_verbose(struct mpsse_adapter *adapter, int verbose)
+{
+    if(adapter == NULL) return -1;
+
+    adapter->verbose = verbose;
+
+    return 0;
+}
+
+
+
+// Enable or disable I2C clock stretching on an I2C adapter. SCL is then only
+// driven low and read back on GPIOL3 (RTCK) for adaptive clocking, so the
+// MPSSE waits while a target holds SCL low. This allows running the bus at
+// 400 kHz or 1 MHz with slow targets, which would otherwise require lowering
+// the frequency of the whole bus.
+// CAUTION: SCL (ADBUS0) must be connected to GPIOL3 (ADBUS7)! Otherwise, the
+// MPSSE stalls on the first clock pulse. Only supported by the FT232H.
+// In open drain mode, set the strap first, see i2c_mpsse_set_strap().
+int i2c_mpsse_set_stretch(struct mpsse_adapter *adapter, int enable)
+{
+    int status;
+
+    // Check if the I2C device was initialized.
+    if(adapter == NULL) {
+        if(i2c_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    status = mpsse_adapter_run(adapter, i2c_mpsse_build_set_stretch, &enable);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to %s I2C clock stretching.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, enable ? "enable" : "disable");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Tell the I2C engine whether ADBUS1 (SDA output) and ADBUS2 (SDA input) are
+// tied together. In open drain mode, SDA is then read by shifting in whole
+// bytes on ADBUS2 instead of sampling each bit on ADBUS1. This reduces the
+// number of commands and read-back bytes of a read by a factor of 8 and lets
+// the MPSSE clock SCL with the configured timing also for reads.
+// Without open drain mode, i.e. on other chips than the FT232H, the strap is
+// always required. The strap cannot be removed while clock stretching is
+// enabled.
+int i2c_mpsse_set_strap(struct mpsse_adapter *adapter, int strap)
+{
+    int status;
+
+    // Check if the I2C device was initialized.
+    if(adapter == NULL) {
+        if(i2c_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    status = mpsse_adapter_run(adapter, i2c_mpsse_build_set_strap, &strap);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to set the I2C SDA strap.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Recover the I2C bus from a target holding SDA low, e.g. after a transaction
+// was interrupted. With SDA released, 9 SCL pulses are clocked out, so that
+// the target can finish sending its byte, followed by a stop condition.
+int i2c_mpsse_recover(struct mpsse_adapter *adapter)
+{
+    int status;
+    unsigned char bus = 0;
+
+    // Check if the I2C device was initialized.
+    if(adapter == NULL) {
+        if(i2c_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    status = mpsse_adapter_run(adapter, i2c_mpsse_build_recover, &bus);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to recover the I2C bus.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    if(i2c_mpsse_check_bus(adapter, bus)) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C bus is still stuck after the recovery (SCL = %d, SDA = %d).\n", __FILE__, __FUNCTION__, PREFIX_ERROR, (bus & I2C_MPSSE_SCL) ? 1 : 0, (bus & I2C_MPSSE_SDA(adapter)) ? 1 : 0);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Write data to the I2C bus.
+int i2c_mpsse_write(struct mpsse_adapter *adapter, int i2c_dev_adr, char *data, int size)
+{
+    struct i2c_mpsse_msg msg;
+
+    msg.adr = i2c_dev_adr;
+    msg.flags = 0;
+    msg.len = size;
+    msg.buf = data;
+
+    return i2c_mpsse_transfer(adapter, &msg, 1);
+}
+
+
+
+// Read data from the I2C bus.
+int i2c_mpsse_read(struct mpsse_adapter *adapter, int i2c_dev_adr, char *data, int size)
+{
+    struct i2c_mpsse_msg msg;
+
+    msg.adr = i2c_dev_adr;
+    msg.flags = I2C_MPSSE_M_RD;
+    msg.len = size;
+    msg.buf = data;
+
+    return i2c_mpsse_transfer(adapter, &msg, 1);
+}
+
+
+
+// Write data to a register of an I2C device. The register address of
+// adr_width bytes (0, 1, 2 or 4) is sent first, most significant byte first,
+// followed by the data in the same write message.
+int i2c_mpsse_reg_write(struct mpsse_adapter *adapter, int i2c_dev_adr, unsigned int reg_adr, int adr_width, char *data, int size)
+{
+    int status;
+    char *buf;
+    struct i2c_mpsse_msg msg;
+
+    if(i2c_mpsse_reg_adr_check(adapter, adr_width) || size < 0) return -1;
+
+    buf = malloc(adr_width + size + 1);
+    if(buf == NULL) {
+        fprintf(stderr, "%s: %s: %sCannot allocate memory for %d byte(s) of I2C data.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, adr_width + size);
+        return -1;
+    }
+    i2c_mpsse_reg_adr(buf, reg_adr, adr_width);
+    if(size > 0)
+        memcpy(buf + adr_width, data, size);
+
+    msg.adr = i2c_dev_adr;
+    msg.flags = 0;
+    msg.len = adr_width + size;
+    msg.buf = buf;
+    status = i2c_mpsse_transfer(adapter, &msg, 1);
+    free(buf);
+
+    return status;
+}
+
+
+
+// Read data from a register of an I2C device. The register address of
+// adr_width bytes (0, 1, 2 or 4) is written, then all data bytes are read
+// after a repeated start condition in one burst. Large reads are split into
+// several USB transfers by the MPSSE adapter layer without interrupting the
+// I2C transaction.
+// NOTE: The command sequence of the whole transaction is built in memory
+// first. Without the ADBUS1/ADBUS2 strap, this takes several dozen bytes per
+// data byte.
+int i2c_mpsse_reg_read(struct mpsse_adapter *adapter, int i2c_dev_adr, unsigned int reg_adr, int adr_width, char *data, int size)
+{
+    char buf[4];
+    struct i2c_mpsse_msg msgs[2];
+
+    if(i2c_mpsse_reg_adr_check(adapter, adr_width) || size <= 0) return -1;
+
+    // Without register address, this is a plain read.
+    if(adr_width == 0)
+        return i2c_mpsse_read(adapter, i2c_dev_adr, data, size);
+
+    i2c_mpsse_reg_adr(buf, reg_adr, adr_width);
+    msgs[0].adr = i2c_dev_adr;
+    msgs[0].flags = 0;
+    msgs[0].len = adr_width;
+    msgs[0].buf = buf;
+    msgs[1].adr = i2c_dev_adr;
+    msgs[1].flags = I2C_MPSSE_M_RD;
+    msgs[1].len = size;
+    msgs[1].buf = data;
+
+    return i2c_mpsse_transfer(adapter, msgs, 2);
+}
+
+
+
+// Execute several I2C messages as one combined transaction.
+int i2c_mpsse_transfer(struct mpsse_adapter *adapter, struct i2c_mpsse_msg *msgs, int num)
+{
+    int status;
+    struct i2c_mpsse_job job;
+
+    // Check if the I2C device was initialized.
+    if(adapter == NULL) {
+        if(i2c_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    if(msgs == NULL || num <= 0) return -1;
+
+    // Execute the transaction.
+    job.msgs = msgs;
+    job.num = num;
+    job.nack_adr = 0;
+    job.nack_data = 0;
+    job.bus = 0;
+    status = mpsse_adapter_run(adapter, i2c_mpsse_build_transfer, &job);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to transfer %d I2C message(s) to the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, num, msgs[0].adr);
+        return -1;
+    }
+
+    // Check that the bus is free again. The ACK bits and data read are not
+    // valid, if a target held SDA low.
+    if(i2c_mpsse_check_bus(adapter, job.bus)) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C bus was stuck after the transaction with the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, msgs[0].adr);
+        i2c_mpsse_recover(adapter);
+        return -1;
+    }
+
+    // Check for acknowledge.
+    if(job.nack_adr) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sDid not get acknowledge from the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, msgs[0].adr);
+        return -1;
+    }
+    if(job.nack_data) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sDid not get acknowledge from the I2C chip address 0x%02x after writing data.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, msgs[0].adr);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Check the width of a register address.
+static int i2c_mpsse_reg_adr_check(struct mpsse_adapter *adapter, int adr_width)
+{
+    if(adr_width == 0 || adr_width == 1 || adr_width == 2 || adr_width == 4)
+        return 0;
+
+    if(adapter == NULL ? i2c_mpsse_verbose : adapter->verbose)
+        fprintf(stderr, "%s: %s: %sInvalid register address width of %d byte(s).\n", __FILE__, __FUNCTION__, PREFIX_ERROR, adr_width);
+
+    return -1;
+}
+
+
+
+// Convert a register address to adr_width bytes, most significant byte first.
+static void i2c_mpsse_reg_adr(char *buf, unsigned int reg_adr, int adr_width)
+{
+    int i;
+
+    for(i = 0; i < adr_width; i++)
+        buf[i] = (char) ((reg_adr >> (8 * (adr_width - 1 - i))) & 0xff);
+}
+
+
+
+// Set the I2C lines. All other pins keep their states. In open drain mode,
+// SDA stays an output and is released by setting it high.
+static int i2c_mpsse_build_lines(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, int scl, int sda, int sda_drive)
+{
+    unsigned char value = 0;
+    unsigned char direction = I2C_MPSSE_SCL;
+
+    if(scl) value |= I2C_MPSSE_SCL;
+    if(adapter->i2c_open_drain) {
+        if(sda || !sda_drive) value |= I2C_MPSSE_SDA_OUT;
+        direction |= I2C_MPSSE_SDA_OUT;
+    } else {
+        if(sda) value |= I2C_MPSSE_SDA_OUT;
+        if(sda_drive) direction |= I2C_MPSSE_SDA_OUT;
+    }
+
+    return mpsse_adapter_set_low(adapter, cmd, value, direction, I2C_MPSSE_PINS);
+}
+
+
+
+// Build clocking in one bit by sampling SDA on ADBUS1 while SCL is high. SDA
+// must already be released and SCL be low. Used in open drain mode without
+// ADBUS1 and ADBUS2 tied together. The bit is shifted into data.
+// The SCL high phase is timed by clocking one bit at the I2C clock, which
+// takes one SCL period with the three phase clocking. SCL is made an input
+// meanwhile, which releases it just like driving it high in open drain mode,
+// so that the clock pulse does not appear on SCL. SDA is sampled at the end
+// of the high phase.
+// NOTE: Adaptive clocking would stall on the clock pulse, as SCL is not
+// driven. Clock stretching therefore requires the strap.
+static int i2c_mpsse_build_sample(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, char *data, int *nack)
+{
+    int status = 0;
+    unsigned char buf[2];
+
+    if(adapter->adaptive) return -1;
+
+    status |= mpsse_adapter_set_low(adapter, cmd, I2C_MPSSE_SCL | I2C_MPSSE_SDA_OUT, I2C_MPSSE_SDA_OUT, I2C_MPSSE_PINS);
+    buf[0] = CLK_BITS;
+    buf[1] = 0;
+    status |= mpsse_cmd_bytes(cmd, buf, 2);
+    status |= mpsse_cmd_read_bit(cmd, (unsigned char *) data, I2C_MPSSE_SDA_OUT, nack);
+    status |= mpsse_cmd_byte(cmd, GET_BITS_LOW);
+    status |= i2c_mpsse_build_lines(cmd, adapter, 0, 0, 0);
+
+    return status;
+}
+
+
+
+// Execute several independent I2C transactions in one USB transfer. Each
+// transaction has its own start and stop condition. The result of each
+// transaction is stored in its status field (0 = OK, -1 = NACK received).
+// Returns 0 if all transactions succeeded.
+int i2c_mpsse_transfer_batch(struct mpsse_adapter *adapter, struct i2c_mpsse_xfer *xfers, int num)
+{
+    int i;
+    int status;
+    int stuck = 0;
+    struct i2c_mpsse_batch_job job;
+
+    // Check if the I2C device was initialized.
+    if(adapter == NULL) {
+        if(i2c_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    if(xfers == NULL || num <= 0) return -1;
+
+    // Check the delays, so that a batch is not rejected while being built.
+    for(i = 0; i < num; i++) {
+        if(xfers[i].delay < 0 || xfers[i].delay > MPSSE_ADAPTER_DELAY_MAX) {
+            if(adapter->verbose)
+                fprintf(stderr, "%s: %s: %sInvalid delay of %d us after I2C transaction %d. Use 0..%d us.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, xfers[i].delay, i, MPSSE_ADAPTER_DELAY_MAX);
+            for(i = 0; i < num; i++)
+                xfers[i].status = -1;
+            return -1;
+        }
+    }
+
+    // Execute the transactions.
+    job.xfers = xfers;
+    job.num = num;
+    job.bus = calloc(num, 1);
+    if(job.bus == NULL)
+        status = -1;
+    else
+        status = mpsse_adapter_run(adapter, i2c_mpsse_build_batch, &job);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to execute a batch of %d I2C transaction(s).\n", __FILE__, __FUNCTION__, PREFIX_ERROR, num);
+        for(i = 0; i < num; i++)
+            xfers[i].status = -1;
+        free(job.bus);
+        return -1;
+    }
+
+    // Check for acknowledge and a stuck bus.
+    for(i = 0; i < num; i++) {
+        if(i2c_mpsse_check_bus(adapter, job.bus[i])) {
+            xfers[i].status = -1;
+            stuck = 1;
+        }
+        if(xfers[i].status) {
+            xfers[i].status = -1;
+            status = -1;
+        }
+    }
+    free(job.bus);
+
+    // Free the I2C bus.
+    if(stuck) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C bus was stuck during a batch of %d I2C transaction(s).\n", __FILE__, __FUNCTION__, PREFIX_ERROR, num);
+        i2c_mpsse_recover(adapter);
+    }
+
+    return status;
+}
+
+
+
+// Prepare an I2C transaction for repeated execution. The messages are bound to
+// the prepared transaction and must stay valid until it is freed. Only the
+// contents of their data buffers may change between the executions: The data
+// to write is taken from the buffers on each execution and the data read is
+// stored in them. The MPSSE command sequence is compiled on the first
+// execution, later executions only patch the data bytes written.
+// A prepared transaction must only be executed by one thread at a time.
+struct i2c_mpsse_prep *i2c_mpsse_prepare(struct mpsse_adapter *adapter, struct i2c_mpsse_msg *msgs, int num)
+{
+    int i;
+    struct i2c_mpsse_prep *prep;
+
+    // Check if the I2C device was initialized.
+    if(adapter == NULL) {
+        if(i2c_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return NULL;
+    }
+    if(msgs == NULL || num <= 0) return NULL;
+
+    prep = calloc(1, sizeof(struct i2c_mpsse_prep));
+    if(prep == NULL) {
+        fprintf(stderr, "%s: %s: %sCannot allocate memory for a prepared I2C transaction.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return NULL;
+    }
+    prep->adapter = adapter;
+    prep->msgs = msgs;
+    prep->num = num;
+    mpsse_cmd_init(&prep->tmpl);
+
+    // Allocate one slot per data byte written.
+    for(i = 0; i < num; i++)
+        if(!(msgs[i].flags & I2C_MPSSE_M_RD))
+            prep->num_slots += msgs[i].len;
+    if(prep->num_slots > 0) {
+        prep->slots = malloc(prep->num_slots * sizeof(int));
+        if(prep->slots == NULL) {
+            fprintf(stderr, "%s: %s: %sCannot allocate memory for a prepared I2C transaction.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+            free(prep);
+            return NULL;
+        }
+    }
+
+    return prep;
+}
+
+
+
+// Execute a prepared I2C transaction.
+int i2c_mpsse_prep_execute(struct i2c_mpsse_prep *prep)
+{
+    int status;
+    struct mpsse_adapter *adapter;
+
+    if(prep == NULL) return -1;
+    adapter = prep->adapter;
+
+    // Execute the transaction.
+    prep->nack_adr = 0;
+    prep->nack_data = 0;
+    prep->bus = 0;
+    status = mpsse_adapter_run(adapter, i2c_mpsse_build_prep, prep);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to execute a prepared I2C transaction with the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, prep->msgs[0].adr);
+        return -1;
+    }
+
+    // Check that the bus is free again. The ACK bits and data read are not
+    // valid, if a target held SDA low.
+    if(i2c_mpsse_check_bus(adapter, prep->bus)) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sThe I2C bus was stuck after the transaction with the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, prep->msgs[0].adr);
+        i2c_mpsse_recover(adapter);
+        return -1;
+    }
+
+    // Check for acknowledge.
+    if(prep->nack_adr) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sDid not get acknowledge from the I2C chip address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, prep->msgs[0].adr);
+        return -1;
+    }
+    if(prep->nack_data) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sDid not get acknowledge from the I2C chip address 0x%02x after writing data.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, prep->msgs[0].adr);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Free a prepared I2C transaction.
+void i2c_mpsse_prep_free(struct i2c_mpsse_prep *prep)
+{
+    if(prep == NULL) return;
+
+    mpsse_cmd_free(&prep->tmpl);
+    free(prep->slots);
+    free(prep);
+}
+
+
+
+// Build an I2C (repeated) start condition.
+static int i2c_mpsse_build_start(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, int repeated)
+{
+    int status = 0;
+
+    // Release SDA while SCL is low, then release SCL, since this is an I2C
+    // repeated start condition.
+    if(repeated) {
+        status |= i2c_mpsse_build_lines(cmd, adapter, 0, 1, 1);
+        status |= i2c_mpsse_build_lines(cmd, adapter, 1, 1, 1);
+    }
+
+    // Pull SDA low while SCL is high.
+    status |= i2c_mpsse_build_lines(cmd, adapter, 1, 0, 1);
+
+    return status;
+}
+
+
+
+// Build an I2C stop condition.
+static int i2c_mpsse_build_stop(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter)
+{
+    int status = 0;
+
+    // Pull SDA low while SCL is low to avoid an inadvertent start condition.
+    status |= i2c_mpsse_build_lines(cmd, adapter, 0, 0, 1);
+    // Release SCL, then SDA.
+    status |= i2c_mpsse_build_lines(cmd, adapter, 1, 0, 1);
+    status |= i2c_mpsse_build_lines(cmd, adapter, 1, 1, 1);
+
+    return status;
+}
+
+
+
+// Build the transmission of one byte, followed by reading the ACK bit.
+// If offset is not NULL, the position of the data byte in the command buffer
+// is stored there, so that it can be patched later.
+static int i2c_mpsse_build_write_byte(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, unsigned char data, int *nack, int *offset)
+{
+    int status = 0;
+    unsigned char buf[4];
+
+    // Clock out the data byte with SCL low. In open drain mode, SCL is
+    // already low after the previous byte, except after a start condition.
+    if(!adapter->i2c_open_drain || (adapter->pins.low & I2C_MPSSE_SCL))
+        status |= i2c_mpsse_build_lines(cmd, adapter, 0, 0, 1);
+    buf[0] = I2C_MPSSE_TX;
+    buf[1] = 0;
+    buf[2] = 0;
+    buf[3] = data;
+    if(offset != NULL)
+        *offset = cmd->len + 3;
+    status |= mpsse_cmd_bytes(cmd, buf, 4);
+
+    if(adapter->i2c_open_drain) {
+        if(adapter->i2c_strap) {
+            // Release SDA by shifting out a one and clock in the ACK bit on
+            // ADBUS2 with the same clock pulse.
+            status |= mpsse_cmd_read(cmd, NULL, 1, nack);
+            buf[0] = I2C_MPSSE_TX | MPSSE_DO_READ | MPSSE_BITMODE;
+            buf[1] = 0;
+            buf[2] = 0xff;
+            status |= mpsse_cmd_bytes(cmd, buf, 3);
+        } else {
+            // Release SDA and sample the ACK bit on ADBUS1.
+            status |= i2c_mpsse_build_lines(cmd, adapter, 0, 0, 0);
+            status |= i2c_mpsse_build_sample(cmd, adapter, NULL, nack);
+        }
+        return status;
+    }
+
+    // Make SDA an input and clock in the ACK bit.
+    status |= i2c_mpsse_build_lines(cmd, adapter, 0, 0, 0);
+    status |= mpsse_cmd_read(cmd, NULL, 1, nack);
+    buf[0] = I2C_MPSSE_RX | MPSSE_BITMODE;
+    buf[1] = 0;
+    status |= mpsse_cmd_bytes(cmd, buf, 2);
+
+    return status;
+}
+
+
+
+// Build the reception of one byte, followed by sending an ACK or, for the last
+// byte, a NACK.
+static int i2c_mpsse_build_read_byte(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, char *data, int last)
+{
+    int i;
+    int status = 0;
+    unsigned char buf[4];
+
+    if(adapter->i2c_open_drain && adapter->i2c_strap) {
+        // Release SDA by shifting out ones and clock in the data byte on
+        // ADBUS2 at the same time.
+        status |= mpsse_cmd_read(cmd, (unsigned char *) data, 1, NULL);
+        buf[0] = I2C_MPSSE_TX | MPSSE_DO_READ;
+        buf[1] = 0;
+        buf[2] = 0;
+        buf[3] = 0xff;
+        status |= mpsse_cmd_bytes(cmd, buf, 4);
+    } else if(adapter->i2c_open_drain) {
+        // Release SDA and sample the data bits on ADBUS1.
+        status |= i2c_mpsse_build_lines(cmd, adapter, 0, 0, 0);
+        for(i = 0; i < 8; i++)
+            status |= i2c_mpsse_build_sample(cmd, adapter, data, NULL);
+    } else {
+        // Make SDA an input and clock in the data byte.
+        status |= i2c_mpsse_build_lines(cmd, adapter, 0, 0, 0);
+        status |= mpsse_cmd_read(cmd, (unsigned char *) data, 1, NULL);
+        buf[0] = I2C_MPSSE_RX;
+        buf[1] = 0;
+        buf[2] = 0;
+        status |= mpsse_cmd_bytes(cmd, buf, 3);
+        // Drive SDA again.
+        status |= i2c_mpsse_build_lines(cmd, adapter, 0, 0, 1);
+    }
+
+    // Clock out the ACK/NACK bit.
+    buf[0] = I2C_MPSSE_TX | MPSSE_BITMODE;
+    buf[1] = 0;
+    buf[2] = last ? 0xff : 0x00;
+    status |= mpsse_cmd_bytes(cmd, buf, 3);
+
+    return status;
+}
+
+
+
+// Build a combined I2C transaction. If bus is not NULL, the levels of the I2C
+// lines are read back after the stop condition. If slots is not NULL, the
+// offsets of all data bytes written are stored there in message order.
+static int i2c_mpsse_build_msgs(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, struct i2c_mpsse_msg *msgs, int num, int *nack_adr, int *nack_data, unsigned char *bus, int *slots)
+{
+    int i, j;
+    int k = 0;
+    int status = 0;
+    struct i2c_mpsse_msg *msg;
+
+    // Switch to the I2C frequency of the devices.
+    status |= i2c_mpsse_build_dev_freq(cmd, adapter, msgs, num);
+
+    for(i = 0; i < num; i++) {
+        msg = &msgs[i];
+        // Generate (repeated) start condition.
+        status |= i2c_mpsse_build_start(cmd, adapter, i > 0);
+        // Send device address with read or write command.
+        if(msg->flags & I2C_MPSSE_M_RD) {
+            status |= i2c_mpsse_build_write_byte(cmd, adapter, ((msg->adr & 0x7f) << 1) | 0x01, nack_adr, NULL);
+            for(j = 0; j < msg->len; j++)
+                status |= i2c_mpsse_build_read_byte(cmd, adapter, msg->buf + j, j == msg->len - 1);
+        } else {
+            status |= i2c_mpsse_build_write_byte(cmd, adapter, ((msg->adr & 0x7f) << 1) | 0x00, nack_adr, NULL);
+            for(j = 0; j < msg->len; j++)
+                status |= i2c_mpsse_build_write_byte(cmd, adapter, msg->buf[j], nack_data, slots == NULL ? NULL : &slots[k++]);
+        }
+    }
+
+    // Generate stop condition.
+    status |= i2c_mpsse_build_stop(cmd, adapter);
+    if(bus != NULL)
+        status |= i2c_mpsse_build_get_bus(cmd, bus);
+
+    return status;
+}
+
+
+
+// Get the I2C frequency of the devices addressed by a transaction. If several
+// devices are addressed, the lowest frequency is used.
+static int i2c_mpsse_dev_freq(struct mpsse_adapter *adapter, struct i2c_mpsse_msg *msgs, int num)
+{
+    int i;
+    int freq, freq_min = 0;
+
+    for(i = 0; i < num; i++) {
+        freq = adapter->i2c_dev_freq[msgs[i].adr & 0x7f];
+        if(freq == 0)
+            freq = adapter->i2c_freq;
+        if(freq_min == 0 || freq < freq_min)
+            freq_min = freq;
+    }
+
+    return freq_min;
+}
+
+
+
+// Build switching to the I2C frequency of the devices addressed by a
+// transaction.
+static int i2c_mpsse_build_dev_freq(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, struct i2c_mpsse_msg *msgs, int num)
+{
+    int freq_min;
+
+    freq_min = i2c_mpsse_dev_freq(adapter, msgs, num);
+
+    // Only change the clock divisor if the frequency changes.
+    if(mpsse_adapter_get_clock(I2C_MPSSE_CLOCK(freq_min)) == adapter->mpsse->clock)
+        return 0;
+
+    return mpsse_adapter_set_clock(cmd, adapter->mpsse, I2C_MPSSE_CLOCK(freq_min));
+}
+
+
+
+// Build reading back the levels of the I2C lines.
+static int i2c_mpsse_build_get_bus(struct mpsse_cmd *cmd, unsigned char *bus)
+{
+    int status = 0;
+
+    status |= mpsse_cmd_read(cmd, bus, 1, NULL);
+    status |= mpsse_cmd_byte(cmd, GET_BITS_LOW);
+
+    return status;
+}
+
+
+
+// Check the levels of the I2C lines read back after a transaction. Returns -1
+// if SDA or SCL is held low.
+static int i2c_mpsse_check_bus(struct mpsse_adapter *adapter, unsigned char bus)
+{
+    if((bus & I2C_MPSSE_SDA(adapter)) && (bus & I2C_MPSSE_SCL)) return 0;
+
+    return -1;
+}
+
+
+
+// Build the I2C transaction of a transfer job.
+static int i2c_mpsse_build_transfer(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    struct i2c_mpsse_job *job = (struct i2c_mpsse_job *) arg;
+
+    return i2c_mpsse_build_msgs(cmd, adapter, job->msgs, job->num, &job->nack_adr, &job->nack_data, &job->bus, NULL) ? -1 : 0;
+}
+
+
+
+// Build the I2C transactions of a batch job. The NACKs of each transaction
+// are counted in its status field. The delays after the transactions are
+// clocked by the MPSSE, so the whole batch still takes one USB transfer.
+static int i2c_mpsse_build_batch(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    int i;
+    int status = 0;
+    struct i2c_mpsse_batch_job *job = (struct i2c_mpsse_batch_job *) arg;
+
+    for(i = 0; i < job->num; i++) {
+        job->xfers[i].status = 0;
+        status |= i2c_mpsse_build_msgs(cmd, adapter, job->xfers[i].msgs, job->xfers[i].num, &job->xfers[i].status, &job->xfers[i].status, &job->bus[i], NULL);
+        if(job->xfers[i].delay > 0)
+            status |= mpsse_adapter_delay(adapter, cmd, job->xfers[i].delay);
+    }
+
+    return status ? -1 : 0;
+}
+
+
+
+// Check if the command template of a prepared transaction was compiled for the
+// current state of the adapter.
+static int i2c_mpsse_prep_valid(struct mpsse_adapter *adapter, struct i2c_mpsse_prep *prep)
+{
+    if(!prep->valid) return 0;
+    if(memcmp(&prep->pins, &adapter->pins, sizeof(struct mpsse_pins))) return 0;
+    if(prep->clock != adapter->mpsse->clock) return 0;
+    if(prep->freq != i2c_mpsse_dev_freq(adapter, prep->msgs, prep->num)) return 0;
+    if(prep->adaptive != adapter->adaptive) return 0;
+    if(prep->open_drain != adapter->i2c_open_drain) return 0;
+    if(prep->strap != adapter->i2c_strap) return 0;
+
+    return 1;
+}
+
+
+
+// Build a prepared I2C transaction. The command template is compiled if
+// needed, then the data bytes to write are patched into it and the template
+// is appended to the command buffer as it is.
+static int i2c_mpsse_build_prep(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    int i, j, k;
+    struct i2c_mpsse_prep *prep = (struct i2c_mpsse_prep *) arg;
+    struct i2c_mpsse_msg *msg;
+
+    if(!i2c_mpsse_prep_valid(adapter, prep)) {
+        // Compile the template for the current state of the adapter.
+        prep->valid = 0;
+        prep->pins = adapter->pins;
+        prep->clock = adapter->mpsse->clock;
+        prep->freq = i2c_mpsse_dev_freq(adapter, prep->msgs, prep->num);
+        prep->adaptive = adapter->adaptive;
+        prep->open_drain = adapter->i2c_open_drain;
+        prep->strap = adapter->i2c_strap;
+        mpsse_cmd_reset(&prep->tmpl);
+        if(i2c_mpsse_build_msgs(&prep->tmpl, adapter, prep->msgs, prep->num, &prep->nack_adr, &prep->nack_data, &prep->bus, prep->slots)) {
+            adapter->pins = prep->pins;
+            adapter->mpsse->clock = prep->clock;
+            return -1;
+        }
+        prep->pins_end = adapter->pins;
+        prep->clock_end = adapter->mpsse->clock;
+        prep->valid = 1;
+    } else {
+        // Update the adapter state as if the template was built again.
+        adapter->pins = prep->pins_end;
+        adapter->mpsse->clock = prep->clock_end;
+    }
+
+    // Patch the data bytes to write.
+    k = 0;
+    for(i = 0; i < prep->num; i++) {
+        msg = &prep->msgs[i];
+        if(msg->flags & I2C_MPSSE_M_RD) continue;
+        for(j = 0; j < msg->len; j++)
+            prep->tmpl.buf[prep->slots[k++]] = msg->buf[j];
+    }
+
+    return mpsse_cmd_append(cmd, &prep->tmpl);
+}
+
+
+
+// Build the set up of the I2C pins and clocking.
+static int i2c_mpsse_build_init(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    int status = 0;
+
+    // The MDIO and SWD functions use the same pins.
+    if(adapter->engines & MPSSE_ADAPTER_ENGINES_SERIAL & ~MPSSE_ADAPTER_ENGINE_I2C) return -1;
+
+    // Enable three phase clock to ensure that I2C data is available on both
+    // the rising and falling clock edges.
+    status |= mpsse_cmd_byte(cmd, EN_3_PHASE);
+    adapter->three_phase = 1;
+    // Only drive SCL and SDA low on the FT232H.
+    if(adapter->mpsse->ftdi.type == TYPE_232H) {
+        adapter->i2c_open_drain = 1;
+        status |= mpsse_adapter_set_open_drain(adapter, cmd, adapter->pins.low_od | I2C_MPSSE_SCL | I2C_MPSSE_SDA_OUT, adapter->pins.high_od);
+    }
+    // Both SCL and SDA idle high.
+    status |= i2c_mpsse_build_lines(cmd, adapter, 1, 1, 1);
+    // Set the default frequency of 100 kHz, unless another I2C user of the
+    // adapter has already set the frequency.
+    if(!(adapter->engines & MPSSE_ADAPTER_ENGINE_I2C)) {
+        adapter->i2c_freq = ONE_HUNDRED_KHZ;
+        status |= mpsse_adapter_set_clock(cmd, adapter->mpsse, I2C_MPSSE_CLOCK(adapter->i2c_freq));
+    }
+    // Read back the I2C lines.
+    status |= i2c_mpsse_build_get_bus(cmd, (unsigned char *) arg);
+    if(status) return -1;
+
+    adapter->engines |= MPSSE_ADAPTER_ENGINE_I2C;
+
+    return 0;
+}
+
+
+
+// Build the setting of the I2C frequency.
+static int i2c_mpsse_build_set_freq(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    if(mpsse_adapter_set_clock(cmd, adapter->mpsse, I2C_MPSSE_CLOCK(*((int *) arg)))) return -1;
+
+    adapter->i2c_freq = *((int *) arg);
+
+    return 0;
+}
+
+
+
+// Build enabling or disabling clock stretching.
+static int i2c_mpsse_build_set_stretch(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    int status = 0;
+    int enable = *((int *) arg);
+
+    // Sampling SDA on ADBUS1 does not work with adaptive clocking.
+    if(enable && adapter->i2c_open_drain && !adapter->i2c_strap) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sClock stretching in open drain mode requires ADBUS1 and ADBUS2 tied together.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    // Only drive SCL low, so that a target can hold it low. In open drain
+    // mode, this is already the case.
+    if(enable)
+        status |= mpsse_adapter_set_open_drain(adapter, cmd, adapter->pins.low_od | I2C_MPSSE_SCL, adapter->pins.high_od);
+    else if(!adapter->i2c_open_drain)
+        status |= mpsse_adapter_set_open_drain(adapter, cmd, adapter->pins.low_od & ~I2C_MPSSE_SCL, adapter->pins.high_od);
+    // Wait for SCL being returned on RTCK for each clock edge.
+    status |= mpsse_adapter_set_adaptive(adapter, cmd, enable);
+
+    return status ? -1 : 0;
+}
+
+
+
+// Build the setting of the I2C SDA strap. No commands are needed, but the
+// setting must only be changed while holding the adapter.
+static int i2c_mpsse_build_set_strap(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    // Sampling SDA on ADBUS1 does not work with adaptive clocking.
+    if(!*((int *) arg) && adapter->i2c_open_drain && adapter->adaptive) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sClock stretching in open drain mode requires ADBUS1 and ADBUS2 tied together.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    adapter->i2c_strap = *((int *) arg) ? 1 : 0;
+
+    return 0;
+}
+
+
+
+// Build the recovery of a stuck I2C bus.
+static int i2c_mpsse_build_recover(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    int status = 0;
+    unsigned char buf[4];
+
+    // Release SDA and pull SCL low.
+    status |= i2c_mpsse_build_lines(cmd, adapter, 0, 1, 0);
+    // Clock out 9 SCL pulses without data. A clock bits command with length
+    // n clocks n + 1 pulses.
+    buf[0] = CLK_BITS;
+    buf[1] = 8 - 1;
+    buf[2] = CLK_BITS;
+    buf[3] = I2C_MPSSE_RECOVER_PULSES - 8 - 1;
+    status |= mpsse_cmd_bytes(cmd, buf, 4);
+    // Generate stop condition.
+    status |= i2c_mpsse_build_stop(cmd, adapter);
+    // Read back the I2C lines.
+    status |= i2c_mpsse_build_get_bus(cmd, (unsigned char *) arg);
+
+    return status ? -1 : 0;
+}
+
@@ -1,38 +1,103 @@
-// File: i2c_mpsse.h
-// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
-// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
-// Date: 09 Feb 2018
-// Rev.: 16 Feb 2018
-//
-// Header file for the basic hardware I2C IO functions based on FTDI's
-// Multi-Protocol Synchronous Serial Engine (MPSSE).
-//
-
-
-
-#ifndef __I2C_MPSSE_H
-#define __I2C_MPSSE_H
-
-
-
-// Message prefixes.
-#define PREFIX_DEBUG            "DEBUG: "
-#define PREFIX_ERROR            "ERROR: "
-
-
-
-// Function prototypes.
-int i2c_init(void);
-int i2c_reset(void);
-int i2c_close(void);
-int i2c_info(void);
-int i2c_get_freq(int *i2c_freq);
-int i2c_set_freq(int i2c_freq);
-int i2c_set_verbose(int verbose);
-int i2c_write(int i2c_dev_adr, char *data, int size);
-int i2c_read(int i2c_dev_adr, char *data, int size);
-
-
-
-#endif
-
+// File: i2c_mpsse.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 09 Feb 2018
+// Rev.: 19 Oct 2026
+//
+// Header file for the basic hardware I2C IO functions based on FTDI's
+// Multi-Protocol Synchronous Serial Engine (MPSSE).
+//
+
+
+
+#ifndef __I2C_MPSSE_H
+#define __I2C_MPSSE_H
+
+
+
+// Message prefixes.
+#define PREFIX_DEBUG            "DEBUG: "
+#define PREFIX_ERROR            "ERROR: "
+
+
+
+// I2C message flags.
+#define I2C_MPSSE_M_RD          0x0001      // Read data from the I2C slave.
+
+
+
+// I2C message. All messages passed to i2c_transfer() are executed as one
+// combined I2C transaction, separated by repeated start conditions.
+struct i2c_mpsse_msg {
+    int adr;                    // 7-bit I2C device address.
+    int flags;                  // I2C_MPSSE_M_* flags.
+    int len;                    // Number of data bytes.
+    char *buf;                  // Data buffer.
+};
+
+// I2C transaction, used for executing several independent transactions in
+// one USB transfer.
+struct i2c_mpsse_xfer {
+    struct i2c_mpsse_msg *msgs; // Messages of the transaction.
+    int num;                    // Number of messages.
+    int delay;                  // Delay in us after the transaction, timed by the MPSSE.
+    int status;                 // Result: 0 = OK, -1 = NACK received.
+};
+
+struct mpsse_adapter;
+
+// Prepared I2C transaction, see i2c_mpsse_prepare().
+struct i2c_mpsse_prep;
+
+
+
+// Function prototypes.
+// Functions operating on the default I2C adapter.
+int i2c_init(void);
+int i2c_reset(void);
+int i2c_close(void);
+int i2c_info(void);
+int i2c_set_stretch(int enable);
+int i2c_set_strap(int strap);
+int i2c_recover(void);
+int i2c_get_freq(int *i2c_freq);
+int i2c_set_freq(int i2c_freq);
+int i2c_set_dev_freq(int i2c_dev_adr, int i2c_freq);
+int i2c_get_dev_freq(int i2c_dev_adr, int *i2c_freq);
+int i2c_set_verbose(int verbose);
+int i2c_write(int i2c_dev_adr, char *data, int size);
+int i2c_read(int i2c_dev_adr, char *data, int size);
+int i2c_reg_write(int i2c_dev_adr, unsigned int reg_adr, int adr_width, char *data, int size);
+int i2c_reg_read(int i2c_dev_adr, unsigned int reg_adr, int adr_width, char *data, int size);
+int i2c_transfer(struct i2c_mpsse_msg *msgs, int num);
+int i2c_transfer_batch(struct i2c_mpsse_xfer *xfers, int num);
+struct i2c_mpsse_prep *i2c_prepare(struct i2c_mpsse_msg *msgs, int num);
+struct mpsse_adapter *i2c_get_adapter(void);
+// Reentrant functions operating on an explicitly opened I2C adapter. An
+// adapter may be shared by any number of threads.
+struct mpsse_adapter *i2c_mpsse_open(void);
+struct mpsse_adapter *i2c_mpsse_open_if(const char *serial, int interface);
+int i2c_mpsse_close(struct mpsse_adapter *adapter);
+int i2c_mpsse_info(struct mpsse_adapter *adapter);
+int i2c_mpsse_get_freq(struct mpsse_adapter *adapter, int *i2c_freq);
+int i2c_mpsse_set_freq(struct mpsse_adapter *adapter, int i2c_freq);
+int i2c_mpsse_set_dev_freq(struct mpsse_adapter *adapter, int i2c_dev_adr, int i2c_freq);
+int i2c_mpsse_get_dev_freq(struct mpsse_adapter *adapter, int i2c_dev_adr, int *i2c_freq);
+int i2c_mpsse_set_verbose(struct mpsse_adapter *adapter, int verbose);
+int i2c_mpsse_set_stretch(struct mpsse_adapter *adapter, int enable);
+int i2c_mpsse_set_strap(struct mpsse_adapter *adapter, int strap);
+int i2c_mpsse_recover(struct mpsse_adapter *adapter);
+int i2c_mpsse_write(struct mpsse_adapter *adapter, int i2c_dev_adr, char *data, int size);
+int i2c_mpsse_read(struct mpsse_adapter *adapter, int i2c_dev_adr, char *data, int size);
+int i2c_mpsse_reg_write(struct mpsse_adapter *adapter, int i2c_dev_adr, unsigned int reg_adr, int adr_width, char *data, int size);
+int i2c_mpsse_reg_read(struct mpsse_adapter *adapter, int i2c_dev_adr, unsigned int reg_adr, int adr_width, char *data, int size);
+int i2c_mpsse_transfer(struct mpsse_adapter *adapter, struct i2c_mpsse_msg *msgs, int num);
+int i2c_mpsse_transfer_batch(struct mpsse_adapter *adapter, struct i2c_mpsse_xfer *xfers, int num);
+struct i2c_mpsse_prep *i2c_mpsse_prepare(struct mpsse_adapter *adapter, struct i2c_mpsse_msg *msgs, int num);
+int i2c_mpsse_prep_execute(struct i2c_mpsse_prep *prep);
+void i2c_mpsse_prep_free(struct i2c_mpsse_prep *prep);
+
+
+
+#endif
+
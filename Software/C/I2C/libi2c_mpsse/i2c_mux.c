@@ -0,0 +1,654 @@
+// File: i2c_mux.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// I2C multiplexer (PCA9548/TCA9548 and compatible) topology layer on top of
+// the hardware I2C IO functions.
+//
+// Devices are addressed by the multiplexer and channel they are connected to
+// and their I2C address. Multiplexers may be nested, i.e. connected to a
+// channel of another multiplexer. The currently selected channels of all
+// multiplexers are cached, so that channel select writes are only sent when
+// the selection actually changes. Other multiplexers on the same branch of
+// the bus are disabled before a channel is selected, so that identical
+// devices behind different multiplexers do not collide.
+//
+// Identical devices behind several channels of a PCA9548 can be written at
+// once with i2c_mux_broadcast(), which enables all their channels together.
+//
+// CAUTION: The cache is only correct, as long as all accesses to the
+// multiplexers go through this layer. Call i2c_mux_invalidate() after
+// accessing them in any other way.
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "mpsse_adapter.h"
+#include "i2c_mpsse.h"
+#include "i2c_mux.h"
+
+
+
+// Plan of the I2C transactions of a batch.
+struct i2c_mux_plan {
+    struct i2c_mpsse_xfer *xfers;   // All I2C transactions of the batch.
+    int xfer_count;
+    int *xfer_mux;                  // Multiplexer written by a select transaction, -1 for an operation.
+    struct i2c_mpsse_msg *sel_msgs; // Messages of the select transactions.
+    char *sel_data;                 // Control register values of the select transactions.
+    int sel_count;
+    int sel_xfer[I2C_MUX_MAX];      // Last select transaction of each multiplexer, -1 if none.
+    int *op_xfer;                   // Transaction of each operation.
+    int *op_dep;                    // Select transactions each operation depends on.
+    int *dep_mux;                   // Multiplexers the current operation relies on, NULL if not tracked.
+    int dep_count;
+};
+
+// Sort key of an operation of a batch.
+struct i2c_mux_key {
+    int index;                      // Index of the operation.
+    int class;                      // 0 = root I2C bus, 1 = selected channel, 2 = others.
+    int depth;
+    int path_mux[I2C_MUX_DEPTH_MAX];
+    int path_channel[I2C_MUX_DEPTH_MAX];
+};
+
+
+
+// Function prototypes.
+static int i2c_mux_path(struct i2c_mux_topo *topo, int mux, int channel, int *path_mux, int *path_channel);
+static int i2c_mux_value(struct i2c_mux *mux, int channel);
+static int i2c_mux_is_selected(struct i2c_mux_topo *topo, struct i2c_mux_op *op);
+static int i2c_mux_compare(const void *a, const void *b);
+static int i2c_mux_sort(struct i2c_mux_topo *topo, struct i2c_mux_op *ops, int num, int *order);
+static void i2c_mux_plan_select(struct i2c_mux_topo *topo, struct i2c_mux_plan *plan, int mux, int value);
+static void i2c_mux_plan_branch(struct i2c_mux_topo *topo, struct i2c_mux_plan *plan, int parent, int parent_channel, int keep);
+
+
+
+// Initialize an I2C multiplexer topology.
+int i2c_mux_init(struct i2c_mux_topo *topo, struct mpsse_adapter *adapter)
+{
+    if(topo == NULL) return -1;
+
+    memset(topo, 0, sizeof(struct i2c_mux_topo));
+    topo->adapter = adapter;
+    pthread_mutex_init(&topo->lock, NULL);
+
+    return 0;
+}
+
+
+
+// Free an I2C multiplexer topology.
+int i2c_mux_free(struct i2c_mux_topo *topo)
+{
+    if(topo == NULL) return -1;
+
+    pthread_mutex_destroy(&topo->lock);
+    topo->mux_count = 0;
+
+    return 0;
+}
+
+
+
+// Add an I2C multiplexer to the topology. The multiplexer is connected either
+// to the root I2C bus (parent = I2C_MUX_ROOT) or to a channel of another
+// multiplexer. Returns the index of the new multiplexer or -1 on error.
+int i2c_mux_add(struct i2c_mux_topo *topo, int adr, int type, int parent, int parent_channel)
+{
+    int index;
+    int depth = 0;
+    int path_mux[I2C_MUX_DEPTH_MAX], path_channel[I2C_MUX_DEPTH_MAX];
+
+    if(topo == NULL) return -1;
+
+    pthread_mutex_lock(&topo->lock);
+
+    // Check the parameters.
+    if(parent != I2C_MUX_ROOT)
+        depth = i2c_mux_path(topo, parent, parent_channel, path_mux, path_channel);
+    if(topo->mux_count >= I2C_MUX_MAX || depth < 0 || depth >= I2C_MUX_DEPTH_MAX ||
+       (type != I2C_MUX_TYPE_PCA9548 && type != I2C_MUX_TYPE_PCA9547)) {
+        fprintf(stderr, "%s: %s: %sCannot add the I2C multiplexer at address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, adr);
+        pthread_mutex_unlock(&topo->lock);
+        return -1;
+    }
+
+    index = topo->mux_count++;
+    topo->mux[index].adr = adr & 0x7f;
+    topo->mux[index].type = type;
+    topo->mux[index].parent = parent;
+    topo->mux[index].parent_channel = (parent == I2C_MUX_ROOT) ? 0 : parent_channel;
+    topo->mux[index].selected = I2C_MUX_UNKNOWN;
+
+    pthread_mutex_unlock(&topo->lock);
+
+    return index;
+}
+
+
+
+// Forget the cached channel selections of all multiplexers.
+int i2c_mux_invalidate(struct i2c_mux_topo *topo)
+{
+    int i;
+
+    if(topo == NULL) return -1;
+
+    pthread_mutex_lock(&topo->lock);
+    for(i = 0; i < topo->mux_count; i++)
+        topo->mux[i].selected = I2C_MUX_UNKNOWN;
+    pthread_mutex_unlock(&topo->lock);
+
+    return 0;
+}
+
+
+
+// Execute an I2C transaction on a device behind a multiplexer channel.
+int i2c_mux_transfer(struct i2c_mux_topo *topo, int mux, int channel, struct i2c_mpsse_msg *msgs, int num)
+{
+    struct i2c_mux_op op;
+
+    op.mux = mux;
+    op.channel = channel;
+    op.msgs = msgs;
+    op.num = num;
+
+    return i2c_mux_batch(topo, &op, 1);
+}
+
+
+
+// Write data to a device behind a multiplexer channel.
+int i2c_mux_write(struct i2c_mux_topo *topo, int mux, int channel, int i2c_dev_adr, char *data, int size)
+{
+    struct i2c_mpsse_msg msg;
+
+    msg.adr = i2c_dev_adr;
+    msg.flags = 0;
+    msg.len = size;
+    msg.buf = data;
+
+    return i2c_mux_transfer(topo, mux, channel, &msg, 1);
+}
+
+
+
+// Read data from a device behind a multiplexer channel.
+int i2c_mux_read(struct i2c_mux_topo *topo, int mux, int channel, int i2c_dev_adr, char *data, int size)
+{
+    struct i2c_mpsse_msg msg;
+
+    msg.adr = i2c_dev_adr;
+    msg.flags = I2C_MPSSE_M_RD;
+    msg.len = size;
+    msg.buf = data;
+
+    return i2c_mux_transfer(topo, mux, channel, &msg, 1);
+}
+
+
+
+// Execute a batch of operations on devices behind multiplexer channels in one
+// USB transfer.
+// The operations are reordered to minimize the number of channel switches:
+// operations on the root I2C bus come first, then the ones on the currently
+// selected channels, then all others grouped by their multiplexer path.
+// Operations on the same multiplexer channel keep their order.
+// The result of each operation is stored in its status field. Returns 0 if
+// all operations succeeded.
+int i2c_mux_batch(struct i2c_mux_topo *topo, struct i2c_mux_op *ops, int num)
+{
+    int i, j, k;
+    int depth;
+    int status = 0;
+    int path_mux[I2C_MUX_DEPTH_MAX], path_channel[I2C_MUX_DEPTH_MAX];
+    int *order = NULL;
+    int dep_max;
+    int dep_mux[I2C_MUX_MAX];
+    struct i2c_mux_plan plan;
+
+    if(topo == NULL || ops == NULL || num <= 0) return -1;
+
+    pthread_mutex_lock(&topo->lock);
+
+    // Each operation needs at most one write to every multiplexer and depends
+    // on at most all multiplexers.
+    memset(&plan, 0, sizeof(struct i2c_mux_plan));
+    dep_max = topo->mux_count + 1;
+    k = num * dep_max;
+    order = malloc(num * sizeof(int));
+    plan.xfers = malloc(k * sizeof(struct i2c_mpsse_xfer));
+    plan.xfer_mux = malloc(k * sizeof(int));
+    plan.sel_msgs = malloc(k * sizeof(struct i2c_mpsse_msg));
+    plan.sel_data = malloc(k);
+    plan.op_xfer = malloc(num * sizeof(int));
+    plan.op_dep = malloc(k * sizeof(int));
+    if(order == NULL || plan.xfers == NULL || plan.xfer_mux == NULL || plan.sel_msgs == NULL ||
+       plan.sel_data == NULL || plan.op_xfer == NULL || plan.op_dep == NULL) {
+        fprintf(stderr, "%s: %s: %sCannot allocate memory for the I2C multiplexer batch.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        status = -1;
+        goto out;
+    }
+    for(i = 0; i < I2C_MUX_MAX; i++)
+        plan.sel_xfer[i] = -1;
+
+    // Sort the operations.
+    if(i2c_mux_sort(topo, ops, num, order)) {
+        status = -1;
+        goto out;
+    }
+
+    // Plan the channel select writes and the I2C transactions.
+    for(i = 0; i < num; i++) {
+        struct i2c_mux_op *op = &ops[order[i]];
+        plan.op_xfer[order[i]] = -1;
+        for(j = 0; j < dep_max; j++)
+            plan.op_dep[order[i] * dep_max + j] = -1;
+        depth = i2c_mux_path(topo, op->mux, op->channel, path_mux, path_channel);
+        if(depth < 0 || op->msgs == NULL || op->num <= 0) {
+            fprintf(stderr, "%s: %s: %sInvalid I2C multiplexer %d, channel %d.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, op->mux, op->channel);
+            continue;
+        }
+        // Walk down the multiplexer path. At each level, disable the other
+        // multiplexers and select the channel. Keep track of all multiplexers
+        // visited, including the ones already in the right state.
+        plan.dep_mux = dep_mux;
+        plan.dep_count = 0;
+        for(j = 0; j < depth; j++) {
+            if(j == 0)
+                i2c_mux_plan_branch(topo, &plan, I2C_MUX_ROOT, 0, path_mux[j]);
+            else
+                i2c_mux_plan_branch(topo, &plan, path_mux[j-1], path_channel[j-1], path_mux[j]);
+            i2c_mux_plan_select(topo, &plan, path_mux[j], i2c_mux_value(&topo->mux[path_mux[j]], path_channel[j]));
+        }
+        // Disable multiplexers connected to the selected channel.
+        if(depth > 0)
+            i2c_mux_plan_branch(topo, &plan, path_mux[depth-1], path_channel[depth-1], -1);
+        // Remember the select writes this operation depends on, i.e. the last
+        // write to each multiplexer on the path and to each one disabled on
+        // the way. If one of them fails, the operation might have reached a
+        // device behind the wrong multiplexer.
+        plan.dep_mux = NULL;
+        for(j = 0; j < plan.dep_count; j++)
+            plan.op_dep[order[i] * dep_max + j] = plan.sel_xfer[dep_mux[j]];
+        // Add the I2C transaction of the operation.
+        plan.op_xfer[order[i]] = plan.xfer_count;
+        plan.xfers[plan.xfer_count].msgs = op->msgs;
+        plan.xfers[plan.xfer_count].num = op->num;
+        plan.xfers[plan.xfer_count].delay = 0;
+        plan.xfer_mux[plan.xfer_count] = -1;
+        plan.xfer_count++;
+    }
+
+    // Execute all I2C transactions.
+    if(plan.xfer_count > 0)
+        i2c_mpsse_transfer_batch(topo->adapter, plan.xfers, plan.xfer_count);
+
+    // Invalidate the cache of multiplexers whose select write failed.
+    for(i = 0; i < plan.xfer_count; i++)
+        if(plan.xfer_mux[i] >= 0 && plan.xfers[i].status)
+            topo->mux[plan.xfer_mux[i]].selected = I2C_MUX_UNKNOWN;
+
+    // Collect the results of the operations.
+    for(i = 0; i < num; i++) {
+        if(plan.op_xfer[i] < 0) {
+            ops[i].status = -1;
+        } else {
+            ops[i].status = plan.xfers[plan.op_xfer[i]].status;
+            for(j = 0; j < dep_max; j++) {
+                k = plan.op_dep[i * dep_max + j];
+                if(k >= 0 && plan.xfers[k].status)
+                    ops[i].status = -1;
+            }
+        }
+        if(ops[i].status)
+            status = -1;
+    }
+
+out:
+    pthread_mutex_unlock(&topo->lock);
+    free(order);
+    free(plan.xfers);
+    free(plan.xfer_mux);
+    free(plan.sel_msgs);
+    free(plan.sel_data);
+    free(plan.op_xfer);
+    free(plan.op_dep);
+
+    return status;
+}
+
+
+
+// Execute write transactions on identical devices behind several channels of
+// a multiplexer at once, e.g. for loading the same register map into all of
+// them. The channels selected by the mask are enabled together, so that each
+// write reaches all devices with a single transfer on the bus. The select
+// writes and all transactions are executed in one USB transfer.
+// Only multiplexers with a channel mask (I2C_MUX_TYPE_PCA9548) can enable
+// several channels. Reads are rejected, as all devices would drive SDA at the
+// same time. Read and verify the devices per channel with i2c_mux_batch().
+// CAUTION: The ACKs of all devices are combined on the bus, so a missing
+// device is not detected. Check the devices with i2c_mux_probe() first.
+// The result of each transaction is stored in its status field. Returns 0 if
+// all transactions succeeded.
+int i2c_mux_broadcast(struct i2c_mux_topo *topo, int mux, int channels, struct i2c_mpsse_xfer *xfers, int num)
+{
+    int i, j;
+    int depth;
+    int channel;
+    int status = 0;
+    int path_mux[I2C_MUX_DEPTH_MAX], path_channel[I2C_MUX_DEPTH_MAX];
+    struct i2c_mux_plan plan;
+
+    if(topo == NULL || xfers == NULL || num <= 0) return -1;
+
+    pthread_mutex_lock(&topo->lock);
+
+    // Check the parameters.
+    for(channel = 0; channel < 8 && !((channels >> channel) & 0x1); channel++);
+    depth = i2c_mux_path(topo, mux, channel, path_mux, path_channel);
+    if(depth <= 0 || topo->mux[mux].type != I2C_MUX_TYPE_PCA9548 || channels <= 0 || channels > 0xff) {
+        fprintf(stderr, "%s: %s: %sInvalid I2C multiplexer %d or channel mask 0x%02x for a broadcast.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, mux, channels);
+        pthread_mutex_unlock(&topo->lock);
+        return -1;
+    }
+    for(i = 0; i < num; i++) {
+        for(j = 0; j < xfers[i].num; j++) {
+            if(xfers[i].msgs[j].flags & I2C_MPSSE_M_RD) {
+                fprintf(stderr, "%s: %s: %sCannot broadcast the read of I2C transaction %d.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, i);
+                pthread_mutex_unlock(&topo->lock);
+                return -1;
+            }
+        }
+    }
+
+    // Each multiplexer is written at most once.
+    memset(&plan, 0, sizeof(struct i2c_mux_plan));
+    plan.xfers = malloc((topo->mux_count + num) * sizeof(struct i2c_mpsse_xfer));
+    plan.xfer_mux = malloc((topo->mux_count + num) * sizeof(int));
+    plan.sel_msgs = malloc(topo->mux_count * sizeof(struct i2c_mpsse_msg));
+    plan.sel_data = malloc(topo->mux_count);
+    if(plan.xfers == NULL || plan.xfer_mux == NULL || plan.sel_msgs == NULL || plan.sel_data == NULL) {
+        fprintf(stderr, "%s: %s: %sCannot allocate memory for the I2C multiplexer broadcast.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        status = -1;
+        goto out;
+    }
+    for(i = 0; i < I2C_MUX_MAX; i++)
+        plan.sel_xfer[i] = -1;
+
+    // Walk down the multiplexer path like for a single channel, but enable all
+    // channels of the mask at the last level.
+    for(j = 0; j < depth; j++) {
+        if(j == 0)
+            i2c_mux_plan_branch(topo, &plan, I2C_MUX_ROOT, 0, path_mux[j]);
+        else
+            i2c_mux_plan_branch(topo, &plan, path_mux[j-1], path_channel[j-1], path_mux[j]);
+        if(j < depth - 1)
+            i2c_mux_plan_select(topo, &plan, path_mux[j], i2c_mux_value(&topo->mux[path_mux[j]], path_channel[j]));
+        else
+            i2c_mux_plan_select(topo, &plan, mux, channels);
+    }
+    // Disable multiplexers connected to the selected channels.
+    for(channel = 0; channel < 8; channel++)
+        if((channels >> channel) & 0x1)
+            i2c_mux_plan_branch(topo, &plan, mux, channel, -1);
+
+    // Add the transactions and execute them.
+    for(i = 0; i < num; i++) {
+        plan.xfers[plan.xfer_count] = xfers[i];
+        plan.xfer_mux[plan.xfer_count] = -1;
+        plan.xfer_count++;
+    }
+    i2c_mpsse_transfer_batch(topo->adapter, plan.xfers, plan.xfer_count);
+
+    // Invalidate the cache of multiplexers whose select write failed. All
+    // transactions depend on all select writes.
+    for(i = 0, j = 0; i < plan.xfer_count - num; i++) {
+        if(plan.xfers[i].status) {
+            topo->mux[plan.xfer_mux[i]].selected = I2C_MUX_UNKNOWN;
+            j = -1;
+        }
+    }
+    for(i = 0; i < num; i++) {
+        xfers[i].status = j ? -1 : plan.xfers[plan.xfer_count - num + i].status;
+        if(xfers[i].status)
+            status = -1;
+    }
+
+out:
+    pthread_mutex_unlock(&topo->lock);
+    free(plan.xfers);
+    free(plan.xfer_mux);
+    free(plan.sel_msgs);
+    free(plan.sel_data);
+
+    return status;
+}
+
+
+
+// Write the same data to identical devices behind several channels of a
+// multiplexer at once, see i2c_mux_broadcast().
+int i2c_mux_broadcast_write(struct i2c_mux_topo *topo, int mux, int channels, int i2c_dev_adr, char *data, int size)
+{
+    struct i2c_mpsse_msg msg;
+    struct i2c_mpsse_xfer xfer;
+
+    msg.adr = i2c_dev_adr;
+    msg.flags = 0;
+    msg.len = size;
+    msg.buf = data;
+    xfer.msgs = &msg;
+    xfer.num = 1;
+    xfer.delay = 0;
+
+    return i2c_mux_broadcast(topo, mux, channels, &xfer, 1);
+}
+
+
+
+// Check on which channels of a multiplexer a device answers. The device is
+// addressed on each channel of the mask separately, all in one USB transfer.
+// Returns the mask of the channels with an answering device or -1 on error.
+int i2c_mux_probe(struct i2c_mux_topo *topo, int mux, int channels, int i2c_dev_adr)
+{
+    int i, n = 0;
+    int found = 0;
+    struct i2c_mpsse_msg msgs[8];
+    struct i2c_mux_op ops[8];
+
+    for(i = 0; i < 8; i++) {
+        if(!((channels >> i) & 0x1)) continue;
+        msgs[n].adr = i2c_dev_adr;
+        msgs[n].flags = 0;
+        msgs[n].len = 0;
+        msgs[n].buf = NULL;
+        ops[n].mux = mux;
+        ops[n].channel = i;
+        ops[n].msgs = &msgs[n];
+        ops[n].num = 1;
+        n++;
+    }
+    if(topo == NULL || topo->adapter == NULL || n == 0) return -1;
+
+    // Missing devices are expected. A batch only reports them in the status
+    // of the operations, so nothing is printed for them. The verbosity of the
+    // adapter must not be changed here, as it is shared by all threads.
+    i2c_mux_batch(topo, ops, n);
+    for(i = 0; i < n; i++)
+        if(!ops[i].status)
+            found |= 1 << ops[i].channel;
+
+    return found;
+}
+
+
+
+// Get the path of multiplexers from the root I2C bus to a channel. Returns
+// the depth of the path or -1 on error.
+static int i2c_mux_path(struct i2c_mux_topo *topo, int mux, int channel, int *path_mux, int *path_channel)
+{
+    int i;
+    int depth = 0;
+    int hop_mux[I2C_MUX_DEPTH_MAX], hop_channel[I2C_MUX_DEPTH_MAX];
+
+    // Walk up to the root I2C bus.
+    while(mux != I2C_MUX_ROOT) {
+        if(mux < 0 || mux >= topo->mux_count || channel < 0 || channel > 7 || depth >= I2C_MUX_DEPTH_MAX)
+            return -1;
+        hop_mux[depth] = mux;
+        hop_channel[depth] = channel;
+        depth++;
+        channel = topo->mux[mux].parent_channel;
+        mux = topo->mux[mux].parent;
+    }
+
+    // Reverse the path, so that it starts at the root I2C bus.
+    for(i = 0; i < depth; i++) {
+        path_mux[i] = hop_mux[depth-1-i];
+        path_channel[i] = hop_channel[depth-1-i];
+    }
+
+    return depth;
+}
+
+
+
+// Get the control register value selecting a channel of a multiplexer.
+static int i2c_mux_value(struct i2c_mux *mux, int channel)
+{
+    if(mux->type == I2C_MUX_TYPE_PCA9547)
+        return 0x08 | (channel & 0x07);
+    else
+        return 1 << (channel & 0x07);
+}
+
+
+
+// Check if the channel of an operation is currently selected.
+static int i2c_mux_is_selected(struct i2c_mux_topo *topo, struct i2c_mux_op *op)
+{
+    int i;
+    int depth;
+    int path_mux[I2C_MUX_DEPTH_MAX], path_channel[I2C_MUX_DEPTH_MAX];
+
+    depth = i2c_mux_path(topo, op->mux, op->channel, path_mux, path_channel);
+    if(depth < 0) return 0;
+    for(i = 0; i < depth; i++)
+        if(topo->mux[path_mux[i]].selected != i2c_mux_value(&topo->mux[path_mux[i]], path_channel[i]))
+            return 0;
+
+    return 1;
+}
+
+
+
+// Compare the sort keys of two operations.
+static int i2c_mux_compare(const void *a, const void *b)
+{
+    int i;
+    const struct i2c_mux_key *key_a = a;
+    const struct i2c_mux_key *key_b = b;
+
+    // Operations on the root I2C bus first, then the ones on the currently
+    // selected channels.
+    if(key_a->class != key_b->class) return key_a->class - key_b->class;
+
+    // Group the others by their path, so that operations sharing upstream
+    // multiplexer channels are adjacent.
+    if(key_a->class == 2) {
+        for(i = 0; i < key_a->depth && i < key_b->depth; i++) {
+            if(key_a->path_mux[i] != key_b->path_mux[i]) return key_a->path_mux[i] - key_b->path_mux[i];
+            if(key_a->path_channel[i] != key_b->path_channel[i]) return key_a->path_channel[i] - key_b->path_channel[i];
+        }
+        if(key_a->depth != key_b->depth) return key_a->depth - key_b->depth;
+    }
+
+    // Keep the order of operations on the same channel.
+    return key_a->index - key_b->index;
+}
+
+
+
+// Sort the operations of a batch. The sort keys are computed once for each
+// operation, the order of equal operations is kept by using their index as
+// the last key.
+static int i2c_mux_sort(struct i2c_mux_topo *topo, struct i2c_mux_op *ops, int num, int *order)
+{
+    int i;
+    struct i2c_mux_key *keys;
+
+    keys = malloc(num * sizeof(struct i2c_mux_key));
+    if(keys == NULL) {
+        fprintf(stderr, "%s: %s: %sCannot allocate memory for sorting the I2C multiplexer batch.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    for(i = 0; i < num; i++) {
+        keys[i].index = i;
+        keys[i].depth = i2c_mux_path(topo, ops[i].mux, ops[i].channel, keys[i].path_mux, keys[i].path_channel);
+        keys[i].class = (ops[i].mux == I2C_MUX_ROOT) ? 0 : (i2c_mux_is_selected(topo, &ops[i]) ? 1 : 2);
+    }
+    qsort(keys, num, sizeof(struct i2c_mux_key), i2c_mux_compare);
+    for(i = 0; i < num; i++)
+        order[i] = keys[i].index;
+    free(keys);
+
+    return 0;
+}
+
+
+
+// Plan writing a control register value to a multiplexer, if it differs from
+// the cached value.
+static void i2c_mux_plan_select(struct i2c_mux_topo *topo, struct i2c_mux_plan *plan, int mux, int value)
+{
+    struct i2c_mpsse_msg *msg;
+
+    if(plan->dep_mux != NULL)
+        plan->dep_mux[plan->dep_count++] = mux;
+    if(topo->mux[mux].selected == value) return;
+
+    plan->sel_data[plan->sel_count] = (char) value;
+    msg = &plan->sel_msgs[plan->sel_count];
+    msg->adr = topo->mux[mux].adr;
+    msg->flags = 0;
+    msg->len = 1;
+    msg->buf = &plan->sel_data[plan->sel_count];
+    plan->sel_count++;
+
+    plan->xfers[plan->xfer_count].msgs = msg;
+    plan->xfers[plan->xfer_count].num = 1;
+    plan->xfers[plan->xfer_count].delay = 0;
+    plan->xfer_mux[plan->xfer_count] = mux;
+    plan->sel_xfer[mux] = plan->xfer_count;
+    plan->xfer_count++;
+
+    topo->mux[mux].selected = value;
+}
+
+
+
+// Plan disabling all multiplexers connected to a channel of a parent
+// multiplexer (or to the root I2C bus), except the one to keep.
+static void i2c_mux_plan_branch(struct i2c_mux_topo *topo, struct i2c_mux_plan *plan, int parent, int parent_channel, int keep)
+{
+    int i;
+
+    for(i = 0; i < topo->mux_count; i++) {
+        if(i == keep || topo->mux[i].parent != parent) continue;
+        if(parent != I2C_MUX_ROOT && topo->mux[i].parent_channel != parent_channel) continue;
+        i2c_mux_plan_select(topo, plan, i, 0);
+    }
+}
+
@@ -0,0 +1,85 @@
+// File: i2c_mux.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for the I2C multiplexer (PCA9548/TCA9548 and compatible)
+// topology layer on top of the hardware I2C IO functions.
+//
+
+
+
+#ifndef __I2C_MUX_H
+#define __I2C_MUX_H
+
+
+
+#include <pthread.h>
+#include "i2c_mpsse.h"
+
+
+
+// Maximum number of I2C multiplexers in a topology.
+#define I2C_MUX_MAX             32
+
+// Maximum nesting depth of I2C multiplexers.
+#define I2C_MUX_DEPTH_MAX       4
+
+// Index of the root I2C bus, i.e. no multiplexer.
+#define I2C_MUX_ROOT            -1
+
+// Cached control register value if the channel selection is unknown.
+#define I2C_MUX_UNKNOWN         -1
+
+// I2C multiplexer types.
+#define I2C_MUX_TYPE_PCA9548    0           // Channel mask (PCA9548, TCA9548, PCA9546, PCA9545).
+#define I2C_MUX_TYPE_PCA9547    1           // Channel number with enable bit (PCA9547, PCA9544).
+
+
+
+// I2C multiplexer.
+struct i2c_mux {
+    int adr;                    // 7-bit I2C address of the multiplexer.
+    int type;                   // I2C_MUX_TYPE_* type.
+    int parent;                 // Index of the upstream multiplexer or I2C_MUX_ROOT.
+    int parent_channel;         // Channel of the upstream multiplexer.
+    int selected;               // Cached control register value or I2C_MUX_UNKNOWN.
+};
+
+// I2C multiplexer topology of one I2C adapter.
+struct i2c_mux_topo {
+    struct mpsse_adapter *adapter;
+    struct i2c_mux mux[I2C_MUX_MAX];
+    int mux_count;
+    pthread_mutex_t lock;
+};
+
+// Operation on a device behind an I2C multiplexer, used for batches.
+struct i2c_mux_op {
+    int mux;                    // Index of the multiplexer or I2C_MUX_ROOT.
+    int channel;                // Channel of the multiplexer.
+    struct i2c_mpsse_msg *msgs; // Messages of the I2C transaction.
+    int num;                    // Number of messages.
+    int status;                 // Result: 0 = OK, -1 = failed.
+};
+
+
+
+// Function prototypes.
+int i2c_mux_init(struct i2c_mux_topo *topo, struct mpsse_adapter *adapter);
+int i2c_mux_free(struct i2c_mux_topo *topo);
+int i2c_mux_add(struct i2c_mux_topo *topo, int adr, int type, int parent, int parent_channel);
+int i2c_mux_invalidate(struct i2c_mux_topo *topo);
+int i2c_mux_transfer(struct i2c_mux_topo *topo, int mux, int channel, struct i2c_mpsse_msg *msgs, int num);
+int i2c_mux_write(struct i2c_mux_topo *topo, int mux, int channel, int i2c_dev_adr, char *data, int size);
+int i2c_mux_read(struct i2c_mux_topo *topo, int mux, int channel, int i2c_dev_adr, char *data, int size);
+int i2c_mux_batch(struct i2c_mux_topo *topo, struct i2c_mux_op *ops, int num);
+int i2c_mux_broadcast(struct i2c_mux_topo *topo, int mux, int channels, struct i2c_mpsse_xfer *xfers, int num);
+int i2c_mux_broadcast_write(struct i2c_mux_topo *topo, int mux, int channels, int i2c_dev_adr, char *data, int size);
+int i2c_mux_probe(struct i2c_mux_topo *topo, int mux, int channels, int i2c_dev_adr);
+
+
+
+#endif
+
@@ -0,0 +1,501 @@
+// File: i2c_regmap.hpp
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header-only C++ register access layer on top of the hardware I2C IO
+// functions.
+//
+// The registers and fields of a device are described at compile time:
+//
+//   struct si5338 {
+//       static constexpr i2c_regmap::reg  DEV_CONFIG2 {2, 1, i2c_regmap::access::ro};
+//       static constexpr i2c_regmap::field REVID {DEV_CONFIG2, 0, 3};
+//       static constexpr i2c_regmap::reg  MISC_CTRL {230};
+//       static constexpr i2c_regmap::field OEB_ALL {MISC_CTRL, 4};
+//       static constexpr i2c_regmap::reg  STATUS {218, 1, i2c_regmap::access::ro, true};
+//   };
+//
+// Register values of non-volatile registers are cached, so that a field
+// update of a cached register takes only one write. Field updates collected
+// in an update are merged per register and executed with at most one batch
+// of reads and one batch of writes, each in a single USB transfer:
+//
+//   i2c_regmap::device dev(i2c_get_adapter(), 0x70);
+//   dev.begin().set<si5338::OEB_ALL>(1).set(other_field, 3).commit();
+//
+// Writes to read-only registers are rejected at compile time when using the
+// template versions of the functions, e.g. dev.write<si5338::REVID>(0).
+//
+
+
+
+#ifndef __I2C_REGMAP_HPP
+#define __I2C_REGMAP_HPP
+
+
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <vector>
+extern "C" {
+#include "i2c_mpsse.h"
+}
+
+
+
+namespace i2c_regmap {
+
+
+
+// Register access types.
+enum class access {
+    rw,                         // Read and write.
+    ro,                         // Read only.
+    wo                          // Write only, the cached or reset value is used for merging.
+};
+
+
+
+// Register description.
+struct reg {
+    unsigned int adr;           // Register address.
+    int width;                  // Register width in bytes (1..4).
+    access acc;                 // Access type.
+    bool vol;                   // Volatile, i.e. changed by the device. Never cached.
+    uint32_t reset;             // Reset value, used for write only registers.
+
+    constexpr reg(unsigned int adr, int width = 1, access acc = access::rw, bool vol = false, uint32_t reset = 0) :
+        adr(adr), width(width), acc(acc), vol(vol), reset(reset) {}
+
+    constexpr uint32_t mask() const
+    {
+        return (width >= 4) ? 0xffffffffu : ((1u << (8 * width)) - 1);
+    }
+};
+
+
+
+// Field description.
+struct field {
+    reg r;                      // Register containing the field.
+    int lsb;                    // Least significant bit of the field.
+    int bits;                   // Number of bits.
+
+    constexpr field(const reg &r, int lsb, int bits = 1) :
+        r(r), lsb(lsb), bits(bits) {}
+
+    constexpr uint32_t mask() const
+    {
+        return ((bits >= 32) ? 0xffffffffu : ((1u << bits) - 1)) << lsb;
+    }
+
+    constexpr uint32_t encode(uint32_t value) const
+    {
+        return (value << lsb) & mask();
+    }
+
+    constexpr uint32_t decode(uint32_t value) const
+    {
+        return (value & mask()) >> lsb;
+    }
+};
+
+
+
+class update;
+
+
+
+// I2C device with register access.
+class device {
+public:
+    // adr_width: width of the register address in bytes.
+    // big_endian: byte order of registers wider than one byte.
+    // auto_increment: the device increments the register address after each
+    // byte, so that consecutive registers can be accessed in one transaction.
+    device(struct mpsse_adapter *adapter, int adr, int adr_width = 1, bool big_endian = true, bool auto_increment = false) :
+        adapter(adapter), adr(adr & 0x7f), adr_width(adr_width), big_endian(big_endian), auto_increment(auto_increment) {}
+
+    // Read a register. Cached values of non-volatile registers are used.
+    int read(const reg &r, uint32_t &value)
+    {
+        std::vector<const reg *> regs(1, &r);
+        std::vector<uint32_t> values(1);
+
+        if(r.acc == access::wo) {
+            fprintf(stderr, "%s: %s: %sThe register 0x%02x is write only.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, r.adr);
+            return -1;
+        }
+        if(cached(r, value)) return 0;
+        if(read_regs(regs, values)) return -1;
+        value = values[0];
+
+        return 0;
+    }
+
+    // Read a field.
+    int read(const field &f, uint32_t &value)
+    {
+        uint32_t reg_value;
+
+        if(read(f.r, reg_value)) return -1;
+        value = f.decode(reg_value);
+
+        return 0;
+    }
+
+    // Write a register.
+    int write(const reg &r, uint32_t value)
+    {
+        std::vector<const reg *> regs(1, &r);
+        std::vector<uint32_t> values(1, value & r.mask());
+
+        if(r.acc == access::ro) {
+            fprintf(stderr, "%s: %s: %sThe register 0x%02x is read only.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, r.adr);
+            return -1;
+        }
+
+        return write_regs(regs, values);
+    }
+
+    // Write a field, keeping the other fields of the register.
+    int write(const field &f, uint32_t value);
+
+    // Versions checking the access type at compile time.
+    template<const reg &R> int write(uint32_t value)
+    {
+        static_assert(R.acc != access::ro, "Write to a read only register.");
+        return write(R, value);
+    }
+
+    template<const field &F> int write(uint32_t value)
+    {
+        static_assert(F.r.acc != access::ro, "Write to a read only register.");
+        return write(F, value);
+    }
+
+    template<const reg &R> int read(uint32_t &value)
+    {
+        static_assert(R.acc != access::wo, "Read from a write only register.");
+        return read(R, value);
+    }
+
+    template<const field &F> int read(uint32_t &value)
+    {
+        static_assert(F.r.acc != access::wo, "Read from a write only register.");
+        return read(F, value);
+    }
+
+    // Start collecting field updates, which are merged per register.
+    update begin();
+
+    // Forget all cached register values.
+    void invalidate()
+    {
+        cache.clear();
+    }
+
+private:
+    friend class update;
+
+    struct mpsse_adapter *adapter;
+    int adr;
+    int adr_width;
+    bool big_endian;
+    bool auto_increment;
+    std::map<unsigned int, uint32_t> cache;
+
+    // Get the cached value of a register.
+    bool cached(const reg &r, uint32_t &value) const
+    {
+        std::map<unsigned int, uint32_t>::const_iterator it;
+
+        if(r.vol) return false;
+        it = cache.find(r.adr);
+        if(it == cache.end()) return false;
+        value = it->second;
+
+        return true;
+    }
+
+    // Update the cached value of a register.
+    void store(const reg &r, uint32_t value)
+    {
+        if(!r.vol)
+            cache[r.adr] = value;
+    }
+
+    // Convert a register address to bytes, most significant byte first.
+    void put_adr(std::vector<char> &buf, unsigned int reg_adr) const
+    {
+        for(int i = adr_width - 1; i >= 0; i--)
+            buf.push_back((char) ((reg_adr >> (8 * i)) & 0xff));
+    }
+
+    // Convert a register value to bytes.
+    void put_value(std::vector<char> &buf, const reg &r, uint32_t value) const
+    {
+        for(int i = 0; i < r.width; i++)
+            buf.push_back((char) ((value >> (8 * (big_endian ? r.width - 1 - i : i))) & 0xff));
+    }
+
+    // Convert bytes to a register value.
+    uint32_t get_value(const char *buf, const reg &r) const
+    {
+        uint32_t value = 0;
+
+        for(int i = 0; i < r.width; i++)
+            value |= (uint32_t) (buf[i] & 0xff) << (8 * (big_endian ? r.width - 1 - i : i));
+
+        return value;
+    }
+
+    // Check if a register directly follows another one, so that both can be
+    // accessed in the same transaction.
+    bool follows(const reg &prev, const reg &r) const
+    {
+        return auto_increment && prev.adr + prev.width == r.adr;
+    }
+
+    // Read registers, sorted by address, in one USB transfer. Consecutive
+    // registers are read in one transaction, if the device auto increments
+    // the register address.
+    int read_regs(const std::vector<const reg *> &regs, std::vector<uint32_t> &values)
+    {
+        std::vector<std::vector<char> > adr_bufs;
+        std::vector<std::vector<char> > data_bufs;
+        std::vector<size_t> first;
+        std::vector<struct i2c_mpsse_msg> msgs;
+        std::vector<struct i2c_mpsse_xfer> xfers;
+        size_t i, j, n;
+        int status = 0;
+
+        // Group consecutive registers.
+        for(i = 0; i < regs.size(); i++) {
+            if(i == 0 || !follows(*regs[i-1], *regs[i])) {
+                first.push_back(i);
+                adr_bufs.push_back(std::vector<char>());
+                put_adr(adr_bufs.back(), regs[i]->adr);
+                data_bufs.push_back(std::vector<char>());
+            }
+            data_bufs.back().resize(data_bufs.back().size() + regs[i]->width);
+        }
+
+        // One write-read transaction per group.
+        n = first.size();
+        msgs.resize(2 * n);
+        xfers.resize(n);
+        for(i = 0; i < n; i++) {
+            msgs[2*i].adr = adr;
+            msgs[2*i].flags = 0;
+            msgs[2*i].len = adr_bufs[i].size();
+            msgs[2*i].buf = adr_bufs[i].data();
+            msgs[2*i+1].adr = adr;
+            msgs[2*i+1].flags = I2C_MPSSE_M_RD;
+            msgs[2*i+1].len = data_bufs[i].size();
+            msgs[2*i+1].buf = data_bufs[i].data();
+            xfers[i].msgs = &msgs[2*i];
+            xfers[i].num = 2;
+        }
+        if(adr_width == 0) {
+            for(i = 0; i < n; i++) {
+                xfers[i].msgs = &msgs[2*i+1];
+                xfers[i].num = 1;
+            }
+        }
+        if(i2c_mpsse_transfer_batch(adapter, xfers.data(), n)) status = -1;
+
+        // Extract the register values.
+        for(i = 0; i < n; i++) {
+            size_t last = (i + 1 < n) ? first[i+1] : regs.size();
+            size_t offset = 0;
+            for(j = first[i]; j < last; j++) {
+                if(xfers[i].status == 0) {
+                    values[j] = get_value(data_bufs[i].data() + offset, *regs[j]);
+                    store(*regs[j], values[j]);
+                }
+                offset += regs[j]->width;
+            }
+        }
+
+        return status;
+    }
+
+    // Write registers, sorted by address, in one USB transfer. Consecutive
+    // registers are written in one transaction, if the device auto increments
+    // the register address.
+    int write_regs(const std::vector<const reg *> &regs, const std::vector<uint32_t> &values)
+    {
+        std::vector<std::vector<char> > bufs;
+        std::vector<size_t> first;
+        std::vector<struct i2c_mpsse_msg> msgs;
+        std::vector<struct i2c_mpsse_xfer> xfers;
+        size_t i, j, n;
+        int status = 0;
+
+        // Group consecutive registers.
+        for(i = 0; i < regs.size(); i++) {
+            if(i == 0 || !follows(*regs[i-1], *regs[i])) {
+                first.push_back(i);
+                bufs.push_back(std::vector<char>());
+                put_adr(bufs.back(), regs[i]->adr);
+            }
+            put_value(bufs.back(), *regs[i], values[i]);
+        }
+
+        // One write transaction per group.
+        n = first.size();
+        msgs.resize(n);
+        xfers.resize(n);
+        for(i = 0; i < n; i++) {
+            msgs[i].adr = adr;
+            msgs[i].flags = 0;
+            msgs[i].len = bufs[i].size();
+            msgs[i].buf = bufs[i].data();
+            xfers[i].msgs = &msgs[i];
+            xfers[i].num = 1;
+        }
+        if(i2c_mpsse_transfer_batch(adapter, xfers.data(), n)) status = -1;
+
+        // Update the cache.
+        for(i = 0; i < n; i++) {
+            size_t last = (i + 1 < n) ? first[i+1] : regs.size();
+            for(j = first[i]; j < last; j++) {
+                if(xfers[i].status == 0)
+                    store(*regs[j], values[j]);
+                else
+                    cache.erase(regs[j]->adr);
+            }
+        }
+
+        return status;
+    }
+};
+
+
+
+// Collection of field updates, merged per register.
+class update {
+public:
+    explicit update(device &dev) : dev(dev), error(false) {}
+
+    // Set a field.
+    update &set(const field &f, uint32_t value)
+    {
+        if(f.r.acc == access::ro) {
+            fprintf(stderr, "%s: %s: %sThe register 0x%02x is read only.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, f.r.adr);
+            error = true;
+            return *this;
+        }
+        std::map<unsigned int, entry>::iterator it = entries.find(f.r.adr);
+        if(it == entries.end())
+            it = entries.insert(std::make_pair(f.r.adr, entry(f.r))).first;
+        it->second.mask |= f.mask();
+        it->second.value = (it->second.value & ~f.mask()) | f.encode(value);
+        return *this;
+    }
+
+    // Set a whole register.
+    update &set(const reg &r, uint32_t value)
+    {
+        return set(field(r, 0, 8 * r.width), value);
+    }
+
+    // Version checking the access type at compile time.
+    template<const field &F> update &set(uint32_t value)
+    {
+        static_assert(F.r.acc != access::ro, "Write to a read only register.");
+        return set(F, value);
+    }
+
+    // Execute the updates: read the registers whose other bits are neither
+    // cached nor overwritten, then write all registers.
+    int commit()
+    {
+        std::vector<const reg *> rd_regs, wr_regs;
+        std::vector<uint32_t> rd_values, wr_values;
+        std::map<unsigned int, entry>::iterator it;
+        uint32_t value;
+        size_t i;
+        int status;
+
+        if(error) return -1;
+        if(entries.empty()) return 0;
+
+        // Find the registers that must be read.
+        for(it = entries.begin(); it != entries.end(); ++it) {
+            entry &e = it->second;
+            if(e.mask == e.r.mask()) continue;
+            if(dev.cached(e.r, value)) {
+                e.value = (value & ~e.mask) | e.value;
+                e.mask = e.r.mask();
+            } else if(e.r.acc == access::wo) {
+                e.value = (e.r.reset & ~e.mask) | e.value;
+                e.mask = e.r.mask();
+            } else {
+                rd_regs.push_back(&e.r);
+            }
+        }
+
+        // Read them in one batch.
+        if(!rd_regs.empty()) {
+            rd_values.resize(rd_regs.size());
+            if(dev.read_regs(rd_regs, rd_values)) return -1;
+            for(i = 0; i < rd_regs.size(); i++) {
+                entry &e = entries.find(rd_regs[i]->adr)->second;
+                e.value = (rd_values[i] & ~e.mask) | e.value;
+                e.mask = e.r.mask();
+            }
+        }
+
+        // Write all registers in one batch. The write list points into the
+        // entries, so they are only cleared afterwards.
+        for(it = entries.begin(); it != entries.end(); ++it) {
+            wr_regs.push_back(&it->second.r);
+            wr_values.push_back(it->second.value & it->second.r.mask());
+        }
+        status = dev.write_regs(wr_regs, wr_values);
+        entries.clear();
+
+        return status;
+    }
+
+private:
+    struct entry {
+        reg r;
+        uint32_t mask;          // Bits set by the update.
+        uint32_t value;
+
+        explicit entry(const reg &r) : r(r), mask(0), value(0) {}
+    };
+
+    device &dev;
+    std::map<unsigned int, entry> entries;
+    bool error;
+};
+
+
+
+inline update device::begin()
+{
+    return update(*this);
+}
+
+
+
+inline int device::write(const field &f, uint32_t value)
+{
+    return begin().set(f, value).commit();
+}
+
+
+
+}
+
+
+
+#endif
+
@@ -0,0 +1,164 @@
+// File: i2c_regmap_test.cpp
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Test of the C++ register access layer without hardware. The I2C batch
+// function is replaced by a simulated device with 256 registers of one byte,
+// which records the bytes of all write transactions. Run it with "make test".
+//
+
+
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "i2c_regmap.hpp"
+
+
+
+// Simulated I2C device.
+#define TEST_DEV_ADR            0x70
+
+static unsigned char test_regs[256];
+static std::vector<std::vector<unsigned char> > test_writes;
+static int test_reads;
+
+
+
+// Simulated I2C batch. Each write transaction starts with the register
+// address, the register address is incremented after each byte.
+extern "C" int i2c_mpsse_transfer_batch(struct mpsse_adapter *adapter, struct i2c_mpsse_xfer *xfers, int num)
+{
+    int i, j, k;
+    unsigned int ptr = 0;
+    struct i2c_mpsse_msg *msg;
+
+    for(i = 0; i < num; i++) {
+        xfers[i].status = 0;
+        for(j = 0; j < xfers[i].num; j++) {
+            msg = &xfers[i].msgs[j];
+            if(msg->adr != TEST_DEV_ADR) {
+                xfers[i].status = -1;
+                continue;
+            }
+            if(msg->flags & I2C_MPSSE_M_RD) {
+                for(k = 0; k < msg->len; k++)
+                    msg->buf[k] = test_regs[ptr++ & 0xff];
+                test_reads++;
+            } else {
+                if(msg->len > 0)
+                    ptr = msg->buf[0] & 0xff;
+                if(j == xfers[i].num - 1) {
+                    test_writes.push_back(std::vector<unsigned char>(msg->buf, msg->buf + msg->len));
+                    for(k = 1; k < msg->len; k++)
+                        test_regs[ptr++ & 0xff] = msg->buf[k];
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+
+// Register map of the simulated device.
+struct test_map {
+    static constexpr i2c_regmap::reg CTRL {0x10};
+    static constexpr i2c_regmap::field CTRL_EN {CTRL, 0};
+    static constexpr i2c_regmap::field CTRL_MODE {CTRL, 4, 3};
+    static constexpr i2c_regmap::reg DATA {0x11};
+    static constexpr i2c_regmap::reg ID {0x20, 1, i2c_regmap::access::ro};
+};
+
+constexpr i2c_regmap::reg test_map::CTRL;
+constexpr i2c_regmap::field test_map::CTRL_EN;
+constexpr i2c_regmap::field test_map::CTRL_MODE;
+constexpr i2c_regmap::reg test_map::DATA;
+constexpr i2c_regmap::reg test_map::ID;
+
+
+
+// Check the write transactions recorded since the last check.
+static int check_writes(const char *name, const std::vector<std::vector<unsigned char> > &expected)
+{
+    size_t i, j;
+    int status = 0;
+
+    if(test_writes != expected) {
+        printf("FAIL: %s: wrote", name);
+        for(i = 0; i < test_writes.size(); i++) {
+            printf(" [");
+            for(j = 0; j < test_writes[i].size(); j++)
+                printf("%s0x%02x", j ? " " : "", test_writes[i][j]);
+            printf("]");
+        }
+        printf("\n");
+        status = -1;
+    } else {
+        printf("PASS: %s\n", name);
+    }
+    test_writes.clear();
+
+    return status;
+}
+
+
+
+int main(void)
+{
+    int status = 0;
+    uint32_t value;
+
+    memset(test_regs, 0, sizeof(test_regs));
+    test_regs[0x10] = 0x82;
+    test_regs[0x20] = 0x5a;
+
+    // Staged update of two fields of a register not cached yet and of a whole
+    // register. CTRL is read once and both registers are written.
+    i2c_regmap::device dev(nullptr, TEST_DEV_ADR);
+    test_reads = 0;
+    if(dev.begin().set<test_map::CTRL_EN>(1).set<test_map::CTRL_MODE>(5).set(test_map::DATA, 0x33).commit()) {
+        printf("FAIL: staged update: commit failed\n");
+        status = -1;
+    }
+    if(test_reads != 1) {
+        printf("FAIL: staged update: %d read(s) instead of 1\n", test_reads);
+        status = -1;
+    }
+    status |= check_writes("staged update", {{0x10, 0xd3}, {0x11, 0x33}});
+
+    // Field write of the now cached register, without reading it again.
+    test_reads = 0;
+    if(dev.write<test_map::CTRL_MODE>(2)) {
+        printf("FAIL: field write: write failed\n");
+        status = -1;
+    }
+    if(test_reads != 0) {
+        printf("FAIL: field write: %d read(s) of a cached register\n", test_reads);
+        status = -1;
+    }
+    status |= check_writes("field write", {{0x10, 0xa3}});
+
+    // Consecutive registers of an auto incrementing device are written in one
+    // transaction.
+    i2c_regmap::device dev_inc(nullptr, TEST_DEV_ADR, 1, true, true);
+    if(dev_inc.begin().set(test_map::CTRL, 0x01).set(test_map::DATA, 0x02).commit()) {
+        printf("FAIL: auto increment: commit failed\n");
+        status = -1;
+    }
+    status |= check_writes("auto increment", {{0x10, 0x01, 0x02}});
+
+    // Read a read-only register.
+    if(dev.read<test_map::ID>(value) || value != 0x5a) {
+        printf("FAIL: register read\n");
+        status = -1;
+    } else {
+        printf("PASS: register read\n");
+    }
+
+    return status ? 1 : 0;
+}
+
@@ -0,0 +1,715 @@
+// File: mdio_mpsse.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// MDIO (IEEE 802.3 Clause 22 and Clause 45) management interface functions
+// based on FTDI's Multi-Protocol Synchronous Serial Engine (MPSSE), e.g. for
+// accessing the registers of Ethernet PHYs.
+//
+// FTDI FT232H pinning:
+// - ADBUS0(13): MDC
+// - ADBUS1(14): MDIO output
+// - ADBUS2(15): MDIO input
+// The pins ADBUS1(14) and ADBUS2(15) *must* be tied together. MDIO needs a
+// pull-up resistor (typ. 1.5 kOhm), which is usually placed at the PHY.
+// All other pins are left to the GPIO functions, which may share the adapter.
+// The MDIO, I2C and SWD functions use the same pins, so they cannot share an
+// adapter.
+//
+// MDIO data is sampled on the rising MDC edge in both directions. The MPSSE
+// shifts out the frame bits on the falling MDC edge and shifts in the bits
+// driven by the PHY on the rising MDC edge. For a read, MDIO is released for
+// the turnaround. The PHY drives the second turnaround bit low, which is read
+// back and checked like an I2C ACK: if no PHY answers, the pull-up keeps it
+// high.
+//
+// The register accesses are compiled into MPSSE command sequences and executed
+// through the MPSSE adapter layer. All frames of a batch, including their
+// preambles, turnarounds and the data read, are transferred in a single USB
+// round trip, e.g. a dump of all 32 Clause 22 registers of a PHY.
+//
+// A Clause 45 access consists of an address frame and a data frame. Within a
+// batch, the address frame is left out if the register address of the PHY is
+// already set by the previous access. Reads use the post-read-increment-address
+// operation, so that a block of consecutive registers is read with only one
+// address frame.
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <mpsse.h>
+#include "mpsse_adapter.h"
+#include "mdio_mpsse.h"
+
+
+
+// MDIO pins.
+#define MDIO_MPSSE_MDC          SK          // ADBUS0
+#define MDIO_MPSSE_MDIO_OUT     DO          // ADBUS1
+#define MDIO_MPSSE_MDIO_IN      DI          // ADBUS2
+#define MDIO_MPSSE_PINS         (MDIO_MPSSE_MDC | MDIO_MPSSE_MDIO_OUT | MDIO_MPSSE_MDIO_IN)
+
+// MDIO frame fields.
+#define MDIO_MPSSE_ST_C22       0x1         // Start of frame.
+#define MDIO_MPSSE_ST_C45       0x0
+#define MDIO_MPSSE_OP_ADR       0x0         // Address (Clause 45).
+#define MDIO_MPSSE_OP_WR        0x1         // Write.
+#define MDIO_MPSSE_OP_RD        0x2         // Read (Clause 22).
+#define MDIO_MPSSE_OP_RD_INC    0x2         // Post-read-increment-address (Clause 45).
+#define MDIO_MPSSE_TA           0x2         // Turnaround of a write.
+
+// Length of the preamble in bytes (32 ones).
+#define MDIO_MPSSE_PREAMBLE     4
+
+// MPSSE data shifting commands. The STA changes MDIO on the falling MDC edge,
+// the data driven by the PHY is sampled on the rising MDC edge.
+#define MDIO_MPSSE_TX           (MPSSE_DO_WRITE | MSB | MPSSE_WRITE_NEG)
+#define MDIO_MPSSE_RX           (MPSSE_DO_READ | MSB)
+
+
+
+// MDIO batch job.
+struct mdio_mpsse_batch_job {
+    struct mdio_mpsse_op *ops;
+    int num;
+    unsigned char *rx;          // Data read, 2 bytes per access.
+};
+
+
+
+// Global variables.
+// Default MDIO adapter used by the non-reentrant functions.
+static struct mpsse_adapter *mdio_mpsse = NULL;
+static pthread_mutex_t mdio_mpsse_init_lock = PTHREAD_MUTEX_INITIALIZER;
+static int mdio_mpsse_verbose = 1;
+
+
+
+// Function prototypes.
+static struct mpsse_adapter *mdio_mpsse_setup(struct mpsse_adapter *adapter);
+static int mdio_mpsse_check_op(struct mpsse_adapter *adapter, struct mdio_mpsse_op *op);
+static int mdio_mpsse_build_line(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, int drive);
+static int mdio_mpsse_build_clock(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter);
+static int mdio_mpsse_build_frame(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, int st, int op, int phy, int dev_reg, unsigned int data, unsigned char *rx, int *nack);
+static int mdio_mpsse_build_batch(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int mdio_mpsse_build_init(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int mdio_mpsse_build_set_freq(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int mdio_mpsse_build_set_preamble(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+
+
+
+// Initialize the MDIO hardware.
+int mdio_init(void)
+{
+    pthread_mutex_lock(&mdio_mpsse_init_lock);
+
+    // Open the default MDIO device, if it was not yet initialized.
+    if(mdio_mpsse == NULL) {
+        mdio_mpsse = mdio_mpsse_open();
+        if(mdio_mpsse != NULL)
+            mdio_mpsse_set_verbose(mdio_mpsse, mdio_mpsse_verbose);
+    }
+
+    pthread_mutex_unlock(&mdio_mpsse_init_lock);
+
+    return (mdio_mpsse == NULL) ? -1 : 0;
+}
+
+
+
+// Close the MDIO hardware.
+int mdio_close(void)
+{
+    pthread_mutex_lock(&mdio_mpsse_init_lock);
+    mdio_mpsse_close(mdio_mpsse);
+    mdio_mpsse = NULL;
+    pthread_mutex_unlock(&mdio_mpsse_init_lock);
+
+    return 0;
+}
+
+
+
+// Get information about the MDIO device.
+int mdio_info(void)
+{
+    return mdio_mpsse_info(mdio_mpsse);
+}
+
+
+
+// Get the MDC frequency.
+int mdio_get_freq(int *mdio_freq)
+{
+    return mdio_mpsse_get_freq(mdio_mpsse, mdio_freq);
+}
+
+
+
+// Set the MDC frequency.
+int mdio_set_freq(int mdio_freq)
+{
+    return mdio_mpsse_set_freq(mdio_mpsse, mdio_freq);
+}
+
+
+
+// Enable or disable the MDIO preamble.
+int mdio_set_preamble(int enable)
+{
+    return mdio_mpsse_set_preamble(mdio_mpsse, enable);
+}
+
+
+
+// Set verbosity of the MDIO functions.
+int mdio_set_verbose(int verbose)
+{
+    mdio_mpsse_verbose = verbose;
+    if(mdio_mpsse != NULL)
+        mdio_mpsse_set_verbose(mdio_mpsse, verbose);
+    return 0;
+}
+
+
+
+// Read a Clause 22 register.
+int mdio_read(int phy_adr, int reg_adr, unsigned int *data)
+{
+    return mdio_mpsse_read(mdio_mpsse, phy_adr, reg_adr, data);
+}
+
+
+
+// Write a Clause 22 register.
+int mdio_write(int phy_adr, int reg_adr, unsigned int data)
+{
+    return mdio_mpsse_write(mdio_mpsse, phy_adr, reg_adr, data);
+}
+
+
+
+// Read a Clause 45 register.
+int mdio_c45_read(int prt_adr, int dev_adr, int reg_adr, unsigned int *data)
+{
+    return mdio_mpsse_c45_read(mdio_mpsse, prt_adr, dev_adr, reg_adr, data);
+}
+
+
+
+// Write a Clause 45 register.
+int mdio_c45_write(int prt_adr, int dev_adr, int reg_adr, unsigned int data)
+{
+    return mdio_mpsse_c45_write(mdio_mpsse, prt_adr, dev_adr, reg_adr, data);
+}
+
+
+
+// Execute several MDIO register accesses in one USB transfer.
+int mdio_transfer_batch(struct mdio_mpsse_op *ops, int num)
+{
+    return mdio_mpsse_transfer_batch(mdio_mpsse, ops, num);
+}
+
+
+
+// Get the default MDIO adapter.
+struct mpsse_adapter *mdio_get_adapter(void)
+{
+    return mdio_mpsse;
+}
+
+
+
+// Open an MDIO adapter.
+// If the adapter is already used by the GPIO functions, the MDIO functions
+// share it.
+struct mpsse_adapter *mdio_mpsse_open(void)
+{
+    return mdio_mpsse_setup(mpsse_adapter_open(SPI0, MDIO_MPSSE_FREQ_DEFAULT, MSB));
+}
+
+
+
+// Open an MDIO adapter on an interface (IFACE_A .. IFACE_D) of the FTDI
+// device with the given serial number, NULL for the first device found.
+struct mpsse_adapter *mdio_mpsse_open_if(const char *serial, int interface)
+{
+    return mdio_mpsse_setup(mpsse_adapter_open_if(SPI0, MDIO_MPSSE_FREQ_DEFAULT, MSB, serial, interface));
+}
+
+
+
+// Set up the MDIO pins of a newly opened adapter.
+static struct mpsse_adapter *mdio_mpsse_setup(struct mpsse_adapter *adapter)
+{
+    int status;
+
+    if(adapter == NULL) return NULL;
+
+    status = mpsse_adapter_run(adapter, mdio_mpsse_build_init, NULL);
+    if(status) {
+        fprintf(stderr, "%s: %s: %sUnable to set up the MDIO pins.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        mpsse_adapter_close(adapter);
+        return NULL;
+    }
+
+    return adapter;
+}
+
+
+
+// Close an MDIO adapter.
+int mdio_mpsse_close(struct mpsse_adapter *adapter)
+{
+    mpsse_adapter_close(adapter);
+
+    return 0;
+}
+
+
+
+// Get information about an MDIO adapter.
+int mdio_mpsse_info(struct mpsse_adapter *adapter)
+{
+    // Check if the MDIO device was initialized.
+    if(adapter == NULL) {
+        if(mdio_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe MDIO device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    printf("MDIO master device: %s\n", GetDescription(adapter->mpsse));
+    printf("MDIO master device VID: 0x%04x\n", GetVid(adapter->mpsse));
+    printf("MDIO master device PID: 0x%04x\n", GetPid(adapter->mpsse));
+    printf("MDC frequency: %d Hz\n", adapter->mdio_freq);
+    printf("MDIO preamble: %s\n", adapter->mdio_preamble ? "enabled" : "disabled");
+
+    return 0;
+}
+
+
+
+// Get the MDC frequency of an MDIO adapter.
+int mdio_mpsse_get_freq(struct mpsse_adapter *adapter, int *mdio_freq)
+{
+    // Check if the MDIO device was initialized.
+    if(adapter == NULL) {
+        if(mdio_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe MDIO device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    *mdio_freq = adapter->mdio_freq;
+
+    return 0;
+}
+
+
+
+// Set the MDC frequency of an MDIO adapter.
+int mdio_mpsse_set_freq(struct mpsse_adapter *adapter, int mdio_freq)
+{
+    int status;
+
+    // Check if the MDIO device was initialized.
+    if(adapter == NULL) {
+        if(mdio_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe MDIO device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    if(mdio_freq <= 0 || mdio_freq > MDIO_MPSSE_FREQ_MAX) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sInvalid MDC frequency of %d Hz.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, mdio_freq);
+        return -1;
+    }
+
+    status = mpsse_adapter_run(adapter, mdio_mpsse_build_set_freq, &mdio_freq);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to set the MDC frequency to %d Hz.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, mdio_freq);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Enable or disable the preamble of 32 ones sent before each MDIO frame. Only
+// disable it if all PHYs on the bus support preamble suppression (Clause 22
+// register 1, bit 6).
+int mdio_mpsse_set_preamble(struct mpsse_adapter *adapter, int enable)
+{
+    // Check if the MDIO device was initialized.
+    if(adapter == NULL) {
+        if(mdio_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe MDIO device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    return mpsse_adapter_run(adapter, mdio_mpsse_build_set_preamble, &enable);
+}
+
+
+
+// Set verbosity of an MDIO adapter.
+int mdio_mpsse_set_verbose(struct mpsse_adapter *adapter, int verbose)
+{
+    if(adapter == NULL) return -1;
+
+    adapter->verbose = verbose;
+
+    return 0;
+}
+
+
+
+// Read a Clause 22 register of a PHY.
+int mdio_mpsse_read(struct mpsse_adapter *adapter, int phy_adr, int reg_adr, unsigned int *data)
+{
+    struct mdio_mpsse_op op;
+
+    op.clause = MDIO_MPSSE_C22;
+    op.flags = MDIO_MPSSE_M_RD;
+    op.phy = phy_adr;
+    op.dev = 0;
+    op.reg = reg_adr;
+    op.data = 0;
+    if(mdio_mpsse_transfer_batch(adapter, &op, 1)) return -1;
+    *data = op.data;
+
+    return 0;
+}
+
+
+
+// Write a Clause 22 register of a PHY.
+int mdio_mpsse_write(struct mpsse_adapter *adapter, int phy_adr, int reg_adr, unsigned int data)
+{
+    struct mdio_mpsse_op op;
+
+    op.clause = MDIO_MPSSE_C22;
+    op.flags = 0;
+    op.phy = phy_adr;
+    op.dev = 0;
+    op.reg = reg_adr;
+    op.data = data;
+
+    return mdio_mpsse_transfer_batch(adapter, &op, 1);
+}
+
+
+
+// Read a Clause 45 register of an MMD (MDIO manageable device) of a port.
+int mdio_mpsse_c45_read(struct mpsse_adapter *adapter, int prt_adr, int dev_adr, int reg_adr, unsigned int *data)
+{
+    struct mdio_mpsse_op op;
+
+    op.clause = MDIO_MPSSE_C45;
+    op.flags = MDIO_MPSSE_M_RD;
+    op.phy = prt_adr;
+    op.dev = dev_adr;
+    op.reg = reg_adr;
+    op.data = 0;
+    if(mdio_mpsse_transfer_batch(adapter, &op, 1)) return -1;
+    *data = op.data;
+
+    return 0;
+}
+
+
+
+// Write a Clause 45 register of an MMD (MDIO manageable device) of a port.
+int mdio_mpsse_c45_write(struct mpsse_adapter *adapter, int prt_adr, int dev_adr, int reg_adr, unsigned int data)
+{
+    struct mdio_mpsse_op op;
+
+    op.clause = MDIO_MPSSE_C45;
+    op.flags = 0;
+    op.phy = prt_adr;
+    op.dev = dev_adr;
+    op.reg = reg_adr;
+    op.data = data;
+
+    return mdio_mpsse_transfer_batch(adapter, &op, 1);
+}
+
+
+
+// Execute several MDIO register accesses in one USB transfer. Clause 22 and
+// Clause 45 accesses may be mixed. The result of each access is stored in its
+// status field (0 = OK, -1 = no PHY answered the read), the data read in its
+// data field. Returns 0 if all accesses succeeded.
+int mdio_mpsse_transfer_batch(struct mpsse_adapter *adapter, struct mdio_mpsse_op *ops, int num)
+{
+    int i;
+    int status;
+    struct mdio_mpsse_batch_job job;
+
+    // Check if the MDIO device was initialized.
+    if(adapter == NULL) {
+        if(mdio_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe MDIO device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    if(ops == NULL || num <= 0) return -1;
+    for(i = 0; i < num; i++)
+        if(mdio_mpsse_check_op(adapter, &ops[i])) return -1;
+
+    // Execute the accesses.
+    job.ops = ops;
+    job.num = num;
+    job.rx = calloc(num, 2);
+    if(job.rx == NULL)
+        status = -1;
+    else
+        status = mpsse_adapter_run(adapter, mdio_mpsse_build_batch, &job);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to execute a batch of %d MDIO access(es).\n", __FILE__, __FUNCTION__, PREFIX_ERROR, num);
+        for(i = 0; i < num; i++)
+            ops[i].status = -1;
+        free(job.rx);
+        return -1;
+    }
+
+    // Check that a PHY answered each read.
+    for(i = 0; i < num; i++) {
+        if(!(ops[i].flags & MDIO_MPSSE_M_RD)) continue;
+        ops[i].data = ((job.rx[2 * i] << 8) | job.rx[2 * i + 1]) & 0xffff;
+        if(ops[i].status) {
+            ops[i].status = -1;
+            if(adapter->verbose)
+                fprintf(stderr, "%s: %s: %sNo answer from the MDIO PHY address 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, ops[i].phy);
+            status = -1;
+        }
+    }
+    free(job.rx);
+
+    return status;
+}
+
+
+
+// Check the addresses of an MDIO register access.
+static int mdio_mpsse_check_op(struct mpsse_adapter *adapter, struct mdio_mpsse_op *op)
+{
+    int reg_max;
+
+    reg_max = (op->clause == MDIO_MPSSE_C45) ? 0xffff : 0x1f;
+    if((op->clause == MDIO_MPSSE_C22 || op->clause == MDIO_MPSSE_C45) &&
+       op->phy >= 0 && op->phy <= 0x1f && op->dev >= 0 && op->dev <= 0x1f &&
+       op->reg >= 0 && op->reg <= reg_max)
+        return 0;
+
+    if(adapter->verbose)
+        fprintf(stderr, "%s: %s: %sInvalid Clause %d MDIO access of PHY address 0x%02x, device address 0x%02x, register address 0x%04x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, op->clause, op->phy, op->dev, op->reg);
+
+    return -1;
+}
+
+
+
+// Drive or release the MDIO line. MDC is low, all other pins keep their
+// states.
+static int mdio_mpsse_build_line(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, int drive)
+{
+    unsigned char direction = MDIO_MPSSE_MDC;
+
+    if(drive) direction |= MDIO_MPSSE_MDIO_OUT;
+
+    return mpsse_adapter_set_low(adapter, cmd, MDIO_MPSSE_MDIO_OUT, direction, MDIO_MPSSE_PINS);
+}
+
+
+
+// Build switching to the MDC frequency and to two phase clocking, in case
+// another engine sharing the adapter has changed them.
+static int mdio_mpsse_build_clock(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter)
+{
+    int status = 0;
+
+    if(adapter->three_phase) {
+        status |= mpsse_cmd_byte(cmd, DISABLE_3_PHASE_CLOCK);
+        adapter->three_phase = 0;
+    }
+    if(mpsse_adapter_get_clock(adapter->mdio_freq) != adapter->mpsse->clock)
+        status |= mpsse_adapter_set_clock(cmd, adapter->mpsse, adapter->mdio_freq);
+
+    return status;
+}
+
+
+
+// Build one MDIO frame. The second address field is the register address
+// for Clause 22 and the device address for Clause 45. For a write (rx ==
+// NULL), the data is shifted out after the turnaround. For a read, MDIO is
+// released for the turnaround, then the second turnaround bit and the 16 data
+// bits driven by the PHY are shifted in. If the turnaround bit is high, nack
+// is incremented.
+static int mdio_mpsse_build_frame(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter, int st, int op, int phy, int dev_reg, unsigned int data, unsigned char *rx, int *nack)
+{
+    int status = 0;
+    unsigned int frame;
+    unsigned char buf[8];
+
+    // Preamble of 32 ones.
+    if(adapter->mdio_preamble) {
+        buf[0] = MDIO_MPSSE_TX;
+        buf[1] = MDIO_MPSSE_PREAMBLE - 1;
+        buf[2] = 0;
+        memset(buf + 3, 0xff, MDIO_MPSSE_PREAMBLE);
+        status |= mpsse_cmd_bytes(cmd, buf, 3 + MDIO_MPSSE_PREAMBLE);
+    }
+
+    frame = (st << 30) | (op << 28) | ((phy & 0x1f) << 23) | ((dev_reg & 0x1f) << 18);
+
+    // Write: Shift out the whole frame.
+    if(rx == NULL) {
+        frame |= (MDIO_MPSSE_TA << 16) | (data & 0xffff);
+        buf[0] = MDIO_MPSSE_TX;
+        buf[1] = 4 - 1;
+        buf[2] = 0;
+        buf[3] = (frame >> 24) & 0xff;
+        buf[4] = (frame >> 16) & 0xff;
+        buf[5] = (frame >> 8) & 0xff;
+        buf[6] = frame & 0xff;
+        status |= mpsse_cmd_bytes(cmd, buf, 7);
+        return status ? -1 : 0;
+    }
+
+    // Read: Shift out the 14 bits up to the turnaround.
+    buf[0] = MDIO_MPSSE_TX;
+    buf[1] = 1 - 1;
+    buf[2] = 0;
+    buf[3] = (frame >> 24) & 0xff;
+    buf[4] = MDIO_MPSSE_TX | MPSSE_BITMODE;
+    buf[5] = 6 - 1;
+    buf[6] = (frame >> 16) & 0xff;
+    status |= mpsse_cmd_bytes(cmd, buf, 7);
+    // Release MDIO and clock the first turnaround bit.
+    status |= mdio_mpsse_build_line(cmd, adapter, 0);
+    buf[0] = CLK_BITS;
+    buf[1] = 1 - 1;
+    status |= mpsse_cmd_bytes(cmd, buf, 2);
+    // Shift in the second turnaround bit, which the PHY drives low.
+    status |= mpsse_cmd_read(cmd, NULL, 1, nack);
+    buf[0] = MDIO_MPSSE_RX | MPSSE_BITMODE;
+    buf[1] = 1 - 1;
+    status |= mpsse_cmd_bytes(cmd, buf, 2);
+    // Shift in the data.
+    status |= mpsse_cmd_read(cmd, rx, 2, NULL);
+    buf[0] = MDIO_MPSSE_RX;
+    buf[1] = 2 - 1;
+    buf[2] = 0;
+    status |= mpsse_cmd_bytes(cmd, buf, 3);
+    // Drive MDIO high again.
+    status |= mdio_mpsse_build_line(cmd, adapter, 1);
+
+    return status ? -1 : 0;
+}
+
+
+
+// Build the MDIO frames of a batch job. The read-back turnaround bits of each
+// access are counted in its status field.
+static int mdio_mpsse_build_batch(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    int i;
+    int status = 0;
+    int read;
+    int adr_valid = 0;
+    int adr_phy = 0, adr_dev = 0, adr_reg = 0;
+    struct mdio_mpsse_batch_job *job = (struct mdio_mpsse_batch_job *) arg;
+    struct mdio_mpsse_op *op;
+
+    status |= mdio_mpsse_build_clock(cmd, adapter);
+
+    for(i = 0; i < job->num; i++) {
+        op = &job->ops[i];
+        op->status = 0;
+        read = (op->flags & MDIO_MPSSE_M_RD) ? 1 : 0;
+        if(op->clause == MDIO_MPSSE_C22) {
+            status |= mdio_mpsse_build_frame(cmd, adapter, MDIO_MPSSE_ST_C22, read ? MDIO_MPSSE_OP_RD : MDIO_MPSSE_OP_WR,
+                                             op->phy, op->reg, op->data, read ? &job->rx[2 * i] : NULL, &op->status);
+            continue;
+        }
+        // Clause 45: Set the register address, unless it is already set by
+        // the previous access of the same MMD.
+        if(!adr_valid || adr_phy != op->phy || adr_dev != op->dev || adr_reg != op->reg)
+            status |= mdio_mpsse_build_frame(cmd, adapter, MDIO_MPSSE_ST_C45, MDIO_MPSSE_OP_ADR, op->phy, op->dev, op->reg, NULL, NULL);
+        status |= mdio_mpsse_build_frame(cmd, adapter, MDIO_MPSSE_ST_C45, read ? MDIO_MPSSE_OP_RD_INC : MDIO_MPSSE_OP_WR,
+                                         op->phy, op->dev, op->data, read ? &job->rx[2 * i] : NULL, &op->status);
+        adr_valid = 1;
+        adr_phy = op->phy;
+        adr_dev = op->dev;
+        adr_reg = read ? ((op->reg + 1) & 0xffff) : op->reg;
+    }
+
+    return status ? -1 : 0;
+}
+
+
+
+// Build the set up of the MDIO pins and clocking.
+static int mdio_mpsse_build_init(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    int status = 0;
+
+    // The I2C and SWD functions use the same pins.
+    if(adapter->engines & MPSSE_ADAPTER_ENGINES_SERIAL & ~MPSSE_ADAPTER_ENGINE_MDIO) return -1;
+
+    // Drive MDC and MDIO push-pull with two phase clocking and without
+    // adaptive clocking.
+    status |= mpsse_cmd_byte(cmd, DISABLE_3_PHASE_CLOCK);
+    adapter->three_phase = 0;
+    if(adapter->adaptive)
+        status |= mpsse_adapter_set_adaptive(adapter, cmd, 0);
+    if(adapter->mpsse->ftdi.type == TYPE_232H && (adapter->pins.low_od & MDIO_MPSSE_PINS))
+        status |= mpsse_adapter_set_open_drain(adapter, cmd, adapter->pins.low_od & ~MDIO_MPSSE_PINS, adapter->pins.high_od);
+    // MDC idles low, MDIO idles high.
+    status |= mdio_mpsse_build_line(cmd, adapter, 1);
+    // Set the default MDC frequency with preamble, unless another MDIO user
+    // of the adapter has already set them.
+    if(!(adapter->engines & MPSSE_ADAPTER_ENGINE_MDIO)) {
+        adapter->mdio_freq = MDIO_MPSSE_FREQ_DEFAULT;
+        adapter->mdio_preamble = 1;
+    }
+    status |= mdio_mpsse_build_clock(cmd, adapter);
+    if(status) return -1;
+
+    adapter->engines |= MPSSE_ADAPTER_ENGINE_MDIO;
+
+    return 0;
+}
+
+
+
+// Build the setting of the MDC frequency.
+static int mdio_mpsse_build_set_freq(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    if(mpsse_adapter_set_clock(cmd, adapter->mpsse, *((int *) arg))) return -1;
+
+    adapter->mdio_freq = *((int *) arg);
+
+    return 0;
+}
+
+
+
+// Build the setting of the MDIO preamble. No commands are needed, but the
+// setting must only be changed while holding the adapter.
+static int mdio_mpsse_build_set_preamble(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    adapter->mdio_preamble = *((int *) arg) ? 1 : 0;
+
+    return 0;
+}
+
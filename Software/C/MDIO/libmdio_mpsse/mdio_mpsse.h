@@ -0,0 +1,89 @@
+// File: mdio_mpsse.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for the MDIO (IEEE 802.3 Clause 22 and Clause 45) management
+// interface functions based on FTDI's Multi-Protocol Synchronous Serial
+// Engine (MPSSE).
+//
+
+
+
+#ifndef __MDIO_MPSSE_H
+#define __MDIO_MPSSE_H
+
+
+
+// Message prefixes.
+#define PREFIX_DEBUG            "DEBUG: "
+#define PREFIX_ERROR            "ERROR: "
+
+
+
+// MDC frequencies. IEEE 802.3 specifies up to 2.5 MHz, many PHYs support
+// much more.
+#define MDIO_MPSSE_FREQ_DEFAULT     2500000
+#define MDIO_MPSSE_FREQ_MAX         30000000
+
+// MDIO frame formats.
+#define MDIO_MPSSE_C22          22          // Clause 22: 5-bit PHY and register address.
+#define MDIO_MPSSE_C45          45          // Clause 45: 5-bit port and device address, 16-bit register address.
+
+// MDIO operation flags.
+#define MDIO_MPSSE_M_RD         0x0001      // Read the register.
+
+
+
+// MDIO register access, used for executing several accesses in one USB
+// transfer.
+struct mdio_mpsse_op {
+    int clause;                 // MDIO_MPSSE_C22 or MDIO_MPSSE_C45.
+    int flags;                  // MDIO_MPSSE_M_* flags.
+    int phy;                    // PHY address (Clause 22) or port address (Clause 45), 0..31.
+    int dev;                    // Device address, 0..31 (Clause 45 only).
+    int reg;                    // Register address, 0..31 (Clause 22) or 0..65535 (Clause 45).
+    unsigned int data;          // Data written or read, 16 bits.
+    int status;                 // Result: 0 = OK, -1 = no PHY answered the read.
+};
+
+struct mpsse_adapter;
+
+
+
+// Function prototypes.
+// Functions operating on the default MDIO adapter.
+int mdio_init(void);
+int mdio_close(void);
+int mdio_info(void);
+int mdio_get_freq(int *mdio_freq);
+int mdio_set_freq(int mdio_freq);
+int mdio_set_preamble(int enable);
+int mdio_set_verbose(int verbose);
+int mdio_read(int phy_adr, int reg_adr, unsigned int *data);
+int mdio_write(int phy_adr, int reg_adr, unsigned int data);
+int mdio_c45_read(int prt_adr, int dev_adr, int reg_adr, unsigned int *data);
+int mdio_c45_write(int prt_adr, int dev_adr, int reg_adr, unsigned int data);
+int mdio_transfer_batch(struct mdio_mpsse_op *ops, int num);
+struct mpsse_adapter *mdio_get_adapter(void);
+// Reentrant functions operating on an explicitly opened MDIO adapter. An
+// adapter may be shared by any number of threads.
+struct mpsse_adapter *mdio_mpsse_open(void);
+struct mpsse_adapter *mdio_mpsse_open_if(const char *serial, int interface);
+int mdio_mpsse_close(struct mpsse_adapter *adapter);
+int mdio_mpsse_info(struct mpsse_adapter *adapter);
+int mdio_mpsse_get_freq(struct mpsse_adapter *adapter, int *mdio_freq);
+int mdio_mpsse_set_freq(struct mpsse_adapter *adapter, int mdio_freq);
+int mdio_mpsse_set_preamble(struct mpsse_adapter *adapter, int enable);
+int mdio_mpsse_set_verbose(struct mpsse_adapter *adapter, int verbose);
+int mdio_mpsse_read(struct mpsse_adapter *adapter, int phy_adr, int reg_adr, unsigned int *data);
+int mdio_mpsse_write(struct mpsse_adapter *adapter, int phy_adr, int reg_adr, unsigned int data);
+int mdio_mpsse_c45_read(struct mpsse_adapter *adapter, int prt_adr, int dev_adr, int reg_adr, unsigned int *data);
+int mdio_mpsse_c45_write(struct mpsse_adapter *adapter, int prt_adr, int dev_adr, int reg_adr, unsigned int data);
+int mdio_mpsse_transfer_batch(struct mpsse_adapter *adapter, struct mdio_mpsse_op *ops, int num);
+
+
+
+#endif
+
@@ -0,0 +1,283 @@
+// File: mdio-io.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Raw MDIO IO control program for the FTDI FH232H chip using FTDI's Multi -
+// Protocol Synchronous Serial Engine (MPSSE), e.g. for Ethernet PHYs.
+//
+// FTDI FT232H pinning:
+// - ADBUS0(13): MDC
+// - ADBUS1(14): MDIO output
+// - ADBUS2(15): MDIO input
+//
+// CAUTION:
+// The pins ADBUS1(14) and ADBUS2(15) *must* be tied together!
+//
+// The option -c selects Clause 22 (default) or Clause 45 frames. Clause 45
+// registers are addressed by port address, device address and register
+// address.
+//
+// Several registers are accessed in one USB transfer: The option -n reads LEN
+// consecutive registers, several data values are written to consecutive
+// registers. The option -d dumps all 32 Clause 22 registers of a PHY, the
+// option -S scans the bus for PHYs and shows their PHY IDs.
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpsse.h>
+#include "mdio-io.h"
+#include "mpsse_adapter.h"
+
+
+
+// Function protoypes.
+int show_help(char* prog_name);
+int scan_phys(void);
+
+
+
+int main(int argc, char **argv)
+{
+    int i;
+    int status;
+    int mdio_freq = MDIO_MPSSE_FREQ_DEFAULT;
+    int mdio_preamble = 1;
+    int mdio_clause = MDIO_MPSSE_C22;
+    int mdio_dump = 0;
+    int mdio_scan = 0;
+    int mdio_len = 1;
+    int mdio_write_len;
+    int mdio_phy_adr;
+    int mdio_dev_adr = 0;
+    int mdio_reg_adr;
+    int mdio_reg_max;
+    int args;
+    struct mdio_mpsse_op *ops;
+
+    // Check command line arguments.
+    if(argc < 2) {
+        show_help(argv[0]);
+        return 1;
+    }
+    // Parse the options and remove them from the command line arguments.
+    for(i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if(!strcmp(argv[i], "-p")) {
+            mdio_preamble = 0;
+        } else if(!strcmp(argv[i], "-d")) {
+            mdio_dump = 1;
+        } else if(!strcmp(argv[i], "-S")) {
+            mdio_scan = 1;
+        } else if(!strcmp(argv[i], "-s") && i + 1 < argc) {
+            mdio_freq = (int) strtoul(argv[++i], NULL, 0);
+            if(mdio_freq <= 0 || mdio_freq > MDIO_MPSSE_FREQ_MAX) {
+                printf("%sInvalid MDC frequency of %d Hz. Use up to %d Hz.\n", PREFIX_ERROR, mdio_freq, MDIO_MPSSE_FREQ_MAX);
+                return 1;
+            }
+        } else if(!strcmp(argv[i], "-c") && i + 1 < argc) {
+            mdio_clause = (int) strtoul(argv[++i], NULL, 0);
+            if(mdio_clause != MDIO_MPSSE_C22 && mdio_clause != MDIO_MPSSE_C45) {
+                printf("%sInvalid MDIO clause %d. Use 22 or 45.\n", PREFIX_ERROR, mdio_clause);
+                return 1;
+            }
+        } else if(!strcmp(argv[i], "-i") && i + 1 < argc) {
+            i++;
+            if(mpsse_adapter_select_interface(mpsse_adapter_parse_interface(argv[i]))) {
+                printf("%sInvalid FTDI interface \"%s\". Use A, B, C or D.\n", PREFIX_ERROR, argv[i]);
+                return 1;
+            }
+        } else if(!strcmp(argv[i], "-w") && i + 1 < argc) {
+            status = mpsse_tune_parse_workload(argv[++i]);
+            if(status < 0) {
+                printf("%sInvalid workload class \"%s\". Use poll or stream.\n", PREFIX_ERROR, argv[i]);
+                return 1;
+            }
+            mpsse_adapter_select_workload(status);
+        } else if(!strcmp(argv[i], "-n") && i + 1 < argc) {
+            mdio_len = (int) strtoul(argv[++i], NULL, 0);
+            if(mdio_len < 1 || mdio_len > MDIO_DATA_LEN_MAX) {
+                printf("%sInvalid number of %d register(s). Use 1..%d registers.\n", PREFIX_ERROR, mdio_len, MDIO_DATA_LEN_MAX);
+                return 1;
+            }
+        } else {
+            show_help(argv[0]);
+            return 1;
+        }
+    }
+    argv[i-1] = argv[0];
+    argv += i - 1;
+    argc -= i - 1;
+
+    // Check the addresses.
+    args = (mdio_clause == MDIO_MPSSE_C45) ? 3 : 2;
+    if(mdio_dump) {
+        if(mdio_clause != MDIO_MPSSE_C22 || argc != 2) {
+            show_help(argv[0]);
+            return 1;
+        }
+        mdio_len = MDIO_C22_REGS;
+    } else if(!mdio_scan && argc < args + 1) {
+        show_help(argv[0]);
+        return 1;
+    }
+    mdio_phy_adr = mdio_scan ? 0 : (int) strtoul(argv[1], NULL, 0);
+    if(mdio_clause == MDIO_MPSSE_C45 && !mdio_scan)
+        mdio_dev_adr = (int) strtoul(argv[2], NULL, 0);
+    mdio_reg_adr = (mdio_dump || mdio_scan) ? 0 : (int) strtoul(argv[args], NULL, 0);
+    mdio_reg_max = (mdio_clause == MDIO_MPSSE_C45) ? 0xffff : MDIO_C22_REGS - 1;
+    mdio_write_len = (mdio_dump || mdio_scan) ? 0 : argc - args - 1;
+    if(mdio_write_len > MDIO_DATA_LEN_MAX)
+        mdio_write_len = MDIO_DATA_LEN_MAX;
+    if(mdio_phy_adr < 0 || mdio_phy_adr >= MDIO_PHYS || mdio_dev_adr < 0 || mdio_dev_adr > 0x1f) {
+        printf("%sInvalid PHY address 0x%02x or device address 0x%02x. Use 0x00..0x1f.\n", PREFIX_ERROR, mdio_phy_adr, mdio_dev_adr);
+        return 1;
+    }
+    if(mdio_reg_adr < 0 || mdio_reg_adr + (mdio_write_len ? mdio_write_len : mdio_len) - 1 > mdio_reg_max) {
+        printf("%sInvalid register address 0x%04x. Use 0x0000..0x%04x.\n", PREFIX_ERROR, mdio_reg_adr, mdio_reg_max);
+        return 1;
+    }
+
+    // Initialize the MDIO master device.
+    status = mdio_init();
+    if(status) {
+        printf("%sUnable to open the MDIO device.\n", PREFIX_ERROR);
+        return 1;
+    }
+    // Set the MDC frequency.
+    status = mdio_set_freq(mdio_freq);
+    if(status) {
+        printf("%sUnable to set the MDC frequency to %d Hz.\n", PREFIX_ERROR, mdio_freq);
+        return 1;
+    }
+    // Suppress the preamble.
+    if(!mdio_preamble && mdio_set_preamble(0)) {
+        printf("%sUnable to disable the MDIO preamble.\n", PREFIX_ERROR);
+        return 1;
+    }
+    // Set verbosity of the MDIO library functions.
+    mdio_set_verbose(1);
+
+    // Show device information.
+    #if DEBUG_LEVEL >= 1
+    mdio_info();
+    #endif
+
+    // Scan the MDIO bus for PHYs.
+    if(mdio_scan) {
+        status = scan_phys();
+        mdio_close();
+        return status ? 1 : 0;
+    }
+
+    // Access all registers in one batch.
+    if(mdio_write_len)
+        mdio_len = mdio_write_len;
+    ops = calloc(mdio_len, sizeof(struct mdio_mpsse_op));
+    if(ops == NULL) {
+        printf("%sCannot allocate memory for %d register(s).\n", PREFIX_ERROR, mdio_len);
+        mdio_close();
+        return 1;
+    }
+    for(i = 0; i < mdio_len; i++) {
+        ops[i].clause = mdio_clause;
+        ops[i].flags = mdio_write_len ? 0 : MDIO_MPSSE_M_RD;
+        ops[i].phy = mdio_phy_adr;
+        ops[i].dev = mdio_dev_adr;
+        ops[i].reg = mdio_reg_adr + i;
+        ops[i].data = mdio_write_len ? (unsigned int) (strtoul(argv[args + 1 + i], NULL, 0) & 0xffff) : 0;
+    }
+    #if DEBUG_LEVEL >= 3
+    printf("%sMDIO %s of %d register(s) of PHY address 0x%02x, register address 0x%04x.\n", PREFIX_DEBUG, mdio_write_len ? "write" : "read", mdio_len, mdio_phy_adr, mdio_reg_adr);
+    #endif
+    status = mdio_transfer_batch(ops, mdio_len);
+    if(status) {
+        printf("%sUnable to %s %d register(s) of the MDIO PHY address 0x%02x, register address 0x%04x.\n", PREFIX_ERROR, mdio_write_len ? "write" : "read", mdio_len, mdio_phy_adr, mdio_reg_adr);
+        free(ops);
+        mdio_close();
+        return 1;
+    }
+
+    // Print the data read.
+    if(!mdio_write_len) {
+        if(mdio_len == 1) {
+            printf("0x%04x\n", ops[0].data);
+        } else {
+            for(i = 0; i < mdio_len; i++)
+                printf("0x%04x: 0x%04x\n", ops[i].reg, ops[i].data);
+        }
+    }
+    free(ops);
+
+    // Close the MDIO device.
+    mdio_close();
+
+    return 0;
+}
+
+
+
+// Scan the MDIO bus for PHYs. The PHY ID registers (Clause 22 registers 2 and
+// 3) of all PHY addresses are read in one batch.
+int scan_phys(void)
+{
+    int i;
+    int found = 0;
+    struct mdio_mpsse_op ops[2 * MDIO_PHYS];
+
+    for(i = 0; i < 2 * MDIO_PHYS; i++) {
+        ops[i].clause = MDIO_MPSSE_C22;
+        ops[i].flags = MDIO_MPSSE_M_RD;
+        ops[i].phy = i / 2;
+        ops[i].dev = 0;
+        ops[i].reg = 2 + (i % 2);
+        ops[i].data = 0;
+    }
+    // Missing PHYs are expected, so do not report them.
+    mdio_set_verbose(0);
+    mdio_transfer_batch(ops, 2 * MDIO_PHYS);
+    mdio_set_verbose(1);
+
+    for(i = 0; i < MDIO_PHYS; i++) {
+        if(ops[2 * i].status || ops[2 * i + 1].status) continue;
+        printf("PHY address 0x%02x: PHY ID 0x%04x%04x\n", i, ops[2 * i].data, ops[2 * i + 1].data);
+        found++;
+    }
+    if(!found) {
+        printf("%sNo PHY found on the MDIO bus.\n", PREFIX_ERROR);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Show help message.
+int show_help(char* prog_name)
+{
+    printf("Raw MDIO IO control program (read/write)\n");
+    printf("\n");
+    printf("Usage: %s [-s FREQ] [-p] [-i IFACE] [-w WORKLOAD] [-n LEN] PHY-ADR REG-ADR [DATA ...]\n", prog_name);
+    printf("       %s [-s FREQ] [-p] [-i IFACE] [-w WORKLOAD] [-n LEN] -c 45 PRT-ADR DEV-ADR REG-ADR [DATA ...]\n", prog_name);
+    printf("       %s [-s FREQ] [-p] [-i IFACE] -d PHY-ADR\n", prog_name);
+    printf("       %s [-s FREQ] [-p] [-i IFACE] -S\n", prog_name);
+    printf("\n");
+    printf("  -s FREQ        MDC frequency in Hz (default: %d).\n", MDIO_MPSSE_FREQ_DEFAULT);
+    printf("  -p             Suppress the preamble, only if all PHYs support it.\n");
+    printf("  -i IFACE       MPSSE interface of an FT2232H or FT4232H: A (default) .. D.\n");
+    printf("  -w WORKLOAD    Apply the USB settings profile of the workload class: poll (default) or stream.\n");
+    printf("  -c CLAUSE      MDIO frame format: 22 (default) or 45.\n");
+    printf("  -n LEN         Number of consecutive registers to read (default: 1).\n");
+    printf("  -d             Dump all %d Clause 22 registers of the PHY.\n", MDIO_C22_REGS);
+    printf("  -S             Scan the bus and show the PHY IDs of all PHYs found.\n");
+    printf("\n");
+    printf("Several DATA values are written to consecutive registers. All registers are\n");
+    printf("accessed in one USB transfer.\n");
+    return 0;
+}
+
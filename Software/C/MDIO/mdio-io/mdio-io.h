@@ -0,0 +1,48 @@
+// File: mdio-io.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for the raw MDIO IO control program for the FTDI FH232H chip.
+//
+
+
+
+#ifndef __MDIO_IO_H
+#define __MDIO_IO_H
+
+
+
+#include "mdio_mpsse.h"
+
+
+
+// Maximum number of registers accessed in one batch.
+#define MDIO_DATA_LEN_MAX       65536
+
+// Number of Clause 22 registers of a PHY.
+#define MDIO_C22_REGS           32
+
+// Number of PHY addresses on an MDIO bus.
+#define MDIO_PHYS               32
+
+
+
+// Message prefixes.
+#define PREFIX_DEBUG            "DEBUG: "
+#define PREFIX_ERROR            "ERROR: "
+
+
+
+// Level of debug info.
+#define DEBUG_LEVEL 0
+//#define DEBUG_LEVEL 1
+//#define DEBUG_LEVEL 2
+//#define DEBUG_LEVEL 3
+//#define DEBUG_LEVEL 4
+
+
+
+#endif
+
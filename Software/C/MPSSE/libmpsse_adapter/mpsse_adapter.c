@@ -0,0 +1,1055 @@
+// File: mpsse_adapter.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// MPSSE adapter layer. An adapter serializes the access to one FTDI MPSSE
+// interface. Command sequences are queued by any number of threads and merged
+// into combined USB transfers by the thread currently owning the adapter.
+//
+// All protocol engines of a process (I2C, GPIO) using the same interface share
+// the same adapter. The adapter keeps one shadow of the low and high byte pin
+// states, so that e.g. GPIO pin changes and I2C transactions can be sent in
+// the same USB transfer.
+//
+// The FT2232H and the FT4232H have two MPSSE interfaces (A and B), each with
+// its own USB endpoints. Every interface opened gets an adapter of its own,
+// with its own libftdi context, submission stack, lock and command buffers.
+// Threads using different interfaces therefore never wait for each other and
+// the USB transfers of the interfaces are in flight at the same time.
+//
+// Submitting a job works like this:
+// - The job is pushed onto the lock-free submission stack of the adapter.
+// - The thread then acquires the adapter lock. While holding it, the thread
+//   takes all jobs queued so far (including the ones of other threads),
+//   builds their commands into one command buffer and executes it.
+// - Threads waiting for the lock meanwhile find their jobs already done and
+//   return immediately. The more threads compete for an adapter, the more
+//   jobs are merged into a single USB transfer.
+//
+// The libmpsse functions operating on the same MPSSE context are not thread
+// safe (e.g. Write() and Read() use the shared context state, FastRead() and
+// FastWrite() the static fast_rw_buf). They must only be called while holding
+// the adapter lock, see mpsse_adapter_lock().
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpsse.h>
+#include "mpsse_adapter.h"
+
+
+
+// Saved pin and clock states of an adapter, used to roll back a failed build.
+struct mpsse_adapter_state {
+    struct mpsse_pins pins;
+    int clock;
+    int three_phase;
+    int adaptive;
+};
+
+
+
+// Global variables.
+// Open adapters of this process, one per device interface. Each one is shared
+// by all protocol engines using that interface.
+static struct mpsse_adapter *mpsse_adapter_shared = NULL;
+static pthread_mutex_t mpsse_adapter_shared_lock = PTHREAD_MUTEX_INITIALIZER;
+// Serial number of the device to open, empty for the first device found.
+static char mpsse_adapter_serial[MPSSE_ENUM_STR_LEN] = "";
+// Interface of the device to open.
+static int mpsse_adapter_interface = IFACE_A;
+// Workload class of the USB settings profile applied on open, -1 = take it
+// from the environment.
+static int mpsse_adapter_workload = -1;
+// Devices supported by libmpsse, defined in mpsse.c.
+extern struct vid_pid supported_devices[];
+
+
+
+// Function prototypes.
+static int mpsse_cmd_grow(void **ptr, int *size, int count, int elem_size);
+static int mpsse_cmd_close_seg(struct mpsse_cmd *cmd);
+static int mpsse_adapter_build_nop(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int mpsse_adapter_build_delay(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int mpsse_adapter_combine(struct mpsse_adapter *adapter);
+static void mpsse_adapter_save(struct mpsse_adapter *adapter, struct mpsse_adapter_state *state);
+static void mpsse_adapter_restore(struct mpsse_adapter *adapter, struct mpsse_adapter_state *state);
+static int mpsse_adapter_divisor(int freq, int *system_clock);
+static struct mpsse_adapter *mpsse_adapter_open_dev(enum modes mode, int freq, int endianess, const char *serial, int interface, int attach);
+static struct mpsse_context *mpsse_adapter_open_any(enum modes mode, int freq, int endianess, int interface);
+
+
+
+// Select the FTDI device opened by the next call of mpsse_adapter_open() by
+// its serial number. NULL or an empty string selects the first device found.
+int mpsse_adapter_select(const char *serial)
+{
+    if(serial != NULL && strlen(serial) >= MPSSE_ENUM_STR_LEN) {
+        fprintf(stderr, "%s: %s: %sSerial number \"%s\" too long.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, serial);
+        return -1;
+    }
+    pthread_mutex_lock(&mpsse_adapter_shared_lock);
+    strcpy(mpsse_adapter_serial, (serial != NULL) ? serial : "");
+    pthread_mutex_unlock(&mpsse_adapter_shared_lock);
+
+    return 0;
+}
+
+
+
+// Select the interface opened by the next call of mpsse_adapter_open(), e.g.
+// IFACE_B of an FT2232H. The default is IFACE_A, which is the only interface of
+// the FT232H.
+int mpsse_adapter_select_interface(int interface)
+{
+    if(interface == IFACE_ANY)
+        interface = IFACE_A;
+    if(interface < IFACE_A || interface > IFACE_D) {
+        fprintf(stderr, "%s: %s: %sInvalid FTDI interface %d.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, interface);
+        return -1;
+    }
+    pthread_mutex_lock(&mpsse_adapter_shared_lock);
+    mpsse_adapter_interface = interface;
+    pthread_mutex_unlock(&mpsse_adapter_shared_lock);
+
+    return 0;
+}
+
+
+
+// Parse the name of an FTDI interface, "A" .. "D" or "0" .. "3". Returns the
+// interface (IFACE_A .. IFACE_D) or -1 if the name is invalid.
+int mpsse_adapter_parse_interface(const char *name)
+{
+    if(name == NULL || strlen(name) != 1) return -1;
+    if(name[0] >= 'A' && name[0] <= 'D') return IFACE_A + (name[0] - 'A');
+    if(name[0] >= 'a' && name[0] <= 'd') return IFACE_A + (name[0] - 'a');
+    if(name[0] >= '0' && name[0] <= '3') return IFACE_A + (name[0] - '0');
+
+    return -1;
+}
+
+
+
+// Select the workload class of the USB settings profile applied by the next
+// open of an adapter, see mpsse_tune_run(). By default, the workload class is
+// taken from the environment variable MPSSE_TUNE_WORKLOAD_ENV or is
+// MPSSE_TUNE_POLL.
+int mpsse_adapter_select_workload(int workload)
+{
+    if(workload < 0 || workload >= MPSSE_TUNE_WORKLOADS) {
+        fprintf(stderr, "%s: %s: %sInvalid workload class %d.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, workload);
+        return -1;
+    }
+    pthread_mutex_lock(&mpsse_adapter_shared_lock);
+    mpsse_adapter_workload = workload;
+    pthread_mutex_unlock(&mpsse_adapter_shared_lock);
+
+    return 0;
+}
+
+
+
+// Open an MPSSE adapter on the selected FTDI device and interface, see
+// mpsse_adapter_select() and mpsse_adapter_select_interface().
+// The device is looked up in the enumeration cache. Without a selected serial
+// number, the libmpsse device search is used as fallback.
+// If the adapter was already opened by another protocol engine of this
+// process, the same adapter is returned and the mode, frequency and endianess
+// are ignored. The calling engine must then set up its pins and clock itself.
+struct mpsse_adapter *mpsse_adapter_open(enum modes mode, int freq, int endianess)
+{
+    char serial[MPSSE_ENUM_STR_LEN];
+    int interface;
+
+    pthread_mutex_lock(&mpsse_adapter_shared_lock);
+    strcpy(serial, mpsse_adapter_serial);
+    interface = mpsse_adapter_interface;
+    pthread_mutex_unlock(&mpsse_adapter_shared_lock);
+
+    return mpsse_adapter_open_dev(mode, freq, endianess, serial, interface, 0);
+}
+
+
+
+// Open an MPSSE adapter on an explicitly given FTDI device and interface,
+// independent of the selection for mpsse_adapter_open(). This allows e.g. to
+// run the two MPSSE interfaces of an FT2232H from different threads. A serial
+// number of NULL or an empty string selects the first device found. Adapters
+// are shared like with mpsse_adapter_open().
+struct mpsse_adapter *mpsse_adapter_open_if(enum modes mode, int freq, int endianess, const char *serial, int interface)
+{
+    if(serial == NULL)
+        serial = "";
+    if(strlen(serial) >= MPSSE_ENUM_STR_LEN) {
+        fprintf(stderr, "%s: %s: %sSerial number \"%s\" too long.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, serial);
+        return NULL;
+    }
+    if(interface == IFACE_ANY)
+        interface = IFACE_A;
+    if(interface < IFACE_A || interface > IFACE_D) {
+        fprintf(stderr, "%s: %s: %sInvalid FTDI interface %d.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, interface);
+        return NULL;
+    }
+
+    return mpsse_adapter_open_dev(mode, freq, endianess, serial, interface, 0);
+}
+
+
+
+// Attach to an MPSSE adapter. If the device was left in MPSSE mode by a
+// previous attached adapter, its pin states are taken over without changing
+// any pin. Otherwise, the device is set up like with mpsse_adapter_open().
+// When the adapter is closed, the device is left in MPSSE mode and its pin
+// states are recorded, so that the next program can attach to it again.
+// The enumeration cache records the pin states of interface A only. Other
+// interfaces are always set up from scratch.
+struct mpsse_adapter *mpsse_adapter_attach(enum modes mode, int freq, int endianess)
+{
+    struct mpsse_adapter *adapter;
+    char serial[MPSSE_ENUM_STR_LEN];
+    int interface;
+
+    pthread_mutex_lock(&mpsse_adapter_shared_lock);
+    strcpy(serial, mpsse_adapter_serial);
+    interface = mpsse_adapter_interface;
+    pthread_mutex_unlock(&mpsse_adapter_shared_lock);
+
+    adapter = mpsse_adapter_open_dev(mode, freq, endianess, serial, interface, 1);
+    if(adapter != NULL) {
+        pthread_mutex_lock(&mpsse_adapter_shared_lock);
+        adapter->keep = 1;
+        pthread_mutex_unlock(&mpsse_adapter_shared_lock);
+    }
+
+    return adapter;
+}
+
+
+
+// Open or attach to the shared MPSSE adapter of a device interface.
+static struct mpsse_adapter *mpsse_adapter_open_dev(enum modes mode, int freq, int endianess, const char *serial, int interface, int attach)
+{
+    struct mpsse_adapter *adapter;
+    struct mpsse_tune_profile profile;
+    int workload;
+
+    pthread_mutex_lock(&mpsse_adapter_shared_lock);
+
+    // Share the adapter of the interface that is already open. Without a
+    // serial number, any open device matches.
+    for(adapter = mpsse_adapter_shared; adapter != NULL; adapter = adapter->next) {
+        if(adapter->interface != interface) continue;
+        if(!serial[0] || !strcmp(adapter->serial, serial) || (adapter->enumerated && !strcmp(adapter->dev.serial, serial))) {
+            adapter->refcount++;
+            pthread_mutex_unlock(&mpsse_adapter_shared_lock);
+            return adapter;
+        }
+    }
+
+    adapter = malloc(sizeof(struct mpsse_adapter));
+    if(adapter == NULL) {
+        fprintf(stderr, "%s: %s: %sCannot allocate memory for the MPSSE adapter.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        pthread_mutex_unlock(&mpsse_adapter_shared_lock);
+        return NULL;
+    }
+    memset(adapter, 0, sizeof(struct mpsse_adapter));
+    strcpy(adapter->serial, serial);
+    adapter->interface = interface;
+    adapter->verbose = 1;
+    mpsse_cmd_init(&adapter->cmd);
+    mpsse_cmd_init(&adapter->pending);
+
+    adapter->mpsse = mpsse_enum_open(mode, freq, endianess, serial[0] ? serial : NULL, interface, attach, &adapter->dev);
+    if(adapter->mpsse != NULL) {
+        adapter->enumerated = 1;
+    } else if(serial[0]) {
+        fprintf(stderr, "%s: %s: %sFailed to open interface %c of the FTDI device with serial number \"%s\".\n", __FILE__, __FUNCTION__, PREFIX_ERROR, 'A' + interface - IFACE_A, serial);
+        free(adapter);
+        pthread_mutex_unlock(&mpsse_adapter_shared_lock);
+        return NULL;
+    } else if(!((adapter->mpsse = mpsse_adapter_open_any(mode, freq, endianess, interface)) != NULL && adapter->mpsse->open))
+    {
+        fprintf(stderr, "%s: %s: %sFailed to initialize MPSSE: %s\n", __FILE__, __FUNCTION__, PREFIX_ERROR, ErrorString(adapter->mpsse));
+        Close(adapter->mpsse);
+        free(adapter);
+        pthread_mutex_unlock(&mpsse_adapter_shared_lock);
+        return NULL;
+    }
+
+    // Take over the pin states set up by libmpsse or read back when attaching.
+    adapter->pins.low = adapter->mpsse->pidle;
+    adapter->pins.low_dir = adapter->mpsse->tris;
+    adapter->pins.high = adapter->mpsse->gpioh;
+    adapter->pins.high_dir = adapter->mpsse->trish;
+
+    // Apply the USB settings tuned for the device interface. libmpsse sets the
+    // latency timer to LATENCY_MS, an attached device may have kept another
+    // value.
+    adapter->latency = attach ? -1 : LATENCY_MS;
+    workload = (mpsse_adapter_workload < 0) ? mpsse_tune_default_workload() : mpsse_adapter_workload;
+    if(mpsse_tune_load(adapter->enumerated ? adapter->dev.serial : adapter->serial, interface, workload, &profile) == 0)
+        mpsse_tune_apply(adapter, &profile);
+
+    pthread_mutex_init(&adapter->lock, NULL);
+    adapter->waiters = 0;
+    adapter->refcount = 1;
+    adapter->next = mpsse_adapter_shared;
+    mpsse_adapter_shared = adapter;
+
+    pthread_mutex_unlock(&mpsse_adapter_shared_lock);
+
+    return adapter;
+}
+
+
+
+// Open the first device supported by libmpsse on the given interface. This
+// works like MPSSE() of libmpsse, which always uses interface A.
+static struct mpsse_context *mpsse_adapter_open_any(enum modes mode, int freq, int endianess, int interface)
+{
+    int i;
+    struct mpsse_context *mpsse = NULL;
+
+    for(i = 0; supported_devices[i].vid != 0; i++) {
+        mpsse = Open(supported_devices[i].vid, supported_devices[i].pid, mode, freq, endianess, interface, NULL, NULL);
+        if(mpsse == NULL) continue;
+        if(mpsse->open) {
+            mpsse->description = supported_devices[i].description;
+            break;
+        }
+        // Keep the context of the last device tried for the error message.
+        if(supported_devices[i+1].vid != 0) {
+            Close(mpsse);
+            mpsse = NULL;
+        }
+    }
+
+    return mpsse;
+}
+
+
+
+// Close an MPSSE adapter. The device is closed when the last protocol engine
+// using the adapter closes it. An attached adapter leaves the device in MPSSE
+// mode with its pins unchanged, otherwise the bit mode is reset.
+// CAUTION: No other thread may use the adapter any more when calling this.
+void mpsse_adapter_close(struct mpsse_adapter *adapter)
+{
+    struct mpsse_adapter **prev;
+
+    if(adapter == NULL) return;
+
+    pthread_mutex_lock(&mpsse_adapter_shared_lock);
+    if(--adapter->refcount > 0) {
+        pthread_mutex_unlock(&mpsse_adapter_shared_lock);
+        return;
+    }
+    for(prev = &mpsse_adapter_shared; *prev != NULL; prev = &(*prev)->next) {
+        if(*prev == adapter) {
+            *prev = adapter->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&mpsse_adapter_shared_lock);
+
+    // Send out commands that are still deferred.
+    mpsse_adapter_flush(adapter);
+
+    if(adapter->keep) {
+        // Close the USB device without resetting the bit mode and record the
+        // pin states for the next attach. The cache only holds the state of
+        // interface A.
+        ftdi_usb_close(&adapter->mpsse->ftdi);
+        ftdi_deinit(&adapter->mpsse->ftdi);
+        free(adapter->mpsse);
+        if(adapter->enumerated && adapter->interface == IFACE_A) {
+            adapter->dev.low = adapter->pins.low;
+            adapter->dev.low_dir = adapter->pins.low_dir;
+            adapter->dev.high = adapter->pins.high;
+            adapter->dev.high_dir = adapter->pins.high_dir;
+            mpsse_enum_set_state(&adapter->dev, MPSSE_ENUM_STATE_MPSSE);
+        }
+    } else {
+        // A cleanly closed device is expected to have the default latency
+        // timer.
+        if(adapter->latency != LATENCY_MS)
+            ftdi_set_latency_timer(&adapter->mpsse->ftdi, LATENCY_MS);
+        Close(adapter->mpsse);
+        // The device was reset cleanly, so the next open can skip the reset.
+        if(adapter->enumerated && adapter->interface == IFACE_A)
+            mpsse_enum_set_state(&adapter->dev, MPSSE_ENUM_STATE_IDLE);
+    }
+    mpsse_cmd_free(&adapter->cmd);
+    mpsse_cmd_free(&adapter->pending);
+    pthread_mutex_destroy(&adapter->lock);
+    free(adapter);
+}
+
+
+
+// Get exclusive access to the adapter, e.g. for calling libmpsse functions
+// directly. The waiter count tells a thread streaming on the adapter, e.g. a
+// GPIO event monitor, to hand over the lock.
+void mpsse_adapter_lock(struct mpsse_adapter *adapter)
+{
+    __atomic_add_fetch(&adapter->waiters, 1, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&adapter->lock);
+    __atomic_sub_fetch(&adapter->waiters, 1, __ATOMIC_RELEASE);
+}
+
+
+
+// Release the exclusive access to the adapter.
+void mpsse_adapter_unlock(struct mpsse_adapter *adapter)
+{
+    pthread_mutex_unlock(&adapter->lock);
+}
+
+
+
+// Submit a job to the adapter and wait until it was executed.
+int mpsse_adapter_submit(struct mpsse_adapter *adapter, struct mpsse_job *job)
+{
+    struct mpsse_job *head;
+
+    job->status = -1;
+    job->done = 0;
+
+    // Push the job onto the submission stack.
+    head = __atomic_load_n(&adapter->queue, __ATOMIC_RELAXED);
+    do {
+        job->next = head;
+    } while(!__atomic_compare_exchange_n(&adapter->queue, &head, job, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    // Execute the queued jobs until our own one is done. Most of the time,
+    // this happens in the first round or another thread has already done it.
+    pthread_mutex_lock(&adapter->lock);
+    while(!job->done)
+        mpsse_adapter_combine(adapter);
+    pthread_mutex_unlock(&adapter->lock);
+
+    return job->status;
+}
+
+
+
+// Run a single build function as job on the adapter.
+int mpsse_adapter_run(struct mpsse_adapter *adapter, int (*build)(struct mpsse_adapter *, struct mpsse_cmd *, void *), void *arg)
+{
+    struct mpsse_job job;
+
+    job.build = build;
+    job.arg = arg;
+
+    return mpsse_adapter_submit(adapter, &job);
+}
+
+
+
+// Build commands without executing them. They are sent at the beginning of
+// the next USB transfer, together with the next job submitted by any thread.
+// The commands must not read back any data.
+int mpsse_adapter_defer(struct mpsse_adapter *adapter, int (*build)(struct mpsse_adapter *, struct mpsse_cmd *, void *), void *arg)
+{
+    int status;
+    struct mpsse_cmd_mark mark;
+    struct mpsse_adapter_state state;
+
+    mpsse_adapter_lock(adapter);
+    mpsse_cmd_save(&adapter->pending, &mark);
+    mpsse_adapter_save(adapter, &state);
+    status = build(adapter, &adapter->pending, arg);
+    if(!status && adapter->pending.rx_count != mark.rx_count)
+        status = -1;
+    if(status) {
+        mpsse_cmd_restore(&adapter->pending, &mark);
+        mpsse_adapter_restore(adapter, &state);
+    }
+    mpsse_adapter_unlock(adapter);
+
+    return status;
+}
+
+
+
+// Build nothing.
+static int mpsse_adapter_build_nop(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    return 0;
+}
+
+
+
+// Send all deferred and queued commands to the MPSSE.
+int mpsse_adapter_flush(struct mpsse_adapter *adapter)
+{
+    return mpsse_adapter_run(adapter, mpsse_adapter_build_nop, NULL);
+}
+
+
+
+// Queue a hardware-timed delay. It is executed by the MPSSE at the beginning
+// of the next USB transfer on the adapter, after the commands queued before,
+// e.g. between GPIO pin changes queued with gpio_queue_pins() and the next
+// I2C transaction.
+int mpsse_adapter_queue_delay(struct mpsse_adapter *adapter, int usec)
+{
+    if(adapter == NULL) return -1;
+
+    return mpsse_adapter_defer(adapter, mpsse_adapter_build_delay, &usec);
+}
+
+
+
+// Build a delay queued with mpsse_adapter_queue_delay().
+static int mpsse_adapter_build_delay(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    return mpsse_adapter_delay(adapter, cmd, *((int *) arg));
+}
+
+
+
+// Append a delay of usec microseconds, timed by the MPSSE. The MPSSE clocks
+// SK without transferring data (commands 0x8F and 0x8E), so the delay takes
+// no USB transfer of its own and is exact to one clock period. The delay is
+// rounded up to whole clock periods.
+// CAUTION: SK (ADBUS0) toggles during the delay! On an idle I2C bus, SDA stays
+// high, so no target sees a start or stop condition.
+// CAUTION: Must only be called from a build function!
+int mpsse_adapter_delay(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, int usec)
+{
+    int status = 0;
+    long long bits, bytes, n;
+    unsigned char buf[3];
+
+    if(usec < 0 || usec > MPSSE_ADAPTER_DELAY_MAX) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sInvalid delay of %d us. Use 0..%d us.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, usec, MPSSE_ADAPTER_DELAY_MAX);
+        return -1;
+    }
+    if(usec == 0) return 0;
+
+    // Use a clock fast enough for microsecond delays. The I2C engine restores
+    // its own clock before the next transaction.
+    if(adapter->mpsse->clock < MPSSE_ADAPTER_DELAY_CLOCK_MIN)
+        status |= mpsse_adapter_set_clock(cmd, adapter->mpsse, MPSSE_ADAPTER_DELAY_CLOCK);
+
+    // Number of clock cycles. With three phase clocking, each bit takes 1.5
+    // clock periods.
+    bits = ((long long) usec * adapter->mpsse->clock + 999999) / 1000000;
+    if(adapter->three_phase)
+        bits = (2 * bits + 2) / 3;
+    if(bits < 1)
+        bits = 1;
+
+    // Clock whole bytes, up to 65536 per command, then the remaining bits.
+    for(bytes = bits / 8; bytes > 0; bytes -= n) {
+        n = (bytes > 0x10000) ? 0x10000 : bytes;
+        buf[0] = CLK_BYTES;
+        buf[1] = (n - 1) & 0xff;
+        buf[2] = ((n - 1) >> 8) & 0xff;
+        status |= mpsse_cmd_bytes(cmd, buf, 3);
+    }
+    if(bits % 8) {
+        buf[0] = CLK_BITS;
+        buf[1] = bits % 8 - 1;
+        status |= mpsse_cmd_bytes(cmd, buf, 2);
+    }
+
+    return status ? -1 : 0;
+}
+
+
+
+// Set the low byte pins selected by mask and keep all others.
+// CAUTION: Must only be called from a build function!
+int mpsse_adapter_set_low(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, unsigned char value, unsigned char direction, unsigned char mask)
+{
+    adapter->pins.low = (adapter->pins.low & ~mask) | (value & mask);
+    adapter->pins.low_dir = (adapter->pins.low_dir & ~mask) | (direction & mask);
+
+    return mpsse_cmd_set_bits_low(cmd, adapter->pins.low, adapter->pins.low_dir);
+}
+
+
+
+// Set the high byte pins selected by mask and keep all others.
+// CAUTION: Must only be called from a build function!
+int mpsse_adapter_set_high(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, unsigned char value, unsigned char direction, unsigned char mask)
+{
+    adapter->pins.high = (adapter->pins.high & ~mask) | (value & mask);
+    adapter->pins.high_dir = (adapter->pins.high_dir & ~mask) | (direction & mask);
+
+    return mpsse_cmd_set_bits_high(cmd, adapter->pins.high, adapter->pins.high_dir);
+}
+
+
+
+// Select the pins that are only driven low and tristated instead of being
+// driven high. This is only supported by the FT232H.
+// CAUTION: Must only be called from a build function!
+int mpsse_adapter_set_open_drain(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, unsigned char low, unsigned char high)
+{
+    unsigned char buf[3];
+
+    buf[0] = DRIVE_OPEN_COLLECTOR;
+    buf[1] = low;
+    buf[2] = high;
+    if(mpsse_cmd_bytes(cmd, buf, 3)) return -1;
+
+    adapter->pins.low_od = low;
+    adapter->pins.high_od = high;
+
+    return 0;
+}
+
+
+
+// Enable or disable adaptive clocking. With adaptive clocking, the MPSSE waits
+// for each clock edge to be returned on GPIOL3 (RTCK) before continuing. This
+// makes the clock follow a target that holds the clock line low. GPIOL3 is
+// made an input.
+// CAUTION: Must only be called from a build function!
+int mpsse_adapter_set_adaptive(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, int enable)
+{
+    int status = 0;
+
+    if(enable)
+        status |= mpsse_adapter_set_low(adapter, cmd, 0, 0, GPIO3);
+    status |= mpsse_cmd_byte(cmd, enable ? EN_ADAPTIVE : DIS_ADAPTIVE);
+    if(status) return -1;
+
+    adapter->adaptive = enable ? 1 : 0;
+
+    return 0;
+}
+
+
+
+// Execute all jobs queued on the adapter in one combined transfer.
+// CAUTION: The adapter lock must be held when calling this function!
+static int mpsse_adapter_combine(struct mpsse_adapter *adapter)
+{
+    int status;
+    int pending;
+    struct mpsse_job *jobs, *job, *prev, *next;
+    struct mpsse_cmd_mark mark;
+    struct mpsse_adapter_state state;
+
+    // Take all queued jobs and restore their submission order.
+    jobs = __atomic_exchange_n(&adapter->queue, NULL, __ATOMIC_ACQUIRE);
+    if(jobs == NULL) return 0;
+    prev = NULL;
+    for(job = jobs; job != NULL; job = next) {
+        next = job->next;
+        job->next = prev;
+        prev = job;
+    }
+    jobs = prev;
+
+    // Start with the deferred commands. Then build the commands of all jobs
+    // into the same command buffer. A job that fails to build is rolled back,
+    // including the pin and clock states it has changed, and does not affect
+    // the others. If the deferred commands cannot be taken over, all jobs
+    // fail, as they rely on the deferred commands being executed before. The
+    // deferred commands are then kept for the next transfer.
+    mpsse_cmd_reset(&adapter->cmd);
+    pending = 0;
+    if(adapter->pending.len > 0) {
+        pending = mpsse_cmd_bytes(&adapter->cmd, adapter->pending.buf, adapter->pending.len);
+        if(pending) {
+            if(adapter->verbose)
+                fprintf(stderr, "%s: %s: %sUnable to add %d deferred command byte(s).\n", __FILE__, __FUNCTION__, PREFIX_ERROR, adapter->pending.len);
+        } else {
+            mpsse_cmd_reset(&adapter->pending);
+        }
+    }
+    for(job = jobs; job != NULL; job = job->next) {
+        mpsse_cmd_save(&adapter->cmd, &mark);
+        mpsse_adapter_save(adapter, &state);
+        job->status = job->build(adapter, &adapter->cmd, job->arg);
+        job->status |= pending;
+        if(job->status) {
+            mpsse_cmd_restore(&adapter->cmd, &mark);
+            mpsse_adapter_restore(adapter, &state);
+        }
+    }
+
+    // Execute the command buffer.
+    status = mpsse_cmd_execute(&adapter->cmd, adapter->mpsse);
+    if(status && adapter->verbose)
+        fprintf(stderr, "%s: %s: %sUSB transfer to the MPSSE failed: %s\n", __FILE__, __FUNCTION__, PREFIX_ERROR, ErrorString(adapter->mpsse));
+
+    // Mark the jobs as done. Do not touch a job after setting done, as the
+    // submitting thread may release it right away.
+    for(job = jobs; job != NULL; job = next) {
+        next = job->next;
+        if(status) job->status = -1;
+        job->done = 1;
+    }
+
+    return status;
+}
+
+
+
+// Save the pin and clock states of an adapter before building a job.
+// CAUTION: The adapter lock must be held when calling this function!
+static void mpsse_adapter_save(struct mpsse_adapter *adapter, struct mpsse_adapter_state *state)
+{
+    state->pins = adapter->pins;
+    state->clock = adapter->mpsse->clock;
+    state->three_phase = adapter->three_phase;
+    state->adaptive = adapter->adaptive;
+}
+
+
+
+// Restore the pin and clock states of an adapter after a failed build, as
+// the commands changing them are rolled back as well.
+// CAUTION: The adapter lock must be held when calling this function!
+static void mpsse_adapter_restore(struct mpsse_adapter *adapter, struct mpsse_adapter_state *state)
+{
+    adapter->pins = state->pins;
+    adapter->mpsse->clock = state->clock;
+    adapter->three_phase = state->three_phase;
+    adapter->adaptive = state->adaptive;
+}
+
+
+
+// Get the MPSSE clock divisor and system clock for a clock frequency.
+static int mpsse_adapter_divisor(int freq, int *system_clock)
+{
+    int divisor;
+
+    *system_clock = (freq > SIX_MHZ) ? SIXTY_MHZ : TWELVE_MHZ;
+    if(freq <= 0)
+        divisor = 0xffff;
+    else
+        divisor = ((*system_clock / freq) / 2) - 1;
+    if(divisor < 0) divisor = 0;
+    if(divisor > 0xffff) divisor = 0xffff;
+
+    return divisor;
+}
+
+
+
+// Get the MPSSE clock frequency that is actually set when requesting a clock
+// frequency. Used for checking if the clock needs to be changed.
+int mpsse_adapter_get_clock(int freq)
+{
+    int system_clock;
+    int divisor;
+
+    divisor = mpsse_adapter_divisor(freq, &system_clock);
+
+    return system_clock / ((1 + divisor) * 2);
+}
+
+
+
+// Append the commands for setting the MPSSE clock frequency.
+int mpsse_adapter_set_clock(struct mpsse_cmd *cmd, struct mpsse_context *mpsse, int freq)
+{
+    int system_clock;
+    int divisor;
+    unsigned char buf[4];
+
+    divisor = mpsse_adapter_divisor(freq, &system_clock);
+    buf[0] = (system_clock == SIXTY_MHZ) ? DIS_DIV_5 : EN_DIV_5;
+    buf[1] = TCK_DIVISOR;
+    buf[2] = divisor & 0xff;
+    buf[3] = (divisor >> 8) & 0xff;
+    if(mpsse_cmd_bytes(cmd, buf, 4)) return -1;
+
+    mpsse->clock = system_clock / ((1 + divisor) * 2);
+
+    return 0;
+}
+
+
+
+// Initialize a command buffer.
+void mpsse_cmd_init(struct mpsse_cmd *cmd)
+{
+    memset(cmd, 0, sizeof(struct mpsse_cmd));
+}
+
+
+
+// Free the memory of a command buffer.
+void mpsse_cmd_free(struct mpsse_cmd *cmd)
+{
+    free(cmd->buf);
+    free(cmd->rx);
+    free(cmd->seg);
+    free(cmd->rx_buf);
+    mpsse_cmd_init(cmd);
+}
+
+
+
+// Clear a command buffer. The memory is kept for reuse.
+void mpsse_cmd_reset(struct mpsse_cmd *cmd)
+{
+    cmd->len = 0;
+    cmd->rx_count = 0;
+    cmd->rx_len = 0;
+    cmd->seg_count = 0;
+    cmd->seg_rx_len = 0;
+}
+
+
+
+// Save the state of a command buffer.
+void mpsse_cmd_save(struct mpsse_cmd *cmd, struct mpsse_cmd_mark *mark)
+{
+    mark->len = cmd->len;
+    mark->rx_count = cmd->rx_count;
+    mark->rx_len = cmd->rx_len;
+    mark->seg_count = cmd->seg_count;
+    mark->seg_rx_len = cmd->seg_rx_len;
+}
+
+
+
+// Roll back a command buffer to a saved state.
+void mpsse_cmd_restore(struct mpsse_cmd *cmd, struct mpsse_cmd_mark *mark)
+{
+    cmd->len = mark->len;
+    cmd->rx_count = mark->rx_count;
+    cmd->rx_len = mark->rx_len;
+    cmd->seg_count = mark->seg_count;
+    cmd->seg_rx_len = mark->seg_rx_len;
+}
+
+
+
+// Make room for count elements in a dynamically allocated array.
+static int mpsse_cmd_grow(void **ptr, int *size, int count, int elem_size)
+{
+    int size_new;
+    void *ptr_new;
+
+    if(count <= *size) return 0;
+
+    size_new = *size ? *size : 256;
+    while(size_new < count)
+        size_new *= 2;
+    ptr_new = realloc(*ptr, (size_t) size_new * elem_size);
+    if(ptr_new == NULL) return -1;
+    *ptr = ptr_new;
+    *size = size_new;
+
+    return 0;
+}
+
+
+
+// Append one byte to a command buffer.
+int mpsse_cmd_byte(struct mpsse_cmd *cmd, unsigned char data)
+{
+    if(mpsse_cmd_grow((void **) &cmd->buf, &cmd->size, cmd->len + 1, 1)) return -1;
+    cmd->buf[cmd->len++] = data;
+
+    return 0;
+}
+
+
+
+// Append several bytes to a command buffer.
+int mpsse_cmd_bytes(struct mpsse_cmd *cmd, const unsigned char *data, int len)
+{
+    if(mpsse_cmd_grow((void **) &cmd->buf, &cmd->size, cmd->len + len, 1)) return -1;
+    memcpy(cmd->buf + cmd->len, data, len);
+    cmd->len += len;
+
+    return 0;
+}
+
+
+
+// Append a prebuilt command buffer, including its read-back entries and USB
+// transfer segments. The read-back data is delivered to the destinations
+// registered in the template. Used for replaying command templates without
+// building them again.
+int mpsse_cmd_append(struct mpsse_cmd *cmd, const struct mpsse_cmd *tmpl)
+{
+    int i;
+    int len, rx_len;
+    int first_rx_len;
+
+    // Start a new USB transfer, if the read-back data of the first segment of
+    // the template does not fit into the current one.
+    first_rx_len = (tmpl->seg_count > 0) ? tmpl->seg[0].rx_len : tmpl->rx_len;
+    if(first_rx_len > 0 && cmd->seg_rx_len + first_rx_len > MPSSE_ADAPTER_RX_CHUNK)
+        if(mpsse_cmd_close_seg(cmd)) return -1;
+
+    if(mpsse_cmd_grow((void **) &cmd->rx, &cmd->rx_size, cmd->rx_count + tmpl->rx_count, sizeof(struct mpsse_cmd_rx))) return -1;
+    if(mpsse_cmd_grow((void **) &cmd->seg, &cmd->seg_size, cmd->seg_count + tmpl->seg_count, sizeof(struct mpsse_cmd_seg))) return -1;
+    len = cmd->len;
+    rx_len = cmd->rx_len;
+    if(mpsse_cmd_bytes(cmd, tmpl->buf, tmpl->len)) return -1;
+
+    memcpy(cmd->rx + cmd->rx_count, tmpl->rx, tmpl->rx_count * sizeof(struct mpsse_cmd_rx));
+    cmd->rx_count += tmpl->rx_count;
+    cmd->rx_len += tmpl->rx_len;
+    for(i = 0; i < tmpl->seg_count; i++) {
+        cmd->seg[cmd->seg_count].len = len + tmpl->seg[i].len;
+        cmd->seg[cmd->seg_count].rx_len = rx_len + tmpl->seg[i].rx_len;
+        cmd->seg_count++;
+    }
+    if(tmpl->seg_count > 0)
+        cmd->seg_rx_len = tmpl->seg_rx_len;
+    else
+        cmd->seg_rx_len += tmpl->seg_rx_len;
+
+    return 0;
+}
+
+
+
+// Append a command setting the value and direction of the low byte pins.
+int mpsse_cmd_set_bits_low(struct mpsse_cmd *cmd, unsigned char value, unsigned char direction)
+{
+    unsigned char buf[3] = {SET_BITS_LOW, value, direction};
+
+    return mpsse_cmd_bytes(cmd, buf, 3);
+}
+
+
+
+// Append a command setting the value and direction of the high byte pins.
+int mpsse_cmd_set_bits_high(struct mpsse_cmd *cmd, unsigned char value, unsigned char direction)
+{
+    unsigned char buf[3] = {SET_BITS_HIGH, value, direction};
+
+    return mpsse_cmd_bytes(cmd, buf, 3);
+}
+
+
+
+// Register len bytes of read-back data for the command appended next.
+// If the read-back data of the current USB transfer would exceed
+// MPSSE_ADAPTER_RX_CHUNK bytes, a new USB transfer is started. Therefore,
+// this function must be called *before* appending the command that produces
+// the data.
+int mpsse_cmd_read(struct mpsse_cmd *cmd, unsigned char *data, int len, int *nack)
+{
+    if(len <= 0 || len > MPSSE_ADAPTER_RX_CHUNK) return -1;
+
+    if(cmd->seg_rx_len + len > MPSSE_ADAPTER_RX_CHUNK)
+        if(mpsse_cmd_close_seg(cmd)) return -1;
+
+    if(mpsse_cmd_grow((void **) &cmd->rx, &cmd->rx_size, cmd->rx_count + 1, sizeof(struct mpsse_cmd_rx))) return -1;
+    cmd->rx[cmd->rx_count].data = data;
+    cmd->rx[cmd->rx_count].len = len;
+    cmd->rx[cmd->rx_count].nack = nack;
+    cmd->rx[cmd->rx_count].mask = 0;
+    cmd->rx_count++;
+    cmd->rx_len += len;
+    cmd->seg_rx_len += len;
+
+    return 0;
+}
+
+
+
+// Register one pin sample for the command appended next, usually
+// GET_BITS_LOW or GET_BITS_HIGH. Only the pin selected by the mask is used:
+// its level is shifted into data from the LSB side, so that 8 samples
+// assemble one byte, MSB first. If nack is not NULL, a high level is counted
+// as NACK. Used for sampling a data line that is not connected to the MPSSE
+// data input.
+int mpsse_cmd_read_bit(struct mpsse_cmd *cmd, unsigned char *data, unsigned char mask, int *nack)
+{
+    if(mask == 0) return -1;
+    if(mpsse_cmd_read(cmd, data, 1, nack)) return -1;
+
+    cmd->rx[cmd->rx_count - 1].mask = mask;
+
+    return 0;
+}
+
+
+
+// Close the current USB transfer segment of a command buffer.
+static int mpsse_cmd_close_seg(struct mpsse_cmd *cmd)
+{
+    // Make the MPSSE send the read-back data of this segment right away
+    // instead of waiting for the latency timer.
+    if(cmd->seg_rx_len > 0)
+        if(mpsse_cmd_byte(cmd, SEND_IMMEDIATE)) return -1;
+
+    if(mpsse_cmd_grow((void **) &cmd->seg, &cmd->seg_size, cmd->seg_count + 1, sizeof(struct mpsse_cmd_seg))) return -1;
+    cmd->seg[cmd->seg_count].len = cmd->len;
+    cmd->seg[cmd->seg_count].rx_len = cmd->rx_len;
+    cmd->seg_count++;
+    cmd->seg_rx_len = 0;
+
+    return 0;
+}
+
+
+
+// Execute a command buffer and distribute the read-back data.
+int mpsse_cmd_execute(struct mpsse_cmd *cmd, struct mpsse_context *mpsse)
+{
+    int i, j;
+    int n, r, retries;
+    int len, rx_len;
+    unsigned char *rx_ptr;
+
+    if(cmd->len == 0) return 0;
+    if(mpsse == NULL || !mpsse->open) return -1;
+
+    if(mpsse_cmd_close_seg(cmd)) return -1;
+    if(mpsse_cmd_grow((void **) &cmd->rx_buf, &cmd->rx_buf_size, cmd->rx_len, 1)) return -1;
+
+    // Write the commands and read back the data segment by segment.
+    len = 0;
+    rx_len = 0;
+    for(i = 0; i < cmd->seg_count; i++) {
+        n = cmd->seg[i].len - len;
+        if(n > 0 && ftdi_write_data(&mpsse->ftdi, cmd->buf + len, n) != n) return -1;
+        len = cmd->seg[i].len;
+        retries = 0;
+        while(rx_len < cmd->seg[i].rx_len) {
+            r = ftdi_read_data(&mpsse->ftdi, cmd->rx_buf + rx_len, cmd->seg[i].rx_len - rx_len);
+            if(r < 0) return -1;
+            if(r == 0 && ++retries > MPSSE_ADAPTER_READ_RETRIES) return -1;
+            rx_len += r;
+        }
+    }
+
+    // Distribute the read-back data.
+    rx_ptr = cmd->rx_buf;
+    for(i = 0; i < cmd->rx_count; i++) {
+        if(cmd->rx[i].mask) {
+            if(cmd->rx[i].nack != NULL && (rx_ptr[0] & cmd->rx[i].mask))
+                (*cmd->rx[i].nack)++;
+            if(cmd->rx[i].data != NULL)
+                *cmd->rx[i].data = (*cmd->rx[i].data << 1) | ((rx_ptr[0] & cmd->rx[i].mask) ? 1 : 0);
+            rx_ptr++;
+            continue;
+        }
+        if(cmd->rx[i].nack != NULL) {
+            for(j = 0; j < cmd->rx[i].len; j++)
+                if(rx_ptr[j] & 0x01) (*cmd->rx[i].nack)++;
+        }
+        if(cmd->rx[i].data != NULL)
+            memcpy(cmd->rx[i].data, rx_ptr, cmd->rx[i].len);
+        rx_ptr += cmd->rx[i].len;
+    }
+
+    return 0;
+}
+
@@ -0,0 +1,208 @@
+// File: mpsse_adapter.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for the MPSSE adapter layer. An adapter serializes the access
+// to one FTDI MPSSE interface. Command sequences are queued by any number of
+// threads and merged into combined USB transfers by the thread currently
+// owning the adapter. The adapter is shared by all protocol engines (I2C,
+// MDIO, SWD, GPIO) of a process using the same interface and keeps the single
+// pin state model of the interface. The interfaces of multi-channel chips
+// (FT2232H, FT4232H) get adapters of their own, which run independently of
+// each other.
+//
+
+
+
+#ifndef __MPSSE_ADAPTER_H
+#define __MPSSE_ADAPTER_H
+
+
+
+#include <pthread.h>
+#include <mpsse.h>
+#include "mpsse_enum.h"
+#include "mpsse_tune.h"
+
+
+
+// Message prefixes.
+#define PREFIX_DEBUG            "DEBUG: "
+#define PREFIX_ERROR            "ERROR: "
+
+
+
+// Maximum number of bytes read back from the MPSSE per USB transfer. The
+// FT232H transmit buffer holds 1 kB. Staying well below that ensures that the
+// MPSSE never stalls on a full buffer while the host is still writing.
+#define MPSSE_ADAPTER_RX_CHUNK          512
+
+// Number of empty USB reads before a read is considered to have timed out.
+#define MPSSE_ADAPTER_READ_RETRIES      1000
+
+// Hardware-timed delays, see mpsse_adapter_delay(). Delays are clocked at the
+// current MPSSE clock if it is at least MPSSE_ADAPTER_DELAY_CLOCK_MIN, else
+// the clock is set to MPSSE_ADAPTER_DELAY_CLOCK first. The data read back after
+// a delay arrives late by the delay, so it must stay well below the read
+// timeout of MPSSE_ADAPTER_READ_RETRIES empty reads, each taking about one
+// latency timer period.
+#define MPSSE_ADAPTER_DELAY_CLOCK       1000000
+#define MPSSE_ADAPTER_DELAY_CLOCK_MIN   100000
+#define MPSSE_ADAPTER_DELAY_MAX         500000      // us
+
+// Protocol engines, used to track which engines have set up the adapter.
+#define MPSSE_ADAPTER_ENGINE_I2C        0x01
+#define MPSSE_ADAPTER_ENGINE_GPIO       0x02
+#define MPSSE_ADAPTER_ENGINE_MDIO       0x04
+#define MPSSE_ADAPTER_ENGINE_SWD        0x08
+// Engines using the serial pins ADBUS0 .. ADBUS2. Only one of them can be set
+// up on an adapter.
+#define MPSSE_ADAPTER_ENGINES_SERIAL    (MPSSE_ADAPTER_ENGINE_I2C | MPSSE_ADAPTER_ENGINE_MDIO | MPSSE_ADAPTER_ENGINE_SWD)
+
+
+
+// Read-back entry of a command buffer.
+struct mpsse_cmd_rx {
+    unsigned char *data;        // Destination of the bytes read, NULL to discard them.
+    int len;                    // Number of bytes read.
+    int *nack;                  // If not NULL, count the bytes with bit 0 set (I2C NACK).
+    unsigned char mask;         // If not 0, only use the pin selected by the mask, see mpsse_cmd_read_bit().
+};
+
+// Boundary of a USB transfer within a command buffer.
+struct mpsse_cmd_seg {
+    int len;                    // End offset in the command buffer.
+    int rx_len;                 // End offset in the read-back data.
+};
+
+// MPSSE command buffer.
+struct mpsse_cmd {
+    // Commands.
+    unsigned char *buf;
+    int len;
+    int size;
+    // Read-back entries.
+    struct mpsse_cmd_rx *rx;
+    int rx_count;
+    int rx_size;
+    int rx_len;                 // Total number of bytes read back.
+    // USB transfer segments.
+    struct mpsse_cmd_seg *seg;
+    int seg_count;
+    int seg_size;
+    int seg_rx_len;             // Bytes read back in the currently open segment.
+    // Buffer for the read-back data.
+    unsigned char *rx_buf;
+    int rx_buf_size;
+};
+
+// Saved state of a command buffer, used to roll back a failed build.
+struct mpsse_cmd_mark {
+    int len;
+    int rx_count;
+    int rx_len;
+    int seg_count;
+    int seg_rx_len;
+};
+
+// Pin states of the MPSSE interface, shared by all protocol engines. Each
+// engine only changes the pins it owns and keeps all others as they are.
+struct mpsse_pins {
+    unsigned char low;          // Output levels of the low byte pins (ADBUS).
+    unsigned char low_dir;      // Directions of the low byte pins (1 = output).
+    unsigned char high;         // Output levels of the high byte pins (ACBUS).
+    unsigned char high_dir;     // Directions of the high byte pins (1 = output).
+    unsigned char low_od;       // Open drain low byte pins (1 = only drive zero, FT232H only).
+    unsigned char high_od;      // Open drain high byte pins (1 = only drive zero, FT232H only).
+};
+
+struct mpsse_adapter;
+
+// Job queued for execution on an adapter.
+struct mpsse_job {
+    // Append the commands of the job to the command buffer.
+    int (*build)(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+    void *arg;
+    int status;
+    int done;
+    struct mpsse_job *next;
+};
+
+// MPSSE adapter.
+struct mpsse_adapter {
+    struct mpsse_context *mpsse;
+    char serial[MPSSE_ENUM_STR_LEN];    // Serial number requested, empty for the first device found.
+    int interface;              // FTDI interface (IFACE_A .. IFACE_D).
+    struct mpsse_enum_dev dev;  // Enumeration data of the device.
+    int enumerated;             // Device opened via the enumeration cache.
+    int keep;                   // Leave the device in MPSSE mode with its pin states when closing.
+    int latency;                // USB latency timer in ms, -1 = unknown.
+    pthread_mutex_t lock;       // Held by the thread owning the adapter.
+    int waiters;                // Threads waiting in mpsse_adapter_lock().
+    struct mpsse_job *queue;    // Lock-free stack of submitted jobs.
+    struct mpsse_cmd cmd;       // Command buffer, reused for every transfer.
+    struct mpsse_cmd pending;   // Deferred commands, sent with the next transfer.
+    struct mpsse_pins pins;     // Pin states, only valid while holding the lock.
+    int adaptive;               // Adaptive clocking enabled (RTCK on GPIOL3).
+    int three_phase;            // Three phase clocking enabled, each bit takes 1.5 clock periods.
+    int engines;                // MPSSE_ADAPTER_ENGINE_* engines set up on the adapter.
+    // I2C engine state.
+    int i2c_freq;               // Default I2C frequency.
+    int i2c_dev_freq[128];      // I2C frequencies of the device addresses, 0 = default.
+    int i2c_open_drain;         // SCL and SDA are only driven low (FT232H only).
+    int i2c_strap;              // ADBUS1 and ADBUS2 are tied together, SDA can be shifted in on ADBUS2.
+    // MDIO engine state.
+    int mdio_freq;              // MDC frequency.
+    int mdio_preamble;          // Send the preamble before each MDIO frame.
+    // SWD engine state.
+    int swd_freq;               // SWCLK frequency.
+    int refcount;               // Number of engines using the adapter.
+    int verbose;
+    struct mpsse_adapter *next; // Next open adapter of this process.
+};
+
+
+
+// Function prototypes.
+int mpsse_adapter_select(const char *serial);
+int mpsse_adapter_select_interface(int interface);
+int mpsse_adapter_parse_interface(const char *name);
+int mpsse_adapter_select_workload(int workload);
+struct mpsse_adapter *mpsse_adapter_open(enum modes mode, int freq, int endianess);
+struct mpsse_adapter *mpsse_adapter_attach(enum modes mode, int freq, int endianess);
+struct mpsse_adapter *mpsse_adapter_open_if(enum modes mode, int freq, int endianess, const char *serial, int interface);
+void mpsse_adapter_close(struct mpsse_adapter *adapter);
+void mpsse_adapter_lock(struct mpsse_adapter *adapter);
+void mpsse_adapter_unlock(struct mpsse_adapter *adapter);
+int mpsse_adapter_submit(struct mpsse_adapter *adapter, struct mpsse_job *job);
+int mpsse_adapter_run(struct mpsse_adapter *adapter, int (*build)(struct mpsse_adapter *, struct mpsse_cmd *, void *), void *arg);
+int mpsse_adapter_defer(struct mpsse_adapter *adapter, int (*build)(struct mpsse_adapter *, struct mpsse_cmd *, void *), void *arg);
+int mpsse_adapter_flush(struct mpsse_adapter *adapter);
+int mpsse_adapter_queue_delay(struct mpsse_adapter *adapter, int usec);
+int mpsse_adapter_delay(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, int usec);
+int mpsse_adapter_set_low(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, unsigned char value, unsigned char direction, unsigned char mask);
+int mpsse_adapter_set_high(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, unsigned char value, unsigned char direction, unsigned char mask);
+int mpsse_adapter_set_open_drain(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, unsigned char low, unsigned char high);
+int mpsse_adapter_set_adaptive(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, int enable);
+int mpsse_adapter_get_clock(int freq);
+int mpsse_adapter_set_clock(struct mpsse_cmd *cmd, struct mpsse_context *mpsse, int freq);
+void mpsse_cmd_init(struct mpsse_cmd *cmd);
+void mpsse_cmd_free(struct mpsse_cmd *cmd);
+void mpsse_cmd_reset(struct mpsse_cmd *cmd);
+void mpsse_cmd_save(struct mpsse_cmd *cmd, struct mpsse_cmd_mark *mark);
+void mpsse_cmd_restore(struct mpsse_cmd *cmd, struct mpsse_cmd_mark *mark);
+int mpsse_cmd_byte(struct mpsse_cmd *cmd, unsigned char data);
+int mpsse_cmd_bytes(struct mpsse_cmd *cmd, const unsigned char *data, int len);
+int mpsse_cmd_append(struct mpsse_cmd *cmd, const struct mpsse_cmd *tmpl);
+int mpsse_cmd_set_bits_low(struct mpsse_cmd *cmd, unsigned char value, unsigned char direction);
+int mpsse_cmd_set_bits_high(struct mpsse_cmd *cmd, unsigned char value, unsigned char direction);
+int mpsse_cmd_read(struct mpsse_cmd *cmd, unsigned char *data, int len, int *nack);
+int mpsse_cmd_read_bit(struct mpsse_cmd *cmd, unsigned char *data, unsigned char mask, int *nack);
+int mpsse_cmd_execute(struct mpsse_cmd *cmd, struct mpsse_context *mpsse);
+
+
+
+#endif
+
@@ -0,0 +1,644 @@
+// File: mpsse_builder.hpp
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header-only C++ MPSSE command builder on top of the MPSSE adapter layer.
+//
+// Typed MPSSE commands are appended to one buffer. Bytes read back by the
+// commands are registered with their offset in the read-back data and an
+// optional destination, to which they are scattered after execution. The
+// commands are split into USB transfers, each a contiguous part of the
+// buffer, so that the read-back data of a transfer never exceeds
+// MPSSE_ADAPTER_RX_CHUNK bytes:
+//
+//   mpsse_builder::builder b;
+//   uint8_t id[4];
+//   b.clock(1000000).set_bits_low(0x00, 0x0b, 0x0b);
+//   b.clock_bytes_out(cmd, sizeof(cmd));
+//   b.clock_bytes_in(sizeof(id), id);
+//   b.set_bits_low(0x08, 0x0b, 0x0b);
+//   b.run(adapter);
+//
+// The buffers are kept by reset(), so a builder reused for the same kind of
+// command sequence does not allocate memory anymore. The number of clock
+// cycles and the resulting time on the bus are tracked for all commands.
+//
+// When run on an adapter, the pin, clock and clocking mode commands go
+// through the adapter layer, so that its pin shadow and clock state stay
+// valid for the other protocol engines sharing the adapter. Pins are then
+// only changed where selected by the mask, see mpsse_adapter_set_low().
+//
+
+
+
+#ifndef __MPSSE_BUILDER_HPP
+#define __MPSSE_BUILDER_HPP
+
+
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+extern "C" {
+#include <ftdi.h>
+#include "mpsse_adapter.h"
+}
+
+
+
+namespace mpsse_builder {
+
+
+
+// USB transfer of a command sequence.
+struct transfer {
+    const uint8_t *data;        // Commands.
+    size_t len;                 // Number of command bytes.
+    size_t rx_offset;           // Offset of the bytes read back in the read-back data.
+    size_t rx_len;              // Number of bytes read back.
+};
+
+
+
+// MPSSE command builder.
+class builder {
+public:
+    // lsb_first: shift the data LSB first.
+    // write_falling: change the data output on the falling clock edge.
+    // read_falling: sample the data input on the falling clock edge.
+    builder(bool lsb_first = false, bool write_falling = true, bool read_falling = false) :
+        tck(0), three_phase_on(false), cycle_count(0), time_ns(0), rx_total(0), seg_rx(0)
+    {
+        edges(lsb_first, write_falling, read_falling);
+    }
+
+    // Change the bit order and clock edges of the following data commands.
+    builder &edges(bool lsb_first, bool write_falling, bool read_falling)
+    {
+        flags = (lsb_first ? MPSSE_LSB : 0) | (write_falling ? MPSSE_WRITE_NEG : 0) | (read_falling ? MPSSE_READ_NEG : 0);
+        return *this;
+    }
+
+    // Clear all commands. The memory is kept for reuse. The clock frequency
+    // is kept, as it is a state of the MPSSE.
+    void reset()
+    {
+        buf.clear();
+        rx.clear();
+        state.clear();
+        segs.clear();
+        cycle_count = 0;
+        time_ns = 0;
+        rx_total = 0;
+        seg_rx = 0;
+    }
+
+    // ********** Data clocking. **********
+
+    // Clock bytes out.
+    builder &clock_bytes_out(const uint8_t *data, size_t len)
+    {
+        size_t n;
+
+        for(; len > 0; data += n, len -= n) {
+            n = (len > 0x10000) ? 0x10000 : len;
+            op_len(MPSSE_DO_WRITE | (flags & (MPSSE_LSB | MPSSE_WRITE_NEG)), n - 1);
+            buf.insert(buf.end(), data, data + n);
+            clocks(8 * n);
+        }
+
+        return *this;
+    }
+
+    // Clock bytes in. Returns the offset of the bytes in the read-back data.
+    size_t clock_bytes_in(size_t len, uint8_t *dest = nullptr, int *nack = nullptr)
+    {
+        size_t ofs = rx_total;
+        size_t n;
+
+        for(; len > 0; len -= n) {
+            n = (len > MPSSE_ADAPTER_RX_CHUNK) ? MPSSE_ADAPTER_RX_CHUNK : len;
+            read(n, dest, nack);
+            op_len(MPSSE_DO_READ | (flags & (MPSSE_LSB | MPSSE_READ_NEG)), n - 1);
+            clocks(8 * n);
+            if(dest != nullptr) dest += n;
+        }
+
+        return ofs;
+    }
+
+    // Clock bytes out and in at the same time.
+    size_t clock_bytes_inout(const uint8_t *data, size_t len, uint8_t *dest = nullptr)
+    {
+        size_t ofs = rx_total;
+        size_t n;
+
+        for(; len > 0; data += n, len -= n) {
+            n = (len > MPSSE_ADAPTER_RX_CHUNK) ? MPSSE_ADAPTER_RX_CHUNK : len;
+            read(n, dest, nullptr);
+            op_len(MPSSE_DO_WRITE | MPSSE_DO_READ | flags, n - 1);
+            buf.insert(buf.end(), data, data + n);
+            clocks(8 * n);
+            if(dest != nullptr) dest += n;
+        }
+
+        return ofs;
+    }
+
+    // Clock 1..8 bits out.
+    builder &clock_bits_out(uint8_t data, int bits)
+    {
+        uint8_t cmd[3] = {(uint8_t) (MPSSE_DO_WRITE | MPSSE_BITMODE | (flags & (MPSSE_LSB | MPSSE_WRITE_NEG))), (uint8_t) (bits - 1), data};
+
+        buf.insert(buf.end(), cmd, cmd + 3);
+        clocks(bits);
+
+        return *this;
+    }
+
+    // Clock 1..8 bits in. The bits are shifted into the byte read back from
+    // the LSB (MSB first) or MSB side (LSB first).
+    size_t clock_bits_in(int bits, uint8_t *dest = nullptr, int *nack = nullptr)
+    {
+        size_t ofs = read(1, dest, nack);
+        uint8_t cmd[2] = {(uint8_t) (MPSSE_DO_READ | MPSSE_BITMODE | (flags & (MPSSE_LSB | MPSSE_READ_NEG))), (uint8_t) (bits - 1)};
+
+        buf.insert(buf.end(), cmd, cmd + 2);
+        clocks(bits);
+
+        return ofs;
+    }
+
+    // Clock 1..8 bits out and in at the same time.
+    size_t clock_bits_inout(uint8_t data, int bits, uint8_t *dest = nullptr, int *nack = nullptr)
+    {
+        size_t ofs = read(1, dest, nack);
+        uint8_t cmd[3] = {(uint8_t) (MPSSE_DO_WRITE | MPSSE_DO_READ | MPSSE_BITMODE | flags), (uint8_t) (bits - 1), data};
+
+        buf.insert(buf.end(), cmd, cmd + 3);
+        clocks(bits);
+
+        return ofs;
+    }
+
+    // Clock 1..7 bits out on TMS (LSB first), holding TDI at a fixed level.
+    builder &clock_tms_out(uint8_t data, int bits, bool tdi = false)
+    {
+        uint8_t cmd[3] = {(uint8_t) (MPSSE_WRITE_TMS | MPSSE_LSB | MPSSE_BITMODE | (flags & MPSSE_WRITE_NEG)), (uint8_t) (bits - 1), (uint8_t) ((data & 0x7f) | (tdi ? 0x80 : 0x00))};
+
+        buf.insert(buf.end(), cmd, cmd + 3);
+        clocks(bits);
+
+        return *this;
+    }
+
+    // Clock without transferring data, e.g. for delays on the bus.
+    builder &idle_clocks(uint64_t n)
+    {
+        uint64_t bytes;
+        uint8_t cmd[3];
+
+        clocks(n);
+        for(bytes = n / 8; bytes > 0; bytes -= (bytes > 0x10000) ? 0x10000 : bytes)
+            op_len(CLK_BYTES, ((bytes > 0x10000) ? 0x10000 : bytes) - 1);
+        if(n % 8) {
+            cmd[0] = CLK_BITS;
+            cmd[1] = (uint8_t) (n % 8 - 1);
+            buf.insert(buf.end(), cmd, cmd + 2);
+        }
+
+        return *this;
+    }
+
+    // Delay by clocking without transferring data at the current clock
+    // frequency, rounded up to whole clock periods. If the clock frequency is
+    // not known, it is set to MPSSE_ADAPTER_DELAY_CLOCK first.
+    builder &delay_us(uint32_t usec)
+    {
+        uint64_t n;
+
+        if(tck <= 0) clock(MPSSE_ADAPTER_DELAY_CLOCK);
+        n = ((uint64_t) usec * tck + 999999) / 1000000;
+        if(three_phase_on) n = (2 * n + 2) / 3;
+        if(usec > 0) idle_clocks((n > 0) ? n : 1);
+
+        return *this;
+    }
+
+    // ********** Pins. **********
+
+    // Set the low byte pins. On an adapter, only the pins selected by the
+    // mask are changed.
+    builder &set_bits_low(uint8_t value, uint8_t direction, uint8_t mask = 0xff)
+    {
+        uint8_t cmd[3] = {SET_BITS_LOW, value, direction};
+
+        set_state(STATE_LOW, cmd, 3, value, direction, mask);
+
+        return *this;
+    }
+
+    // Set the high byte pins. On an adapter, only the pins selected by the
+    // mask are changed.
+    builder &set_bits_high(uint8_t value, uint8_t direction, uint8_t mask = 0xff)
+    {
+        uint8_t cmd[3] = {SET_BITS_HIGH, value, direction};
+
+        set_state(STATE_HIGH, cmd, 3, value, direction, mask);
+
+        return *this;
+    }
+
+    // Read the levels of the low byte pins.
+    size_t get_bits_low(uint8_t *dest = nullptr)
+    {
+        size_t ofs = read(1, dest, nullptr);
+
+        buf.push_back(GET_BITS_LOW);
+
+        return ofs;
+    }
+
+    // Read the levels of the high byte pins.
+    size_t get_bits_high(uint8_t *dest = nullptr)
+    {
+        size_t ofs = read(1, dest, nullptr);
+
+        buf.push_back(GET_BITS_HIGH);
+
+        return ofs;
+    }
+
+    // Open drain pins, only driving zero (FT232H only).
+    builder &open_drain(uint8_t low, uint8_t high)
+    {
+        uint8_t cmd[3] = {DRIVE_OPEN_COLLECTOR, low, high};
+
+        set_state(STATE_OPEN_DRAIN, cmd, 3, low, high, 0);
+
+        return *this;
+    }
+
+    // Wait until GPIOL1 is high or low. The waiting time is not known.
+    builder &wait_high()
+    {
+        buf.push_back(WAIT_ON_HIGH);
+        return *this;
+    }
+
+    builder &wait_low()
+    {
+        buf.push_back(WAIT_ON_LOW);
+        return *this;
+    }
+
+    // ********** Clocking. **********
+
+    // Set the clock divisor. With the divide by 5 prescaler, the MPSSE is
+    // clocked with 12 MHz instead of 60 MHz.
+    builder &divisor(uint16_t div, bool div_by_5)
+    {
+        uint8_t cmd[4] = {(uint8_t) (div_by_5 ? EN_DIV_5 : DIS_DIV_5), TCK_DIVISOR, (uint8_t) (div & 0xff), (uint8_t) (div >> 8)};
+
+        tck = (div_by_5 ? TWELVE_MHZ : SIXTY_MHZ) / ((1 + div) * 2);
+        set_state(STATE_CLOCK, cmd, 4, tck, 0, 0);
+
+        return *this;
+    }
+
+    // Set the clock frequency, using the same divisor as the adapter.
+    builder &clock(int freq)
+    {
+        int system_clock = (freq > SIX_MHZ) ? SIXTY_MHZ : TWELVE_MHZ;
+        int div = (freq <= 0) ? 0xffff : ((system_clock / freq) / 2) - 1;
+
+        if(div < 0) div = 0;
+        if(div > 0xffff) div = 0xffff;
+
+        return divisor(div, system_clock == TWELVE_MHZ);
+    }
+
+    // Set the clock frequency already active on the MPSSE, for the timing
+    // of the commands only. No command is appended.
+    builder &assume_clock(int freq)
+    {
+        tck = freq;
+        return *this;
+    }
+
+    // 3-phase data clocking, data is valid on both clock edges. Each bit then
+    // takes 1.5 clock periods.
+    builder &three_phase(bool enable)
+    {
+        uint8_t cmd = enable ? EN_3_PHASE : DIS_3_PHASE;
+
+        set_state(STATE_THREE_PHASE, &cmd, 1, enable, 0, 0);
+        three_phase_on = enable;
+        return *this;
+    }
+
+    // Adaptive clocking with RTCK on GPIOL3. On an adapter, GPIOL3 is made an
+    // input when enabling it.
+    builder &adaptive(bool enable)
+    {
+        uint8_t cmd = enable ? EN_ADAPTIVE : DIS_ADAPTIVE;
+
+        set_state(STATE_ADAPTIVE, &cmd, 1, enable, 0, 0);
+        return *this;
+    }
+
+    // Internal loopback of TDI/DO to TDO/DI.
+    builder &loopback(bool enable)
+    {
+        buf.push_back(enable ? LOOPBACK_START : LOOPBACK_END);
+        return *this;
+    }
+
+    // ********** Raw commands. **********
+
+    // Append raw command bytes, which must not read back any data.
+    builder &raw(const uint8_t *data, size_t len)
+    {
+        buf.insert(buf.end(), data, data + len);
+        return *this;
+    }
+
+    // Flush the read-back data to the host.
+    builder &send_immediate()
+    {
+        buf.push_back(SEND_IMMEDIATE);
+        return *this;
+    }
+
+    // ********** Transfers. **********
+
+    // Close the current USB transfer. Called automatically when the
+    // read-back data of a transfer would exceed MPSSE_ADAPTER_RX_CHUNK bytes.
+    void end_transfer()
+    {
+        if(seg_rx > 0) buf.push_back(SEND_IMMEDIATE);
+        if(buf.size() > seg_end())
+            segs.push_back(seg {buf.size(), rx_total});
+        seg_rx = 0;
+    }
+
+    // Number of USB transfers, including the still open one.
+    size_t transfers() const
+    {
+        return segs.size() + ((buf.size() > seg_end()) ? 1 : 0);
+    }
+
+    // Get a USB transfer. Call end_transfer() before, so that the read-back
+    // data of the last transfer is flushed.
+    struct transfer get_transfer(size_t i) const
+    {
+        struct transfer t;
+        size_t start = (i > 0) ? segs[i - 1].len : 0;
+        size_t rx_start = (i > 0) ? segs[i - 1].rx_len : 0;
+
+        t.data = buf.data() + start;
+        t.len = ((i < segs.size()) ? segs[i].len : buf.size()) - start;
+        t.rx_offset = rx_start;
+        t.rx_len = ((i < segs.size()) ? segs[i].rx_len : rx_total) - rx_start;
+
+        return t;
+    }
+
+    // ********** Execution. **********
+
+    // Append the commands to a command buffer of the adapter layer, e.g. in
+    // the build function of a job. With an adapter, the pin, clock and
+    // clocking mode commands update its state, see set_state().
+    // CAUTION: With an adapter, must only be called from a build function!
+    int append(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter = nullptr)
+    {
+        size_t done = 0;
+        auto r = rx.begin();
+        auto s = state.begin();
+
+        result.resize(rx_total);
+        while(r != rx.end() || s != state.end()) {
+            if(s != state.end() && (r == rx.end() || s->pos < r->pos)) {
+                if(s->pos > done && mpsse_cmd_bytes(cmd, buf.data() + done, s->pos - done)) return -1;
+                if(apply(adapter, cmd, *s)) return -1;
+                done = s->pos + s->len;
+                s++;
+            } else {
+                if(r->pos > done && mpsse_cmd_bytes(cmd, buf.data() + done, r->pos - done)) return -1;
+                if(mpsse_cmd_read(cmd, result.data() + r->offset, r->len, r->nack)) return -1;
+                done = r->pos;
+                r++;
+            }
+        }
+        if(buf.size() > done && mpsse_cmd_bytes(cmd, buf.data() + done, buf.size() - done)) return -1;
+
+        return 0;
+    }
+
+    // Execute the commands on an adapter, combined with the jobs of other
+    // threads, and scatter the bytes read back to their destinations.
+    int run(struct mpsse_adapter *adapter)
+    {
+        if(mpsse_adapter_run(adapter, build, this)) return -1;
+        scatter();
+
+        return 0;
+    }
+
+    // Execute the commands directly on an MPSSE context, e.g. one not opened
+    // via the adapter layer. The state of an adapter is not updated, so use
+    // run() for an adapter shared with other protocol engines.
+    int execute(struct mpsse_context *mpsse)
+    {
+        struct mpsse_cmd cmd;
+        int ret;
+
+        mpsse_cmd_init(&cmd);
+        ret = append(&cmd);
+        if(!ret) ret = mpsse_cmd_execute(&cmd, mpsse);
+        mpsse_cmd_free(&cmd);
+        if(!ret) scatter();
+
+        return ret;
+    }
+
+    // Get the bytes read back at an offset returned by a read command.
+    const uint8_t *data(size_t offset) const
+    {
+        return result.data() + offset;
+    }
+
+    // ********** Accounting. **********
+
+    // Number of command bytes.
+    size_t size() const
+    {
+        return buf.size();
+    }
+
+    // Number of bytes read back.
+    size_t rx_len() const
+    {
+        return rx_total;
+    }
+
+    // Number of clock cycles of all commands.
+    uint64_t cycles() const
+    {
+        return cycle_count;
+    }
+
+    // Time on the bus of all commands in ns, excluding the USB transfers and
+    // waits. Clock cycles before the clock frequency is known are not counted.
+    double duration_ns() const
+    {
+        return time_ns;
+    }
+
+private:
+    // Read-back entry.
+    struct rx_entry {
+        size_t pos;             // Offset of the command reading the bytes.
+        size_t offset;          // Offset in the read-back data.
+        size_t len;
+        uint8_t *dest;          // Destination, nullptr if only kept in the read-back data.
+        int *nack;
+    };
+
+    // Pin, clock and clocking mode commands.
+    enum state_kind {
+        STATE_LOW,
+        STATE_HIGH,
+        STATE_OPEN_DRAIN,
+        STATE_CLOCK,
+        STATE_THREE_PHASE,
+        STATE_ADAPTIVE
+    };
+
+    // State command entry.
+    struct state_entry {
+        size_t pos;             // Offset of the command.
+        size_t len;             // Number of command bytes.
+        state_kind kind;
+        int value;              // Pin levels, low byte open drain pins, clock frequency or enable.
+        int direction;          // Pin directions or high byte open drain pins.
+        int mask;               // Pins changed on an adapter.
+    };
+
+    // End of a USB transfer.
+    struct seg {
+        size_t len;             // End offset in the command buffer.
+        size_t rx_len;          // End offset in the read-back data.
+    };
+
+    std::vector<uint8_t> buf;
+    std::vector<rx_entry> rx;
+    std::vector<state_entry> state;
+    std::vector<seg> segs;
+    std::vector<uint8_t> result;
+    int flags;                  // Bit order and clock edges of data commands.
+    int tck;                    // Clock frequency, 0 = unknown.
+    bool three_phase_on;
+    uint64_t cycle_count;
+    double time_ns;
+    size_t rx_total;
+    size_t seg_rx;              // Bytes read back in the currently open transfer.
+
+    size_t seg_end() const
+    {
+        return segs.empty() ? 0 : segs.back().len;
+    }
+
+    // Register bytes read back by the next command.
+    size_t read(size_t len, uint8_t *dest, int *nack)
+    {
+        size_t ofs = rx_total;
+
+        if(seg_rx + len > MPSSE_ADAPTER_RX_CHUNK) end_transfer();
+        rx.push_back(rx_entry {buf.size(), ofs, len, dest, nack});
+        rx_total += len;
+        seg_rx += len;
+
+        return ofs;
+    }
+
+    // Append a pin, clock or clocking mode command and register it, so that
+    // it can be applied to the state of an adapter.
+    void set_state(state_kind kind, const uint8_t *cmd, size_t len, int value, int direction, int mask)
+    {
+        state.push_back(state_entry {buf.size(), len, kind, value, direction, mask});
+        buf.insert(buf.end(), cmd, cmd + len);
+    }
+
+    // Append a state command. Without an adapter, the command bytes are
+    // appended as they are. Otherwise, the pins, clock and clocking modes
+    // are changed via the adapter layer, which tracks them for all engines.
+    int apply(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, const state_entry &s)
+    {
+        if(adapter == nullptr)
+            return mpsse_cmd_bytes(cmd, buf.data() + s.pos, s.len);
+
+        switch(s.kind) {
+        case STATE_LOW:
+            return mpsse_adapter_set_low(adapter, cmd, s.value, s.direction, s.mask);
+        case STATE_HIGH:
+            return mpsse_adapter_set_high(adapter, cmd, s.value, s.direction, s.mask);
+        case STATE_OPEN_DRAIN:
+            return mpsse_adapter_set_open_drain(adapter, cmd, s.value, s.direction);
+        case STATE_CLOCK:
+            if(mpsse_cmd_bytes(cmd, buf.data() + s.pos, s.len)) return -1;
+            adapter->mpsse->clock = s.value;
+            return 0;
+        case STATE_THREE_PHASE:
+            if(mpsse_cmd_bytes(cmd, buf.data() + s.pos, s.len)) return -1;
+            adapter->three_phase = s.value;
+            return 0;
+        case STATE_ADAPTIVE:
+            return mpsse_adapter_set_adaptive(adapter, cmd, s.value);
+        }
+
+        return -1;
+    }
+
+    // Append a command with a 16 bit length.
+    void op_len(uint8_t op, size_t len)
+    {
+        uint8_t cmd[3] = {op, (uint8_t) (len & 0xff), (uint8_t) ((len >> 8) & 0xff)};
+
+        buf.insert(buf.end(), cmd, cmd + 3);
+    }
+
+    // Account clock cycles. With 3-phase clocking, each bit takes 1.5 clock
+    // periods.
+    void clocks(uint64_t bits)
+    {
+        uint64_t n = three_phase_on ? (3 * bits + 1) / 2 : bits;
+
+        cycle_count += n;
+        if(tck > 0) time_ns += n * 1e9 / tck;
+    }
+
+    // Copy the bytes read back to their destinations.
+    void scatter()
+    {
+        for(const auto &r : rx)
+            if(r.dest != nullptr)
+                memcpy(r.dest, result.data() + r.offset, r.len);
+    }
+
+    static int build(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+    {
+        return static_cast<builder *>(arg)->append(cmd, adapter);
+    }
+};
+
+
+
+}
+
+
+
+#endif
+
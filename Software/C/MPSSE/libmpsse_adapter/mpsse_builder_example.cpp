@@ -0,0 +1,68 @@
+// File: mpsse_builder_example.cpp
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Example for the C++ MPSSE command builder, built together with the library
+// so that the header-only builder is compiled against the adapter layer.
+//
+// Without parameters, the levels of all pins are read back and printed. With
+// a value and a mask, the GPIOL0..GPIOL3 pins (ADBUS4..ADBUS7) selected by
+// the mask are set as outputs before, all other pins are kept:
+//
+//   mpsse_builder_example [VALUE MASK]
+//
+
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "mpsse_builder.hpp"
+
+
+
+int main(int argc, char **argv)
+{
+    struct mpsse_adapter *adapter;
+    mpsse_builder::builder b;
+    uint8_t low, high;
+    uint8_t value, mask;
+
+    if(argc != 1 && argc != 3) {
+        printf("Usage: %s [VALUE MASK]\n", argv[0]);
+        printf("Set the GPIOL0..GPIOL3 pins selected by MASK to VALUE and read back all pins.\n");
+        return 1;
+    }
+
+    // Attach to the device, keeping the current pin states.
+    adapter = mpsse_adapter_attach(GPIO, 0, 0);
+    if(adapter == NULL) {
+        printf("%sUnable to open the MPSSE adapter.\n", PREFIX_ERROR);
+        return 1;
+    }
+    adapter->verbose = 1;
+
+    // Only the GPIOL pins are changed, via the pin shadow of the adapter.
+    if(argc == 3) {
+        value = (strtoul(argv[1], NULL, 0) << 4) & 0xf0;
+        mask = (strtoul(argv[2], NULL, 0) << 4) & 0xf0;
+        b.set_bits_low(value, mask, mask);
+    }
+    b.get_bits_low(&low);
+    b.get_bits_high(&high);
+    if(b.run(adapter)) {
+        printf("%sUnable to execute the MPSSE commands.\n", PREFIX_ERROR);
+        mpsse_adapter_close(adapter);
+        return 1;
+    }
+
+    printf("ADBUS: 0x%02x\n", low);
+    printf("ACBUS: 0x%02x\n", high);
+
+    mpsse_adapter_close(adapter);
+
+    return 0;
+}
+
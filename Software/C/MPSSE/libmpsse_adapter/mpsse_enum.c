@@ -0,0 +1,541 @@
+// File: mpsse_enum.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Enumeration of the FTDI MPSSE devices.
+//
+// The libmpsse function MPSSE() tries all supported VID/PID pairs one after
+// another. Each try scans the USB bus and opens every matching device to read
+// its strings. The device is then reset and set up from scratch. With many
+// adapters and many short running programs, this dominates the run time.
+//
+// Here, the USB bus is scanned once. The serial numbers of the devices found
+// are mapped to their USB bus and device addresses and stored in a small
+// cache file. Later opens use ftdi_usb_open_bus_addr() directly and only
+// check the serial number of the device. If the device was unplugged or the
+// cache is outdated, the bus is scanned again.
+//
+// The cache also records the state a device was left in. If it was closed
+// cleanly, the bit mode is already reset, the buffers are empty and the
+// latency timer is set, so these steps are skipped on the next open. If it was
+// left in MPSSE mode, a program may attach to it: the pin levels are read
+// back with GET_BITS_LOW/HIGH, the pin directions are taken from the cache and
+// the device is used as it is, without changing any pin.
+//
+// The cache holds one entry per USB device. Its state refers to interface A,
+// the only interface of the FT232H. The other interfaces of the FT2232H and
+// the FT4232H are opened via the cache as well, but always set up from scratch
+// and their use does not change the recorded state.
+//
+// Several processes may use the cache at the same time. Each load, change
+// and save of the cache is done while holding an exclusive flock() on a lock
+// file next to it, so that no process overwrites the changes of another one.
+// Otherwise, a device in use could be left marked as closed cleanly, and the
+// next open would skip its reset.
+//
+// Cache file format, one device per line:
+// SERIAL VID PID BUS ADDR STATE LOW LOW_DIR HIGH HIGH_DIR DESCRIPTION
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <libusb.h>
+#include <mpsse.h>
+#include "mpsse_adapter.h"
+#include "mpsse_enum.h"
+
+
+
+// Global variables.
+// Devices supported by libmpsse, defined in mpsse.c.
+extern struct vid_pid supported_devices[];
+
+
+
+// Function prototypes.
+static const char *mpsse_enum_supported(int vid, int pid);
+static int mpsse_enum_cache_path(char *path, int size);
+static int mpsse_enum_lock(void);
+static void mpsse_enum_unlock(int fd);
+static int mpsse_enum_update(struct mpsse_enum_dev *devs, int max);
+static int mpsse_enum_load(struct mpsse_enum_dev *devs, int max);
+static int mpsse_enum_save(struct mpsse_enum_dev *devs, int count);
+static struct mpsse_enum_dev *mpsse_enum_find(struct mpsse_enum_dev *devs, int count, const char *serial);
+static struct mpsse_context *mpsse_enum_open_dev(enum modes mode, int freq, int endianess, int interface, int attach, struct mpsse_enum_dev *dev);
+static int mpsse_enum_attach(struct mpsse_context *mpsse, struct mpsse_enum_dev *dev, int freq, int endianess);
+
+
+
+// Scan the USB bus for supported devices and update the cache file. The
+// recorded state is kept for devices that are still at the same address.
+// Returns the number of devices found or -1 on error.
+int mpsse_enum_scan(struct mpsse_enum_dev *devs, int max)
+{
+    int fd, count;
+
+    fd = mpsse_enum_lock();
+    count = mpsse_enum_update(devs, max);
+    mpsse_enum_unlock(fd);
+
+    return count;
+}
+
+
+
+// Get the list of devices from the cache. The USB bus is only scanned if the
+// cache is empty. Returns the number of devices or -1 on error.
+int mpsse_enum_list(struct mpsse_enum_dev *devs, int max)
+{
+    int fd, count;
+
+    fd = mpsse_enum_lock();
+    count = mpsse_enum_load(devs, max);
+    if(count <= 0)
+        count = mpsse_enum_update(devs, max);
+    mpsse_enum_unlock(fd);
+
+    return count;
+}
+
+
+
+// Open an interface (IFACE_A .. IFACE_D) of the device with the given serial
+// number, or of the first device if serial is NULL. The cached USB address is
+// tried first, then the bus is scanned again. If attach is set and the device
+// was left in MPSSE mode, the device is attached to without changing its pins.
+// On success, the enumeration data of the device is stored in dev. Returns
+// NULL if no matching device could be opened.
+// The cache is locked during the whole open, so that the recorded state
+// cannot change between reading it and marking the device as in use.
+struct mpsse_context *mpsse_enum_open(enum modes mode, int freq, int endianess, const char *serial, int interface, int attach, struct mpsse_enum_dev *dev)
+{
+    struct mpsse_enum_dev devs[MPSSE_ENUM_MAX];
+    struct mpsse_enum_dev *found;
+    struct mpsse_enum_dev other;
+    struct mpsse_context *mpsse = NULL;
+    int fd, count, scan;
+
+    fd = mpsse_enum_lock();
+    count = mpsse_enum_load(devs, MPSSE_ENUM_MAX);
+    for(scan = 0; scan < 2 && mpsse == NULL; scan++) {
+        if(scan) {
+            count = mpsse_enum_update(devs, MPSSE_ENUM_MAX);
+            if(count <= 0) break;
+        }
+        found = mpsse_enum_find(devs, count, serial);
+        if(found == NULL) continue;
+
+        // The recorded state only applies to interface A. Set up the other
+        // interfaces from scratch and leave the state of interface A alone.
+        if(interface != IFACE_A) {
+            memcpy(&other, found, sizeof(struct mpsse_enum_dev));
+            other.state = MPSSE_ENUM_STATE_UNKNOWN;
+            mpsse = mpsse_enum_open_dev(mode, freq, endianess, interface, 0, &other);
+            if(mpsse != NULL)
+                memcpy(dev, &other, sizeof(struct mpsse_enum_dev));
+            continue;
+        }
+
+        mpsse = mpsse_enum_open_dev(mode, freq, endianess, interface, attach, found);
+        if(mpsse == NULL) continue;
+
+        // The device is in use now.
+        memcpy(dev, found, sizeof(struct mpsse_enum_dev));
+        if(dev->state != MPSSE_ENUM_STATE_UNKNOWN) {
+            dev->state = MPSSE_ENUM_STATE_UNKNOWN;
+            found->state = MPSSE_ENUM_STATE_UNKNOWN;
+            mpsse_enum_save(devs, count);
+        }
+    }
+    mpsse_enum_unlock(fd);
+
+    return mpsse;
+}
+
+
+
+// Record the state of a device in the cache. For MPSSE_ENUM_STATE_MPSSE, the
+// pin states of dev are recorded as well.
+int mpsse_enum_set_state(const struct mpsse_enum_dev *dev, int state)
+{
+    struct mpsse_enum_dev devs[MPSSE_ENUM_MAX];
+    int i, fd, count;
+    int status = -1;
+
+    fd = mpsse_enum_lock();
+    count = mpsse_enum_load(devs, MPSSE_ENUM_MAX);
+    for(i = 0; i < count; i++) {
+        if(devs[i].bus == dev->bus && devs[i].addr == dev->addr && !strcmp(devs[i].serial, dev->serial)) {
+            status = 0;
+            if(devs[i].state == state && state != MPSSE_ENUM_STATE_MPSSE) break;
+            devs[i].state = state;
+            if(state == MPSSE_ENUM_STATE_MPSSE) {
+                devs[i].low = dev->low;
+                devs[i].low_dir = dev->low_dir;
+                devs[i].high = dev->high;
+                devs[i].high_dir = dev->high_dir;
+            }
+            status = mpsse_enum_save(devs, count);
+            break;
+        }
+    }
+    mpsse_enum_unlock(fd);
+
+    return status;
+}
+
+
+
+// Scan the USB bus for supported devices and update the cache file, see
+// mpsse_enum_scan(). The cache must be locked by the caller.
+static int mpsse_enum_update(struct mpsse_enum_dev *devs, int max)
+{
+    struct ftdi_context *ftdi;
+    struct libusb_device **list;
+    struct libusb_device_descriptor desc;
+    struct mpsse_enum_dev old[MPSSE_ENUM_MAX];
+    struct mpsse_enum_dev *dev;
+    ssize_t num, i;
+    int j, count = 0, old_count;
+
+    ftdi = ftdi_new();
+    if(ftdi == NULL) {
+        fprintf(stderr, "%s: %s: %sCannot initialize libftdi.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    num = libusb_get_device_list(ftdi->usb_ctx, &list);
+    if(num < 0) {
+        fprintf(stderr, "%s: %s: %sCannot get the list of USB devices: %s\n", __FILE__, __FUNCTION__, PREFIX_ERROR, libusb_error_name((int) num));
+        ftdi_free(ftdi);
+        return -1;
+    }
+
+    old_count = mpsse_enum_load(old, MPSSE_ENUM_MAX);
+    for(i = 0; i < num && count < max; i++) {
+        if(libusb_get_device_descriptor(list[i], &desc) < 0) continue;
+        if(mpsse_enum_supported(desc.idVendor, desc.idProduct) == NULL) continue;
+        dev = &devs[count];
+        memset(dev, 0, sizeof(struct mpsse_enum_dev));
+        dev->vid = desc.idVendor;
+        dev->pid = desc.idProduct;
+        dev->bus = libusb_get_bus_number(list[i]);
+        dev->addr = libusb_get_device_address(list[i]);
+        if(ftdi_usb_get_strings2(ftdi, list[i], NULL, 0, dev->description, MPSSE_ENUM_STR_LEN, dev->serial, MPSSE_ENUM_STR_LEN) < 0) {
+            dev->serial[0] = 0;
+            dev->description[0] = 0;
+        }
+        // Keep the state of devices that were not unplugged meanwhile.
+        for(j = 0; j < old_count; j++) {
+            if(old[j].bus == dev->bus && old[j].addr == dev->addr && !strcmp(old[j].serial, dev->serial)) {
+                dev->state = old[j].state;
+                dev->low = old[j].low;
+                dev->low_dir = old[j].low_dir;
+                dev->high = old[j].high;
+                dev->high_dir = old[j].high_dir;
+                break;
+            }
+        }
+        count++;
+    }
+    libusb_free_device_list(list, 1);
+    ftdi_free(ftdi);
+
+    mpsse_enum_save(devs, count);
+
+    return count;
+}
+
+
+
+// Get the description of a device supported by libmpsse. Returns NULL if the
+// device is not supported.
+static const char *mpsse_enum_supported(int vid, int pid)
+{
+    int i;
+
+    for(i = 0; supported_devices[i].vid != 0; i++)
+        if(supported_devices[i].vid == vid && supported_devices[i].pid == pid)
+            return supported_devices[i].description;
+
+    return NULL;
+}
+
+
+
+// Get the path of the cache file.
+static int mpsse_enum_cache_path(char *path, int size)
+{
+    const char *env;
+    int len;
+
+    env = getenv(MPSSE_ENUM_CACHE_ENV);
+    if(env != NULL && *env)
+        len = snprintf(path, size, "%s", env);
+    else if((env = getenv("HOME")) != NULL && *env)
+        len = snprintf(path, size, "%s/%s", env, MPSSE_ENUM_CACHE_FILE);
+    else
+        return -1;
+
+    return (len < 0 || len >= size) ? -1 : 0;
+}
+
+
+
+// Lock the cache file against other processes. Returns the file descriptor of
+// the lock file, or -1 if the cache cannot be locked. Then, the cache is used
+// without locking.
+static int mpsse_enum_lock(void)
+{
+    char path[1040];
+    int fd;
+
+    if(mpsse_enum_cache_path(path, sizeof(path) - 16)) return -1;
+    strcat(path, ".lock");
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(fd < 0) return -1;
+    if(flock(fd, LOCK_EX)) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+
+// Unlock the cache file.
+static void mpsse_enum_unlock(int fd)
+{
+    if(fd < 0) return;
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+
+
+// Load the devices from the cache file. Returns the number of devices, 0 if
+// there is no cache file.
+static int mpsse_enum_load(struct mpsse_enum_dev *devs, int max)
+{
+    char path[1024];
+    char line[256];
+    FILE *fp;
+    struct mpsse_enum_dev *dev;
+    int count = 0;
+
+    if(mpsse_enum_cache_path(path, sizeof(path))) return 0;
+    fp = fopen(path, "r");
+    if(fp == NULL) return 0;
+
+    while(count < max && fgets(line, sizeof(line), fp) != NULL) {
+        if(line[0] == '#') continue;
+        dev = &devs[count];
+        memset(dev, 0, sizeof(struct mpsse_enum_dev));
+        if(sscanf(line, "%63s %x %x %d %d %d %hhx %hhx %hhx %hhx %63[^\n]", dev->serial, &dev->vid, &dev->pid, &dev->bus, &dev->addr, &dev->state,
+                  &dev->low, &dev->low_dir, &dev->high, &dev->high_dir, dev->description) < 10)
+            continue;
+        if(!strcmp(dev->serial, "-"))
+            dev->serial[0] = 0;
+        count++;
+    }
+    fclose(fp);
+
+    return count;
+}
+
+
+
+// Save the devices to the cache file. The file is replaced atomically, so
+// that other processes never see a partially written cache.
+static int mpsse_enum_save(struct mpsse_enum_dev *devs, int count)
+{
+    char path[1024];
+    char path_tmp[1040];
+    FILE *fp;
+    int i;
+
+    if(mpsse_enum_cache_path(path, sizeof(path))) return -1;
+    snprintf(path_tmp, sizeof(path_tmp), "%s.%d", path, (int) getpid());
+    fp = fopen(path_tmp, "w");
+    if(fp == NULL) return -1;
+
+    fprintf(fp, "# MPSSE device enumeration cache.\n");
+    fprintf(fp, "# SERIAL VID PID BUS ADDR STATE LOW LOW_DIR HIGH HIGH_DIR DESCRIPTION\n");
+    for(i = 0; i < count; i++)
+        fprintf(fp, "%s 0x%04x 0x%04x %d %d %d 0x%02x 0x%02x 0x%02x 0x%02x %s\n", devs[i].serial[0] ? devs[i].serial : "-", devs[i].vid, devs[i].pid, devs[i].bus, devs[i].addr, devs[i].state,
+                devs[i].low, devs[i].low_dir, devs[i].high, devs[i].high_dir, devs[i].description);
+    if(fclose(fp) || rename(path_tmp, path)) {
+        unlink(path_tmp);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Find a device by its serial number. If serial is NULL, the first device is
+// returned.
+static struct mpsse_enum_dev *mpsse_enum_find(struct mpsse_enum_dev *devs, int count, const char *serial)
+{
+    int i;
+
+    for(i = 0; i < count; i++)
+        if(serial == NULL || !strcmp(devs[i].serial, serial))
+            return &devs[i];
+
+    return NULL;
+}
+
+
+
+// Open an interface of a device by its USB address and set it up like
+// OpenIndex() of libmpsse does. The reset steps are skipped if the device was
+// closed cleanly. If attach is set and the device was left in MPSSE mode, the
+// set up is skipped completely.
+static struct mpsse_context *mpsse_enum_open_dev(enum modes mode, int freq, int endianess, int interface, int attach, struct mpsse_enum_dev *dev)
+{
+    struct mpsse_context *mpsse;
+    struct libusb_device_descriptor desc;
+    char serial[MPSSE_ENUM_STR_LEN];
+    int status = 0;
+    int idle = (dev->state == MPSSE_ENUM_STATE_IDLE);
+
+    mpsse = malloc(sizeof(struct mpsse_context));
+    if(mpsse == NULL) return NULL;
+    memset(mpsse, 0, sizeof(struct mpsse_context));
+    FlushAfterRead(mpsse, 0);
+    if(ftdi_init(&mpsse->ftdi) < 0) {
+        free(mpsse);
+        return NULL;
+    }
+    if(ftdi_set_interface(&mpsse->ftdi, interface) < 0) {
+        ftdi_deinit(&mpsse->ftdi);
+        free(mpsse);
+        return NULL;
+    }
+
+    // Open the device and check that it is still the same one.
+    if(ftdi_usb_open_bus_addr(&mpsse->ftdi, dev->bus, dev->addr) < 0) {
+        ftdi_deinit(&mpsse->ftdi);
+        free(mpsse);
+        return NULL;
+    }
+    serial[0] = 0;
+    if(libusb_get_device_descriptor(libusb_get_device(mpsse->ftdi.usb_dev), &desc) < 0 ||
+       desc.idVendor != dev->vid || desc.idProduct != dev->pid ||
+       (desc.iSerialNumber && libusb_get_string_descriptor_ascii(mpsse->ftdi.usb_dev, desc.iSerialNumber, (unsigned char *) serial, sizeof(serial)) < 0) ||
+       strcmp(serial, dev->serial)) {
+        ftdi_usb_close(&mpsse->ftdi);
+        ftdi_deinit(&mpsse->ftdi);
+        free(mpsse);
+        return NULL;
+    }
+
+    mpsse->mode = mode;
+    mpsse->vid = dev->vid;
+    mpsse->pid = dev->pid;
+    mpsse->status = STOPPED;
+    mpsse->endianess = endianess;
+    mpsse->description = (char *) mpsse_enum_supported(dev->vid, dev->pid);
+    mpsse->xsize = (mode == I2C) ? I2C_TRANSFER_SIZE : SPI_RW_SIZE;
+
+    // Attach to the device left in MPSSE mode. If the MPSSE does not respond
+    // as expected, the device is set up from scratch.
+    if(attach && dev->state == MPSSE_ENUM_STATE_MPSSE && mode != BITBANG) {
+        status |= ftdi_write_data_set_chunksize(&mpsse->ftdi, CHUNK_SIZE);
+        status |= ftdi_read_data_set_chunksize(&mpsse->ftdi, CHUNK_SIZE);
+        mpsse->ftdi.usb_read_timeout = USB_TIMEOUT;
+        mpsse->ftdi.usb_write_timeout = USB_TIMEOUT;
+        if(status == 0 && mpsse_enum_attach(mpsse, dev, freq, endianess) == 0) {
+            mpsse->open = 1;
+            return mpsse;
+        }
+        status = 0;
+    }
+
+    if(!idle) {
+        status |= ftdi_usb_reset(&mpsse->ftdi);
+        status |= ftdi_set_latency_timer(&mpsse->ftdi, LATENCY_MS);
+    }
+    status |= ftdi_write_data_set_chunksize(&mpsse->ftdi, CHUNK_SIZE);
+    status |= ftdi_read_data_set_chunksize(&mpsse->ftdi, CHUNK_SIZE);
+    if(!idle)
+        status |= ftdi_set_bitmode(&mpsse->ftdi, 0, BITMODE_RESET);
+    mpsse->ftdi.usb_read_timeout = USB_TIMEOUT;
+    mpsse->ftdi.usb_write_timeout = USB_TIMEOUT;
+
+    if(status == 0) {
+        if(mode != BITBANG) {
+            ftdi_set_bitmode(&mpsse->ftdi, 0, BITMODE_MPSSE);
+            if(SetClock(mpsse, freq) == MPSSE_OK && SetMode(mpsse, endianess) == MPSSE_OK) {
+                mpsse->open = 1;
+                // Give the chip a few ms to initialize and clear out the
+                // errors of commands not supported by all chips.
+                usleep(SETUP_DELAY);
+                ftdi_usb_purge_buffers(&mpsse->ftdi);
+            }
+        } else if(ftdi_set_bitmode(&mpsse->ftdi, 0xff, BITMODE_BITBANG) == 0) {
+            mpsse->open = 1;
+        }
+    }
+    if(!mpsse->open) {
+        ftdi_usb_close(&mpsse->ftdi);
+        ftdi_deinit(&mpsse->ftdi);
+        free(mpsse);
+        return NULL;
+    }
+
+    return mpsse;
+}
+
+
+
+// Attach to a device left in MPSSE mode. The MPSSE answers an invalid command
+// with 0xfa followed by the command, which confirms that it is still active.
+// The pin levels are read back in the same USB transfer, the pin directions
+// are taken from the cache. No pin is changed.
+static int mpsse_enum_attach(struct mpsse_context *mpsse, struct mpsse_enum_dev *dev, int freq, int endianess)
+{
+    unsigned char cmd[] = { 0xaa, GET_BITS_LOW, GET_BITS_HIGH, SEND_IMMEDIATE };
+    unsigned char buf[4];
+    int len = 0, r, retries = 0;
+
+    if(ftdi_usb_purge_buffers(&mpsse->ftdi) < 0) return -1;
+    if(ftdi_write_data(&mpsse->ftdi, cmd, sizeof(cmd)) != sizeof(cmd)) return -1;
+    while(len < (int) sizeof(buf)) {
+        r = ftdi_read_data(&mpsse->ftdi, buf + len, sizeof(buf) - len);
+        if(r < 0) return -1;
+        if(r == 0 && ++retries > MPSSE_ADAPTER_READ_RETRIES) return -1;
+        len += r;
+    }
+    if(buf[0] != 0xfa || buf[1] != 0xaa) return -1;
+
+    // Take the levels of the output pins as read back and keep the recorded
+    // levels of the input pins.
+    mpsse->tris = dev->low_dir;
+    mpsse->pidle = mpsse->pstart = mpsse->pstop = (buf[2] & dev->low_dir) | (dev->low & ~dev->low_dir);
+    mpsse->trish = dev->high_dir;
+    mpsse->gpioh = (buf[3] & dev->high_dir) | (dev->high & ~dev->high_dir);
+
+    // Set up the context like SetMode() does, but without sending the pin
+    // states.
+    mpsse->tx = MPSSE_DO_WRITE | endianess;
+    mpsse->rx = MPSSE_DO_READ | endianess;
+    mpsse->txrx = MPSSE_DO_WRITE | MPSSE_DO_READ | endianess;
+    mpsse->tack = 0x00;         // Send ACKs by default.
+
+    // The clock settings do not affect the pins.
+    if(SetClock(mpsse, freq) != MPSSE_OK) return -1;
+
+    return 0;
+}
+
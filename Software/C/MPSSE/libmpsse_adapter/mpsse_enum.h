@@ -0,0 +1,70 @@
+// File: mpsse_enum.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for the enumeration of the FTDI MPSSE devices. The USB bus is
+// scanned once and the devices found are kept in a cache file, so that later
+// opens go straight to the USB bus and device address.
+//
+
+
+
+#ifndef __MPSSE_ENUM_H
+#define __MPSSE_ENUM_H
+
+
+
+#include <mpsse.h>
+
+
+
+// Maximum number of devices in the enumeration cache.
+#define MPSSE_ENUM_MAX              32
+
+// Maximum length of the USB strings, including the terminating zero.
+#define MPSSE_ENUM_STR_LEN          64
+
+// Environment variable overriding the path of the cache file.
+#define MPSSE_ENUM_CACHE_ENV        "MPSSE_ENUM_CACHE"
+
+// Name of the cache file in the home directory.
+#define MPSSE_ENUM_CACHE_FILE       ".mpsse_enum.cache"
+
+// Device states recorded in the cache.
+#define MPSSE_ENUM_STATE_UNKNOWN    0   // In use or not closed cleanly. A full reset is required.
+#define MPSSE_ENUM_STATE_IDLE       1   // Closed cleanly: bit mode reset, buffers empty, latency timer set.
+#define MPSSE_ENUM_STATE_MPSSE      2   // Left in MPSSE mode with the recorded pin states. Can be attached to.
+
+
+
+// Enumerated device.
+struct mpsse_enum_dev {
+    char serial[MPSSE_ENUM_STR_LEN];        // Serial number, empty if none.
+    char description[MPSSE_ENUM_STR_LEN];   // Product description.
+    int vid;
+    int pid;
+    int bus;                    // USB bus number.
+    int addr;                   // USB device address on the bus.
+    int state;                  // MPSSE_ENUM_STATE_* state.
+    // Pin states recorded with MPSSE_ENUM_STATE_MPSSE. The pin directions
+    // cannot be read back from the MPSSE.
+    unsigned char low;
+    unsigned char low_dir;
+    unsigned char high;
+    unsigned char high_dir;
+};
+
+
+
+// Function prototypes.
+int mpsse_enum_scan(struct mpsse_enum_dev *devs, int max);
+int mpsse_enum_list(struct mpsse_enum_dev *devs, int max);
+struct mpsse_context *mpsse_enum_open(enum modes mode, int freq, int endianess, const char *serial, int interface, int attach, struct mpsse_enum_dev *dev);
+int mpsse_enum_set_state(const struct mpsse_enum_dev *dev, int state);
+
+
+
+#endif
+
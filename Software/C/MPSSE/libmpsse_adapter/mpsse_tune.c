@@ -0,0 +1,429 @@
+// File: mpsse_tune.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Tuning of the USB settings of an FTDI MPSSE interface.
+//
+// libmpsse always sets the latency timer to LATENCY_MS (2 ms) and the libftdi
+// chunk size to CHUNK_SIZE (65535 bytes). Which settings are best depends on
+// the host, the USB topology and the workload: Short register accesses need a
+// low round trip time, long transfers like flash programming a high
+// throughput.
+//
+// mpsse_tune_run() measures all combinations of a set of latency timer values
+// and chunk sizes on an open adapter:
+// - Round trip: A GET_BITS_LOW command is sent and its result read back.
+// - Stream: MPSSE_TUNE_STREAM_SIZE bytes of SET_BITS_LOW commands repeating
+//   the current pin states are sent, followed by a GET_BITS_LOW round trip.
+// Neither changes any pin, so the adapter may be tuned while devices are
+// connected to it. The best settings for the workload class are applied and
+// saved as the profile of the device interface.
+//
+// When an adapter is opened, the profile of the selected workload class (see
+// mpsse_adapter_select_workload() and MPSSE_TUNE_WORKLOAD_ENV) is applied, if
+// the device has one.
+//
+// Several processes may tune adapters at the same time. Each profile file
+// update is done while holding an exclusive flock() on a lock file next to
+// it, so that no process drops the profile saved by another one.
+//
+// Profile file format, one profile per line:
+// SERIAL IFACE WORKLOAD LATENCY CHUNK_SIZE RTT THROUGHPUT
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <mpsse.h>
+#include "mpsse_adapter.h"
+#include "mpsse_tune.h"
+
+
+
+// Profile of a device interface in the profile file.
+struct mpsse_tune_entry {
+    char serial[MPSSE_ENUM_STR_LEN];
+    int interface;
+    int workload;
+    struct mpsse_tune_profile profile;
+};
+
+
+
+// Global variables.
+// Latency timer values and chunk sizes tried.
+static const int mpsse_tune_latencies[] = { 1, 2, 4, 8, 16 };
+static const int mpsse_tune_chunk_sizes[] = { 512, 4096, 16384, 65535 };
+// Names of the workload classes.
+static const char *mpsse_tune_workloads[MPSSE_TUNE_WORKLOADS] = { "poll", "stream" };
+
+
+
+// Function prototypes.
+static double mpsse_tune_time(void);
+static int mpsse_tune_measure(struct mpsse_adapter *adapter, struct mpsse_tune_profile *profile);
+static int mpsse_tune_path(char *path, int size);
+static int mpsse_tune_lock(void);
+static void mpsse_tune_unlock(int fd);
+static int mpsse_tune_read(struct mpsse_tune_entry *entries, int max);
+
+
+
+// Parse the name of a workload class. Returns the workload class or -1 if the
+// name is invalid.
+int mpsse_tune_parse_workload(const char *name)
+{
+    int i;
+
+    if(name == NULL) return -1;
+    for(i = 0; i < MPSSE_TUNE_WORKLOADS; i++)
+        if(!strcmp(name, mpsse_tune_workloads[i]))
+            return i;
+
+    return -1;
+}
+
+
+
+// Get the name of a workload class.
+const char *mpsse_tune_workload_name(int workload)
+{
+    if(workload < 0 || workload >= MPSSE_TUNE_WORKLOADS) return "unknown";
+
+    return mpsse_tune_workloads[workload];
+}
+
+
+
+// Get the workload class selected by the environment, MPSSE_TUNE_POLL if none
+// is set.
+int mpsse_tune_default_workload(void)
+{
+    int workload;
+
+    workload = mpsse_tune_parse_workload(getenv(MPSSE_TUNE_WORKLOAD_ENV));
+
+    return (workload < 0) ? MPSSE_TUNE_POLL : workload;
+}
+
+
+
+// Measure all USB settings on an adapter and apply the best ones for the
+// workload class. The profile is saved for the device interface and returned
+// in best, if it is not NULL. If verbose is set, the results of all settings
+// are printed.
+int mpsse_tune_run(struct mpsse_adapter *adapter, int workload, struct mpsse_tune_profile *best, int verbose)
+{
+    int i, j;
+    int status = 0;
+    int found = 0;
+    struct mpsse_tune_profile profile, result;
+    const char *serial;
+
+    if(adapter == NULL) return -1;
+    if(workload < 0 || workload >= MPSSE_TUNE_WORKLOADS) {
+        fprintf(stderr, "%s: %s: %sInvalid workload class %d.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, workload);
+        return -1;
+    }
+
+    // Send out deferred commands, then keep other threads off the adapter.
+    if(mpsse_adapter_flush(adapter)) return -1;
+    mpsse_adapter_lock(adapter);
+
+    if(verbose)
+        printf("Latency [ms]  Chunk size [B]  Round trip [us]  Throughput [kB/s]\n");
+    for(i = 0; i < (int) (sizeof(mpsse_tune_latencies) / sizeof(int)) && !status; i++) {
+        for(j = 0; j < (int) (sizeof(mpsse_tune_chunk_sizes) / sizeof(int)) && !status; j++) {
+            profile.latency = mpsse_tune_latencies[i];
+            profile.chunk_size = mpsse_tune_chunk_sizes[j];
+            status |= mpsse_tune_apply(adapter, &profile);
+            status |= mpsse_tune_measure(adapter, &profile);
+            if(status) break;
+            if(verbose)
+                printf("%12d  %14d  %15.1f  %17.1f\n", profile.latency, profile.chunk_size, profile.rtt, profile.throughput / 1000.0);
+            if(!found ||
+               (workload == MPSSE_TUNE_POLL && profile.rtt < result.rtt) ||
+               (workload == MPSSE_TUNE_STREAM && profile.throughput > result.throughput))
+                result = profile;
+            found = 1;
+        }
+    }
+
+    // Apply the best settings.
+    if(found)
+        status |= mpsse_tune_apply(adapter, &result);
+    mpsse_adapter_unlock(adapter);
+    if(status || !found) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sError measuring the USB settings.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    if(verbose)
+        printf("Best settings for workload \"%s\": latency timer %d ms, chunk size %d bytes.\n", mpsse_tune_workloads[workload], result.latency, result.chunk_size);
+    if(best != NULL)
+        *best = result;
+
+    // Save the profile.
+    serial = adapter->enumerated ? adapter->dev.serial : adapter->serial;
+    if(mpsse_tune_save(serial, adapter->interface, workload, &result)) {
+        fprintf(stderr, "%s: %s: %sCannot save the USB settings profile.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Apply USB settings to an adapter.
+// CAUTION: Must only be called while holding the adapter or before it is
+// shared!
+int mpsse_tune_apply(struct mpsse_adapter *adapter, const struct mpsse_tune_profile *profile)
+{
+    int status = 0;
+
+    if(adapter == NULL || profile == NULL) return -1;
+    if(profile->latency < 1 || profile->latency > 255 || profile->chunk_size < 64) return -1;
+
+    if(profile->latency != adapter->latency) {
+        status |= ftdi_set_latency_timer(&adapter->mpsse->ftdi, profile->latency);
+        adapter->latency = status ? -1 : profile->latency;
+    }
+    status |= ftdi_write_data_set_chunksize(&adapter->mpsse->ftdi, profile->chunk_size);
+    status |= ftdi_read_data_set_chunksize(&adapter->mpsse->ftdi, profile->chunk_size);
+
+    return status ? -1 : 0;
+}
+
+
+
+// Load the profile of a device interface for a workload class. Returns -1 if
+// there is none.
+int mpsse_tune_load(const char *serial, int interface, int workload, struct mpsse_tune_profile *profile)
+{
+    struct mpsse_tune_entry entries[MPSSE_TUNE_MAX];
+    int i, count;
+
+    if(serial == NULL)
+        serial = "";
+    count = mpsse_tune_read(entries, MPSSE_TUNE_MAX);
+    for(i = 0; i < count; i++) {
+        if(!strcmp(entries[i].serial, serial) && entries[i].interface == interface && entries[i].workload == workload) {
+            *profile = entries[i].profile;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+
+
+// Save the profile of a device interface for a workload class. An existing
+// profile is replaced. The file is replaced atomically, so that other
+// processes never see a partially written profile file. The profile file is
+// locked from reading until it is replaced.
+int mpsse_tune_save(const char *serial, int interface, int workload, const struct mpsse_tune_profile *profile)
+{
+    struct mpsse_tune_entry entries[MPSSE_TUNE_MAX];
+    char path[1024];
+    char path_tmp[1040];
+    FILE *fp;
+    int i, fd, count;
+    int status = 0;
+
+    if(serial == NULL)
+        serial = "";
+    if(workload < 0 || workload >= MPSSE_TUNE_WORKLOADS) return -1;
+    if(mpsse_tune_path(path, sizeof(path))) return -1;
+
+    // Replace the profile of the device interface or add a new one.
+    fd = mpsse_tune_lock();
+    count = mpsse_tune_read(entries, MPSSE_TUNE_MAX);
+    for(i = 0; i < count; i++)
+        if(!strcmp(entries[i].serial, serial) && entries[i].interface == interface && entries[i].workload == workload)
+            break;
+    if(i == MPSSE_TUNE_MAX) {
+        // Drop the oldest profile.
+        memmove(&entries[0], &entries[1], (MPSSE_TUNE_MAX - 1) * sizeof(struct mpsse_tune_entry));
+        i = --count;
+    }
+    if(i == count)
+        count++;
+    strcpy(entries[i].serial, serial);
+    entries[i].interface = interface;
+    entries[i].workload = workload;
+    entries[i].profile = *profile;
+
+    snprintf(path_tmp, sizeof(path_tmp), "%s.%d", path, (int) getpid());
+    fp = fopen(path_tmp, "w");
+    if(fp == NULL) {
+        mpsse_tune_unlock(fd);
+        return -1;
+    }
+
+    fprintf(fp, "# MPSSE USB settings profiles.\n");
+    fprintf(fp, "# SERIAL IFACE WORKLOAD LATENCY CHUNK_SIZE RTT THROUGHPUT\n");
+    for(i = 0; i < count; i++)
+        fprintf(fp, "%s %c %s %d %d %.1f %.0f\n", entries[i].serial[0] ? entries[i].serial : "-", 'A' + entries[i].interface - IFACE_A,
+                mpsse_tune_workloads[entries[i].workload], entries[i].profile.latency, entries[i].profile.chunk_size,
+                entries[i].profile.rtt, entries[i].profile.throughput);
+    if(fclose(fp) || rename(path_tmp, path)) {
+        unlink(path_tmp);
+        status = -1;
+    }
+    mpsse_tune_unlock(fd);
+
+    return status;
+}
+
+
+
+// Get a monotonic time stamp in us.
+static double mpsse_tune_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+
+// Measure the round trip time and the stream throughput with the current USB
+// settings of an adapter.
+// CAUTION: Must only be called while holding the adapter!
+static int mpsse_tune_measure(struct mpsse_adapter *adapter, struct mpsse_tune_profile *profile)
+{
+    int i;
+    int status = 0;
+    unsigned char data;
+    double t;
+    struct mpsse_cmd cmd;
+
+    mpsse_cmd_init(&cmd);
+
+    // Round trip: read back the low byte pins.
+    t = mpsse_tune_time();
+    for(i = 0; i < MPSSE_TUNE_ROUND_TRIPS && !status; i++) {
+        mpsse_cmd_reset(&cmd);
+        status |= mpsse_cmd_read(&cmd, &data, 1, NULL);
+        status |= mpsse_cmd_byte(&cmd, GET_BITS_LOW);
+        status |= mpsse_cmd_execute(&cmd, adapter->mpsse);
+    }
+    profile->rtt = (mpsse_tune_time() - t) / MPSSE_TUNE_ROUND_TRIPS;
+
+    // Stream: set the low byte pins to their current states over and over
+    // again, then wait for the MPSSE to have executed all commands. The
+    // command buffer is built once and sent repeatedly.
+    mpsse_cmd_reset(&cmd);
+    while(cmd.len + 3 <= MPSSE_TUNE_STREAM_SIZE && !status)
+        status |= mpsse_cmd_set_bits_low(&cmd, adapter->pins.low, adapter->pins.low_dir);
+    status |= mpsse_cmd_read(&cmd, &data, 1, NULL);
+    status |= mpsse_cmd_byte(&cmd, GET_BITS_LOW);
+    t = mpsse_tune_time();
+    for(i = 0; i < MPSSE_TUNE_STREAMS && !status; i++)
+        status |= mpsse_cmd_execute(&cmd, adapter->mpsse);
+    profile->throughput = (double) cmd.len * MPSSE_TUNE_STREAMS / ((mpsse_tune_time() - t) / 1e6);
+
+    mpsse_cmd_free(&cmd);
+
+    return status ? -1 : 0;
+}
+
+
+
+// Get the path of the profile file.
+static int mpsse_tune_path(char *path, int size)
+{
+    const char *env;
+    int len;
+
+    env = getenv(MPSSE_TUNE_PROFILE_ENV);
+    if(env != NULL && *env)
+        len = snprintf(path, size, "%s", env);
+    else if((env = getenv("HOME")) != NULL && *env)
+        len = snprintf(path, size, "%s/%s", env, MPSSE_TUNE_PROFILE_FILE);
+    else
+        return -1;
+
+    return (len < 0 || len >= size) ? -1 : 0;
+}
+
+
+
+// Lock the profile file. Returns the file descriptor of the lock file or -1,
+// if it cannot be locked. The profile file is then updated without the lock.
+static int mpsse_tune_lock(void)
+{
+    char path[1040];
+    int fd;
+
+    if(mpsse_tune_path(path, sizeof(path) - 16)) return -1;
+    strcat(path, ".lock");
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(fd < 0) return -1;
+    if(flock(fd, LOCK_EX)) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+
+// Unlock the profile file.
+static void mpsse_tune_unlock(int fd)
+{
+    if(fd < 0) return;
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+
+
+// Read the profiles from the profile file. Returns the number of profiles, 0
+// if there is no profile file.
+static int mpsse_tune_read(struct mpsse_tune_entry *entries, int max)
+{
+    char path[1024];
+    char line[256];
+    char iface[2], workload[16];
+    FILE *fp;
+    struct mpsse_tune_entry *entry;
+    int count = 0;
+
+    if(mpsse_tune_path(path, sizeof(path))) return 0;
+    fp = fopen(path, "r");
+    if(fp == NULL) return 0;
+
+    while(count < max && fgets(line, sizeof(line), fp) != NULL) {
+        if(line[0] == '#') continue;
+        entry = &entries[count];
+        memset(entry, 0, sizeof(struct mpsse_tune_entry));
+        if(sscanf(line, "%63s %1s %15s %d %d %lf %lf", entry->serial, iface, workload, &entry->profile.latency, &entry->profile.chunk_size,
+                  &entry->profile.rtt, &entry->profile.throughput) < 5)
+            continue;
+        if(!strcmp(entry->serial, "-"))
+            entry->serial[0] = 0;
+        entry->interface = mpsse_adapter_parse_interface(iface);
+        entry->workload = mpsse_tune_parse_workload(workload);
+        if(entry->interface < 0 || entry->workload < 0) continue;
+        count++;
+    }
+    fclose(fp);
+
+    return count;
+}
+
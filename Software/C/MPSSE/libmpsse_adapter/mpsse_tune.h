@@ -0,0 +1,69 @@
+// File: mpsse_tune.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for tuning the USB latency timer and transfer chunk size of an
+// FTDI MPSSE interface. The settings are measured per workload class and kept
+// per device in a profile file, which is applied when an adapter is opened.
+//
+
+
+
+#ifndef __MPSSE_TUNE_H
+#define __MPSSE_TUNE_H
+
+
+
+// Workload classes.
+#define MPSSE_TUNE_POLL             0   // Short register accesses, optimized for round trip latency.
+#define MPSSE_TUNE_STREAM           1   // Long transfers, optimized for throughput.
+#define MPSSE_TUNE_WORKLOADS        2
+
+// Maximum number of profiles in the profile file.
+#define MPSSE_TUNE_MAX              64
+
+// Environment variable overriding the path of the profile file.
+#define MPSSE_TUNE_PROFILE_ENV      "MPSSE_TUNE_PROFILES"
+
+// Environment variable selecting the workload class applied on open.
+#define MPSSE_TUNE_WORKLOAD_ENV     "MPSSE_TUNE_WORKLOAD"
+
+// Name of the profile file in the home directory.
+#define MPSSE_TUNE_PROFILE_FILE     ".mpsse_tune.profiles"
+
+// Number of round trips and stream transfers per measurement.
+#define MPSSE_TUNE_ROUND_TRIPS      200
+#define MPSSE_TUNE_STREAMS          4
+
+// Size of one stream transfer in bytes.
+#define MPSSE_TUNE_STREAM_SIZE      65536
+
+
+
+// USB settings of an MPSSE interface with the results measured for them.
+struct mpsse_tune_profile {
+    int latency;                // Latency timer in ms.
+    int chunk_size;             // Read and write chunk size of libftdi in bytes.
+    double rtt;                 // Mean round trip time in us.
+    double throughput;          // Stream throughput in bytes/s.
+};
+
+struct mpsse_adapter;
+
+
+
+// Function prototypes.
+int mpsse_tune_parse_workload(const char *name);
+const char *mpsse_tune_workload_name(int workload);
+int mpsse_tune_default_workload(void);
+int mpsse_tune_run(struct mpsse_adapter *adapter, int workload, struct mpsse_tune_profile *best, int verbose);
+int mpsse_tune_apply(struct mpsse_adapter *adapter, const struct mpsse_tune_profile *profile);
+int mpsse_tune_load(const char *serial, int interface, int workload, struct mpsse_tune_profile *profile);
+int mpsse_tune_save(const char *serial, int interface, int workload, const struct mpsse_tune_profile *profile);
+
+
+
+#endif
+
@@ -0,0 +1,1128 @@
+// File: swd_mpsse.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// ARM Serial Wire Debug (SWD) functions based on FTDI's Multi-Protocol
+// Synchronous Serial Engine (MPSSE), e.g. for programming the flash memory of
+// Cortex-M microcontrollers.
+//
+// FTDI FT232H pinning:
+// - ADBUS0(13): SWCLK
+// - ADBUS1(14): SWDIO output, connected to SWDIO through a resistor (typ.
+//               470 Ohm)
+// - ADBUS2(15): SWDIO input, connected to SWDIO directly
+// All other pins are left to the GPIO functions, which may share the adapter.
+// The SWD, I2C and MDIO functions use the same pins, so they cannot share an
+// adapter.
+//
+// Thanks to the resistor, ADBUS1 stays an output all the time: when the target
+// drives SWDIO, it overrides the level of ADBUS1. So no pin direction changes
+// are needed for the turnarounds and the SWD transactions become plain
+// streams of MPSSE shift commands. The MPSSE shifts out the bits on the falling
+// SWCLK edge and shifts in the bits driven by the target on the rising SWCLK
+// edge, LSB first.
+//
+// The SWD transactions are compiled into MPSSE command sequences and executed
+// through the MPSSE adapter layer. All transactions of a batch are transferred
+// in one USB transfer. The ACK of a write is not read back. Instead, overrun
+// detection is enabled in the DP CTRL/STAT register when connecting: once a
+// transaction gets a WAIT or FAULT response, the DP sets a sticky error flag
+// and answers all further transactions with FAULT. The data phase is then
+// still performed, so the transactions keep their fixed length. After each
+// batch containing writes, CTRL/STAT is read back and the sticky flags are
+// checked. A batch of writes therefore needs no read-back data except for the
+// final CTRL/STAT, so long block writes are clocked out at the full SWCLK
+// rate.
+//
+// AP reads are posted: the data of an AP read is returned by the next AP read
+// or by a read of the DP RDBUFF register. The batch functions take care of
+// this and append an RDBUFF read where needed, so each read access gets its
+// own data.
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <mpsse.h>
+#include "mpsse_adapter.h"
+#include "swd_mpsse.h"
+
+
+
+// SWD pins.
+#define SWD_MPSSE_SWCLK         SK          // ADBUS0
+#define SWD_MPSSE_SWDIO_OUT     DO          // ADBUS1
+#define SWD_MPSSE_SWDIO_IN      DI          // ADBUS2
+#define SWD_MPSSE_PINS          (SWD_MPSSE_SWCLK | SWD_MPSSE_SWDIO_OUT | SWD_MPSSE_SWDIO_IN)
+
+// MPSSE data shifting commands.
+#define SWD_MPSSE_TX            (MPSSE_DO_WRITE | LSB | MPSSE_WRITE_NEG)
+#define SWD_MPSSE_RX            (MPSSE_DO_READ | LSB)
+
+// Number of idle cycles after a batch, so that the target completes the last
+// transaction before SWCLK stops.
+#define SWD_MPSSE_IDLE_END      8
+
+// Number of CTRL/STAT reads while waiting for the debug power up.
+#define SWD_MPSSE_CONNECT_POLL  100
+
+
+
+// SWD batch job. The ACK, data and parity slots 0 .. num - 1 belong to the
+// frames of the accesses, the slots num .. 2 * num - 1 to the RDBUFF reads
+// appended for posted AP reads and the slot 2 * num to the final CTRL/STAT
+// read.
+struct swd_mpsse_batch_job {
+    struct swd_mpsse_op *ops;
+    int num;
+    int reset;                  // Start with a line reset.
+    int check;                  // Read CTRL/STAT at the end.
+    unsigned char *ack;         // ACKs read back.
+    unsigned char *rx;          // Data read, 4 bytes per slot.
+    unsigned char *par;         // Parity bits read.
+    int *src;                   // Slot of the frame returning the data of a read.
+};
+
+
+
+// Global variables.
+// Default SWD adapter used by the non-reentrant functions.
+static struct mpsse_adapter *swd_mpsse = NULL;
+static pthread_mutex_t swd_mpsse_init_lock = PTHREAD_MUTEX_INITIALIZER;
+static int swd_mpsse_verbose = 1;
+
+
+
+// Function prototypes.
+static struct mpsse_adapter *swd_mpsse_setup(struct mpsse_adapter *adapter);
+static void swd_mpsse_set_op(struct swd_mpsse_op *op, int flags, int adr, unsigned int data);
+static int swd_mpsse_parity(unsigned int data);
+static int swd_mpsse_run(struct mpsse_adapter *adapter, struct swd_mpsse_op *ops, int num, int reset);
+static int swd_mpsse_mem_ops(struct swd_mpsse_op *ops, int ap, unsigned int csw, unsigned int adr, int size, int num, int flags, int idle);
+static int swd_mpsse_write_regs(struct mpsse_adapter *adapter, const unsigned int *adr, const unsigned int *data, int num);
+static int swd_mpsse_flash_wait(struct mpsse_adapter *adapter, const struct swd_mpsse_flash *flash);
+static int swd_mpsse_build_clock(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter);
+static int swd_mpsse_build_idle(struct mpsse_cmd *cmd, int cycles);
+static int swd_mpsse_build_reset(struct mpsse_cmd *cmd);
+static int swd_mpsse_build_frame(struct mpsse_cmd *cmd, int flags, int adr, unsigned int data, unsigned char *ack, unsigned char *rx, unsigned char *par);
+static int swd_mpsse_build_batch(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int swd_mpsse_build_init(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+static int swd_mpsse_build_set_freq(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg);
+
+
+
+// Initialize the SWD hardware.
+int swd_init(void)
+{
+    pthread_mutex_lock(&swd_mpsse_init_lock);
+
+    // Open the default SWD device, if it was not yet initialized.
+    if(swd_mpsse == NULL) {
+        swd_mpsse = swd_mpsse_open();
+        if(swd_mpsse != NULL)
+            swd_mpsse_set_verbose(swd_mpsse, swd_mpsse_verbose);
+    }
+
+    pthread_mutex_unlock(&swd_mpsse_init_lock);
+
+    return (swd_mpsse == NULL) ? -1 : 0;
+}
+
+
+
+// Close the SWD hardware.
+int swd_close(void)
+{
+    pthread_mutex_lock(&swd_mpsse_init_lock);
+    swd_mpsse_close(swd_mpsse);
+    swd_mpsse = NULL;
+    pthread_mutex_unlock(&swd_mpsse_init_lock);
+
+    return 0;
+}
+
+
+
+// Get information about the SWD device.
+int swd_info(void)
+{
+    return swd_mpsse_info(swd_mpsse);
+}
+
+
+
+// Get the SWCLK frequency.
+int swd_get_freq(int *swd_freq)
+{
+    return swd_mpsse_get_freq(swd_mpsse, swd_freq);
+}
+
+
+
+// Set the SWCLK frequency.
+int swd_set_freq(int swd_freq)
+{
+    return swd_mpsse_set_freq(swd_mpsse, swd_freq);
+}
+
+
+
+// Set verbosity of the SWD functions.
+int swd_set_verbose(int verbose)
+{
+    swd_mpsse_verbose = verbose;
+    if(swd_mpsse != NULL)
+        swd_mpsse_set_verbose(swd_mpsse, verbose);
+    return 0;
+}
+
+
+
+// Connect to the debug port of the target.
+int swd_connect(unsigned int *dpidr)
+{
+    return swd_mpsse_connect(swd_mpsse, dpidr);
+}
+
+
+
+// Read a DP register.
+int swd_dp_read(int adr, unsigned int *data)
+{
+    return swd_mpsse_dp_read(swd_mpsse, adr, data);
+}
+
+
+
+// Write a DP register.
+int swd_dp_write(int adr, unsigned int data)
+{
+    return swd_mpsse_dp_write(swd_mpsse, adr, data);
+}
+
+
+
+// Read an AP register.
+int swd_ap_read(int ap, int adr, unsigned int *data)
+{
+    return swd_mpsse_ap_read(swd_mpsse, ap, adr, data);
+}
+
+
+
+// Write an AP register.
+int swd_ap_write(int ap, int adr, unsigned int data)
+{
+    return swd_mpsse_ap_write(swd_mpsse, ap, adr, data);
+}
+
+
+
+// Execute several SWD register accesses in one USB transfer.
+int swd_transfer_batch(struct swd_mpsse_op *ops, int num)
+{
+    return swd_mpsse_transfer_batch(swd_mpsse, ops, num);
+}
+
+
+
+// Read 32-bit words from the memory of the target.
+int swd_mem_read(int ap, unsigned int adr, unsigned int *data, int num)
+{
+    return swd_mpsse_mem_read(swd_mpsse, ap, adr, data, num);
+}
+
+
+
+// Write 32-bit words to the memory of the target.
+int swd_mem_write(int ap, unsigned int adr, const unsigned int *data, int num)
+{
+    return swd_mpsse_mem_write(swd_mpsse, ap, adr, data, num);
+}
+
+
+
+// Erase the flash memory pages of the target.
+int swd_flash_erase(const struct swd_mpsse_flash *flash, unsigned int adr, int len)
+{
+    return swd_mpsse_flash_erase(swd_mpsse, flash, adr, len);
+}
+
+
+
+// Program the flash memory of the target.
+int swd_flash_write(const struct swd_mpsse_flash *flash, unsigned int adr, const unsigned char *data, int len)
+{
+    return swd_mpsse_flash_write(swd_mpsse, flash, adr, data, len);
+}
+
+
+
+// Get the default SWD adapter.
+struct mpsse_adapter *swd_get_adapter(void)
+{
+    return swd_mpsse;
+}
+
+
+
+// Open an SWD adapter.
+// If the adapter is already used by the GPIO functions, the SWD functions
+// share it.
+struct mpsse_adapter *swd_mpsse_open(void)
+{
+    return swd_mpsse_setup(mpsse_adapter_open(SPI0, SWD_MPSSE_FREQ_DEFAULT, LSB));
+}
+
+
+
+// Open an SWD adapter on an interface (IFACE_A .. IFACE_D) of the FTDI device
+// with the given serial number, NULL for the first device found.
+struct mpsse_adapter *swd_mpsse_open_if(const char *serial, int interface)
+{
+    return swd_mpsse_setup(mpsse_adapter_open_if(SPI0, SWD_MPSSE_FREQ_DEFAULT, LSB, serial, interface));
+}
+
+
+
+// Set up the SWD pins of a newly opened adapter.
+static struct mpsse_adapter *swd_mpsse_setup(struct mpsse_adapter *adapter)
+{
+    int status;
+
+    if(adapter == NULL) return NULL;
+
+    status = mpsse_adapter_run(adapter, swd_mpsse_build_init, NULL);
+    if(status) {
+        fprintf(stderr, "%s: %s: %sUnable to set up the SWD pins.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        mpsse_adapter_close(adapter);
+        return NULL;
+    }
+
+    return adapter;
+}
+
+
+
+// Close an SWD adapter.
+int swd_mpsse_close(struct mpsse_adapter *adapter)
+{
+    mpsse_adapter_close(adapter);
+
+    return 0;
+}
+
+
+
+// Get information about an SWD adapter.
+int swd_mpsse_info(struct mpsse_adapter *adapter)
+{
+    // Check if the SWD device was initialized.
+    if(adapter == NULL) {
+        if(swd_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe SWD device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    printf("SWD master device: %s\n", GetDescription(adapter->mpsse));
+    printf("SWD master device VID: 0x%04x\n", GetVid(adapter->mpsse));
+    printf("SWD master device PID: 0x%04x\n", GetPid(adapter->mpsse));
+    printf("SWCLK frequency: %d Hz\n", adapter->swd_freq);
+
+    return 0;
+}
+
+
+
+// Get the SWCLK frequency of an SWD adapter.
+int swd_mpsse_get_freq(struct mpsse_adapter *adapter, int *swd_freq)
+{
+    // Check if the SWD device was initialized.
+    if(adapter == NULL) {
+        if(swd_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe SWD device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    *swd_freq = adapter->swd_freq;
+
+    return 0;
+}
+
+
+
+// Set the SWCLK frequency of an SWD adapter. The resistor in the SWDIO output
+// and the capacitance of the line limit the usable frequency.
+int swd_mpsse_set_freq(struct mpsse_adapter *adapter, int swd_freq)
+{
+    int status;
+
+    // Check if the SWD device was initialized.
+    if(adapter == NULL) {
+        if(swd_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe SWD device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    if(swd_freq <= 0 || swd_freq > SWD_MPSSE_FREQ_MAX) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sInvalid SWCLK frequency of %d Hz.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, swd_freq);
+        return -1;
+    }
+
+    status = mpsse_adapter_run(adapter, swd_mpsse_build_set_freq, &swd_freq);
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to set the SWCLK frequency to %d Hz.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, swd_freq);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Set verbosity of an SWD adapter.
+int swd_mpsse_set_verbose(struct mpsse_adapter *adapter, int verbose)
+{
+    if(adapter == NULL) return -1;
+
+    adapter->verbose = verbose;
+
+    return 0;
+}
+
+
+
+// Connect to the debug port of the target. A JTAG-to-SWD switching sequence
+// framed by line resets is sent and the DPIDR is read, which takes the DP out
+// of its reset state. Then all sticky errors are cleared, the debug and system
+// power domains are powered up and overrun detection is enabled, which is
+// required for the deferred ACK checking of the batches.
+int swd_mpsse_connect(struct mpsse_adapter *adapter, unsigned int *dpidr)
+{
+    int i;
+    unsigned int ctrl_stat;
+    struct swd_mpsse_op ops[3];
+
+    // Check if the SWD device was initialized.
+    if(adapter == NULL) {
+        if(swd_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe SWD device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+
+    swd_mpsse_set_op(&ops[0], SWD_MPSSE_M_RD, SWD_MPSSE_DP_DPIDR, 0);
+    swd_mpsse_set_op(&ops[1], 0, SWD_MPSSE_DP_ABORT, SWD_MPSSE_ABORT_CLEAR);
+    swd_mpsse_set_op(&ops[2], 0, SWD_MPSSE_DP_CTRL_STAT, SWD_MPSSE_CTRL_CSYSPWRUPREQ | SWD_MPSSE_CTRL_CDBGPWRUPREQ | SWD_MPSSE_CTRL_ORUNDETECT);
+    if(swd_mpsse_run(adapter, ops, 3, 1)) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sNo answer from the SWD debug port.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    if(dpidr != NULL)
+        *dpidr = ops[0].data;
+
+    // Wait for the power up.
+    for(i = 0; i < SWD_MPSSE_CONNECT_POLL; i++) {
+        if(swd_mpsse_dp_read(adapter, SWD_MPSSE_DP_CTRL_STAT, &ctrl_stat)) return -1;
+        if((ctrl_stat & SWD_MPSSE_CTRL_CSYSPWRUPACK) && (ctrl_stat & SWD_MPSSE_CTRL_CDBGPWRUPACK))
+            return 0;
+    }
+    if(adapter->verbose)
+        fprintf(stderr, "%s: %s: %sThe debug power domains of the target did not power up (CTRL/STAT = 0x%08x).\n", __FILE__, __FUNCTION__, PREFIX_ERROR, ctrl_stat);
+
+    return -1;
+}
+
+
+
+// Read a DP register.
+int swd_mpsse_dp_read(struct mpsse_adapter *adapter, int adr, unsigned int *data)
+{
+    struct swd_mpsse_op op;
+
+    swd_mpsse_set_op(&op, SWD_MPSSE_M_RD, adr, 0);
+    if(swd_mpsse_transfer_batch(adapter, &op, 1)) return -1;
+    *data = op.data;
+
+    return 0;
+}
+
+
+
+// Write a DP register.
+int swd_mpsse_dp_write(struct mpsse_adapter *adapter, int adr, unsigned int data)
+{
+    struct swd_mpsse_op op;
+
+    swd_mpsse_set_op(&op, 0, adr, data);
+
+    return swd_mpsse_transfer_batch(adapter, &op, 1);
+}
+
+
+
+// Read a register of an AP. The register bank (bits 7..4 of the address) is
+// selected in the DP SELECT register first.
+int swd_mpsse_ap_read(struct mpsse_adapter *adapter, int ap, int adr, unsigned int *data)
+{
+    struct swd_mpsse_op ops[2];
+
+    swd_mpsse_set_op(&ops[0], 0, SWD_MPSSE_DP_SELECT, ((ap & 0xff) << 24) | (adr & 0xf0));
+    swd_mpsse_set_op(&ops[1], SWD_MPSSE_M_AP | SWD_MPSSE_M_RD, adr, 0);
+    if(swd_mpsse_transfer_batch(adapter, ops, 2)) return -1;
+    *data = ops[1].data;
+
+    return 0;
+}
+
+
+
+// Write a register of an AP.
+int swd_mpsse_ap_write(struct mpsse_adapter *adapter, int ap, int adr, unsigned int data)
+{
+    struct swd_mpsse_op ops[2];
+
+    swd_mpsse_set_op(&ops[0], 0, SWD_MPSSE_DP_SELECT, ((ap & 0xff) << 24) | (adr & 0xf0));
+    swd_mpsse_set_op(&ops[1], SWD_MPSSE_M_AP, adr, data);
+
+    return swd_mpsse_transfer_batch(adapter, ops, 2);
+}
+
+
+
+// Execute several SWD register accesses in one USB transfer. The result of
+// each access is stored in its status field (0 = OK, -1 = failed), the data
+// read in its data field. The writes are checked together at the end of the
+// batch: if one of them failed, all writes of the batch are marked as failed.
+// After a failure, the sticky error flags of the DP are cleared.
+// Returns 0 if all accesses succeeded.
+int swd_mpsse_transfer_batch(struct mpsse_adapter *adapter, struct swd_mpsse_op *ops, int num)
+{
+    // Check if the SWD device was initialized.
+    if(adapter == NULL) {
+        if(swd_mpsse_verbose)
+            fprintf(stderr, "%s: %s: %sThe SWD device was not properly initialized.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+        return -1;
+    }
+    if(ops == NULL || num <= 0) return -1;
+
+    return swd_mpsse_run(adapter, ops, num, 0);
+}
+
+
+
+// Read 32-bit words from the memory of the target through a MEM-AP. The address
+// must be word aligned. All words are read in one batch.
+int swd_mpsse_mem_read(struct mpsse_adapter *adapter, int ap, unsigned int adr, unsigned int *data, int num)
+{
+    int i, n;
+    int status;
+    struct swd_mpsse_op *ops;
+
+    if(adr & 3 || num <= 0) return -1;
+
+    ops = malloc((num + num / (SWD_MPSSE_TAR_BLOCK / 4) + 3) * sizeof(struct swd_mpsse_op));
+    if(ops == NULL) return -1;
+    n = swd_mpsse_mem_ops(ops, ap, SWD_MPSSE_CSW_32, adr, 4, num, SWD_MPSSE_M_RD, 0);
+    status = swd_mpsse_transfer_batch(adapter, ops, n);
+    if(!status) {
+        for(i = 0, n = 0; n < num; i++)
+            if(ops[i].flags & SWD_MPSSE_M_RD)
+                data[n++] = ops[i].data;
+    } else if(adapter->verbose) {
+        fprintf(stderr, "%s: %s: %sUnable to read %d word(s) from the target address 0x%08x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, num, adr);
+    }
+    free(ops);
+
+    return status;
+}
+
+
+
+// Write 32-bit words to the memory of the target through a MEM-AP. The address
+// must be word aligned. All words are written in one batch.
+int swd_mpsse_mem_write(struct mpsse_adapter *adapter, int ap, unsigned int adr, const unsigned int *data, int num)
+{
+    int i, n;
+    int status;
+    struct swd_mpsse_op *ops;
+
+    if(adr & 3 || num <= 0) return -1;
+
+    ops = malloc((num + num / (SWD_MPSSE_TAR_BLOCK / 4) + 3) * sizeof(struct swd_mpsse_op));
+    if(ops == NULL) return -1;
+    n = swd_mpsse_mem_ops(ops, ap, SWD_MPSSE_CSW_32, adr, 4, num, 0, 0);
+    for(i = 0, num = 0; i < n; i++)
+        if(ops[i].flags & SWD_MPSSE_M_AP && ops[i].adr == SWD_MPSSE_AP_DRW)
+            ops[i].data = data[num++];
+    status = swd_mpsse_transfer_batch(adapter, ops, n);
+    if(status && adapter->verbose)
+        fprintf(stderr, "%s: %s: %sUnable to write %d word(s) to the target address 0x%08x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, num, adr);
+    free(ops);
+
+    return status;
+}
+
+
+
+// Erase the flash memory pages containing the address range adr .. adr + len - 1.
+int swd_mpsse_flash_erase(struct mpsse_adapter *adapter, const struct swd_mpsse_flash *flash, unsigned int adr, int len)
+{
+    int status = 0;
+    unsigned int page;
+    unsigned int regs[5], data[5];
+
+    if(adapter == NULL || flash == NULL || len <= 0 || flash->page_size <= 0) return -1;
+
+    // Unlock the flash controller and clear its error flags.
+    regs[0] = flash->key_adr;
+    data[0] = flash->key[0];
+    regs[1] = flash->key_adr;
+    data[1] = flash->key[1];
+    regs[2] = flash->sr_adr;
+    data[2] = flash->sr_error;
+    if(flash->key_adr)
+        status = swd_mpsse_write_regs(adapter, regs, data, 3);
+    else
+        status = swd_mpsse_write_regs(adapter, regs + 2, data + 2, 1);
+
+    // Erase the pages one by one.
+    for(page = adr - (adr % flash->page_size); !status && page < adr + len; page += flash->page_size) {
+        regs[0] = flash->cr_adr;
+        data[0] = flash->cr_erase;
+        regs[1] = flash->ar_adr;
+        data[1] = page;
+        regs[2] = flash->cr_adr;
+        data[2] = flash->cr_erase | flash->cr_start;
+        status = swd_mpsse_write_regs(adapter, regs, data, 3);
+        if(!status)
+            status = swd_mpsse_flash_wait(adapter, flash);
+        if(status && adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to erase the flash memory page at address 0x%08x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, page);
+    }
+
+    // Lock the flash controller again.
+    regs[0] = flash->cr_adr;
+    data[0] = flash->cr_lock;
+    status |= swd_mpsse_write_regs(adapter, regs, data, 1);
+
+    return status ? -1 : 0;
+}
+
+
+
+// Program the flash memory of the target, which must have been erased. The
+// address and length must be multiples of the program unit. The data is
+// streamed in chunks of SWD_MPSSE_FLASH_CHUNK bytes, each being one batch. The
+// programming time of each unit is covered by idle cycles clocked after it,
+// so that the flash controller never stalls the bus.
+int swd_mpsse_flash_write(struct mpsse_adapter *adapter, const struct swd_mpsse_flash *flash, unsigned int adr, const unsigned char *data, int len)
+{
+    int i, j, n, k;
+    int status = 0;
+    int units, chunk, idle;
+    unsigned int a, value;
+    unsigned int regs[4], vals[4];
+    struct swd_mpsse_op *ops;
+
+    if(adapter == NULL || flash == NULL || data == NULL || len <= 0) return -1;
+    if((flash->width != 2 && flash->width != 4) || adr % flash->width || len % flash->width) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sThe address 0x%08x and length %d are not aligned to the program unit of %d bytes.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, adr, len, flash->width);
+        return -1;
+    }
+
+    // Program units per batch. The delay of a batch must stay below the
+    // read timeout of the final CTRL/STAT read.
+    units = SWD_MPSSE_FLASH_CHUNK / flash->width;
+    if(flash->prog_time > 0 && units > MPSSE_ADAPTER_DELAY_MAX / flash->prog_time)
+        units = MPSSE_ADAPTER_DELAY_MAX / flash->prog_time;
+    idle = (int) (((long long) flash->prog_time * adapter->swd_freq + 999999) / 1000000);
+    ops = malloc((units + units * flash->width / SWD_MPSSE_TAR_BLOCK + 3) * sizeof(struct swd_mpsse_op));
+    if(ops == NULL) return -1;
+
+    // Unlock the flash controller, clear its error flags and enable
+    // programming.
+    n = 0;
+    if(flash->key_adr) {
+        regs[n] = flash->key_adr;
+        vals[n++] = flash->key[0];
+        regs[n] = flash->key_adr;
+        vals[n++] = flash->key[1];
+    }
+    regs[n] = flash->sr_adr;
+    vals[n++] = flash->sr_error;
+    regs[n] = flash->cr_adr;
+    vals[n++] = flash->cr_prog;
+    status = swd_mpsse_write_regs(adapter, regs, vals, n);
+
+    // Stream the data.
+    for(i = 0; !status && i < len; i += chunk) {
+        chunk = len - i;
+        if(chunk > units * flash->width)
+            chunk = units * flash->width;
+        n = swd_mpsse_mem_ops(ops, 0, (flash->width == 2) ? SWD_MPSSE_CSW_16 : SWD_MPSSE_CSW_32, adr + i, flash->width, chunk / flash->width, 0, idle);
+        for(j = 0, k = i; j < n; j++) {
+            if(!(ops[j].flags & SWD_MPSSE_M_AP) || ops[j].adr != SWD_MPSSE_AP_DRW) continue;
+            a = adr + k;
+            if(flash->width == 2) {
+                // Half-words are transferred on the byte lanes of their
+                // address.
+                value = data[k] | (data[k + 1] << 8);
+                value <<= 8 * (a & 2);
+            } else {
+                value = data[k] | (data[k + 1] << 8) | (data[k + 2] << 16) | ((unsigned int) data[k + 3] << 24);
+            }
+            ops[j].data = value;
+            k += flash->width;
+        }
+        status = swd_mpsse_transfer_batch(adapter, ops, n);
+        if(!status)
+            status = swd_mpsse_flash_wait(adapter, flash);
+        if(status && adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to program %d byte(s) of flash memory at address 0x%08x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, chunk, adr + i);
+    }
+    free(ops);
+
+    // Lock the flash controller again.
+    regs[0] = flash->cr_adr;
+    vals[0] = flash->cr_lock;
+    status |= swd_mpsse_write_regs(adapter, regs, vals, 1);
+
+    return status ? -1 : 0;
+}
+
+
+
+// Fill in an SWD register access.
+static void swd_mpsse_set_op(struct swd_mpsse_op *op, int flags, int adr, unsigned int data)
+{
+    op->flags = flags;
+    op->adr = adr;
+    op->data = data;
+    op->idle = 0;
+    op->status = 0;
+}
+
+
+
+// Get the even parity of a data word.
+static int swd_mpsse_parity(unsigned int data)
+{
+    data ^= data >> 16;
+    data ^= data >> 8;
+    data ^= data >> 4;
+    data ^= data >> 2;
+    data ^= data >> 1;
+
+    return data & 1;
+}
+
+
+
+// Execute a batch of SWD register accesses, optionally starting with a line
+// reset, and check the results.
+static int swd_mpsse_run(struct mpsse_adapter *adapter, struct swd_mpsse_op *ops, int num, int reset)
+{
+    int i;
+    int status;
+    int read;
+    unsigned int data, ctrl_stat;
+    struct swd_mpsse_batch_job job;
+    struct swd_mpsse_op op_abort;
+
+    // Allocate the read-back slots. Unused ACK slots read as OK.
+    job.ops = ops;
+    job.num = num;
+    job.reset = reset;
+    job.check = 0;
+    for(i = 0; i < num; i++)
+        if(!(ops[i].flags & SWD_MPSSE_M_RD))
+            job.check = 1;
+    job.ack = malloc(2 * num + 1);
+    job.rx = malloc(4 * (2 * num + 1));
+    job.par = malloc(2 * num + 1);
+    job.src = malloc(num * sizeof(int));
+    if(job.ack == NULL || job.rx == NULL || job.par == NULL || job.src == NULL) {
+        status = -1;
+    } else {
+        memset(job.ack, SWD_MPSSE_ACK_OK << 5, 2 * num + 1);
+        status = mpsse_adapter_run(adapter, swd_mpsse_build_batch, &job);
+    }
+    if(status) {
+        if(adapter->verbose)
+            fprintf(stderr, "%s: %s: %sUnable to execute a batch of %d SWD access(es).\n", __FILE__, __FUNCTION__, PREFIX_ERROR, num);
+        for(i = 0; i < num; i++)
+            ops[i].status = -1;
+        free(job.ack);
+        free(job.rx);
+        free(job.par);
+        free(job.src);
+        return -1;
+    }
+
+    // Check the ACKs and the parity of the reads.
+    for(i = 0; i < num; i++) {
+        ops[i].status = 0;
+        read = (ops[i].flags & SWD_MPSSE_M_RD) ? 1 : 0;
+        if(!read) continue;
+        if((job.ack[i] >> 5) != SWD_MPSSE_ACK_OK || (job.ack[job.src[i]] >> 5) != SWD_MPSSE_ACK_OK) {
+            if(adapter->verbose)
+                fprintf(stderr, "%s: %s: %sSWD read of %s register 0x%02x failed with ACK 0x%x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, (ops[i].flags & SWD_MPSSE_M_AP) ? "AP" : "DP", ops[i].adr, ((job.ack[i] >> 5) != SWD_MPSSE_ACK_OK) ? job.ack[i] >> 5 : job.ack[job.src[i]] >> 5);
+            ops[i].status = -1;
+            status = -1;
+            continue;
+        }
+        data = job.rx[4 * i] | (job.rx[4 * i + 1] << 8) | (job.rx[4 * i + 2] << 16) | ((unsigned int) job.rx[4 * i + 3] << 24);
+        if(swd_mpsse_parity(data) != ((job.par[i] >> 6) & 1)) {
+            if(adapter->verbose)
+                fprintf(stderr, "%s: %s: %sParity error in the SWD read of %s register 0x%02x.\n", __FILE__, __FUNCTION__, PREFIX_ERROR, (ops[i].flags & SWD_MPSSE_M_AP) ? "AP" : "DP", ops[i].adr);
+            ops[i].status = -1;
+            status = -1;
+            continue;
+        }
+        ops[i].data = data;
+    }
+
+    // Check the sticky error flags for the writes.
+    if(job.check) {
+        ctrl_stat = job.rx[8 * num] | (job.rx[8 * num + 1] << 8) | (job.rx[8 * num + 2] << 16) | ((unsigned int) job.rx[8 * num + 3] << 24);
+        if((job.ack[2 * num] >> 5) != SWD_MPSSE_ACK_OK || (ctrl_stat & SWD_MPSSE_CTRL_STICKY)) {
+            if(adapter->verbose)
+                fprintf(stderr, "%s: %s: %sSWD write failed (ACK 0x%x, CTRL/STAT = 0x%08x).\n", __FILE__, __FUNCTION__, PREFIX_ERROR, job.ack[2 * num] >> 5, ctrl_stat);
+            for(i = 0; i < num; i++)
+                if(!(ops[i].flags & SWD_MPSSE_M_RD))
+                    ops[i].status = -1;
+            status = -1;
+        }
+    }
+    free(job.ack);
+    free(job.rx);
+    free(job.par);
+    free(job.src);
+
+    // Clear the sticky error flags, so that the DP accepts transactions again.
+    if(status) {
+        swd_mpsse_set_op(&op_abort, 0, SWD_MPSSE_DP_ABORT, SWD_MPSSE_ABORT_CLEAR);
+        job.ops = &op_abort;
+        job.num = 1;
+        job.reset = 0;
+        job.check = 0;
+        job.ack = NULL;
+        job.rx = NULL;
+        job.par = NULL;
+        job.src = NULL;
+        mpsse_adapter_run(adapter, swd_mpsse_build_batch, &job);
+    }
+
+    return status;
+}
+
+
+
+// Fill in the MEM-AP accesses of a block transfer of num units of size bytes.
+// The TAR is set again at each 1 kB boundary. Returns the number of accesses.
+static int swd_mpsse_mem_ops(struct swd_mpsse_op *ops, int ap, unsigned int csw, unsigned int adr, int size, int num, int flags, int idle)
+{
+    int i, n = 0;
+    unsigned int a;
+
+    swd_mpsse_set_op(&ops[n++], 0, SWD_MPSSE_DP_SELECT, (ap & 0xff) << 24);
+    swd_mpsse_set_op(&ops[n++], SWD_MPSSE_M_AP, SWD_MPSSE_AP_CSW, csw);
+    for(i = 0; i < num; i++) {
+        a = adr + i * size;
+        if(i == 0 || (a % SWD_MPSSE_TAR_BLOCK) == 0)
+            swd_mpsse_set_op(&ops[n++], SWD_MPSSE_M_AP, SWD_MPSSE_AP_TAR, a);
+        swd_mpsse_set_op(&ops[n], SWD_MPSSE_M_AP | flags, SWD_MPSSE_AP_DRW, 0);
+        ops[n++].idle = idle;
+    }
+
+    return n;
+}
+
+
+
+// Write single 32-bit registers of the target in one batch.
+static int swd_mpsse_write_regs(struct mpsse_adapter *adapter, const unsigned int *adr, const unsigned int *data, int num)
+{
+    int i, n = 0;
+    struct swd_mpsse_op ops[2 + 2 * 8];
+
+    if(num > 8) return -1;
+
+    swd_mpsse_set_op(&ops[n++], 0, SWD_MPSSE_DP_SELECT, 0);
+    swd_mpsse_set_op(&ops[n++], SWD_MPSSE_M_AP, SWD_MPSSE_AP_CSW, SWD_MPSSE_CSW_32);
+    for(i = 0; i < num; i++) {
+        swd_mpsse_set_op(&ops[n++], SWD_MPSSE_M_AP, SWD_MPSSE_AP_TAR, adr[i]);
+        swd_mpsse_set_op(&ops[n++], SWD_MPSSE_M_AP, SWD_MPSSE_AP_DRW, data[i]);
+    }
+
+    return swd_mpsse_transfer_batch(adapter, ops, n);
+}
+
+
+
+// Wait for the flash controller to finish and check its error flags.
+static int swd_mpsse_flash_wait(struct mpsse_adapter *adapter, const struct swd_mpsse_flash *flash)
+{
+    int i;
+    unsigned int sr;
+
+    for(i = 0; i < SWD_MPSSE_FLASH_POLL; i++) {
+        if(swd_mpsse_mem_read(adapter, 0, flash->sr_adr, &sr, 1)) return -1;
+        if(sr & flash->sr_busy) continue;
+        if(sr & flash->sr_error) {
+            if(adapter->verbose)
+                fprintf(stderr, "%s: %s: %sFlash controller error (status = 0x%08x).\n", __FILE__, __FUNCTION__, PREFIX_ERROR, sr);
+            return -1;
+        }
+        return 0;
+    }
+    if(adapter->verbose)
+        fprintf(stderr, "%s: %s: %sTimeout waiting for the flash controller.\n", __FILE__, __FUNCTION__, PREFIX_ERROR);
+
+    return -1;
+}
+
+
+
+// Build switching to the SWCLK frequency and to two phase clocking, in case
+// another engine sharing the adapter has changed them.
+static int swd_mpsse_build_clock(struct mpsse_cmd *cmd, struct mpsse_adapter *adapter)
+{
+    int status = 0;
+
+    if(adapter->three_phase) {
+        status |= mpsse_cmd_byte(cmd, DISABLE_3_PHASE_CLOCK);
+        adapter->three_phase = 0;
+    }
+    if(mpsse_adapter_get_clock(adapter->swd_freq) != adapter->mpsse->clock)
+        status |= mpsse_adapter_set_clock(cmd, adapter->mpsse, adapter->swd_freq);
+
+    return status;
+}
+
+
+
+// Build idle cycles: SWCLK is clocked with SWDIO low.
+static int swd_mpsse_build_idle(struct mpsse_cmd *cmd, int cycles)
+{
+    int status = 0;
+    int n;
+    unsigned char buf[3 + 64];
+
+    memset(buf, 0, sizeof(buf));
+    for(; cycles >= 8; cycles -= 8 * n) {
+        n = cycles / 8;
+        if(n > 64) n = 64;
+        buf[0] = SWD_MPSSE_TX;
+        buf[1] = n - 1;
+        buf[2] = 0;
+        status |= mpsse_cmd_bytes(cmd, buf, 3 + n);
+    }
+    if(cycles > 0) {
+        buf[0] = SWD_MPSSE_TX | MPSSE_BITMODE;
+        buf[1] = cycles - 1;
+        buf[2] = 0;
+        status |= mpsse_cmd_bytes(cmd, buf, 3);
+    }
+
+    return status;
+}
+
+
+
+// Build a line reset with the JTAG-to-SWD switching sequence: 56 cycles with
+// SWDIO high, the 16-bit sequence 0xe79e, again 56 cycles with SWDIO high and
+// 8 idle cycles.
+static int swd_mpsse_build_reset(struct mpsse_cmd *cmd)
+{
+    unsigned char buf[3 + 7 + 2 + 7 + 1];
+
+    buf[0] = SWD_MPSSE_TX;
+    buf[1] = sizeof(buf) - 3 - 1;
+    buf[2] = 0;
+    memset(buf + 3, 0xff, 7);
+    buf[10] = 0x9e;
+    buf[11] = 0xe7;
+    memset(buf + 12, 0xff, 7);
+    buf[19] = 0x00;
+
+    return mpsse_cmd_bytes(cmd, buf, sizeof(buf));
+}
+
+
+
+// Build one SWD transaction: the 8-bit request, a turnaround, the 3-bit ACK
+// and the data phase of 32 data bits and parity. A read ends with another
+// turnaround, a write has its turnaround before the data phase.
+// For a read, the ACK, the data and the parity bit are read back into ack, rx
+// and par, any of which may be NULL to discard them. For a write, the ACK is
+// only read back if ack is not NULL.
+// The ACK is read back in bits 7..5 of ack, the parity in bit 6 of par.
+static int swd_mpsse_build_frame(struct mpsse_cmd *cmd, int flags, int adr, unsigned int data, unsigned char *ack, unsigned char *rx, unsigned char *par)
+{
+    int status = 0;
+    int ap, rd, a2, a3;
+    unsigned char buf[8];
+
+    // Request: start, APnDP, RnW, A[2:3], parity, stop, park.
+    ap = (flags & SWD_MPSSE_M_AP) ? 1 : 0;
+    rd = (flags & SWD_MPSSE_M_RD) ? 1 : 0;
+    a2 = (adr >> 2) & 1;
+    a3 = (adr >> 3) & 1;
+    buf[0] = SWD_MPSSE_TX;
+    buf[1] = 0;
+    buf[2] = 0;
+    buf[3] = 0x81 | (ap << 1) | (rd << 2) | (a2 << 3) | (a3 << 4) | (((ap + rd + a2 + a3) & 1) << 5);
+    status |= mpsse_cmd_bytes(cmd, buf, 4);
+
+    // Turnaround and ACK.
+    if(rd || ack != NULL) {
+        status |= mpsse_cmd_read(cmd, ack, 1, NULL);
+        buf[0] = SWD_MPSSE_RX | MPSSE_BITMODE;
+        buf[1] = 4 - 1;
+    } else {
+        buf[0] = CLK_BITS;
+        buf[1] = 4 - 1;
+    }
+    status |= mpsse_cmd_bytes(cmd, buf, 2);
+
+    if(rd) {
+        // Data and parity driven by the target, followed by a turnaround.
+        status |= mpsse_cmd_read(cmd, rx, 4, NULL);
+        buf[0] = SWD_MPSSE_RX;
+        buf[1] = 4 - 1;
+        buf[2] = 0;
+        status |= mpsse_cmd_bytes(cmd, buf, 3);
+        status |= mpsse_cmd_read(cmd, par, 1, NULL);
+        buf[0] = SWD_MPSSE_RX | MPSSE_BITMODE;
+        buf[1] = 2 - 1;
+        status |= mpsse_cmd_bytes(cmd, buf, 2);
+    } else {
+        // Turnaround, then data and parity.
+        buf[0] = SWD_MPSSE_TX;
+        buf[1] = 4 - 1;
+        buf[2] = 0;
+        buf[3] = (data << 1) & 0xff;
+        buf[4] = (data >> 7) & 0xff;
+        buf[5] = (data >> 15) & 0xff;
+        buf[6] = (data >> 23) & 0xff;
+        status |= mpsse_cmd_bytes(cmd, buf, 7);
+        buf[0] = SWD_MPSSE_TX | MPSSE_BITMODE;
+        buf[1] = 2 - 1;
+        buf[2] = ((data >> 31) & 1) | (swd_mpsse_parity(data) << 1);
+        status |= mpsse_cmd_bytes(cmd, buf, 3);
+    }
+
+    return status ? -1 : 0;
+}
+
+
+
+// Build the SWD transactions of a batch job. The data of a posted AP read is
+// read back with the next AP read or with an RDBUFF read appended.
+static int swd_mpsse_build_batch(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    int i;
+    int status = 0;
+    int pending = -1;
+    struct swd_mpsse_batch_job *job = (struct swd_mpsse_batch_job *) arg;
+    struct swd_mpsse_op *op;
+
+    status |= swd_mpsse_build_clock(cmd, adapter);
+    if(job->reset)
+        status |= swd_mpsse_build_reset(cmd);
+
+    for(i = 0; i < job->num; i++) {
+        op = &job->ops[i];
+        // Return the data of a pending AP read.
+        if(pending >= 0 && !((op->flags & SWD_MPSSE_M_AP) && (op->flags & SWD_MPSSE_M_RD))) {
+            status |= swd_mpsse_build_frame(cmd, SWD_MPSSE_M_RD, SWD_MPSSE_DP_RDBUFF, 0, &job->ack[job->num + pending], &job->rx[4 * pending], &job->par[pending]);
+            job->src[pending] = job->num + pending;
+            pending = -1;
+        }
+        if(!(op->flags & SWD_MPSSE_M_RD)) {
+            // Write, the ACK is checked at the end of the batch.
+            status |= swd_mpsse_build_frame(cmd, op->flags, op->adr, op->data, NULL, NULL, NULL);
+        } else if(op->flags & SWD_MPSSE_M_AP) {
+            // Posted AP read, returning the data of the previous one.
+            if(pending >= 0) {
+                status |= swd_mpsse_build_frame(cmd, op->flags, op->adr, 0, &job->ack[i], &job->rx[4 * pending], &job->par[pending]);
+                job->src[pending] = i;
+            } else {
+                status |= swd_mpsse_build_frame(cmd, op->flags, op->adr, 0, &job->ack[i], NULL, NULL);
+            }
+            pending = i;
+        } else {
+            // DP read.
+            status |= swd_mpsse_build_frame(cmd, op->flags, op->adr, 0, &job->ack[i], &job->rx[4 * i], &job->par[i]);
+            job->src[i] = i;
+        }
+        if(op->idle > 0)
+            status |= swd_mpsse_build_idle(cmd, op->idle);
+    }
+    if(pending >= 0) {
+        status |= swd_mpsse_build_frame(cmd, SWD_MPSSE_M_RD, SWD_MPSSE_DP_RDBUFF, 0, &job->ack[job->num + pending], &job->rx[4 * pending], &job->par[pending]);
+        job->src[pending] = job->num + pending;
+    }
+
+    // Read back CTRL/STAT for checking the sticky error flags of the writes.
+    if(job->check)
+        status |= swd_mpsse_build_frame(cmd, SWD_MPSSE_M_RD, SWD_MPSSE_DP_CTRL_STAT, 0, &job->ack[2 * job->num], &job->rx[8 * job->num], NULL);
+
+    status |= swd_mpsse_build_idle(cmd, SWD_MPSSE_IDLE_END);
+
+    return status ? -1 : 0;
+}
+
+
+
+// Build the set up of the SWD pins and clocking.
+static int swd_mpsse_build_init(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    int status = 0;
+
+    // The I2C and MDIO functions use the same pins.
+    if(adapter->engines & MPSSE_ADAPTER_ENGINES_SERIAL & ~MPSSE_ADAPTER_ENGINE_SWD) return -1;
+
+    // Drive SWCLK and SWDIO push-pull with two phase clocking and without
+    // adaptive clocking.
+    status |= mpsse_cmd_byte(cmd, DISABLE_3_PHASE_CLOCK);
+    adapter->three_phase = 0;
+    if(adapter->adaptive)
+        status |= mpsse_adapter_set_adaptive(adapter, cmd, 0);
+    if(adapter->mpsse->ftdi.type == TYPE_232H && (adapter->pins.low_od & SWD_MPSSE_PINS))
+        status |= mpsse_adapter_set_open_drain(adapter, cmd, adapter->pins.low_od & ~SWD_MPSSE_PINS, adapter->pins.high_od);
+    // SWCLK and SWDIO idle low. ADBUS1 stays an output.
+    status |= mpsse_adapter_set_low(adapter, cmd, 0, SWD_MPSSE_SWCLK | SWD_MPSSE_SWDIO_OUT, SWD_MPSSE_PINS);
+    // Set the default SWCLK frequency, unless another SWD user of the adapter
+    // has already set it.
+    if(!(adapter->engines & MPSSE_ADAPTER_ENGINE_SWD))
+        adapter->swd_freq = SWD_MPSSE_FREQ_DEFAULT;
+    status |= swd_mpsse_build_clock(cmd, adapter);
+    if(status) return -1;
+
+    adapter->engines |= MPSSE_ADAPTER_ENGINE_SWD;
+
+    return 0;
+}
+
+
+
+// Build the setting of the SWCLK frequency.
+static int swd_mpsse_build_set_freq(struct mpsse_adapter *adapter, struct mpsse_cmd *cmd, void *arg)
+{
+    if(mpsse_adapter_set_clock(cmd, adapter->mpsse, *((int *) arg))) return -1;
+
+    adapter->swd_freq = *((int *) arg);
+
+    return 0;
+}
+
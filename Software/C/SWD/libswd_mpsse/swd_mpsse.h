@@ -0,0 +1,162 @@
+// File: swd_mpsse.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for the ARM Serial Wire Debug (SWD) functions based on FTDI's
+// Multi-Protocol Synchronous Serial Engine (MPSSE).
+//
+
+
+
+#ifndef __SWD_MPSSE_H
+#define __SWD_MPSSE_H
+
+
+
+// Message prefixes.
+#define PREFIX_DEBUG            "DEBUG: "
+#define PREFIX_ERROR            "ERROR: "
+
+
+
+// SWCLK frequencies.
+#define SWD_MPSSE_FREQ_DEFAULT      1000000
+#define SWD_MPSSE_FREQ_MAX          30000000
+
+// SWD operation flags.
+#define SWD_MPSSE_M_AP          0x0001      // Access an AP register, else a DP register.
+#define SWD_MPSSE_M_RD          0x0002      // Read the register.
+
+// SWD acknowledge responses.
+#define SWD_MPSSE_ACK_OK        0x1
+#define SWD_MPSSE_ACK_WAIT      0x2
+#define SWD_MPSSE_ACK_FAULT     0x4
+
+// DP registers.
+#define SWD_MPSSE_DP_DPIDR      0x0         // Read only.
+#define SWD_MPSSE_DP_ABORT      0x0         // Write only.
+#define SWD_MPSSE_DP_CTRL_STAT  0x4
+#define SWD_MPSSE_DP_SELECT     0x8         // Write only.
+#define SWD_MPSSE_DP_RDBUFF     0xc         // Read only.
+
+// DP CTRL/STAT bits.
+#define SWD_MPSSE_CTRL_ORUNDETECT   0x00000001
+#define SWD_MPSSE_CTRL_STICKYORUN   0x00000002
+#define SWD_MPSSE_CTRL_STICKYCMP    0x00000010
+#define SWD_MPSSE_CTRL_STICKYERR    0x00000020
+#define SWD_MPSSE_CTRL_WDATAERR     0x00000080
+#define SWD_MPSSE_CTRL_CDBGPWRUPREQ 0x10000000
+#define SWD_MPSSE_CTRL_CDBGPWRUPACK 0x20000000
+#define SWD_MPSSE_CTRL_CSYSPWRUPREQ 0x40000000
+#define SWD_MPSSE_CTRL_CSYSPWRUPACK 0x80000000
+#define SWD_MPSSE_CTRL_STICKY       (SWD_MPSSE_CTRL_STICKYORUN | SWD_MPSSE_CTRL_STICKYCMP | SWD_MPSSE_CTRL_STICKYERR | SWD_MPSSE_CTRL_WDATAERR)
+
+// DP ABORT value clearing all sticky error flags.
+#define SWD_MPSSE_ABORT_CLEAR   0x0000001e
+
+// MEM-AP registers. Bits 7..4 select the register bank.
+#define SWD_MPSSE_AP_CSW        0x00
+#define SWD_MPSSE_AP_TAR        0x04
+#define SWD_MPSSE_AP_DRW        0x0c
+#define SWD_MPSSE_AP_IDR        0xfc
+
+// MEM-AP CSW values for 16-bit and 32-bit accesses with single address
+// increment.
+#define SWD_MPSSE_CSW_16        0x23000011
+#define SWD_MPSSE_CSW_32        0x23000012
+
+// The TAR auto-increment is only guaranteed within blocks of 1 kB.
+#define SWD_MPSSE_TAR_BLOCK     1024
+
+// Number of bytes written to the flash memory per USB transfer.
+#define SWD_MPSSE_FLASH_CHUNK   4096
+
+// Number of status register reads while waiting for the flash controller.
+#define SWD_MPSSE_FLASH_POLL    1000
+
+
+
+// SWD register access, used for executing several accesses in one USB
+// transfer.
+struct swd_mpsse_op {
+    int flags;                  // SWD_MPSSE_M_* flags.
+    int adr;                    // Register address, bits 3..2 (A[3:2]).
+    unsigned int data;          // Data written or read.
+    int idle;                   // Idle cycles after the access.
+    int status;                 // Result: 0 = OK, -1 = failed.
+};
+
+// Flash controller, programmed through memory-mapped registers. The data is
+// written to the flash memory addresses directly, one program unit after the
+// other. The error flags are cleared by writing ones to them.
+struct swd_mpsse_flash {
+    unsigned int key_adr;       // Key register, 0 if no unlock is needed.
+    unsigned int key[2];        // Unlock key sequence.
+    unsigned int cr_adr;        // Control register.
+    unsigned int cr_prog;       // Control register value for programming.
+    unsigned int cr_erase;      // Control register value for erasing a page.
+    unsigned int cr_start;      // Control register bit starting the erase.
+    unsigned int cr_lock;       // Control register value after programming.
+    unsigned int ar_adr;        // Address register of the page erase.
+    unsigned int sr_adr;        // Status register.
+    unsigned int sr_busy;       // Busy flags of the status register.
+    unsigned int sr_error;      // Error flags of the status register.
+    int width;                  // Program unit in bytes: 2 or 4.
+    int prog_time;              // Programming time of a program unit in us.
+    int page_size;              // Erase page size in bytes.
+};
+
+// Flash controller of the STM32F1 (1 kB pages up to medium density devices).
+#define SWD_MPSSE_FLASH_STM32F1 { 0x40022004, { 0x45670123, 0xcdef89ab }, \
+                                  0x40022010, 0x00000001, 0x00000002, 0x00000040, 0x00000080, \
+                                  0x40022014, 0x4002200c, 0x00000001, 0x00000014, 2, 70, 1024 }
+
+struct mpsse_adapter;
+
+
+
+// Function prototypes.
+// Functions operating on the default SWD adapter.
+int swd_init(void);
+int swd_close(void);
+int swd_info(void);
+int swd_get_freq(int *swd_freq);
+int swd_set_freq(int swd_freq);
+int swd_set_verbose(int verbose);
+int swd_connect(unsigned int *dpidr);
+int swd_dp_read(int adr, unsigned int *data);
+int swd_dp_write(int adr, unsigned int data);
+int swd_ap_read(int ap, int adr, unsigned int *data);
+int swd_ap_write(int ap, int adr, unsigned int data);
+int swd_transfer_batch(struct swd_mpsse_op *ops, int num);
+int swd_mem_read(int ap, unsigned int adr, unsigned int *data, int num);
+int swd_mem_write(int ap, unsigned int adr, const unsigned int *data, int num);
+int swd_flash_erase(const struct swd_mpsse_flash *flash, unsigned int adr, int len);
+int swd_flash_write(const struct swd_mpsse_flash *flash, unsigned int adr, const unsigned char *data, int len);
+struct mpsse_adapter *swd_get_adapter(void);
+// Reentrant functions operating on an explicitly opened SWD adapter. An
+// adapter may be shared by any number of threads.
+struct mpsse_adapter *swd_mpsse_open(void);
+struct mpsse_adapter *swd_mpsse_open_if(const char *serial, int interface);
+int swd_mpsse_close(struct mpsse_adapter *adapter);
+int swd_mpsse_info(struct mpsse_adapter *adapter);
+int swd_mpsse_get_freq(struct mpsse_adapter *adapter, int *swd_freq);
+int swd_mpsse_set_freq(struct mpsse_adapter *adapter, int swd_freq);
+int swd_mpsse_set_verbose(struct mpsse_adapter *adapter, int verbose);
+int swd_mpsse_connect(struct mpsse_adapter *adapter, unsigned int *dpidr);
+int swd_mpsse_dp_read(struct mpsse_adapter *adapter, int adr, unsigned int *data);
+int swd_mpsse_dp_write(struct mpsse_adapter *adapter, int adr, unsigned int data);
+int swd_mpsse_ap_read(struct mpsse_adapter *adapter, int ap, int adr, unsigned int *data);
+int swd_mpsse_ap_write(struct mpsse_adapter *adapter, int ap, int adr, unsigned int data);
+int swd_mpsse_transfer_batch(struct mpsse_adapter *adapter, struct swd_mpsse_op *ops, int num);
+int swd_mpsse_mem_read(struct mpsse_adapter *adapter, int ap, unsigned int adr, unsigned int *data, int num);
+int swd_mpsse_mem_write(struct mpsse_adapter *adapter, int ap, unsigned int adr, const unsigned int *data, int num);
+int swd_mpsse_flash_erase(struct mpsse_adapter *adapter, const struct swd_mpsse_flash *flash, unsigned int adr, int len);
+int swd_mpsse_flash_write(struct mpsse_adapter *adapter, const struct swd_mpsse_flash *flash, unsigned int adr, const unsigned char *data, int len);
+
+
+
+#endif
+
@@ -0,0 +1,229 @@
+// File: swd-flash.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// SWD flash programmer for the FTDI FH232H chip using FTDI's Multi - Protocol
+// Synchronous Serial Engine (MPSSE), e.g. for STM32F1 microcontrollers.
+//
+// FTDI FT232H pinning:
+// - ADBUS0(13): SWCLK
+// - ADBUS1(14): SWDIO output
+// - ADBUS2(15): SWDIO input
+//
+// CAUTION:
+// The pin ADBUS1(14) *must* be connected to SWDIO through a resistor (typ. 470
+// Ohm), the pin ADBUS2(15) directly!
+//
+// The binary image file is programmed to the flash memory starting at the
+// address given with the option -a. The core is halted during programming and
+// reset afterwards. The flash memory is read back and verified, unless the
+// option -n is given.
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpsse.h>
+#include "swd-flash.h"
+#include "mpsse_adapter.h"
+
+
+
+// Function protoypes.
+int show_help(char* prog_name);
+int verify_flash(unsigned int adr, const unsigned char *data, int len);
+
+
+
+int main(int argc, char **argv)
+{
+    int i;
+    int status;
+    int swd_freq = SWD_MPSSE_FREQ_DEFAULT;
+    int swd_verify = 1;
+    int len;
+    unsigned int adr = SWD_FLASH_ADR_DEFAULT;
+    unsigned int dpidr;
+    unsigned char *data;
+    FILE *file;
+    struct swd_mpsse_flash flash = SWD_MPSSE_FLASH_STM32F1;
+
+    // Check command line arguments.
+    if(argc < 2) {
+        show_help(argv[0]);
+        return 1;
+    }
+    // Parse the options and remove them from the command line arguments.
+    for(i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if(!strcmp(argv[i], "-n")) {
+            swd_verify = 0;
+        } else if(!strcmp(argv[i], "-s") && i + 1 < argc) {
+            swd_freq = (int) strtoul(argv[++i], NULL, 0);
+            if(swd_freq <= 0 || swd_freq > SWD_MPSSE_FREQ_MAX) {
+                printf("%sInvalid SWCLK frequency of %d Hz. Use up to %d Hz.\n", PREFIX_ERROR, swd_freq, SWD_MPSSE_FREQ_MAX);
+                return 1;
+            }
+        } else if(!strcmp(argv[i], "-a") && i + 1 < argc) {
+            adr = (unsigned int) strtoul(argv[++i], NULL, 0);
+        } else if(!strcmp(argv[i], "-i") && i + 1 < argc) {
+            i++;
+            if(mpsse_adapter_select_interface(mpsse_adapter_parse_interface(argv[i]))) {
+                printf("%sInvalid FTDI interface \"%s\". Use A, B, C or D.\n", PREFIX_ERROR, argv[i]);
+                return 1;
+            }
+        } else {
+            show_help(argv[0]);
+            return 1;
+        }
+    }
+    argv[i-1] = argv[0];
+    argv += i - 1;
+    argc -= i - 1;
+    if(argc != 2) {
+        show_help(argv[0]);
+        return 1;
+    }
+    if(adr % flash.page_size) {
+        printf("%sThe address 0x%08x is not aligned to a flash memory page of %d bytes.\n", PREFIX_ERROR, adr, flash.page_size);
+        return 1;
+    }
+
+    // Read the image file. Pad it to the program unit with erased bytes.
+    file = fopen(argv[1], "rb");
+    if(file == NULL) {
+        printf("%sCannot open the file \"%s\".\n", PREFIX_ERROR, argv[1]);
+        return 1;
+    }
+    data = malloc(SWD_FLASH_SIZE_MAX + 4);
+    if(data == NULL) {
+        printf("%sCannot allocate memory for the image file.\n", PREFIX_ERROR);
+        fclose(file);
+        return 1;
+    }
+    len = fread(data, 1, SWD_FLASH_SIZE_MAX + 1, file);
+    fclose(file);
+    if(len <= 0 || len > SWD_FLASH_SIZE_MAX) {
+        printf("%sThe file \"%s\" is empty or larger than %d bytes.\n", PREFIX_ERROR, argv[1], SWD_FLASH_SIZE_MAX);
+        free(data);
+        return 1;
+    }
+    for(; len % flash.width; len++)
+        data[len] = 0xff;
+
+    // Initialize the SWD master device.
+    status = swd_init();
+    if(status) {
+        printf("%sUnable to open the SWD device.\n", PREFIX_ERROR);
+        free(data);
+        return 1;
+    }
+    // Set the SWCLK frequency.
+    status = swd_set_freq(swd_freq);
+    if(status) {
+        printf("%sUnable to set the SWCLK frequency to %d Hz.\n", PREFIX_ERROR, swd_freq);
+        free(data);
+        swd_close();
+        return 1;
+    }
+    // Set verbosity of the SWD library functions.
+    swd_set_verbose(1);
+
+    // Show device information.
+    #if DEBUG_LEVEL >= 1
+    swd_info();
+    #endif
+
+    // Connect to the target and halt the core.
+    status = swd_connect(&dpidr);
+    if(status) {
+        printf("%sUnable to connect to the SWD target.\n", PREFIX_ERROR);
+        free(data);
+        swd_close();
+        return 1;
+    }
+    printf("DPIDR: 0x%08x\n", dpidr);
+    dpidr = SWD_FLASH_DHCSR_HALT;
+    status = swd_mem_write(0, SWD_FLASH_DHCSR, &dpidr, 1);
+    if(status) {
+        printf("%sUnable to halt the core of the target.\n", PREFIX_ERROR);
+        free(data);
+        swd_close();
+        return 1;
+    }
+
+    // Erase, program and verify the flash memory.
+    printf("Erasing %d byte(s) of flash memory at address 0x%08x.\n", len, adr);
+    status = swd_flash_erase(&flash, adr, len);
+    if(!status) {
+        printf("Programming %d byte(s) of flash memory at address 0x%08x.\n", len, adr);
+        status = swd_flash_write(&flash, adr, data, len);
+    }
+    if(!status && swd_verify) {
+        printf("Verifying %d byte(s) of flash memory at address 0x%08x.\n", len, adr);
+        status = verify_flash(adr, data, len);
+    }
+    if(status)
+        printf("%sUnable to program the flash memory of the target.\n", PREFIX_ERROR);
+    free(data);
+
+    // Release and reset the core.
+    dpidr = SWD_FLASH_DHCSR_RUN;
+    swd_mem_write(0, SWD_FLASH_DHCSR, &dpidr, 1);
+    dpidr = SWD_FLASH_AIRCR_RESET;
+    swd_mem_write(0, SWD_FLASH_AIRCR, &dpidr, 1);
+
+    // Close the SWD device.
+    swd_close();
+
+    return status ? 1 : 0;
+}
+
+
+
+// Read back the flash memory and compare it with the image, in blocks of
+// SWD_MPSSE_TAR_BLOCK bytes per USB transfer.
+int verify_flash(unsigned int adr, const unsigned char *data, int len)
+{
+    int i, j, n;
+    unsigned int words[SWD_MPSSE_TAR_BLOCK / 4];
+    unsigned char byte;
+
+    for(i = 0; i < len; i += n) {
+        n = len - i;
+        if(n > SWD_MPSSE_TAR_BLOCK)
+            n = SWD_MPSSE_TAR_BLOCK;
+        if(swd_mem_read(0, adr + i, words, (n + 3) / 4)) return -1;
+        for(j = 0; j < n; j++) {
+            byte = (words[j / 4] >> (8 * (j % 4))) & 0xff;
+            if(byte != data[i + j]) {
+                printf("%sVerification failed at address 0x%08x: read 0x%02x, expected 0x%02x.\n", PREFIX_ERROR, adr + i + j, byte, data[i + j]);
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+
+// Show help message.
+int show_help(char* prog_name)
+{
+    printf("SWD flash programmer for STM32F1 microcontrollers\n");
+    printf("\n");
+    printf("Usage: %s [-s FREQ] [-i IFACE] [-a ADR] [-n] FILE\n", prog_name);
+    printf("\n");
+    printf("  -s FREQ        SWCLK frequency in Hz (default: %d).\n", SWD_MPSSE_FREQ_DEFAULT);
+    printf("  -i IFACE       MPSSE interface of an FT2232H or FT4232H: A (default) .. D.\n");
+    printf("  -a ADR         Flash memory address (default: 0x%08x).\n", SWD_FLASH_ADR_DEFAULT);
+    printf("  -n             Do not verify the flash memory.\n");
+    printf("\n");
+    printf("The binary image FILE is programmed in chunks of %d bytes per USB transfer.\n", SWD_MPSSE_FLASH_CHUNK);
+    return 0;
+}
+
@@ -0,0 +1,52 @@
+// File: swd-flash.h
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Header file for the SWD flash programmer for the FTDI FH232H chip.
+//
+
+
+
+#ifndef __SWD_FLASH_H
+#define __SWD_FLASH_H
+
+
+
+#include "swd_mpsse.h"
+
+
+
+// Default flash memory start address.
+#define SWD_FLASH_ADR_DEFAULT   0x08000000
+
+// Maximum size of the image file.
+#define SWD_FLASH_SIZE_MAX      (1024 * 1024)
+
+// Cortex-M debug registers.
+#define SWD_FLASH_DHCSR         0xe000edf0
+#define SWD_FLASH_DHCSR_HALT    0xa05f0003  // Key, C_HALT, C_DEBUGEN.
+#define SWD_FLASH_DHCSR_RUN     0xa05f0000  // Key.
+#define SWD_FLASH_AIRCR         0xe000ed0c
+#define SWD_FLASH_AIRCR_RESET   0x05fa0004  // Key, SYSRESETREQ.
+
+
+
+// Message prefixes.
+#define PREFIX_DEBUG            "DEBUG: "
+#define PREFIX_ERROR            "ERROR: "
+
+
+
+// Level of debug info.
+#define DEBUG_LEVEL 0
+//#define DEBUG_LEVEL 1
+//#define DEBUG_LEVEL 2
+//#define DEBUG_LEVEL 3
+//#define DEBUG_LEVEL 4
+
+
+
+#endif
+
@@ -0,0 +1,1060 @@
+// File: ftdi_mpsse.c
+// Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+// Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+// Date: 19 Oct 2026
+// Rev.: 19 Oct 2026
+//
+// Python 3 extension module for the hardware I2C and GPIO IO functions based
+// on FTDI's Multi-Protocol Synchronous Serial Engine (MPSSE).
+//
+// Data is passed with the buffer protocol: write data may be any bytes-like
+// object (bytes, bytearray, memoryview, array, ...) and is used in place.
+// Read data is either returned as a new bytes object, which is filled
+// directly by the library, or stored into a writable buffer supplied by the
+// caller. The GIL is released during the USB IO, so that several Python
+// threads can use the adapter in parallel. The calls in progress are counted,
+// and close() waits for them before the adapter is freed.
+//
+// The MPSSE interfaces of an FT2232H or FT4232H are opened with the keyword
+// arguments serial and interface ("A" .. "D"). Each interface is an adapter of
+// its own, so Python threads can drive them in parallel.
+//
+// I2C messages are tuples:
+//   (ADR, DATA)            Write the bytes-like object DATA.
+//   (ADR, LEN)             Read LEN bytes into a new bytes object.
+//   (ADR, BUFFER, M_RD)    Read len(BUFFER) bytes into the writable BUFFER.
+//
+// Example:
+//   import ftdi_mpsse
+//   i2c = ftdi_mpsse.I2C()
+//   i2c.write(0x70, b'\x01')
+//   data = i2c.reg_read(0x50, 0x0000, 16, 2)
+//   # One combined transaction: write the register address, read 4 bytes.
+//   id, = i2c.transfer([(0x40, b'\xfe'), (0x40, 4)])
+//   # Several transactions in one USB transfer. NACKed ones return None.
+//   results = i2c.batch([[(0x48, b'\x00'), (0x48, 2)], [(0x49, b'\x00'), (0x49, 2)]])
+//   # I2C bus on interface B of an FT2232H.
+//   i2c_b = ftdi_mpsse.I2C(interface='B')
+//
+
+
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <unistd.h>
+#include "mpsse_adapter.h"
+#include "i2c_mpsse.h"
+#include "gpio_mpsse.h"
+
+
+
+// I2C adapter object.
+typedef struct {
+    PyObject_HEAD
+    struct mpsse_adapter *adapter;
+    int busy;                   // Number of calls using the adapter without the GIL.
+} ftdi_mpsse_i2c_object;
+
+// GPIO adapter object.
+typedef struct {
+    PyObject_HEAD
+    struct mpsse_adapter *adapter;
+    int busy;                   // Number of calls using the adapter without the GIL.
+} ftdi_mpsse_gpio_object;
+
+// Parsed I2C transactions.
+struct ftdi_mpsse_batch {
+    struct i2c_mpsse_xfer *xfers;
+    struct i2c_mpsse_msg *msgs;
+    Py_buffer *views;           // Buffers of the messages, obj is NULL if unused.
+    PyObject **reads;           // Read data objects, NULL for write messages.
+    int num_xfers;
+    int num_msgs;
+};
+
+
+
+// Function prototypes.
+static int ftdi_mpsse_parse_msg(PyObject *item, struct i2c_mpsse_msg *msg, Py_buffer *view, PyObject **read);
+static int ftdi_mpsse_batch_parse(struct ftdi_mpsse_batch *batch, PyObject *seq, int single);
+static void ftdi_mpsse_batch_free(struct ftdi_mpsse_batch *batch);
+static PyObject *ftdi_mpsse_batch_reads(struct ftdi_mpsse_batch *batch, int xfer);
+static int ftdi_mpsse_i2c_check(ftdi_mpsse_i2c_object *self);
+static int ftdi_mpsse_gpio_check(ftdi_mpsse_gpio_object *self);
+static struct mpsse_adapter *ftdi_mpsse_i2c_acquire(ftdi_mpsse_i2c_object *self);
+static void ftdi_mpsse_i2c_release(ftdi_mpsse_i2c_object *self);
+static struct mpsse_adapter *ftdi_mpsse_gpio_acquire(ftdi_mpsse_gpio_object *self);
+static void ftdi_mpsse_gpio_release(ftdi_mpsse_gpio_object *self);
+
+
+
+// Parse one I2C message tuple.
+static int ftdi_mpsse_parse_msg(PyObject *item, struct i2c_mpsse_msg *msg, Py_buffer *view, PyObject **read)
+{
+    PyObject *obj;
+    Py_ssize_t len;
+
+    view->obj = NULL;
+    *read = NULL;
+    if(!PyTuple_Check(item) || PyTuple_GET_SIZE(item) < 2 || PyTuple_GET_SIZE(item) > 3) {
+        PyErr_SetString(PyExc_TypeError, "I2C message must be a tuple (ADR, DATA|LEN[, FLAGS]).");
+        return -1;
+    }
+    msg->adr = (int) PyLong_AsLong(PyTuple_GET_ITEM(item, 0));
+    if(msg->adr == -1 && PyErr_Occurred()) return -1;
+    msg->flags = 0;
+    if(PyTuple_GET_SIZE(item) == 3) {
+        msg->flags = (int) PyLong_AsLong(PyTuple_GET_ITEM(item, 2));
+        if(msg->flags == -1 && PyErr_Occurred()) return -1;
+    }
+    obj = PyTuple_GET_ITEM(item, 1);
+
+    // Read into a new bytes object.
+    if(PyLong_Check(obj)) {
+        len = PyLong_AsSsize_t(obj);
+        if(len == -1 && PyErr_Occurred()) return -1;
+        if(len < 0 || len > INT_MAX) {
+            PyErr_SetString(PyExc_ValueError, "Invalid I2C read length.");
+            return -1;
+        }
+        *read = PyBytes_FromStringAndSize(NULL, len);
+        if(*read == NULL) return -1;
+        msg->flags |= I2C_MPSSE_M_RD;
+        msg->len = (int) len;
+        msg->buf = PyBytes_AS_STRING(*read);
+        return 0;
+    }
+
+    // Write from or read into a buffer.
+    if(PyObject_GetBuffer(obj, view, (msg->flags & I2C_MPSSE_M_RD) ? PyBUF_WRITABLE : PyBUF_SIMPLE)) {
+        view->obj = NULL;
+        return -1;
+    }
+    if(view->len > INT_MAX) {
+        PyErr_SetString(PyExc_ValueError, "I2C message too long.");
+        return -1;
+    }
+    msg->len = (int) view->len;
+    msg->buf = (char *) view->buf;
+    if(msg->flags & I2C_MPSSE_M_RD) {
+        Py_INCREF(obj);
+        *read = obj;
+    }
+
+    return 0;
+}
+
+
+
+// Parse a list of transactions, each being a list of messages. If single is
+// set, seq is the message list of a single transaction.
+static int ftdi_mpsse_batch_parse(struct ftdi_mpsse_batch *batch, PyObject *seq, int single)
+{
+    PyObject *fast, *xfer_fast, *item;
+    Py_ssize_t i, j, num_xfers, num_msgs = 0;
+    int k = 0;
+
+    memset(batch, 0, sizeof(struct ftdi_mpsse_batch));
+    fast = PySequence_Fast(seq, "I2C transactions must be a sequence.");
+    if(fast == NULL) return -1;
+
+    // Count the messages.
+    num_xfers = single ? 1 : PySequence_Fast_GET_SIZE(fast);
+    if(single) {
+        num_msgs = PySequence_Fast_GET_SIZE(fast);
+    } else {
+        for(i = 0; i < num_xfers; i++) {
+            item = PySequence_Fast_GET_ITEM(fast, i);
+            if(!PySequence_Check(item) || PySequence_Size(item) < 0) {
+                PyErr_SetString(PyExc_TypeError, "I2C transaction must be a sequence of messages.");
+                Py_DECREF(fast);
+                return -1;
+            }
+            num_msgs += PySequence_Size(item);
+        }
+    }
+    if(num_xfers > INT_MAX || num_msgs > INT_MAX) {
+        PyErr_SetString(PyExc_ValueError, "Too many I2C messages.");
+        Py_DECREF(fast);
+        return -1;
+    }
+
+    batch->xfers = PyMem_Calloc(num_xfers ? num_xfers : 1, sizeof(struct i2c_mpsse_xfer));
+    batch->msgs = PyMem_Calloc(num_msgs ? num_msgs : 1, sizeof(struct i2c_mpsse_msg));
+    batch->views = PyMem_Calloc(num_msgs ? num_msgs : 1, sizeof(Py_buffer));
+    batch->reads = PyMem_Calloc(num_msgs ? num_msgs : 1, sizeof(PyObject *));
+    if(batch->xfers == NULL || batch->msgs == NULL || batch->views == NULL || batch->reads == NULL) {
+        PyErr_NoMemory();
+        Py_DECREF(fast);
+        ftdi_mpsse_batch_free(batch);
+        return -1;
+    }
+    batch->num_xfers = (int) num_xfers;
+    batch->num_msgs = (int) num_msgs;
+
+    // Parse the messages.
+    for(i = 0; i < num_xfers; i++) {
+        if(single) {
+            xfer_fast = fast;
+            Py_INCREF(xfer_fast);
+        } else {
+            xfer_fast = PySequence_Fast(PySequence_Fast_GET_ITEM(fast, i), "I2C transaction must be a sequence of messages.");
+            if(xfer_fast == NULL) goto fail;
+        }
+        if(k + PySequence_Fast_GET_SIZE(xfer_fast) > batch->num_msgs) {
+            PyErr_SetString(PyExc_RuntimeError, "I2C transaction list changed during parsing.");
+            Py_DECREF(xfer_fast);
+            goto fail;
+        }
+        batch->xfers[i].msgs = &batch->msgs[k];
+        batch->xfers[i].num = (int) PySequence_Fast_GET_SIZE(xfer_fast);
+        for(j = 0; j < PySequence_Fast_GET_SIZE(xfer_fast); j++, k++) {
+            if(ftdi_mpsse_parse_msg(PySequence_Fast_GET_ITEM(xfer_fast, j), &batch->msgs[k], &batch->views[k], &batch->reads[k])) {
+                Py_DECREF(xfer_fast);
+                goto fail;
+            }
+        }
+        Py_DECREF(xfer_fast);
+    }
+    Py_DECREF(fast);
+
+    return 0;
+
+fail:
+    Py_DECREF(fast);
+    ftdi_mpsse_batch_free(batch);
+    return -1;
+}
+
+
+
+// Release the buffers and objects of parsed transactions.
+static void ftdi_mpsse_batch_free(struct ftdi_mpsse_batch *batch)
+{
+    int i;
+
+    for(i = 0; i < batch->num_msgs; i++) {
+        if(batch->views != NULL && batch->views[i].obj != NULL)
+            PyBuffer_Release(&batch->views[i]);
+        if(batch->reads != NULL)
+            Py_XDECREF(batch->reads[i]);
+    }
+    PyMem_Free(batch->xfers);
+    PyMem_Free(batch->msgs);
+    PyMem_Free(batch->views);
+    PyMem_Free(batch->reads);
+    memset(batch, 0, sizeof(struct ftdi_mpsse_batch));
+}
+
+
+
+// Get a list of the read data objects of a transaction.
+static PyObject *ftdi_mpsse_batch_reads(struct ftdi_mpsse_batch *batch, int xfer)
+{
+    PyObject *list;
+    int i, first;
+
+    list = PyList_New(0);
+    if(list == NULL) return NULL;
+    first = batch->xfers[xfer].msgs - batch->msgs;
+    for(i = first; i < first + batch->xfers[xfer].num; i++) {
+        if(batch->reads[i] == NULL) continue;
+        if(PyList_Append(list, batch->reads[i])) {
+            Py_DECREF(list);
+            return NULL;
+        }
+    }
+
+    return list;
+}
+
+
+
+// Check if the I2C adapter is open.
+static int ftdi_mpsse_i2c_check(ftdi_mpsse_i2c_object *self)
+{
+    if(self->adapter == NULL) {
+        PyErr_SetString(PyExc_ValueError, "I2C adapter is closed.");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Check if the GPIO adapter is open.
+static int ftdi_mpsse_gpio_check(ftdi_mpsse_gpio_object *self)
+{
+    if(self->adapter == NULL) {
+        PyErr_SetString(PyExc_ValueError, "GPIO adapter is closed.");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+// Get the I2C adapter for a call without the GIL. The pointer is copied and the
+// call is counted while holding the GIL, so that close() waits for the call to
+// finish. Must be followed by ftdi_mpsse_i2c_release(). Returns NULL and raises
+// an exception if the adapter is closed.
+static struct mpsse_adapter *ftdi_mpsse_i2c_acquire(ftdi_mpsse_i2c_object *self)
+{
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    self->busy++;
+
+    return self->adapter;
+}
+
+
+
+// End a call without the GIL on the I2C adapter.
+static void ftdi_mpsse_i2c_release(ftdi_mpsse_i2c_object *self)
+{
+    self->busy--;
+}
+
+
+
+// Get the GPIO adapter for a call without the GIL, see ftdi_mpsse_i2c_acquire().
+static struct mpsse_adapter *ftdi_mpsse_gpio_acquire(ftdi_mpsse_gpio_object *self)
+{
+    if(ftdi_mpsse_gpio_check(self)) return NULL;
+    self->busy++;
+
+    return self->adapter;
+}
+
+
+
+// End a call without the GIL on the GPIO adapter.
+static void ftdi_mpsse_gpio_release(ftdi_mpsse_gpio_object *self)
+{
+    self->busy--;
+}
+
+
+
+// Get the FTDI interface from its name. Returns -1 and raises an exception if
+// the name is invalid.
+static int ftdi_mpsse_interface(const char *name)
+{
+    int interface;
+
+    if(name == NULL) return IFACE_ANY;
+    interface = mpsse_adapter_parse_interface(name);
+    if(interface < 0)
+        PyErr_Format(PyExc_ValueError, "Invalid FTDI interface \"%s\". Use A, B, C or D.", name);
+
+    return interface;
+}
+
+
+
+// I2C adapter methods.
+static int ftdi_mpsse_i2c_init(ftdi_mpsse_i2c_object *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = { "serial", "interface", NULL };
+    struct mpsse_adapter *adapter;
+    const char *serial = NULL;
+    const char *name = NULL;
+    int interface;
+
+    if(!PyArg_ParseTupleAndKeywords(args, kwds, "|zz:I2C", kwlist, &serial, &name)) return -1;
+    if(self->adapter != NULL) return 0;
+    interface = ftdi_mpsse_interface(name);
+    if(interface < 0) return -1;
+
+    Py_BEGIN_ALLOW_THREADS
+    if(serial == NULL && name == NULL)
+        adapter = i2c_mpsse_open();
+    else
+        adapter = i2c_mpsse_open_if(serial, interface);
+    Py_END_ALLOW_THREADS
+    if(adapter == NULL) {
+        PyErr_SetString(PyExc_OSError, "Unable to open the I2C adapter.");
+        return -1;
+    }
+    self->adapter = adapter;
+
+    return 0;
+}
+
+static PyObject *ftdi_mpsse_i2c_close(ftdi_mpsse_i2c_object *self, PyObject *Py_UNUSED(ignored))
+{
+    struct mpsse_adapter *adapter = self->adapter;
+
+    if(adapter != NULL) {
+        // No new calls can start now. Wait for the ones still using the
+        // adapter.
+        self->adapter = NULL;
+        while(self->busy > 0) {
+            Py_BEGIN_ALLOW_THREADS
+            usleep(1000);
+            Py_END_ALLOW_THREADS
+        }
+        Py_BEGIN_ALLOW_THREADS
+        i2c_mpsse_close(adapter);
+        Py_END_ALLOW_THREADS
+    }
+
+    Py_RETURN_NONE;
+}
+
+static void ftdi_mpsse_i2c_dealloc(ftdi_mpsse_i2c_object *self)
+{
+    Py_XDECREF(ftdi_mpsse_i2c_close(self, NULL));
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *ftdi_mpsse_i2c_enter(ftdi_mpsse_i2c_object *self, PyObject *Py_UNUSED(ignored))
+{
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    Py_INCREF(self);
+
+    return (PyObject *) self;
+}
+
+static PyObject *ftdi_mpsse_i2c_exit(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    return ftdi_mpsse_i2c_close(self, NULL);
+}
+
+static PyObject *ftdi_mpsse_i2c_info(ftdi_mpsse_i2c_object *self, PyObject *Py_UNUSED(ignored))
+{
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    i2c_mpsse_info(self->adapter);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_i2c_set_verbose(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    int verbose;
+
+    if(!PyArg_ParseTuple(args, "i:set_verbose", &verbose)) return NULL;
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    i2c_mpsse_set_verbose(self->adapter, verbose);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_i2c_get_freq(ftdi_mpsse_i2c_object *self, PyObject *Py_UNUSED(ignored))
+{
+    int freq;
+
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    if(i2c_mpsse_get_freq(self->adapter, &freq)) {
+        PyErr_SetString(PyExc_OSError, "Unable to get the I2C frequency.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(freq);
+}
+
+static PyObject *ftdi_mpsse_i2c_set_freq(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    struct mpsse_adapter *adapter;
+    int freq, status;
+
+    if(!PyArg_ParseTuple(args, "i:set_freq", &freq)) return NULL;
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    adapter = ftdi_mpsse_i2c_acquire(self);
+    if(adapter == NULL) return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    status = i2c_mpsse_set_freq(adapter, freq);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_i2c_release(self);
+    if(status) {
+        PyErr_Format(PyExc_OSError, "Unable to set the I2C frequency to %d Hz.", freq);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_i2c_get_dev_freq(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    int adr, freq;
+
+    if(!PyArg_ParseTuple(args, "i:get_dev_freq", &adr)) return NULL;
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    if(i2c_mpsse_get_dev_freq(self->adapter, adr, &freq)) {
+        PyErr_Format(PyExc_OSError, "Unable to get the I2C frequency of the device 0x%02x.", adr);
+        return NULL;
+    }
+
+    return PyLong_FromLong(freq);
+}
+
+static PyObject *ftdi_mpsse_i2c_set_dev_freq(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    int adr, freq;
+
+    if(!PyArg_ParseTuple(args, "ii:set_dev_freq", &adr, &freq)) return NULL;
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    if(i2c_mpsse_set_dev_freq(self->adapter, adr, freq)) {
+        PyErr_Format(PyExc_OSError, "Unable to set the I2C frequency of the device 0x%02x to %d Hz.", adr, freq);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_i2c_set_stretch(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    struct mpsse_adapter *adapter;
+    int enable, status;
+
+    if(!PyArg_ParseTuple(args, "p:set_stretch", &enable)) return NULL;
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    adapter = ftdi_mpsse_i2c_acquire(self);
+    if(adapter == NULL) return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    status = i2c_mpsse_set_stretch(adapter, enable);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_i2c_release(self);
+    if(status) {
+        PyErr_SetString(PyExc_OSError, "Unable to set the I2C clock stretching.");
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_i2c_set_strap(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    struct mpsse_adapter *adapter;
+    int strap, status;
+
+    if(!PyArg_ParseTuple(args, "p:set_strap", &strap)) return NULL;
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    adapter = ftdi_mpsse_i2c_acquire(self);
+    if(adapter == NULL) return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    status = i2c_mpsse_set_strap(adapter, strap);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_i2c_release(self);
+    if(status) {
+        PyErr_SetString(PyExc_OSError, "Unable to set the I2C SDA strap.");
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_i2c_recover(ftdi_mpsse_i2c_object *self, PyObject *Py_UNUSED(ignored))
+{
+    struct mpsse_adapter *adapter;
+    int status;
+
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    adapter = ftdi_mpsse_i2c_acquire(self);
+    if(adapter == NULL) return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    status = i2c_mpsse_recover(adapter);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_i2c_release(self);
+    if(status) {
+        PyErr_SetString(PyExc_OSError, "Unable to recover the I2C bus.");
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_i2c_write(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    struct mpsse_adapter *adapter;
+    int adr, status;
+    Py_buffer data;
+
+    if(!PyArg_ParseTuple(args, "iy*:write", &adr, &data)) return NULL;
+    if(ftdi_mpsse_i2c_check(self) || data.len > INT_MAX) {
+        if(!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "I2C data too long.");
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+    adapter = ftdi_mpsse_i2c_acquire(self);
+    if(adapter == NULL) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    status = i2c_mpsse_write(adapter, adr, (char *) data.buf, (int) data.len);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_i2c_release(self);
+    PyBuffer_Release(&data);
+    if(status) {
+        PyErr_Format(PyExc_OSError, "Unable to write to the I2C device 0x%02x.", adr);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_i2c_read(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    struct mpsse_adapter *adapter;
+    int adr, len, status;
+    PyObject *data;
+
+    if(!PyArg_ParseTuple(args, "ii:read", &adr, &len)) return NULL;
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    if(len < 0) {
+        PyErr_SetString(PyExc_ValueError, "Invalid I2C read length.");
+        return NULL;
+    }
+    data = PyBytes_FromStringAndSize(NULL, len);
+    if(data == NULL) return NULL;
+    adapter = ftdi_mpsse_i2c_acquire(self);
+    if(adapter == NULL) {
+        Py_DECREF(data);
+        return NULL;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    status = i2c_mpsse_read(adapter, adr, PyBytes_AS_STRING(data), len);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_i2c_release(self);
+    if(status) {
+        Py_DECREF(data);
+        PyErr_Format(PyExc_OSError, "Unable to read from the I2C device 0x%02x.", adr);
+        return NULL;
+    }
+
+    return data;
+}
+
+static PyObject *ftdi_mpsse_i2c_read_into(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    struct mpsse_adapter *adapter;
+    int adr, status;
+    Py_buffer data;
+
+    if(!PyArg_ParseTuple(args, "iw*:read_into", &adr, &data)) return NULL;
+    if(ftdi_mpsse_i2c_check(self) || data.len > INT_MAX) {
+        if(!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "I2C data too long.");
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+    adapter = ftdi_mpsse_i2c_acquire(self);
+    if(adapter == NULL) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    status = i2c_mpsse_read(adapter, adr, (char *) data.buf, (int) data.len);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_i2c_release(self);
+    PyBuffer_Release(&data);
+    if(status) {
+        PyErr_Format(PyExc_OSError, "Unable to read from the I2C device 0x%02x.", adr);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_i2c_reg_write(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    struct mpsse_adapter *adapter;
+    int adr, adr_width = 1, status;
+    unsigned int reg_adr;
+    Py_buffer data;
+
+    if(!PyArg_ParseTuple(args, "iIy*|i:reg_write", &adr, &reg_adr, &data, &adr_width)) return NULL;
+    if(ftdi_mpsse_i2c_check(self) || data.len > INT_MAX) {
+        if(!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "I2C data too long.");
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+    adapter = ftdi_mpsse_i2c_acquire(self);
+    if(adapter == NULL) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    status = i2c_mpsse_reg_write(adapter, adr, reg_adr, adr_width, (char *) data.buf, (int) data.len);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_i2c_release(self);
+    PyBuffer_Release(&data);
+    if(status) {
+        PyErr_Format(PyExc_OSError, "Unable to write to register 0x%x of the I2C device 0x%02x.", reg_adr, adr);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_i2c_reg_read(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    struct mpsse_adapter *adapter;
+    int adr, len, adr_width = 1, status;
+    unsigned int reg_adr;
+    PyObject *data;
+
+    if(!PyArg_ParseTuple(args, "iIi|i:reg_read", &adr, &reg_adr, &len, &adr_width)) return NULL;
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    if(len < 0) {
+        PyErr_SetString(PyExc_ValueError, "Invalid I2C read length.");
+        return NULL;
+    }
+    data = PyBytes_FromStringAndSize(NULL, len);
+    if(data == NULL) return NULL;
+    adapter = ftdi_mpsse_i2c_acquire(self);
+    if(adapter == NULL) {
+        Py_DECREF(data);
+        return NULL;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    status = i2c_mpsse_reg_read(adapter, adr, reg_adr, adr_width, PyBytes_AS_STRING(data), len);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_i2c_release(self);
+    if(status) {
+        Py_DECREF(data);
+        PyErr_Format(PyExc_OSError, "Unable to read from register 0x%x of the I2C device 0x%02x.", reg_adr, adr);
+        return NULL;
+    }
+
+    return data;
+}
+
+static PyObject *ftdi_mpsse_i2c_transfer(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    struct mpsse_adapter *adapter;
+    PyObject *seq, *result;
+    struct ftdi_mpsse_batch batch;
+    int status;
+
+    if(!PyArg_ParseTuple(args, "O:transfer", &seq)) return NULL;
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    if(ftdi_mpsse_batch_parse(&batch, seq, 1)) return NULL;
+    adapter = ftdi_mpsse_i2c_acquire(self);
+    if(adapter == NULL) {
+        ftdi_mpsse_batch_free(&batch);
+        return NULL;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    status = i2c_mpsse_transfer(adapter, batch.msgs, batch.num_msgs);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_i2c_release(self);
+    if(status) {
+        ftdi_mpsse_batch_free(&batch);
+        PyErr_SetString(PyExc_OSError, "I2C transaction failed.");
+        return NULL;
+    }
+    result = ftdi_mpsse_batch_reads(&batch, 0);
+    ftdi_mpsse_batch_free(&batch);
+
+    return result;
+}
+
+static PyObject *ftdi_mpsse_i2c_batch(ftdi_mpsse_i2c_object *self, PyObject *args)
+{
+    struct mpsse_adapter *adapter;
+    PyObject *seq, *result, *reads;
+    struct ftdi_mpsse_batch batch;
+    int i;
+
+    if(!PyArg_ParseTuple(args, "O:batch", &seq)) return NULL;
+    if(ftdi_mpsse_i2c_check(self)) return NULL;
+    if(ftdi_mpsse_batch_parse(&batch, seq, 0)) return NULL;
+    // Failed transactions are reported by their status.
+    adapter = ftdi_mpsse_i2c_acquire(self);
+    if(adapter == NULL) {
+        ftdi_mpsse_batch_free(&batch);
+        return NULL;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    i2c_mpsse_transfer_batch(adapter, batch.xfers, batch.num_xfers);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_i2c_release(self);
+    result = PyList_New(batch.num_xfers);
+    if(result == NULL) {
+        ftdi_mpsse_batch_free(&batch);
+        return NULL;
+    }
+    for(i = 0; i < batch.num_xfers; i++) {
+        if(batch.xfers[i].status) {
+            Py_INCREF(Py_None);
+            reads = Py_None;
+        } else {
+            reads = ftdi_mpsse_batch_reads(&batch, i);
+            if(reads == NULL) {
+                Py_DECREF(result);
+                ftdi_mpsse_batch_free(&batch);
+                return NULL;
+            }
+        }
+        PyList_SET_ITEM(result, i, reads);
+    }
+    ftdi_mpsse_batch_free(&batch);
+
+    return result;
+}
+
+static PyMethodDef ftdi_mpsse_i2c_methods[] = {
+    { "close", (PyCFunction) ftdi_mpsse_i2c_close, METH_NOARGS, "Close the I2C adapter." },
+    { "__enter__", (PyCFunction) ftdi_mpsse_i2c_enter, METH_NOARGS, NULL },
+    { "__exit__", (PyCFunction) ftdi_mpsse_i2c_exit, METH_VARARGS, NULL },
+    { "info", (PyCFunction) ftdi_mpsse_i2c_info, METH_NOARGS, "Show information about the I2C adapter." },
+    { "set_verbose", (PyCFunction) ftdi_mpsse_i2c_set_verbose, METH_VARARGS, "set_verbose(VERBOSE): Enable or disable error messages." },
+    { "get_freq", (PyCFunction) ftdi_mpsse_i2c_get_freq, METH_NOARGS, "Get the default I2C frequency in Hz." },
+    { "set_freq", (PyCFunction) ftdi_mpsse_i2c_set_freq, METH_VARARGS, "set_freq(FREQ): Set the default I2C frequency in Hz." },
+    { "get_dev_freq", (PyCFunction) ftdi_mpsse_i2c_get_dev_freq, METH_VARARGS, "get_dev_freq(ADR): Get the I2C frequency of a device in Hz." },
+    { "set_dev_freq", (PyCFunction) ftdi_mpsse_i2c_set_dev_freq, METH_VARARGS, "set_dev_freq(ADR, FREQ): Set the I2C frequency of a device in Hz, 0 = default." },
+    { "set_stretch", (PyCFunction) ftdi_mpsse_i2c_set_stretch, METH_VARARGS, "set_stretch(ENABLE): Enable or disable clock stretching." },
+    { "set_strap", (PyCFunction) ftdi_mpsse_i2c_set_strap, METH_VARARGS, "set_strap(STRAP): ADBUS1 and ADBUS2 are tied together, use them for faster reads." },
+    { "recover", (PyCFunction) ftdi_mpsse_i2c_recover, METH_NOARGS, "Recover a stuck I2C bus." },
+    { "write", (PyCFunction) ftdi_mpsse_i2c_write, METH_VARARGS, "write(ADR, DATA): Write a bytes-like object." },
+    { "read", (PyCFunction) ftdi_mpsse_i2c_read, METH_VARARGS, "read(ADR, LEN) -> bytes: Read LEN bytes." },
+    { "read_into", (PyCFunction) ftdi_mpsse_i2c_read_into, METH_VARARGS, "read_into(ADR, BUFFER): Read len(BUFFER) bytes into a writable buffer." },
+    { "reg_write", (PyCFunction) ftdi_mpsse_i2c_reg_write, METH_VARARGS, "reg_write(ADR, REG, DATA[, ADR_WIDTH]): Write to registers." },
+    { "reg_read", (PyCFunction) ftdi_mpsse_i2c_reg_read, METH_VARARGS, "reg_read(ADR, REG, LEN[, ADR_WIDTH]) -> bytes: Read from registers." },
+    { "transfer", (PyCFunction) ftdi_mpsse_i2c_transfer, METH_VARARGS, "transfer(MSGS) -> list: Execute messages as one combined transaction. Returns the read data." },
+    { "batch", (PyCFunction) ftdi_mpsse_i2c_batch, METH_VARARGS, "batch(XFERS) -> list: Execute transactions in one USB transfer. Returns the read data per transaction, None if it failed." },
+    { NULL, NULL, 0, NULL }
+};
+
+static PyTypeObject ftdi_mpsse_i2c_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "ftdi_mpsse.I2C",
+    .tp_doc = "I2C(serial=None, interface=None): I2C adapter based on the FTDI MPSSE. Opens the interface (\"A\" .. \"D\") of the device with the serial number, by default interface A of the first device found.",
+    .tp_basicsize = sizeof(ftdi_mpsse_i2c_object),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc) ftdi_mpsse_i2c_init,
+    .tp_dealloc = (destructor) ftdi_mpsse_i2c_dealloc,
+    .tp_methods = ftdi_mpsse_i2c_methods,
+};
+
+
+
+// GPIO adapter methods.
+static int ftdi_mpsse_gpio_init(ftdi_mpsse_gpio_object *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = { "attach", "serial", "interface", NULL };
+    struct mpsse_adapter *adapter;
+    int attach = 0;
+    const char *serial = NULL;
+    const char *name = NULL;
+    int interface;
+
+    if(!PyArg_ParseTupleAndKeywords(args, kwds, "|pzz:GPIO", kwlist, &attach, &serial, &name)) return -1;
+    if(self->adapter != NULL) return 0;
+    interface = ftdi_mpsse_interface(name);
+    if(interface < 0) return -1;
+    if(attach && (serial != NULL || name != NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Attaching is only supported for the default device.");
+        return -1;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    if(attach)
+        adapter = gpio_mpsse_attach();
+    else if(serial == NULL && name == NULL)
+        adapter = gpio_mpsse_open();
+    else
+        adapter = gpio_mpsse_open_if(serial, interface);
+    Py_END_ALLOW_THREADS
+    if(adapter == NULL) {
+        PyErr_SetString(PyExc_OSError, "Unable to open the GPIO adapter.");
+        return -1;
+    }
+    self->adapter = adapter;
+
+    return 0;
+}
+
+static PyObject *ftdi_mpsse_gpio_close(ftdi_mpsse_gpio_object *self, PyObject *Py_UNUSED(ignored))
+{
+    struct mpsse_adapter *adapter = self->adapter;
+
+    if(adapter != NULL) {
+        // No new calls can start now. Wait for the ones still using the
+        // adapter.
+        self->adapter = NULL;
+        while(self->busy > 0) {
+            Py_BEGIN_ALLOW_THREADS
+            usleep(1000);
+            Py_END_ALLOW_THREADS
+        }
+        Py_BEGIN_ALLOW_THREADS
+        gpio_mpsse_close(adapter);
+        Py_END_ALLOW_THREADS
+    }
+
+    Py_RETURN_NONE;
+}
+
+static void ftdi_mpsse_gpio_dealloc(ftdi_mpsse_gpio_object *self)
+{
+    Py_XDECREF(ftdi_mpsse_gpio_close(self, NULL));
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *ftdi_mpsse_gpio_enter(ftdi_mpsse_gpio_object *self, PyObject *Py_UNUSED(ignored))
+{
+    if(ftdi_mpsse_gpio_check(self)) return NULL;
+    Py_INCREF(self);
+
+    return (PyObject *) self;
+}
+
+static PyObject *ftdi_mpsse_gpio_exit(ftdi_mpsse_gpio_object *self, PyObject *args)
+{
+    return ftdi_mpsse_gpio_close(self, NULL);
+}
+
+static PyObject *ftdi_mpsse_gpio_info(ftdi_mpsse_gpio_object *self, PyObject *Py_UNUSED(ignored))
+{
+    if(ftdi_mpsse_gpio_check(self)) return NULL;
+    gpio_mpsse_info(self->adapter);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_gpio_set_verbose(ftdi_mpsse_gpio_object *self, PyObject *args)
+{
+    int verbose;
+
+    if(!PyArg_ParseTuple(args, "i:set_verbose", &verbose)) return NULL;
+    if(ftdi_mpsse_gpio_check(self)) return NULL;
+    gpio_mpsse_set_verbose(self->adapter, verbose);
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_gpio_set_pins(ftdi_mpsse_gpio_object *self, PyObject *args)
+{
+    struct mpsse_adapter *adapter;
+    int data, mask, status;
+
+    if(!PyArg_ParseTuple(args, "ii:set_pins", &data, &mask)) return NULL;
+    if(ftdi_mpsse_gpio_check(self)) return NULL;
+    adapter = ftdi_mpsse_gpio_acquire(self);
+    if(adapter == NULL) return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    status = gpio_mpsse_set_pins(adapter, data, mask);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_gpio_release(self);
+    if(status) {
+        PyErr_SetString(PyExc_OSError, "Unable to set the GPIO pins.");
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_gpio_queue_pins(ftdi_mpsse_gpio_object *self, PyObject *args)
+{
+    struct mpsse_adapter *adapter;
+    int data, mask, status;
+
+    if(!PyArg_ParseTuple(args, "ii:queue_pins", &data, &mask)) return NULL;
+    if(ftdi_mpsse_gpio_check(self)) return NULL;
+    adapter = ftdi_mpsse_gpio_acquire(self);
+    if(adapter == NULL) return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    status = gpio_mpsse_queue_pins(adapter, data, mask);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_gpio_release(self);
+    if(status) {
+        PyErr_SetString(PyExc_OSError, "Unable to queue the GPIO pins.");
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyObject *ftdi_mpsse_gpio_get_pins(ftdi_mpsse_gpio_object *self, PyObject *Py_UNUSED(ignored))
+{
+    struct mpsse_adapter *adapter;
+    int data, status;
+
+    if(ftdi_mpsse_gpio_check(self)) return NULL;
+    adapter = ftdi_mpsse_gpio_acquire(self);
+    if(adapter == NULL) return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    status = gpio_mpsse_get_pins(adapter, &data);
+    Py_END_ALLOW_THREADS
+    ftdi_mpsse_gpio_release(self);
+    if(status) {
+        PyErr_SetString(PyExc_OSError, "Unable to get the GPIO pins.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(data);
+}
+
+static PyMethodDef ftdi_mpsse_gpio_methods[] = {
+    { "close", (PyCFunction) ftdi_mpsse_gpio_close, METH_NOARGS, "Close the GPIO adapter." },
+    { "__enter__", (PyCFunction) ftdi_mpsse_gpio_enter, METH_NOARGS, NULL },
+    { "__exit__", (PyCFunction) ftdi_mpsse_gpio_exit, METH_VARARGS, NULL },
+    { "info", (PyCFunction) ftdi_mpsse_gpio_info, METH_NOARGS, "Show information about the GPIO adapter." },
+    { "set_verbose", (PyCFunction) ftdi_mpsse_gpio_set_verbose, METH_VARARGS, "set_verbose(VERBOSE): Enable or disable error messages." },
+    { "set_pins", (PyCFunction) ftdi_mpsse_gpio_set_pins, METH_VARARGS, "set_pins(DATA, MASK): Set the output levels of the GPIO pins selected by MASK." },
+    { "queue_pins", (PyCFunction) ftdi_mpsse_gpio_queue_pins, METH_VARARGS, "queue_pins(DATA, MASK): Queue the output levels for the next USB transfer." },
+    { "get_pins", (PyCFunction) ftdi_mpsse_gpio_get_pins, METH_NOARGS, "get_pins() -> int: Get the levels of the GPIO pins." },
+    { NULL, NULL, 0, NULL }
+};
+
+static PyTypeObject ftdi_mpsse_gpio_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "ftdi_mpsse.GPIO",
+    .tp_doc = "GPIO(attach=False, serial=None, interface=None): GPIO adapter based on the FTDI MPSSE. With attach=True, the pin states are kept when opening and closing. Opens the interface (\"A\" .. \"D\") of the device with the serial number, by default interface A of the first device found.",
+    .tp_basicsize = sizeof(ftdi_mpsse_gpio_object),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc) ftdi_mpsse_gpio_init,
+    .tp_dealloc = (destructor) ftdi_mpsse_gpio_dealloc,
+    .tp_methods = ftdi_mpsse_gpio_methods,
+};
+
+
+
+// Module definition.
+static struct PyModuleDef ftdi_mpsse_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "ftdi_mpsse",
+    .m_doc = "Hardware I2C and GPIO IO based on the FTDI MPSSE.",
+    .m_size = -1,
+};
+
+PyMODINIT_FUNC PyInit_ftdi_mpsse(void)
+{
+    PyObject *module;
+
+    if(PyType_Ready(&ftdi_mpsse_i2c_type) < 0) return NULL;
+    if(PyType_Ready(&ftdi_mpsse_gpio_type) < 0) return NULL;
+
+    module = PyModule_Create(&ftdi_mpsse_module);
+    if(module == NULL) return NULL;
+
+    Py_INCREF(&ftdi_mpsse_i2c_type);
+    if(PyModule_AddObject(module, "I2C", (PyObject *) &ftdi_mpsse_i2c_type) < 0) {
+        Py_DECREF(&ftdi_mpsse_i2c_type);
+        Py_DECREF(module);
+        return NULL;
+    }
+    Py_INCREF(&ftdi_mpsse_gpio_type);
+    if(PyModule_AddObject(module, "GPIO", (PyObject *) &ftdi_mpsse_gpio_type) < 0) {
+        Py_DECREF(&ftdi_mpsse_gpio_type);
+        Py_DECREF(module);
+        return NULL;
+    }
+    if(PyModule_AddIntConstant(module, "M_RD", I2C_MPSSE_M_RD) < 0) {
+        Py_DECREF(module);
+        return NULL;
+    }
+
+    return module;
+}
+
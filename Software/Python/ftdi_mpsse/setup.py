@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+#
+# File: setup.py
+# Auth: M. Fras, Electronics Division, MPI for Physics, Munich
+# Mod.: M. Fras, Electronics Division, MPI for Physics, Munich
+# Date: 19 Oct 2026
+# Rev.: 19 Oct 2026
+#
+# Build script of the Python 3 extension module for the hardware I2C and GPIO
+# IO functions.
+#
+# The C library sources are compiled into the module, so that they are built
+# as position independent code.
+#
+# Build in place:
+#   python3 setup.py build_ext --inplace
+#
+
+
+
+from setuptools import setup, Extension
+
+
+
+# Path to the C libraries.
+C_DIR = '../../C'
+
+
+
+ftdi_mpsse = Extension(
+    'ftdi_mpsse',
+    sources = [
+        'ftdi_mpsse.c',
+        C_DIR + '/MPSSE/libmpsse_adapter/mpsse_adapter.c',
+        C_DIR + '/MPSSE/libmpsse_adapter/mpsse_enum.c',
+        C_DIR + '/MPSSE/libmpsse_adapter/mpsse_tune.c',
+        C_DIR + '/I2C/libi2c_mpsse/i2c_mpsse.c',
+        C_DIR + '/GPIO/libgpio_mpsse/gpio_mpsse.c',
+    ],
+    include_dirs = [
+        C_DIR + '/MPSSE/libmpsse_adapter',
+        C_DIR + '/I2C/libi2c_mpsse',
+        C_DIR + '/GPIO/libgpio_mpsse',
+        '/usr/include/libftdi1',
+        '/usr/local/include/libftdi1',
+        '/usr/include/libusb-1.0',
+        '/usr/local/include/libusb-1.0',
+    ],
+    library_dirs = ['/usr/local/lib'],
+    libraries = ['mpsse', 'ftdi1', 'usb-1.0', 'pthread'],
+    extra_compile_args = ['-fcommon'],
+)
+
+
+
+setup(
+    name = 'ftdi_mpsse',
+    version = '1.0',
+    description = 'Hardware I2C and GPIO IO based on the FTDI MPSSE.',
+    ext_modules = [ftdi_mpsse],
+)
+